@@ -273,3 +273,38 @@ log4g_appender_attachable_impl_append_loop_on_appenders(
 	}
 	return size;
 }
+
+/**
+ * log4g_appender_attachable_impl_append_batch_loop_on_appenders:
+ * @base: An appender attachable implementation object.
+ * @events: An array of log events to append.
+ * @n: The number of events in @events.
+ *
+ * Call the Log4gAppenderInterface::do_append_batch() virtual function for
+ * all attached appenders.
+ *
+ * Returns: The number of appenders @events were appended to.
+ * Since: 0.1
+ */
+guint
+log4g_appender_attachable_impl_append_batch_loop_on_appenders(
+		Log4gAppenderAttachable *base, Log4gLoggingEvent **events,
+		guint n)
+{
+	g_return_val_if_fail(LOG4G_IS_APPENDER_ATTACHABLE_IMPL(base), 0);
+	struct Private *priv = GET_PRIVATE(base);
+	if (!priv->list) {
+		return 0;
+	}
+	guint size = 0;
+	for (guint i = 0; i < priv->list->len; ++i) {
+		Log4gAppender *appender =
+			g_array_index(priv->list, Log4gAppender *, i);
+		if (!appender) {
+			continue;
+		}
+		log4g_appender_do_append_batch(appender, events, n);
+		++size;
+	}
+	return size;
+}
@@ -27,9 +27,57 @@
 #include "config.h"
 #endif
 #include "log4g/appender.h"
+#include "log4g/helpers/hazard.h"
 #include "log4g/helpers/only-once-error-handler.h"
 
-G_DEFINE_ABSTRACT_TYPE(Log4gAppender, log4g_appender, G_TYPE_OBJECT)
+static void
+log4g_appender_init(Log4gAppender *self);
+
+static void
+log4g_appender_class_init(Log4gAppenderClass *klass);
+
+static gpointer log4g_appender_parent_class = NULL;
+
+/* Runs for every class derived from Log4gAppender before its class_init,
+ * concurrent append is not inherited so sub-classes of an appender that
+ * sets it are serialized until they are audited and opt in themselves */
+static void
+log4g_appender_base_init(Log4gAppenderClass *klass)
+{
+	klass->concurrent_append = FALSE;
+}
+
+static void
+log4g_appender_class_intern_init(gpointer klass)
+{
+	log4g_appender_parent_class = g_type_class_peek_parent(klass);
+	log4g_appender_class_init(klass);
+}
+
+GType
+log4g_appender_get_type(void)
+{
+	static gsize type = 0;
+	if (g_once_init_enter(&type)) {
+		static const GTypeInfo info = {
+			sizeof(Log4gAppenderClass),
+			(GBaseInitFunc)log4g_appender_base_init,
+			NULL,
+			(GClassInitFunc)log4g_appender_class_intern_init,
+			NULL,
+			NULL,
+			sizeof(Log4gAppender),
+			0,
+			(GInstanceInitFunc)log4g_appender_init,
+			NULL
+		};
+		GType id = g_type_register_static(G_TYPE_OBJECT,
+				g_intern_static_string("Log4gAppender"),
+				&info, G_TYPE_FLAG_ABSTRACT);
+		g_once_init_leave(&type, id);
+	}
+	return type;
+}
 
 #define ASSIGN_PRIVATE(instance) \
 	(G_TYPE_INSTANCE_GET_PRIVATE(instance, LOG4G_TYPE_APPENDER, \
@@ -39,13 +87,14 @@ G_DEFINE_ABSTRACT_TYPE(Log4gAppender, log4g_appender, G_TYPE_OBJECT)
 	((struct Private *)((Log4gAppender *)instance)->priv)
 
 struct Private {
-	Log4gLayout *layout;
+	Log4gLayout *layout; /* Read via hazard pointers, see append_() */
 	gchar *name;
 	Log4gLevel *threshold;
+	gint level; /* The integer value of 'threshold', G_MININT if unset */
 	gpointer error;
-	Log4gFilter *head;
+	Log4gFilter *head; /* Read via hazard pointers, see accept_() */
 	Log4gFilter *tail;
-	gboolean closed;
+	gint closed;
 	GMutex lock;
 };
 
@@ -57,6 +106,7 @@ log4g_appender_init(Log4gAppender *self)
 	priv->layout = NULL;
 	priv->name = NULL;
 	priv->threshold = NULL;
+	priv->level = G_MININT;
 	priv->error = log4g_only_once_error_handler_new();
 	priv->head = priv->tail = NULL;
 	priv->closed = FALSE;
@@ -72,7 +122,7 @@ dispose(GObject *self)
 		priv->layout = NULL;
 	}
 	if (priv->threshold) {
-		g_object_unref(priv->name);
+		g_object_unref(priv->threshold);
 		priv->threshold = NULL;
 	}
 	if (priv->error) {
@@ -119,53 +169,134 @@ static void
 add_filter(Log4gAppender *self, Log4gFilter *filter)
 {
 	struct Private *priv = GET_PRIVATE(self);
+	g_mutex_lock(&priv->lock);
 	if (!priv->head) {
 		g_object_ref(filter);
-		priv->head = priv->tail = filter;
+		priv->tail = filter;
+		g_atomic_pointer_set(&priv->head, filter);
 	} else {
 		log4g_filter_set_next(priv->tail, filter);
 		priv->tail = filter;
 	}
+	g_mutex_unlock(&priv->lock);
 }
 
 static Log4gFilter *
 get_filter(Log4gAppender *self)
 {
-	return GET_PRIVATE(self)->head;
+	return g_atomic_pointer_get(&GET_PRIVATE(self)->head);
 }
 
-static void
-do_append(Log4gAppender *self, Log4gLoggingEvent *event)
+/* Runs without priv->lock. The filter chain is only ever appended to while
+ * it is published, clearing it retires the head (which owns the rest of
+ * the chain) so a concurrent reader may finish walking it. */
+static gboolean
+accept_(Log4gAppender *self, Log4gLoggingEvent *event)
 {
 	struct Private *priv = GET_PRIVATE(self);
-	g_mutex_lock(&priv->lock);
-	if (priv->closed) {
+	Log4gLevel *level = log4g_logging_event_get_level(event);
+	if (!log4g_appender_is_as_severe_as(self, level)) {
+		return FALSE;
+	}
+	if (!g_atomic_pointer_get(&priv->head)) {
+		return TRUE;
+	}
+	gboolean accept = TRUE;
+	Log4gFilter *filter = log4g_hazard_acquire((gpointer *)&priv->head);
+	while (filter) {
+		gint decision = log4g_filter_decide(filter, event);
+		if (LOG4G_FILTER_DENY == decision) {
+			accept = FALSE;
+			break;
+		} else if (LOG4G_FILTER_ACCEPT == decision) {
+			break;
+		} else if (LOG4G_FILTER_NEUTRAL == decision) {
+			filter = log4g_filter_get_next(filter);
+		}
+	}
+	log4g_hazard_release();
+	return accept;
+}
+
+static gboolean
+closed_(Log4gAppender *self)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	if (G_UNLIKELY(g_atomic_int_get(&priv->closed))) {
 		log4g_log_error(Q_("attempted to append to closed "
 					"appender named [%s]"), priv->name);
-		goto exit;
+		return TRUE;
 	}
-	Log4gLevel *level = log4g_logging_event_get_level(event);
-	if (!log4g_appender_is_as_severe_as(self, level)) {
-		goto exit;
+	return FALSE;
+}
+
+/* Call append or append_batch. Concurrent appenders run without priv->lock
+ * and protect the layout so set_layout() cannot destroy it while events
+ * are formatted. Serialized appenders hold priv->lock, which close() also
+ * takes, so 'closed' is checked again once it is held. */
+static void
+append_(Log4gAppender *self, Log4gLoggingEvent **events, guint n)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	if (LOG4G_APPENDER_GET_CLASS(self)->concurrent_append) {
+		log4g_hazard_acquire((gpointer *)&priv->layout);
+		if (1 == n) {
+			log4g_appender_append(self, events[0]);
+		} else {
+			log4g_appender_append_batch(self, events, n);
+		}
+		log4g_hazard_release();
+		return;
 	}
-	if (priv->head) {
-		Log4gFilter *filter = priv->head;
-		while (filter) {
-			gint decision = log4g_filter_decide(filter, event);
-			if (LOG4G_FILTER_DENY == decision) {
-				goto exit;
-			} else if (LOG4G_FILTER_ACCEPT == decision) {
-				break;
-			} else if (LOG4G_FILTER_NEUTRAL == decision) {
-				filter = log4g_filter_get_next(filter);
-			}
+	g_mutex_lock(&priv->lock);
+	if (G_LIKELY(!g_atomic_int_get(&priv->closed))) {
+		if (1 == n) {
+			log4g_appender_append(self, events[0]);
+		} else {
+			log4g_appender_append_batch(self, events, n);
 		}
 	}
-	log4g_appender_append(self, event);
-exit:
 	g_mutex_unlock(&priv->lock);
 }
 
+static void
+do_append(Log4gAppender *self, Log4gLoggingEvent *event)
+{
+	if (closed_(self) || !accept_(self, event)) {
+		return;
+	}
+	append_(self, &event, 1);
+}
+
+static void
+append_batch(Log4gAppender *self, Log4gLoggingEvent **events, guint n)
+{
+	for (guint i = 0; i < n; ++i) {
+		log4g_appender_append(self, events[i]);
+	}
+}
+
+static void
+do_append_batch(Log4gAppender *self, Log4gLoggingEvent **events, guint n)
+{
+	if (closed_(self)) {
+		return;
+	}
+	Log4gLoggingEvent **accepted = g_new(Log4gLoggingEvent *, n);
+	guint size = 0;
+	for (guint i = 0; i < n; ++i) {
+		if (accept_(self, events[i])) {
+			accepted[size++] = events[i];
+		}
+	}
+	if (!size) {
+		goto exit;
+	}
+	append_(self, accepted, size);
+exit:
+	g_free(accepted);
+}
+
 static const gchar *
 get_name(Log4gAppender *self)
 {
@@ -195,24 +326,27 @@ get_error_handler(Log4gAppender *self)
 	return GET_PRIVATE(self)->error;
 }
 
+/* The previous layout is destroyed once no concurrent append uses it */
 static void
 set_layout(Log4gAppender *self, Log4gLayout *layout)
 {
 	struct Private *priv = GET_PRIVATE(self);
-	if (priv->layout) {
-		g_object_unref(priv->layout);
-		priv->layout = NULL;
-	}
 	if (layout) {
 		g_object_ref(layout);
-		priv->layout = layout;
+	}
+	g_mutex_lock(&priv->lock);
+	Log4gLayout *old = g_atomic_pointer_get(&priv->layout);
+	g_atomic_pointer_set(&priv->layout, layout);
+	g_mutex_unlock(&priv->lock);
+	if (old) {
+		log4g_hazard_retire(old, g_object_unref);
 	}
 }
 
 static Log4gLayout *
 get_layout(Log4gAppender *self)
 {
-	return GET_PRIVATE(self)->layout;
+	return g_atomic_pointer_get(&GET_PRIVATE(self)->layout);
 }
 
 static void
@@ -248,6 +382,9 @@ log4g_appender_class_init(Log4gAppenderClass *klass)
 	klass->set_name = set_name;
 	klass->requires_layout = NULL;
 	klass->activate_options = activate_options;
+	klass->append_batch = append_batch;
+	klass->do_append_batch = do_append_batch;
+	klass->concurrent_append = FALSE;
 	g_type_class_add_private(klass, sizeof(struct Private));
 	/**
 	 * Log4gAppender:threshold:
@@ -276,9 +413,13 @@ log4g_appender_clear_filters(Log4gAppender *self)
 {
 	g_return_if_fail(LOG4G_IS_APPENDER(self));
 	struct Private *priv = GET_PRIVATE(self);
-	if (priv->head) {
-		g_object_unref(priv->head);
-		priv->head = priv->tail = NULL;
+	g_mutex_lock(&priv->lock);
+	Log4gFilter *head = g_atomic_pointer_get(&priv->head);
+	g_atomic_pointer_set(&priv->head, NULL);
+	priv->tail = NULL;
+	g_mutex_unlock(&priv->lock);
+	if (head) {
+		log4g_hazard_retire(head, g_object_unref);
 	}
 }
 
@@ -320,13 +461,24 @@ log4g_appender_get_filter(Log4gAppender *self)
  *
  * Calls the @close function from the #Log4gAppenderClass of @self.
  *
+ * Unless @self sets @concurrent_append, @close waits for the event being
+ * appended and later events are discarded.
+ *
  * Since: 0.1
  */
 void
 log4g_appender_close(Log4gAppender *self)
 {
 	g_return_if_fail(LOG4G_IS_APPENDER(self));
-	LOG4G_APPENDER_GET_CLASS(self)->close(self);
+	Log4gAppenderClass *klass = LOG4G_APPENDER_GET_CLASS(self);
+	if (klass->concurrent_append) {
+		klass->close(self);
+	} else {
+		struct Private *priv = GET_PRIVATE(self);
+		g_mutex_lock(&priv->lock);
+		klass->close(self);
+		g_mutex_unlock(&priv->lock);
+	}
 }
 
 /**
@@ -488,6 +640,46 @@ log4g_appender_append(Log4gAppender *self, Log4gLoggingEvent *event)
 	LOG4G_APPENDER_GET_CLASS(self)->append(self, event);
 }
 
+/**
+ * log4g_appender_do_append_batch:
+ * @self: A #Log4gAppender object.
+ * @events: An array of log events to append.
+ * @n: The number of events in @events.
+ *
+ * Calls the @do_append_batch function from the #Log4gAppenderClass of @self.
+ *
+ * Since: 0.1
+ */
+void
+log4g_appender_do_append_batch(Log4gAppender *self, Log4gLoggingEvent **events,
+		guint n)
+{
+	g_return_if_fail(LOG4G_IS_APPENDER(self));
+	if (!n) {
+		return;
+	}
+	g_return_if_fail(events);
+	LOG4G_APPENDER_GET_CLASS(self)->do_append_batch(self, events, n);
+}
+
+/**
+ * log4g_appender_append_batch:
+ * @self: A #Log4gAppender object.
+ * @events: An array of log events.
+ * @n: The number of events in @events.
+ *
+ * Calls the @append_batch function from the #Log4gAppenderClass of @self.
+ *
+ * Since: 0.1
+ */
+void
+log4g_appender_append_batch(Log4gAppender *self, Log4gLoggingEvent **events,
+		guint n)
+{
+	g_return_if_fail(LOG4G_IS_APPENDER(self));
+	LOG4G_APPENDER_GET_CLASS(self)->append_batch(self, events, n);
+}
+
 /**
  * log4g_appender_get_first_filter:
  * @self: A #Log4gAppender object.
@@ -502,7 +694,7 @@ Log4gFilter *
 log4g_appender_get_first_filter(Log4gAppender *self)
 {
 	g_return_val_if_fail(LOG4G_IS_APPENDER(self), NULL);
-	return GET_PRIVATE(self)->head;
+	return g_atomic_pointer_get(&GET_PRIVATE(self)->head);
 }
 
 /**
@@ -522,10 +714,9 @@ gboolean
 log4g_appender_is_as_severe_as(Log4gAppender *self, Log4gLevel *level)
 {
 	g_return_val_if_fail(LOG4G_IS_APPENDER(self), FALSE);
-	struct Private *priv = GET_PRIVATE(self);
-	return ((priv->threshold == NULL)
-			|| (log4g_level_is_greater_or_equal(level,
-					priv->threshold)));
+	gint threshold = g_atomic_int_get(&GET_PRIVATE(self)->level);
+	return ((G_MININT == threshold)
+			|| (log4g_level_to_int(level) >= threshold));
 }
 
 /**
@@ -542,16 +733,22 @@ log4g_appender_set_threshold(Log4gAppender *self, const gchar *threshold)
 {
 	g_return_if_fail(LOG4G_IS_APPENDER(self));
 	struct Private *priv = GET_PRIVATE(self);
-	if (priv->threshold) {
-		g_object_unref(priv->threshold);
-		priv->threshold = NULL;
-	}
+	Log4gLevel *level = NULL;
 	if (threshold) {
-		priv->threshold = log4g_level_string_to_level(threshold);
-		if (priv->threshold) {
-			g_object_ref(priv->threshold);
+		level = log4g_level_string_to_level(threshold);
+		if (level) {
+			g_object_ref(level);
 		}
 	}
+	/* levels are owned by the level class, a reader never sees a
+	 * threshold that has been freed */
+	g_atomic_int_set(&priv->level,
+			(level ? log4g_level_to_int(level) : G_MININT));
+	Log4gLevel *old = g_atomic_pointer_get(&priv->threshold);
+	g_atomic_pointer_set(&priv->threshold, level);
+	if (old) {
+		g_object_unref(old);
+	}
 }
 
 /**
@@ -567,7 +764,7 @@ Log4gLevel *
 log4g_appender_get_threshold(Log4gAppender *self)
 {
 	g_return_val_if_fail(LOG4G_IS_APPENDER(self), NULL);
-	return GET_PRIVATE(self)->threshold;
+	return g_atomic_pointer_get(&GET_PRIVATE(self)->threshold);
 }
 
 /**
@@ -583,7 +780,7 @@ gboolean
 log4g_appender_get_closed(Log4gAppender *self)
 {
 	g_return_val_if_fail(LOG4G_IS_APPENDER(self), TRUE);
-	return GET_PRIVATE(self)->closed;
+	return g_atomic_int_get(&GET_PRIVATE(self)->closed);
 }
 
 /**
@@ -602,5 +799,5 @@ void
 log4g_appender_set_closed(Log4gAppender *self, gboolean closed)
 {
 	g_return_if_fail(LOG4G_IS_APPENDER(self));
-	GET_PRIVATE(self)->closed = closed;
+	g_atomic_int_set(&GET_PRIVATE(self)->closed, closed);
 }
@@ -131,6 +131,42 @@ typedef void
 typedef void
 (*Log4gAppenderDoAppend)(Log4gAppender *self, Log4gLoggingEvent *event);
 
+/**
+ * Log4gAppenderAppendBatch:
+ * @base: An #Log4gAppender object.
+ * @events: An array of log events.
+ * @n: The number of events in @events.
+ *
+ * Sub-classes may implement this virtual function to log several events at
+ * once, e.g. with a single write. The default implementation calls
+ * @append for each event.
+ *
+ * See: #Log4gLoggingEvent
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gAppenderAppendBatch)(Log4gAppender *base, Log4gLoggingEvent **events,
+		guint n);
+
+/**
+ * Log4gAppenderDoAppendBatch:
+ * @self: A #Log4gAppender object.
+ * @events: An array of logging events to append.
+ * @n: The number of events in @events.
+ *
+ * Asynchronous dispatchers will call this function in order to log several
+ * events at once. Events are filtered individually, the events that pass
+ * are handed to @append_batch.
+ *
+ * See: #Log4gLoggingEvent
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gAppenderDoAppendBatch)(Log4gAppender *self, Log4gLoggingEvent **events,
+		guint n);
+
 /**
  * Log4gAppenderSetName:
  * @self: A #Log4gAppender object.
@@ -256,6 +292,18 @@ typedef void
  * @get_layout: Get the layout for this appender.
  * @requires_layout: Determine if this appender requires a layout.
  * @activate_options: Activate all options set for this appender.
+ * @append_batch: Perform actual logging of several events.
+ * @do_append_batch: Log several events in an appender-specific way.
+ * @concurrent_append: Set to %TRUE if @append and @append_batch may be
+ *                     called from several threads at once. This field is
+ *                     not inherited, each class must set it in its
+ *                     class_init function.
+ *
+ * The closed check, threshold and filters are evaluated without taking a
+ * lock. Unless @concurrent_append is set the default @do_append and
+ * @do_append_batch implementations serialize calls to @append and
+ * @append_batch. Sub-classes that set @concurrent_append are responsible
+ * for their own locking, typically around the final write only.
  */
 struct Log4gAppenderClass_ {
 	/*< private >*/
@@ -274,6 +322,9 @@ struct Log4gAppenderClass_ {
 	Log4gAppenderGetLayout get_layout;
 	Log4gAppenderRequiresLayout requires_layout;
 	Log4gAppenderActivateOptions activate_options;
+	Log4gAppenderAppendBatch append_batch;
+	Log4gAppenderDoAppendBatch do_append_batch;
+	gboolean concurrent_append;
 };
 
 GType
@@ -321,6 +372,14 @@ log4g_appender_activate_options(Log4gAppender *self);
 void
 log4g_appender_append(Log4gAppender *self, Log4gLoggingEvent *event);
 
+void
+log4g_appender_do_append_batch(Log4gAppender *self, Log4gLoggingEvent **events,
+		guint n);
+
+void
+log4g_appender_append_batch(Log4gAppender *self, Log4gLoggingEvent **events,
+		guint n);
+
 Log4gFilter *
 log4g_appender_get_first_filter(Log4gAppender *self);
 
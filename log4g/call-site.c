@@ -0,0 +1,125 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: call-site
+ * @short_description: A registry of static logging statements
+ * @see_also: log4g_static_trace(), #Log4gBinaryLayout
+ *
+ * The log4g_static_trace() family of macros declare a static
+ * #Log4gCallSite for each logging statement. The level, location and
+ * format string of a call site never change, so they are registered once,
+ * the first time the statement is logged, and given a small integer
+ * identifier.
+ *
+ * Logging events created from a call site do not format their message.
+ * They keep a reference to the call site and a copy of the format
+ * parameters, and the message is rendered when a layout asks for it,
+ * which may be on the thread of an asynchronous appender. The binary layout
+ * goes further: it writes the call site once per file and afterwards only
+ * the call site identifier, time stamp and raw parameters of each event,
+ * leaving all formatting to the <command>log4g-decode</command> tool.
+ *
+ * Identifiers are assigned in the order call sites are first used, so they
+ * are only meaningful within one process.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "log4g/call-site.h"
+
+/* Protects the registry */
+static GMutex lock;
+
+/* Registered call sites, indexed by identifier - 1 */
+static GPtrArray *sites = NULL;
+
+/**
+ * log4g_call_site_register:
+ * @site: A call site with static storage duration.
+ *
+ * Assign an identifier to a call site. Registering a call site more than
+ * once returns the same identifier.
+ *
+ * This function is called by the logging macros, it is not usually called
+ * directly.
+ *
+ * Returns: The identifier of @site.
+ * Since: 0.1
+ */
+guint
+log4g_call_site_register(Log4gCallSite *site)
+{
+	g_return_val_if_fail(site, 0);
+	guint id = (guint)g_atomic_int_get(&site->id);
+	if (id) {
+		return id;
+	}
+	g_mutex_lock(&lock);
+	id = (guint)site->id;
+	if (!id) {
+		if (!sites) {
+			sites = g_ptr_array_new();
+		}
+		g_ptr_array_add(sites, site);
+		id = sites->len;
+		g_atomic_int_set(&site->id, (gint)id);
+	}
+	g_mutex_unlock(&lock);
+	return id;
+}
+
+/**
+ * log4g_call_site_lookup:
+ * @id: A call site identifier.
+ *
+ * Retrieve a registered call site.
+ *
+ * Returns: The call site identified by @id, or %NULL if @id has not been
+ *          assigned.
+ * Since: 0.1
+ */
+const Log4gCallSite *
+log4g_call_site_lookup(guint id)
+{
+	const Log4gCallSite *site = NULL;
+	g_mutex_lock(&lock);
+	if (sites && id && id <= sites->len) {
+		site = g_ptr_array_index(sites, id - 1);
+	}
+	g_mutex_unlock(&lock);
+	return site;
+}
+
+/**
+ * log4g_call_site_get_count:
+ *
+ * Determine how many call sites have been registered.
+ *
+ * Returns: The number of registered call sites, which is also the largest
+ *          assigned identifier.
+ * Since: 0.1
+ */
+guint
+log4g_call_site_get_count(void)
+{
+	g_mutex_lock(&lock);
+	guint count = (sites ? sites->len : 0);
+	g_mutex_unlock(&lock);
+	return count;
+}
@@ -0,0 +1,123 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG4G_CALL_SITE_H
+#define LOG4G_CALL_SITE_H
+
+#include <glib.h>
+#include <stddef.h>
+#include <stdint.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Log4gArgumentType:
+ * @LOG4G_ARGUMENT_NONE: Not a parameter ("%%" or the end of a list).
+ * @LOG4G_ARGUMENT_INT: An int (also char & short, and '*' width/precision).
+ * @LOG4G_ARGUMENT_LONG: A long ("l").
+ * @LOG4G_ARGUMENT_LLONG: A long long ("ll").
+ * @LOG4G_ARGUMENT_INTMAX: An intmax_t ("j").
+ * @LOG4G_ARGUMENT_SIZE: A size_t ("z").
+ * @LOG4G_ARGUMENT_PTRDIFF: A ptrdiff_t ("t").
+ * @LOG4G_ARGUMENT_DOUBLE: A double.
+ * @LOG4G_ARGUMENT_LDOUBLE: A long double ("L").
+ * @LOG4G_ARGUMENT_POINTER: A pointer ("%p").
+ * @LOG4G_ARGUMENT_STRING: A nul terminated string ("%s").
+ *
+ * The type of a captured printf format parameter.
+ */
+typedef enum {
+	LOG4G_ARGUMENT_NONE,
+	LOG4G_ARGUMENT_INT,
+	LOG4G_ARGUMENT_LONG,
+	LOG4G_ARGUMENT_LLONG,
+	LOG4G_ARGUMENT_INTMAX,
+	LOG4G_ARGUMENT_SIZE,
+	LOG4G_ARGUMENT_PTRDIFF,
+	LOG4G_ARGUMENT_DOUBLE,
+	LOG4G_ARGUMENT_LDOUBLE,
+	LOG4G_ARGUMENT_POINTER,
+	LOG4G_ARGUMENT_STRING
+} Log4gArgumentType;
+
+typedef struct Log4gArgument_ Log4gArgument;
+
+/**
+ * Log4gArgument:
+ * @type: The type of this parameter, selects a member of @value.
+ *
+ * A type-tagged copy of a printf format parameter. The members of @value
+ * are named after the printf length modifiers: @i (int), @l (long), @ll
+ * (long long), @j (intmax_t), @z (size_t), @t (ptrdiff_t), @d (double),
+ * @ld (long double), @p (pointer) and @s (string).
+ */
+struct Log4gArgument_ {
+	Log4gArgumentType type;
+	union {
+		gint i;
+		glong l;
+		long long ll;
+		intmax_t j;
+		gsize z;
+		ptrdiff_t t;
+		gdouble d;
+		long double ld;
+		gpointer p;
+		gchar *s;
+	} value;
+};
+
+typedef struct Log4gCallSite_ Log4gCallSite;
+
+/**
+ * Log4gCallSite:
+ * @id: The identifier of this call site, zero (0) until it is registered.
+ * @level: The integer log level of this call site.
+ * @function: The function containing this call site.
+ * @file: The file containing this call site.
+ * @line: The line in @file of this call site.
+ * @format: The printf format of this call site.
+ *
+ * The static description of one logging statement.
+ *
+ * Call sites are declared by the log4g_static_trace() family of macros.
+ * All strings have static storage duration.
+ */
+struct Log4gCallSite_ {
+	gint id;
+	gint level;
+	const gchar *function;
+	const gchar *file;
+	const gchar *line;
+	const gchar *format;
+	/*< private >*/
+	gint size;
+	gpointer types;
+};
+
+guint
+log4g_call_site_register(Log4gCallSite *site);
+
+const Log4gCallSite *
+log4g_call_site_lookup(guint id);
+
+guint
+log4g_call_site_get_count(void);
+
+G_END_DECLS
+
+#endif /* LOG4G_CALL_SITE_H */
@@ -0,0 +1,318 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: clock
+ * @short_description: Select the clock used to time stamp logging events
+ * @see_also: clock_gettime(2)
+ *
+ * Logging events are time stamped in nanoseconds since the Unix epoch. The
+ * clock source determines the cost and resolution of the time stamp:
+ * <itemizedlist>
+ * <listitem><para>realtime: the system wall clock (the
+ * default)</para></listitem>
+ * <listitem><para>realtime-coarse: the wall clock as of the last
+ * scheduler tick, cheapest but only millisecond resolution</para></listitem>
+ * <listitem><para>monotonic: the monotonic clock offset to the wall
+ * clock, events are ordered even if the wall clock is
+ * adjusted</para></listitem>
+ * <listitem><para>cycles: the CPU cycle counter converted with integer
+ * arithmetic, no system call or vDSO call is made</para></listitem>
+ * </itemizedlist>
+ *
+ * The cycle counter is calibrated against the monotonic clock when it is
+ * first selected, which takes about twenty milliseconds. It gives the best
+ * resolution and ordering across threads, but drifts slowly from the wall
+ * clock by the calibration error. If the CPU does not have an invariant
+ * counter the monotonic clock is used instead.
+ *
+ * The clock source may be set at start-up with the
+ * <emphasis>--log4g-clock</emphasis> command line argument, the
+ * <envar>LOG4G_CLOCK</envar> environment variable or the "clock" attribute
+ * of a DOM configuration.
+ *
+ * The clock source is shared by every logger repository. Events are time
+ * stamped when they are created, before the repository that will handle
+ * them is known, and one clock keeps the events of all repositories in
+ * order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "log4g/helpers/clock.h"
+#include <time.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define HAVE_CYCLES (1)
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define HAVE_CYCLES (1)
+#endif
+
+/** \brief Nanoseconds per second */
+#define NSEC (G_GINT64_CONSTANT(1000000000))
+
+/** \brief Cycle counter calibration time in microseconds */
+#define CALIBRATION (20000)
+
+#ifdef CLOCK_REALTIME_COARSE
+#define CLOCK_COARSE CLOCK_REALTIME_COARSE
+#else
+#define CLOCK_COARSE CLOCK_REALTIME
+#endif
+
+#ifdef CLOCK_MONOTONIC_RAW
+#define CLOCK_RAW CLOCK_MONOTONIC_RAW
+#else
+#define CLOCK_RAW CLOCK_MONOTONIC
+#endif
+
+static gint current = LOG4G_CLOCK_REALTIME;
+
+/* The wall clock minus the monotonic clock */
+static gint64 offset;
+
+/* Cycle counter calibration */
+static struct {
+	guint64 base; /* Counter value at 'epoch' */
+	gint64 epoch; /* Wall clock time at 'base' */
+	guint64 frequency; /* Counter frequency (Hz) */
+	guint64 scale; /* Nanoseconds per tick, 32.32 fixed point */
+} cycles;
+
+static const struct {
+	const gchar *name;
+	Log4gClockSource source;
+} names[] = {
+	{ "realtime", LOG4G_CLOCK_REALTIME },
+	{ "realtime-coarse", LOG4G_CLOCK_REALTIME_COARSE },
+	{ "coarse", LOG4G_CLOCK_REALTIME_COARSE },
+	{ "monotonic", LOG4G_CLOCK_MONOTONIC },
+	{ "cycles", LOG4G_CLOCK_CYCLES },
+	{ "tsc", LOG4G_CLOCK_CYCLES }
+};
+
+static inline gint64
+clock_(clockid_t id)
+{
+	struct timespec ts;
+	if (G_UNLIKELY(clock_gettime(id, &ts))) {
+		return g_get_real_time() * 1000;
+	}
+	return (ts.tv_sec * NSEC) + ts.tv_nsec;
+}
+
+#ifdef HAVE_CYCLES
+static inline guint64
+cycles_read_(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	guint32 lo, hi;
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((guint64)hi << 32) | lo;
+#else
+	guint64 value;
+	__asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(value)
+			:: "memory");
+	return value;
+#endif
+}
+
+/* Determine the counter frequency, returns zero if it is unusable */
+static guint64
+cycles_frequency_(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	guint eax, ebx, ecx, edx;
+	/* CPUID.80000007H:EDX[8] indicates an invariant TSC */
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)
+			|| !(edx & (1 << 8))) {
+		return 0;
+	}
+	gint64 t0 = clock_(CLOCK_RAW);
+	guint64 c0 = cycles_read_();
+	gint64 t1 = clock_(CLOCK_RAW);
+	g_usleep(CALIBRATION);
+	gint64 t2 = clock_(CLOCK_RAW);
+	guint64 c1 = cycles_read_();
+	gint64 t3 = clock_(CLOCK_RAW);
+	gint64 elapsed = ((t2 + t3) / 2) - ((t0 + t1) / 2);
+	if (elapsed <= 0 || c1 <= c0) {
+		return 0;
+	}
+	return (guint64)((gdouble)(c1 - c0) * NSEC / elapsed);
+#else
+	guint64 frequency;
+	__asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+	return frequency;
+#endif
+}
+#endif /* HAVE_CYCLES */
+
+static gsize
+monotonic_init_(void)
+{
+	static gsize once = 0;
+	if (g_once_init_enter(&once)) {
+		gint64 t0 = clock_(CLOCK_REALTIME);
+		gint64 monotonic = clock_(CLOCK_MONOTONIC);
+		gint64 t1 = clock_(CLOCK_REALTIME);
+		offset = ((t0 + t1) / 2) - monotonic;
+		g_once_init_leave(&once, 1);
+	}
+	return once;
+}
+
+static gsize
+cycles_init_(void)
+{
+	static gsize once = 0;
+	if (g_once_init_enter(&once)) {
+		gsize result = 1;
+#ifdef HAVE_CYCLES
+		guint64 frequency = cycles_frequency_();
+		if (frequency) {
+			gint64 t0 = clock_(CLOCK_REALTIME);
+			cycles.base = cycles_read_();
+			gint64 t1 = clock_(CLOCK_REALTIME);
+			cycles.epoch = (t0 + t1) / 2;
+			cycles.frequency = frequency;
+			cycles.scale = ((guint64)NSEC << 32) / frequency;
+			result = 2;
+		}
+#endif
+		g_once_init_leave(&once, result);
+	}
+	return once;
+}
+
+#ifdef HAVE_CYCLES
+static inline gint64
+cycles_get_time_(void)
+{
+	guint64 delta = cycles_read_() - cycles.base;
+#ifdef __SIZEOF_INT128__
+	return cycles.epoch
+		+ (gint64)(((unsigned __int128)delta * cycles.scale) >> 32);
+#else
+	guint64 seconds = delta / cycles.frequency;
+	guint64 remainder = delta % cycles.frequency;
+	return cycles.epoch + (gint64)(seconds * NSEC)
+		+ (gint64)((remainder * NSEC) / cycles.frequency);
+#endif
+}
+#endif /* HAVE_CYCLES */
+
+/**
+ * log4g_clock_set_source:
+ * @source: The new clock source.
+ *
+ * Set the clock used to time stamp logging events.
+ *
+ * If @source is %LOG4G_CLOCK_CYCLES and the CPU does not provide a usable
+ * cycle counter a warning is logged and %LOG4G_CLOCK_MONOTONIC is selected
+ * instead.
+ *
+ * Since: 0.1
+ */
+void
+log4g_clock_set_source(Log4gClockSource source)
+{
+	switch (source) {
+	case LOG4G_CLOCK_REALTIME:
+	case LOG4G_CLOCK_REALTIME_COARSE:
+		break;
+	case LOG4G_CLOCK_CYCLES:
+		if (2 == cycles_init_()) {
+			break;
+		}
+		log4g_log_warn(Q_("cycle counter is not available, "
+					"using the monotonic clock"));
+		source = LOG4G_CLOCK_MONOTONIC;
+		/* fall through */
+	case LOG4G_CLOCK_MONOTONIC:
+		monotonic_init_();
+		break;
+	default:
+		g_return_if_reached();
+	}
+	g_atomic_int_set(&current, source);
+}
+
+/**
+ * log4g_clock_get_source:
+ *
+ * Retrieve the clock used to time stamp logging events.
+ *
+ * Returns: The current clock source.
+ * Since: 0.1
+ */
+Log4gClockSource
+log4g_clock_get_source(void)
+{
+	return g_atomic_int_get(&current);
+}
+
+/**
+ * log4g_clock_set_source_name:
+ * @name: The name of a clock source.
+ *
+ * Set the clock source by name. Valid names are "realtime",
+ * "realtime-coarse" (or "coarse"), "monotonic" and "cycles" (or "tsc").
+ *
+ * See: log4g_clock_set_source()
+ *
+ * Returns: %TRUE if @name is a valid clock source, %FALSE otherwise.
+ * Since: 0.1
+ */
+gboolean
+log4g_clock_set_source_name(const gchar *name)
+{
+	g_return_val_if_fail(name, FALSE);
+	for (guint i = 0; i < G_N_ELEMENTS(names); ++i) {
+		if (!g_ascii_strcasecmp(name, names[i].name)) {
+			log4g_clock_set_source(names[i].source);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * log4g_clock_get_time:
+ *
+ * Read the current clock source.
+ *
+ * Returns: The number of nanoseconds elapsed since the Unix epoch.
+ * Since: 0.1
+ */
+gint64
+log4g_clock_get_time(void)
+{
+	switch (g_atomic_int_get(&current)) {
+	case LOG4G_CLOCK_REALTIME_COARSE:
+		return clock_(CLOCK_COARSE);
+	case LOG4G_CLOCK_MONOTONIC:
+		return clock_(CLOCK_MONOTONIC) + offset;
+#ifdef HAVE_CYCLES
+	case LOG4G_CLOCK_CYCLES:
+		return cycles_get_time_();
+#endif
+	default:
+		return clock_(CLOCK_REALTIME);
+	}
+}
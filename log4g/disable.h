@@ -81,12 +81,42 @@ G_BEGIN_DECLS
 
 #define log4g_logger_fatal(logger, format, args...)
 
+#define log4g_static_trace(format, args...)
+
+#define log4g_logger_static_trace(logger, format, args...)
+
+#define log4g_static_debug(format, args...)
+
+#define log4g_logger_static_debug(logger, format, args...)
+
+#define log4g_static_info(format, args...)
+
+#define log4g_logger_static_info(logger, format, args...)
+
+#define log4g_static_warn(format, args...)
+
+#define log4g_logger_static_warn(logger, format, args...)
+
+#define log4g_static_error(format, args...)
+
+#define log4g_logger_static_error(logger, format, args...)
+
+#define log4g_static_fatal(format, args...)
+
+#define log4g_logger_static_fatal(logger, format, args...)
+
 /* log4g/mdc.h definitions */
 
+#define log4g_mdc_key_register(key) (0)
+
 #define log4g_mdc_put(key, value, args...)
 
+#define log4g_mdc_put_by_id(key, value, args...)
+
 #define log4g_mdc_get(key) (NULL)
 
+#define log4g_mdc_get_by_id(key) (NULL)
+
 #define log4g_mdc_remove(key)
 
 /* log4g/ndc.h definitions */
@@ -63,6 +63,14 @@
  * &lt;log4g:configuration debug="true"&gt;
  * &lt;/log4g:configuration&gt;
  * ]|
+ *
+ * The "clock" attribute of the log4g:configuration element selects the
+ * clock used to time stamp logging events, see log4g_clock_set_source_name()
+ * for the valid names:
+ * |[
+ * &lt;log4g:configuration clock="monotonic"&gt;
+ * &lt;/log4g:configuration&gt;
+ * ]|
  */
 
 #ifdef HAVE_CONFIG_H
@@ -72,6 +80,7 @@
 #include <libxml/parser.h>
 #include "log4g/dom-configurator.h"
 #include "log4g/error.h"
+#include "log4g/helpers/clock.h"
 #include "log4g/interface/appender-attachable.h"
 #include "log4g/log-manager.h"
 
@@ -782,6 +791,15 @@ do_configure(Log4gConfigurator *base,
 		}
 		xmlFree(att);
 	}
+	att = xmlGetProp(node, (const xmlChar *)"clock");
+	if (att) {
+		if (xmlStrcmp(att, (const xmlChar *)"null")
+				&& !log4g_clock_set_source_name(
+					(const gchar *)att)) {
+			log4g_log_error(Q_("%s: invalid clock source"), att);
+		}
+		xmlFree(att);
+	}
 	/* parse document */
 	node = node->xmlChildrenNode;
 	while (node) {
@@ -0,0 +1,250 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: hazard
+ * @short_description: Hazard pointers for read-mostly data
+ * @title: Log4gHazard
+ * @section_id: Log4gHazard
+ *
+ * This API allows Log4g to publish immutable snapshots of read-mostly data
+ * (e.g. the appenders attached to a logger) that may be read without
+ * locking.
+ *
+ * Writers build a new snapshot, swap it in atomically and retire the old
+ * one with log4g_hazard_retire(). Readers protect a snapshot with
+ * log4g_hazard_acquire() before using it and drop the protection with
+ * log4g_hazard_release(). A retired snapshot is not destroyed while any
+ * thread is protecting it.
+ *
+ * Each thread may hold a small number of nested protections. Deeper
+ * nesting falls back to a lock that blocks reclamation.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "log4g/helpers/hazard.h"
+
+/* The number of hazard pointers available to each thread */
+#define HAZARD_MAX (8)
+
+/* The hazard pointers of one thread */
+typedef struct Record_ {
+	gpointer slot[HAZARD_MAX];
+	guint depth; /* The number of slots in use */
+	guint overflow; /* The number of protections held by 'lock' */
+	gint active; /* This record is owned by a thread */
+	struct Record_ *next;
+} Record;
+
+/* A retired pointer waiting to be destroyed */
+typedef struct Retired_ {
+	gpointer pointer;
+	GDestroyNotify destroy;
+	struct Retired_ *next;
+} Retired;
+
+/* All hazard pointer records, records are never freed */
+static Record *records = NULL;
+
+/* Pointers waiting to be destroyed */
+static Retired *retired = NULL;
+
+/* Held during reclamation & by readers that run out of slots */
+static GRecMutex lock;
+
+static void
+record_release_(gpointer data)
+{
+	Record *self = data;
+	for (guint i = 0; i < HAZARD_MAX; ++i) {
+		g_atomic_pointer_set(&self->slot[i], NULL);
+	}
+	while (self->overflow) {
+		--self->overflow;
+		g_rec_mutex_unlock(&lock);
+	}
+	self->depth = 0;
+	g_atomic_int_set(&self->active, FALSE);
+}
+
+static GPrivate current = G_PRIVATE_INIT(record_release_);
+
+/**
+ * record_get_:
+ *
+ * Retrieve the hazard pointer record of the calling thread. Records
+ * released by exited threads are reused.
+ *
+ * Returns: The hazard pointer record of the calling thread.
+ */
+static Record *
+record_get_(void)
+{
+	Record *self = g_private_get(&current);
+	if (G_LIKELY(self)) {
+		return self;
+	}
+	for (self = g_atomic_pointer_get(&records); self; self = self->next) {
+		if (g_atomic_int_compare_and_exchange(&self->active,
+					FALSE, TRUE)) {
+			break;
+		}
+	}
+	if (!self) {
+		self = g_new0(Record, 1);
+		self->active = TRUE;
+		do {
+			self->next = g_atomic_pointer_get(&records);
+		} while (!g_atomic_pointer_compare_and_exchange(&records,
+					self->next, self));
+	}
+	g_private_set(&current, self);
+	return self;
+}
+
+/**
+ * log4g_hazard_acquire:
+ * @location: The location of a pointer to a snapshot.
+ *
+ * Load and protect the snapshot stored at @location.
+ *
+ * The returned snapshot will not be destroyed until the calling thread
+ * calls log4g_hazard_release(). Protections nest and must be released in
+ * the reverse order they were acquired.
+ *
+ * Returns: The snapshot stored at @location (may be %NULL).
+ */
+gpointer
+log4g_hazard_acquire(gpointer *location)
+{
+	Record *self = record_get_();
+	if (G_UNLIKELY(self->depth == HAZARD_MAX)) {
+		g_rec_mutex_lock(&lock);
+		++self->overflow;
+		return g_atomic_pointer_get(location);
+	}
+	gpointer *slot = &self->slot[self->depth++];
+	gpointer pointer;
+	do {
+		pointer = g_atomic_pointer_get(location);
+		g_atomic_pointer_set(slot, pointer);
+	} while (pointer != g_atomic_pointer_get(location));
+	return pointer;
+}
+
+/**
+ * log4g_hazard_release:
+ *
+ * Release the most recent protection acquired by the calling thread.
+ *
+ * See: log4g_hazard_acquire()
+ */
+void
+log4g_hazard_release(void)
+{
+	Record *self = g_private_get(&current);
+	g_return_if_fail(self && (self->depth || self->overflow));
+	if (G_UNLIKELY(self->overflow)) {
+		--self->overflow;
+		g_rec_mutex_unlock(&lock);
+		return;
+	}
+	g_atomic_pointer_set(&self->slot[--self->depth], NULL);
+}
+
+/**
+ * is_protected_:
+ * @pointer: A retired pointer.
+ *
+ * Determine if any thread is protecting @pointer.
+ *
+ * Returns: %TRUE if @pointer is protected, %FALSE otherwise.
+ */
+static gboolean
+is_protected_(gpointer pointer)
+{
+	for (Record *r = g_atomic_pointer_get(&records); r; r = r->next) {
+		for (guint i = 0; i < HAZARD_MAX; ++i) {
+			if (g_atomic_pointer_get(&r->slot[i]) == pointer) {
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * log4g_hazard_retire:
+ * @pointer: A snapshot that has been replaced.
+ * @destroy: The function used to destroy @pointer.
+ *
+ * Destroy a snapshot once it is no longer protected by any thread.
+ *
+ * The caller must have already replaced @pointer so that new readers
+ * cannot acquire it. Retired snapshots that are still protected are
+ * destroyed by a later call to this function or to
+ * log4g_hazard_reclaim().
+ */
+void
+log4g_hazard_retire(gpointer pointer, GDestroyNotify destroy)
+{
+	if (!pointer) {
+		return;
+	}
+	Retired *node = g_slice_new(Retired);
+	node->pointer = pointer;
+	node->destroy = destroy;
+	g_rec_mutex_lock(&lock);
+	node->next = retired;
+	retired = node;
+	g_rec_mutex_unlock(&lock);
+	log4g_hazard_reclaim();
+}
+
+/**
+ * log4g_hazard_reclaim:
+ *
+ * Destroy all retired snapshots that are no longer protected.
+ */
+void
+log4g_hazard_reclaim(void)
+{
+	Retired *dead = NULL;
+	g_rec_mutex_lock(&lock);
+	Retired **node = &retired;
+	while (*node) {
+		Retired *candidate = *node;
+		if (is_protected_(candidate->pointer)) {
+			node = &candidate->next;
+		} else {
+			*node = candidate->next;
+			candidate->next = dead;
+			dead = candidate;
+		}
+	}
+	g_rec_mutex_unlock(&lock);
+	while (dead) {
+		Retired *next = dead->next;
+		if (dead->destroy) {
+			dead->destroy(dead->pointer);
+		}
+		g_slice_free(Retired, dead);
+		dead = next;
+	}
+}
@@ -85,6 +85,11 @@ guint
 log4g_appender_attachable_impl_append_loop_on_appenders(
 		Log4gAppenderAttachable *base, Log4gLoggingEvent *event);
 
+guint
+log4g_appender_attachable_impl_append_batch_loop_on_appenders(
+		Log4gAppenderAttachable *base, Log4gLoggingEvent **events,
+		guint n);
+
 G_END_DECLS
 
 #endif /* LOG4G_APPENDER_ATTACHABLE_IMPL_H */
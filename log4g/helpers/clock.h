@@ -0,0 +1,62 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG4G_CLOCK_H
+#define LOG4G_CLOCK_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Log4gClockSource:
+ * @LOG4G_CLOCK_REALTIME: The system wall clock.
+ * @LOG4G_CLOCK_REALTIME_COARSE: A faster, lower resolution wall clock
+ *                               (typically one scheduler tick).
+ * @LOG4G_CLOCK_MONOTONIC: The monotonic clock, offset to the wall clock
+ *                         when the source was selected.
+ * @LOG4G_CLOCK_CYCLES: The CPU cycle counter (rdtsc on x86, cntvct on ARM),
+ *                      calibrated against the monotonic clock.
+ *
+ * Clock sources used to time stamp logging events.
+ *
+ * All sources return nanoseconds since the Unix epoch. The monotonic and
+ * cycle counter sources never go backwards, but do not follow adjustments
+ * made to the wall clock after they were selected.
+ */
+typedef enum {
+	LOG4G_CLOCK_REALTIME,
+	LOG4G_CLOCK_REALTIME_COARSE,
+	LOG4G_CLOCK_MONOTONIC,
+	LOG4G_CLOCK_CYCLES
+} Log4gClockSource;
+
+void
+log4g_clock_set_source(Log4gClockSource source);
+
+Log4gClockSource
+log4g_clock_get_source(void);
+
+gboolean
+log4g_clock_set_source_name(const gchar *name);
+
+gint64
+log4g_clock_get_time(void);
+
+G_END_DECLS
+
+#endif /* LOG4G_CLOCK_H */
@@ -0,0 +1,39 @@
+/* Copyright 2010 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG4G_HAZARD_H
+#define LOG4G_HAZARD_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gpointer
+log4g_hazard_acquire(gpointer *location);
+
+void
+log4g_hazard_release(void);
+
+void
+log4g_hazard_retire(gpointer pointer, GDestroyNotify destroy);
+
+void
+log4g_hazard_reclaim(void);
+
+G_END_DECLS
+
+#endif /* LOG4G_HAZARD_H */
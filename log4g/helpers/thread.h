@@ -72,6 +72,12 @@ struct Log4gThreadClass_ {
 GType
 log4g_thread_get_type(void) G_GNUC_CONST;
 
+guint
+log4g_thread_get_id(void);
+
+gint
+log4g_thread_get_tid(void);
+
 const gchar *
 log4g_thread_get_name(void);
 
@@ -36,6 +36,9 @@
  * a provision node (#Log4gProvisionNode) is created for the ancestor and
  * the descendant is added to the provision node. Other descendants of the
  * same ancestor are added to the previously created provision node.
+ *
+ * Logger names are interned (see g_intern_string()). The hierarchy table
+ * borrows the interned names of its loggers rather than copying them.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -116,20 +119,14 @@ update_parents(Log4gHierarchy *self, Log4gLogger *logger)
 		*dot = '\0';
 		GObject *object = g_hash_table_lookup(priv->table, name);
 		if (!object) {
-			gchar *key;
 			Log4gProvisionNode *node =
 				log4g_provision_node_new(logger);
 			if (!node) {
 				status = FALSE;
 				goto exit;
 			}
-			key = g_strdup(name);
-			if (!key) {
-				g_object_unref(node);
-				status = FALSE;
-				goto exit;
-			}
-			g_hash_table_insert(priv->table, key, node);
+			g_hash_table_insert(priv->table,
+					(gpointer)g_intern_string(name), node);
 		} else if (LOG4G_IS_LOGGER(object)) {
 			log4g_logger_set_parent(logger, LOG4G_LOGGER(object));
 			found = TRUE;
@@ -161,8 +158,9 @@ update_children(G_GNUC_UNUSED Log4gHierarchy *self, Log4gProvisionNode *node,
 		if (!child) {
 			continue;
 		}
-		const gchar *name = log4g_logger_get_name(logger);
-		if (!g_strcmp0(log4g_logger_get_name(child), name)) {
+		/* logger names are interned */
+		if (log4g_logger_get_name(child)
+				== log4g_logger_get_name(logger)) {
 			log4g_logger_set_parent(logger,
 					log4g_logger_get_parent(child));
 			log4g_logger_set_parent(child, logger);
@@ -180,7 +178,6 @@ get_logger_factory(Log4gLoggerRepository *base, const gchar *name,
 	g_mutex_lock(&priv->lock);
 	GObject *object = g_hash_table_lookup(priv->table, name);
 	if (!object) {
-		gchar *key;
 		logger = log4g_logger_factory_make_new_logger_instance(factory,
 				name);
 		if (!logger) {
@@ -192,17 +189,11 @@ get_logger_factory(Log4gLoggerRepository *base, const gchar *name,
 			logger = NULL;
 			goto exit;
 		}
-		key = g_strdup(name);
-		if (!key) {
-			g_object_unref(logger);
-			logger = NULL;
-			goto exit;
-		}
-		g_hash_table_insert(priv->table, key, logger);
+		g_hash_table_insert(priv->table,
+				(gpointer)log4g_logger_get_name(logger), logger);
 	} else if (LOG4G_IS_LOGGER(object)) {
 		logger = LOG4G_LOGGER(object);
 	} else if (LOG4G_IS_PROVISION_NODE(object)) {
-		gchar *key;
 		Log4gProvisionNode *node = LOG4G_PROVISION_NODE(object);
 		logger = log4g_logger_factory_make_new_logger_instance(factory,
 				name);
@@ -216,13 +207,8 @@ get_logger_factory(Log4gLoggerRepository *base, const gchar *name,
 			logger = NULL;
 			goto exit;
 		}
-		key = g_strdup(name);
-		if (!key) {
-			g_object_unref(logger);
-			logger = NULL;
-			goto exit;
-		}
-		g_hash_table_insert(priv->table, key, logger);
+		g_hash_table_insert(priv->table,
+				(gpointer)log4g_logger_get_name(logger), logger);
 	} else {
 		/* should be unreachable */
 	}
@@ -264,6 +250,7 @@ set_threshold(Log4gLoggerRepository *base, Log4gLevel *level)
 		g_object_ref(level);
 		priv->threshold = level;
 		priv->threshold_int = log4g_level_to_int(level);
+		log4g_logger_invalidate_thresholds();
 	}
 }
 
@@ -371,8 +358,9 @@ log4g_hierarchy_init(Log4gHierarchy *self)
 	self->priv = ASSIGN_PRIVATE(self);
 	struct Private *priv = GET_PRIVATE(self);
 	priv->root = NULL;
+	/* keys are interned logger names */
 	priv->table = g_hash_table_new_full(g_str_hash, g_str_equal,
-			g_free, g_object_unref);
+			NULL, g_object_unref);
 	priv->factory = log4g_default_logger_factory_new();
 	priv->threshold = NULL;
 	priv->threshold_int = 0;
@@ -24,6 +24,20 @@
  * Many appenders require a layout in order to log an event. Sub-classes
  * must override the Log4gLayoutClass_::format() virtual function to implement
  * custom formatting.
+ *
+ * Appenders that format events concurrently use
+ * Log4gLayoutClass_::format_to(). Layouts that can format without shared
+ * state should override it, the default implementation serializes calls to
+ * Log4gLayoutClass_::format().
+ *
+ * When an event is written by several appenders, layouts that produce the
+ * same output may share it. A layout whose output depends only on the event
+ * declares a fingerprint with log4g_layout_set_fingerprint(), e.g.
+ * #Log4gPatternLayout uses its type and conversion pattern. While two or
+ * more layouts have the same fingerprint, log4g_layout_format_to() caches
+ * their output in the event, so it is formatted at most once per event.
+ * The cache is stored inside the event, layouts that share a fingerprint
+ * but not events pay for a copy of their output, not an allocation.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -33,10 +47,53 @@
 
 G_DEFINE_ABSTRACT_TYPE(Log4gLayout, log4g_layout, G_TYPE_OBJECT)
 
+/* The instance structure has no priv pointer, adding one would change the
+ * size of Log4gLayout and break layouts built against earlier headers */
+#define GET_PRIVATE(instance) \
+	(G_TYPE_INSTANCE_GET_PRIVATE(instance, LOG4G_TYPE_LAYOUT, \
+		struct Private))
+
+/* Layouts that share a fingerprint */
+struct Fingerprint {
+	const gchar *name; /* Interned */
+	gint count; /* The number of layouts using this fingerprint */
+};
+
+struct Private {
+	GMutex lock; /* Serializes format() in the default format_to() */
+	struct Fingerprint *fingerprint;
+};
+
+/* Protects 'fingerprints' */
+static GMutex lock;
+
+/* All fingerprints that have been used, never freed */
+static GHashTable *fingerprints = NULL;
+
 static void
-log4g_layout_init(G_GNUC_UNUSED Log4gLayout *self)
+log4g_layout_init(Log4gLayout *self)
 {
-	/* do nothing */
+	g_mutex_init(&GET_PRIVATE(self)->lock);
+}
+
+static void
+finalize(GObject *base)
+{
+	log4g_layout_set_fingerprint(LOG4G_LAYOUT(base), NULL);
+	g_mutex_clear(&GET_PRIVATE(base)->lock);
+	G_OBJECT_CLASS(log4g_layout_parent_class)->finalize(base);
+}
+
+static void
+format_to(Log4gLayout *self, Log4gLoggingEvent *event, GString *string)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	g_mutex_lock(&priv->lock);
+	const gchar *message = log4g_layout_format(self, event);
+	if (message) {
+		g_string_append(string, message);
+	}
+	g_mutex_unlock(&priv->lock);
 }
 
 static const gchar *
@@ -60,11 +117,15 @@ activate_options(G_GNUC_UNUSED Log4gLayout *self)
 static void
 log4g_layout_class_init(Log4gLayoutClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = finalize;
 	klass->format = NULL;
 	klass->get_content_type = get_content_type;
 	klass->get_header = get;
 	klass->get_footer = get;
 	klass->activate_options = activate_options;
+	klass->format_to = format_to;
+	g_type_class_add_private(klass, sizeof(struct Private));
 }
 
 /**
@@ -84,6 +145,88 @@ log4g_layout_format(Log4gLayout *self, Log4gLoggingEvent *event)
 	return LOG4G_LAYOUT_GET_CLASS(self)->format(self, event);
 }
 
+/**
+ * log4g_layout_format_to:
+ * @self: A layout object.
+ * @event: A logging event object to be laid out.
+ * @string: The buffer to append the formatted event to.
+ *
+ * Calls the @format_to function from the #Log4gLayoutClass of @self,
+ * unless another layout with the same fingerprint has already formatted
+ * @event (see log4g_layout_set_fingerprint()).
+ *
+ * Since: 0.1
+ */
+void
+log4g_layout_format_to(Log4gLayout *self, Log4gLoggingEvent *event,
+		GString *string)
+{
+	g_return_if_fail(LOG4G_IS_LAYOUT(self));
+	g_return_if_fail(string);
+	struct Fingerprint *fingerprint =
+		g_atomic_pointer_get(&GET_PRIVATE(self)->fingerprint);
+	if (!fingerprint || g_atomic_int_get(&fingerprint->count) < 2) {
+		/* no other layout can reuse the output */
+		LOG4G_LAYOUT_GET_CLASS(self)->format_to(self, event, string);
+		return;
+	}
+	gsize length;
+	const gchar *output = log4g_logging_event_get_cached_output(event,
+			fingerprint->name, &length);
+	if (output) {
+		g_string_append_len(string, output, length);
+		return;
+	}
+	gsize start = string->len;
+	LOG4G_LAYOUT_GET_CLASS(self)->format_to(self, event, string);
+	log4g_logging_event_set_cached_output(event, fingerprint->name,
+			string->str + start, string->len - start);
+}
+
+/**
+ * log4g_layout_set_fingerprint:
+ * @self: A layout object.
+ * @fingerprint: (allow-none): A string that identifies the output of @self,
+ *               or %NULL if the output may not be shared.
+ *
+ * Declare that @self formats every event exactly like any other layout
+ * with the same @fingerprint. The fingerprint should include the type name
+ * of the layout and every option that changes its output.
+ *
+ * Layouts must only set a fingerprint if their output depends on nothing
+ * but the event, e.g. not on the number of events formatted so far.
+ * Sub-classes call this function when their options change.
+ *
+ * Since: 0.1
+ */
+void
+log4g_layout_set_fingerprint(Log4gLayout *self, const gchar *fingerprint)
+{
+	g_return_if_fail(LOG4G_IS_LAYOUT(self));
+	struct Private *priv = GET_PRIVATE(self);
+	g_mutex_lock(&lock);
+	if (priv->fingerprint) {
+		g_atomic_int_add(&priv->fingerprint->count, -1);
+	}
+	struct Fingerprint *entry = NULL;
+	if (fingerprint) {
+		if (!fingerprints) {
+			fingerprints = g_hash_table_new(NULL, NULL);
+		}
+		const gchar *name = g_intern_string(fingerprint);
+		entry = g_hash_table_lookup(fingerprints, name);
+		if (!entry) {
+			entry = g_new0(struct Fingerprint, 1);
+			entry->name = name;
+			g_hash_table_insert(fingerprints, (gpointer)name,
+					entry);
+		}
+		g_atomic_int_inc(&entry->count);
+	}
+	g_atomic_pointer_set(&priv->fingerprint, entry);
+	g_mutex_unlock(&lock);
+}
+
 /**
  * log4g_layout_get_content_type:
  * @self: A layout object.
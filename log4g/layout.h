@@ -72,6 +72,25 @@ struct Log4gLayout_ {
 typedef gchar *
 (*Log4gLayoutFormat)(Log4gLayout *self, Log4gLoggingEvent *event);
 
+/**
+ * Log4gLayoutFormatTo:
+ * @self: A layout object.
+ * @event: A logging event object to be laid out.
+ * @string: The buffer to append the formatted event to.
+ *
+ * Append the formatted logging event to a caller supplied buffer.
+ *
+ * Unlike @format this function must not use any state that is shared
+ * between callers, appenders call it concurrently from several threads
+ * with a per-thread buffer. The base class calls @format while holding a
+ * per-layout lock and appends the result.
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gLayoutFormatTo)(Log4gLayout *self, Log4gLoggingEvent *event,
+		GString *string);
+
 /**
  * Log4gLayoutGetContentType:
  * @self: A layout object.
@@ -132,6 +151,7 @@ typedef void
  * @get_header: Retrieve the header for this layout.
  * @get_footer: Retrieve the footer for this layout.
  * @activate_options: Activate all options set for this layout.
+ * @format_to: Append the formatted event to a buffer, reentrantly.
  */
 struct Log4gLayoutClass_ {
 	/*< private >*/
@@ -142,6 +162,7 @@ struct Log4gLayoutClass_ {
 	Log4gLayoutGetHeader get_header;
 	Log4gLayoutGetFooter get_footer;
 	Log4gLayoutActivateOptions activate_options;
+	Log4gLayoutFormatTo format_to;
 };
 
 GType
@@ -150,6 +171,10 @@ log4g_layout_get_type(void) G_GNUC_CONST;
 gchar *
 log4g_layout_format(Log4gLayout *self, Log4gLoggingEvent *event);
 
+void
+log4g_layout_format_to(Log4gLayout *self, Log4gLoggingEvent *event,
+		GString *string);
+
 const gchar *
 log4g_layout_get_content_type(Log4gLayout *self);
 
@@ -162,6 +187,9 @@ log4g_layout_get_footer(Log4gLayout *self);
 void
 log4g_layout_activate_options(Log4gLayout *self);
 
+void
+log4g_layout_set_fingerprint(Log4gLayout *self, const gchar *fingerprint);
+
 G_END_DECLS
 
 #endif /* LOG4G_LAYOUT_H */
@@ -63,6 +63,7 @@
 #include <locale.h>
 #include "log4g/basic-configurator.h"
 #include "log4g/dom-configurator.h"
+#include "log4g/helpers/clock.h"
 #include "log4g/helpers/thread.h"
 #include "log4g/log-manager.h"
 #include "log4g/log4g.h"
@@ -73,14 +74,16 @@ static gboolean initialized = FALSE;
 
 /* Option flags */
 typedef enum {
-	LOG4G_FLAG_DEBUG, /* Enable debug output */
-	LOG4G_FLAG_QUIET /* Enable quiet mode */
+	LOG4G_FLAG_DEBUG = 1 << 0, /* Enable debug output */
+	LOG4G_FLAG_QUIET = 1 << 1, /* Enable quiet mode */
+	LOG4G_FLAG_DEFERRED = 1 << 2 /* Enable deferred formatting */
 } Log4gFlag;
 
 /* Option flag definitions */
 static const GDebugKey flags[] = {
 	{ "debug", LOG4G_FLAG_DEBUG },
-	{ "quiet", LOG4G_FLAG_QUIET }
+	{ "quiet", LOG4G_FLAG_QUIET },
+	{ "deferred", LOG4G_FLAG_DEFERRED }
 };
 
 /* Configuration options */
@@ -88,6 +91,7 @@ typedef struct Options_ {
 	gchar *configuration; /* Configuration file name */
 	gint flags; /* Configuration flags */
 	gchar *thread; /* Main thread name */
+	gchar *clock; /* Clock source name */
 } Options;
 
 static Options *
@@ -100,6 +104,7 @@ options_new(void)
 	self->configuration = NULL;
 	self->flags = 0;
 	self->thread = NULL;
+	self->clock = NULL;
 	return self;
 }
 
@@ -110,6 +115,7 @@ options_destroy(gpointer object)
 	if (self) {
 		g_free(self->configuration);
 		g_free(self->thread);
+		g_free(self->clock);
 		g_slice_free(Options, self);
 	}
 }
@@ -147,6 +153,19 @@ log4g_arg_main_thread_cb(G_GNUC_UNUSED const gchar *key, const gchar *value,
 	return TRUE;
 }
 
+static gboolean
+log4g_arg_clock_cb(G_GNUC_UNUSED const gchar *key, const gchar *value,
+		gpointer data)
+{
+	Options *opt = (Options *)data;
+	g_free(opt->clock);
+	opt->clock = g_strdup(value);
+	if (!opt->clock) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static const GOptionEntry log4g_args[] = {
 	{ "log4g-configuration", '\0', G_OPTION_FLAG_FILENAME,
 		G_OPTION_ARG_CALLBACK, log4g_arg_configuration_cb,
@@ -157,6 +176,9 @@ static const GOptionEntry log4g_args[] = {
 	{ "log4g-main-thread", '\0', 0,
 		G_OPTION_ARG_CALLBACK, log4g_arg_main_thread_cb,
 		N_("Set the name of the main thread"), N_("NAME") },
+	{ "log4g-clock", '\0', 0,
+		G_OPTION_ARG_CALLBACK, log4g_arg_clock_cb,
+		N_("Clock used to time stamp events"), N_("CLOCK") },
 	{ NULL, '\0', 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
 };
 
@@ -174,6 +196,13 @@ pre_parse_hook(G_GNUC_UNUSED GOptionContext *context,
 		opt->flags =
 			g_parse_debug_string(env, flags, G_N_ELEMENTS(flags));
 	}
+	env = g_getenv("LOG4G_CLOCK");
+	if (env) {
+		opt->clock = g_strdup(env);
+		if (!opt->clock) {
+			return FALSE;
+		}
+	}
 	env = g_getenv("LOG4G_CONFIGURATION");
 	if (env) {
 		opt->configuration = g_strdup(env);
@@ -199,6 +228,12 @@ post_parse_hook(G_GNUC_UNUSED GOptionContext *context,
 	if (opt->flags & LOG4G_FLAG_QUIET) {
 		log4g_set_quiet_mode(TRUE);
 	}
+	if (opt->flags & LOG4G_FLAG_DEFERRED) {
+		log4g_logging_event_set_deferred_formatting(TRUE);
+	}
+	if (opt->clock && !log4g_clock_set_source_name(opt->clock)) {
+		log4g_log_warn(Q_("%s: invalid clock source"), opt->clock);
+	}
 	gboolean cfg = FALSE;
 	log4g_thread_set_name((opt->thread ? opt->thread : "main"));
 	if (opt->configuration) {
@@ -355,16 +390,25 @@ log4g_get_option_group(void)
  * <emphasis>--log4g-flags=&lt;FLAGS&gt;</emphasis>
  *
  * Specify flags that modify the behavior of Log4g. Currently Log4g
- * understands two flags.
+ * understands three flags.
  * <itemizedlist>
  * <listitem><para>debug: enable debug output on stdout</para></listitem>
  * <listitem><para>quiet: disable all error and debug output</para></listitem>
+ * <listitem><para>deferred: defer formatting of log messages (see
+ * log4g_logging_event_set_deferred_formatting())</para></listitem>
  * </itemizedlist>
  *
  * <emphasis>--log4g-main-thread=&lt;NAME&gt;</emphasis>
  *
  * Set the name of the main thread (the default is "main").
  *
+ * <emphasis>--log4g-clock=&lt;CLOCK&gt;</emphasis>
+ *
+ * Select the clock used to time stamp logging events, one of "realtime"
+ * (the default), "realtime-coarse", "monotonic" or "cycles" (see
+ * log4g_clock_set_source()). The clock may also be selected with the
+ * <envar>LOG4G_CLOCK</envar> environment variable.
+ *
  * After calling this function the Log4g API is ready for use within your
  * application.
  *
@@ -19,6 +19,7 @@
 #define LOG4G_H
 #ifndef LOG4G_DISABLE
 
+#include <log4g/call-site.h>
 #include <log4g/error.h>
 #include <log4g/filter.h>
 #include <log4g/appender.h>
@@ -65,6 +66,37 @@ G_BEGIN_DECLS
 	log4g_logger_get_root_logger()
 #endif /* LOG4G_LOG_DOMAIN */
 
+/**
+ * log4g_is_enabled_:
+ * @level: An integer log level.
+ *
+ * Determine if @level is enabled for the logger of the defined domain.
+ *
+ * Each call site keeps a static cache of the result tagged with the
+ * generation of the logger hierarchy (see log4g_logger_get_generation()).
+ * While the hierarchy is unchanged the check costs two loads and a compare,
+ * and the logger for the domain is not looked up at all.
+ *
+ * This macro is meant to used internally.
+ *
+ * Returns: %TRUE if @level is enabled, %FALSE otherwise.
+ * Since: 0.1
+ */
+#define log4g_is_enabled_(level) \
+	({ \
+		static gint log4g_site_ = 0; \
+		guint log4g_tag_ = (guint)g_atomic_int_get(&log4g_site_); \
+		guint log4g_gen_ = (guint)log4g_logger_get_generation() << 1; \
+		if (G_UNLIKELY((log4g_tag_ & ~1u) != log4g_gen_)) { \
+			log4g_tag_ = log4g_gen_ | \
+				(log4g_logger_is_enabled_for_( \
+					log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+					(level)) ? 1u : 0u); \
+			g_atomic_int_set(&log4g_site_, (gint)log4g_tag_); \
+		} \
+		(gboolean)(log4g_tag_ & 1u); \
+	})
+
 void
 log4g_init(int *argc, char ***argv);
 
@@ -123,9 +155,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_assert(assertion, format, args...) \
-	log4g_logger_assert_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			(assertion), G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		if (!(assertion) && log4g_is_enabled_(LOG4G_LEVEL_ERROR_INT)) { \
+			log4g_logger_assert_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				FALSE, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_assert:
@@ -148,8 +185,15 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_assert(logger, assertion, format, args...) \
-	log4g_logger_trace_(logger, (assertion), G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (!(assertion) && log4g_logger_is_enabled_for_(log4g_logger_, \
+					LOG4G_LEVEL_ERROR_INT)) { \
+			log4g_logger_assert_(log4g_logger_, FALSE, G_STRFUNC, \
+				__FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_is_trace_enabled:
@@ -172,13 +216,17 @@ log4g_get_option_group(void);
  * A similar macro exists for all of the default log levels.
  * </para></note>
  *
+ * The logging macros perform this check before evaluating any of their
+ * format parameters, so arguments to a disabled logging statement are never
+ * evaluated.
+ *
  * See: log4g_logger_is_trace_enabled(), log4g/level.h
  *
  * Returns: %TRUE if trace is enabled, %FALSE otherwise.
  * Since: 0.1
  */
 #define log4g_is_trace_enabled() \
-	log4g_logger_is_trace_enabled(log4g_get_logger_(LOG4G_LOG_DOMAIN))
+	log4g_is_enabled_(LOG4G_LEVEL_TRACE_INT)
 
 /**
  * log4g_trace:
@@ -198,9 +246,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_trace(format, args...) \
-	log4g_logger_trace_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
-			format, ##args)
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_TRACE_INT)) { \
+			log4g_logger_trace_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_trace:
@@ -222,8 +275,13 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_trace(logger, format, args...) \
-	log4g_logger_trace_(logger, G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_trace_enabled_(log4g_logger_)) { \
+			log4g_logger_trace_(log4g_logger_, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_is_debug_enabled:
@@ -237,7 +295,7 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_is_debug_enabled() \
-	log4g_logger_is_debug_enabled(log4g_get_logger_(LOG4G_LOG_DOMAIN))
+	log4g_is_enabled_(LOG4G_LEVEL_DEBUG_INT)
 
 /**
  * log4g_debug:
@@ -257,9 +315,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_debug(format, args...) \
-	log4g_logger_debug_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
-			format, ##args)
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_DEBUG_INT)) { \
+			log4g_logger_debug_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_debug:
@@ -281,8 +344,13 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_debug(logger, format, args...) \
-	log4g_logger_debug_(logger, G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_debug_enabled_(log4g_logger_)) { \
+			log4g_logger_debug_(log4g_logger_, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_is_info_enabled:
@@ -296,7 +364,7 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_is_info_enabled() \
-	log4g_logger_is_info_enabled(log4g_get_logger_(LOG4G_LOG_DOMAIN))
+	log4g_is_enabled_(LOG4G_LEVEL_INFO_INT)
 
 /**
  * log4g_info:
@@ -316,9 +384,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_info(format, args...) \
-	log4g_logger_info_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
-			format, ##args)
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_INFO_INT)) { \
+			log4g_logger_info_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_info:
@@ -340,8 +413,13 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_info(logger, format, args...) \
-	log4g_logger_info_(logger, G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_info_enabled_(log4g_logger_)) { \
+			log4g_logger_info_(log4g_logger_, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_is_warn_enabled:
@@ -355,7 +433,7 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_is_warn_enabled() \
-	log4g_logger_is_warn_enabled(log4g_get_logger_(LOG4G_LOG_DOMAIN))
+	log4g_is_enabled_(LOG4G_LEVEL_WARN_INT)
 
 /**
  * log4g_warn:
@@ -375,9 +453,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_warn(format, args...) \
-	log4g_logger_warn_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
-			format, ##args)
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_WARN_INT)) { \
+			log4g_logger_warn_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_warn:
@@ -399,8 +482,13 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_warn(logger, format, args...) \
-	log4g_logger_warn_(logger, G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_warn_enabled_(log4g_logger_)) { \
+			log4g_logger_warn_(log4g_logger_, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_is_error_enabled:
@@ -414,7 +502,7 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_is_error_enabled() \
-	log4g_logger_is_error_enabled(log4g_get_logger_(LOG4G_LOG_DOMAIN))
+	log4g_is_enabled_(LOG4G_LEVEL_ERROR_INT)
 
 /**
  * log4g_error:
@@ -434,9 +522,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_error(format, args...) \
-	log4g_logger_error_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
-			format, ##args)
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_ERROR_INT)) { \
+			log4g_logger_error_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_error:
@@ -458,8 +551,13 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_error(logger, format, args...) \
-	log4g_logger_error_(logger, G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_error_enabled_(log4g_logger_)) { \
+			log4g_logger_error_(log4g_logger_, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_is_fatal_enabled:
@@ -473,7 +571,7 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_is_fatal_enabled() \
-	log4g_logger_is_fatal_enabled(log4g_get_logger_(LOG4G_LOG_DOMAIN))
+	log4g_is_enabled_(LOG4G_LEVEL_FATAL_INT)
 
 /**
  * log4g_fatal:
@@ -493,9 +591,14 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_fatal(format, args...) \
-	log4g_logger_fatal_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
-			G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
-			format, ##args)
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_FATAL_INT)) { \
+			log4g_logger_fatal_( \
+				log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				G_STRFUNC, __FILE__, G_STRINGIFY(__LINE__), \
+				format, ##args); \
+		} \
+	} while (0)
 
 /**
  * log4g_logger_fatal:
@@ -517,8 +620,295 @@ log4g_get_option_group(void);
  * Since: 0.1
  */
 #define log4g_logger_fatal(logger, format, args...) \
-	log4g_logger_fatal_(logger, G_STRFUNC, __FILE__, \
-			G_STRINGIFY(__LINE__), format, ##args)
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_fatal_enabled_(log4g_logger_)) { \
+			log4g_logger_fatal_(log4g_logger_, G_STRFUNC, __FILE__, \
+				G_STRINGIFY(__LINE__), format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_static_log_:
+ * @logger: A logger object.
+ * @level: An integer log level.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Declare a static #Log4gCallSite and log a message from it.
+ *
+ * This macro is meant to used internally.
+ *
+ * See: log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_log_(logger, level, format, args...) \
+	do { \
+		static Log4gCallSite log4g_call_site_ = { \
+			0, (level), G_STRFUNC, __FILE__, \
+			G_STRINGIFY(__LINE__), "" format, 0, NULL \
+		}; \
+		log4g_logger_log_call_site_((logger), &log4g_call_site_, \
+				format, ##args); \
+	} while (0)
+
+/**
+ * log4g_static_trace:
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a trace message from a static call site.
+ *
+ * The static logging macros behave like log4g_trace() but do not format
+ * the message on the logging thread. The level, location and format of the
+ * statement are registered once (see #Log4gCallSite) and each event only
+ * records the call site, a time stamp and a copy of the format parameters.
+ * The message is formatted when a layout needs it, and #Log4gBinaryLayout
+ * never formats it at all.
+ *
+ * Example:
+ *
+ * |[
+ * log4g_static_trace("read %zu bytes from %s", size, path);
+ * ]|
+ *
+ * <note><para>
+ * A similar macro exists for all of the default log levels.
+ * </para></note>
+ *
+ * See: log4g_logger_static_trace(), log4g_call_site_register()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_trace(format, args...) \
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_TRACE_INT)) { \
+			log4g_static_log_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				LOG4G_LEVEL_TRACE_INT, format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_logger_static_trace:
+ * @logger: A logger object.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a trace message from a static call site.
+ *
+ * See: log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_logger_static_trace(logger, format, args...) \
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_trace_enabled_(log4g_logger_)) { \
+			log4g_static_log_(log4g_logger_, LOG4G_LEVEL_TRACE_INT, \
+				format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_static_debug:
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a debug message from a static call site.
+ *
+ * See: log4g_logger_static_debug(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_debug(format, args...) \
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_DEBUG_INT)) { \
+			log4g_static_log_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				LOG4G_LEVEL_DEBUG_INT, format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_logger_static_debug:
+ * @logger: A logger object.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a debug message from a static call site.
+ *
+ * See: log4g_static_debug(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_logger_static_debug(logger, format, args...) \
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_debug_enabled_(log4g_logger_)) { \
+			log4g_static_log_(log4g_logger_, LOG4G_LEVEL_DEBUG_INT, \
+				format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_static_info:
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log an info message from a static call site.
+ *
+ * See: log4g_logger_static_info(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_info(format, args...) \
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_INFO_INT)) { \
+			log4g_static_log_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				LOG4G_LEVEL_INFO_INT, format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_logger_static_info:
+ * @logger: A logger object.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log an info message from a static call site.
+ *
+ * See: log4g_static_info(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_logger_static_info(logger, format, args...) \
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_info_enabled_(log4g_logger_)) { \
+			log4g_static_log_(log4g_logger_, LOG4G_LEVEL_INFO_INT, \
+				format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_static_warn:
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a warn message from a static call site.
+ *
+ * See: log4g_logger_static_warn(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_warn(format, args...) \
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_WARN_INT)) { \
+			log4g_static_log_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				LOG4G_LEVEL_WARN_INT, format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_logger_static_warn:
+ * @logger: A logger object.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a warn message from a static call site.
+ *
+ * See: log4g_static_warn(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_logger_static_warn(logger, format, args...) \
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_warn_enabled_(log4g_logger_)) { \
+			log4g_static_log_(log4g_logger_, LOG4G_LEVEL_WARN_INT, \
+				format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_static_error:
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log an error message from a static call site.
+ *
+ * See: log4g_logger_static_error(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_error(format, args...) \
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_ERROR_INT)) { \
+			log4g_static_log_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				LOG4G_LEVEL_ERROR_INT, format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_logger_static_error:
+ * @logger: A logger object.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log an error message from a static call site.
+ *
+ * See: log4g_static_error(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_logger_static_error(logger, format, args...) \
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_error_enabled_(log4g_logger_)) { \
+			log4g_static_log_(log4g_logger_, LOG4G_LEVEL_ERROR_INT, \
+				format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_static_fatal:
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a fatal message from a static call site.
+ *
+ * See: log4g_logger_static_fatal(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_static_fatal(format, args...) \
+	do { \
+		if (log4g_is_enabled_(LOG4G_LEVEL_FATAL_INT)) { \
+			log4g_static_log_(log4g_get_logger_(LOG4G_LOG_DOMAIN), \
+				LOG4G_LEVEL_FATAL_INT, format, ##args); \
+		} \
+	} while (0)
+
+/**
+ * log4g_logger_static_fatal:
+ * @logger: A logger object.
+ * @format: A printf format, which must be a string literal.
+ * @args...: Format parameters.
+ *
+ * Log a fatal message from a static call site.
+ *
+ * See: log4g_static_fatal(), log4g_static_trace()
+ *
+ * Since: 0.1
+ */
+#define log4g_logger_static_fatal(logger, format, args...) \
+	do { \
+		Log4gLogger *log4g_logger_ = (logger); \
+		if (log4g_logger_is_fatal_enabled_(log4g_logger_)) { \
+			log4g_static_log_(log4g_logger_, LOG4G_LEVEL_FATAL_INT, \
+				format, ##args); \
+		} \
+	} while (0)
 
 G_END_DECLS
 
@@ -27,6 +27,7 @@
 #include "config.h"
 #endif
 #include "log4g/helpers/appender-attachable-impl.h"
+#include "log4g/helpers/hazard.h"
 #include "log4g/interface/logger-repository.h"
 #include "log4g/log-manager.h"
 #include "log4g/logger.h"
@@ -63,13 +64,37 @@ G_DEFINE_TYPE_WITH_CODE(Log4gLogger, log4g_logger, G_TYPE_OBJECT,
 struct Private {
 	gboolean additive; /* Indicates if children inherit appenders */
 	Log4gLevel *level; /* The assigned level of this logger */
-	gchar *name; /* The name of this logger */
+	const gchar *name; /* The interned name of this logger */
 	Log4gLogger *parent; /* The parent of the logger */
 	Log4gLoggerRepository *repository; /* Owner of this logger */
 	Log4gAppenderAttachable *aai; /* Appenders attached to this logger */
+	gpointer appenders; /* Immutable snapshot of 'aai' (see Appenders) */
+	gpointer effective_appenders; /* Flattened appenders of all ancestors */
 	GMutex lock; /* Synchronizes access to 'aai' */
+	gint effective; /* Cached effective level threshold */
+	gint threshold; /* Cached maximum of 'effective' & repository threshold */
+	gint generation; /* Value of 'generation' when the cache was updated */
 };
 
+/* An immutable snapshot of the appenders attached to a logger */
+typedef struct Appenders_ {
+	gint generation; /* Value of 'appenders_generation' when created */
+	guint size;
+	Log4gAppender *appender[];
+} Appenders;
+
+/* Bumped whenever appenders, additivity or a parent changes */
+static gint appenders_generation = 1;
+
+/* Serializes updates to the effective appenders of all loggers */
+static GMutex appenders_lock;
+
+/* Bumped whenever a level, a parent or a threshold changes */
+static gint generation = 1;
+
+/* Serializes updates to the cached effective level of all loggers */
+static GMutex effective_lock;
+
 static void
 log4g_logger_init(Log4gLogger *self)
 {
@@ -78,6 +103,108 @@ log4g_logger_init(Log4gLogger *self)
 	g_mutex_init(&priv->lock);
 }
 
+static void
+appenders_destroy_(gpointer data)
+{
+	Appenders *self = data;
+	for (guint i = 0; i < self->size; ++i) {
+		g_object_unref(self->appender[i]);
+	}
+	g_free(self);
+}
+
+static Appenders *
+appenders_new_(Log4gAppender **appenders, guint size)
+{
+	Appenders *self = g_malloc(sizeof(*self)
+			+ (size * sizeof(Log4gAppender *)));
+	self->generation = 0;
+	self->size = 0;
+	for (guint i = 0; i < size; ++i) {
+		if (appenders[i]) {
+			self->appender[self->size++] =
+				g_object_ref(appenders[i]);
+		}
+	}
+	return self;
+}
+
+/**
+ * update_effective_appenders_:
+ * @self: A #Log4gLogger object.
+ * @current: The current value of 'appenders_generation'.
+ *
+ * Flatten the appenders of @self and its ancestors (up to the first
+ * non-additive logger) into a single deduplicated snapshot.
+ */
+static void
+update_effective_appenders_(Log4gLogger *self, gint current)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	g_mutex_lock(&appenders_lock);
+	Appenders *old = g_atomic_pointer_get(&priv->effective_appenders);
+	if (old && old->generation == current) {
+		/* updated by another thread */
+		g_mutex_unlock(&appenders_lock);
+		return;
+	}
+	GPtrArray *list = g_ptr_array_new_with_free_func(g_object_unref);
+	Log4gLogger *logger = self;
+	while (logger) {
+		struct Private *p = GET_PRIVATE(logger);
+		Appenders *appenders = log4g_hazard_acquire(&p->appenders);
+		for (guint i = 0; appenders && i < appenders->size; ++i) {
+			Log4gAppender *appender = appenders->appender[i];
+			guint j = 0;
+			while (j < list->len && list->pdata[j] != appender) {
+				++j;
+			}
+			if (j == list->len) {
+				g_ptr_array_add(list, g_object_ref(appender));
+			}
+		}
+		log4g_hazard_release();
+		if (!g_atomic_int_get(&p->additive)) {
+			break;
+		}
+		logger = g_atomic_pointer_get(&p->parent);
+	}
+	Appenders *effective = appenders_new_(
+			(Log4gAppender **)list->pdata, list->len);
+	effective->generation = current;
+	g_atomic_pointer_set(&priv->effective_appenders, effective);
+	g_ptr_array_free(list, TRUE);
+	g_mutex_unlock(&appenders_lock);
+	log4g_hazard_retire(old, appenders_destroy_);
+}
+
+/**
+ * update_appenders_:
+ * @priv: The private data of a logger.
+ *
+ * Publish a new snapshot of the appenders attached to a logger. The
+ * previous snapshot is destroyed once no thread is reading it.
+ *
+ * The logger lock must be held when this function is called.
+ */
+static void
+update_appenders_(struct Private *priv)
+{
+	Appenders *snapshot = NULL;
+	const GArray *list = NULL;
+	if (priv->aai) {
+		list = log4g_appender_attachable_get_all_appenders(priv->aai);
+	}
+	if (list && list->len) {
+		snapshot = appenders_new_((Log4gAppender **)list->data,
+				list->len);
+	}
+	Appenders *old = g_atomic_pointer_get(&priv->appenders);
+	g_atomic_pointer_set(&priv->appenders, snapshot);
+	g_atomic_int_inc(&appenders_generation);
+	log4g_hazard_retire(old, appenders_destroy_);
+}
+
 static void
 dispose(GObject *base)
 {
@@ -97,6 +224,11 @@ dispose(GObject *base)
 		g_object_unref(priv->aai);
 		priv->aai = NULL;
 	}
+	if (priv->appenders) {
+		update_appenders_(priv);
+	}
+	log4g_hazard_retire(priv->effective_appenders, appenders_destroy_);
+	priv->effective_appenders = NULL;
 	G_OBJECT_CLASS(log4g_logger_parent_class)->dispose(base);
 }
 
@@ -104,7 +236,6 @@ static void
 finalize(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	g_free(priv->name);
 	g_mutex_clear(&priv->lock);
 	G_OBJECT_CLASS(log4g_logger_parent_class)->finalize(base);
 }
@@ -130,10 +261,35 @@ set_level(Log4gLogger *self, Log4gLevel *level)
 	if (priv->level) {
 		g_object_unref(priv->level);
 	}
-	g_object_ref(level);
-	priv->level = level;
+	priv->level = level ? g_object_ref(level) : NULL;
+	g_atomic_int_inc(&generation);
 }
 
+static void
+update_cache(Log4gLogger *self, gint current)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	g_mutex_lock(&effective_lock);
+	Log4gLevel *level = log4g_logger_get_effective_level(self);
+	/* a logger without an effective level is disabled */
+	gint effective = level ? log4g_level_to_int(level) : G_MAXINT;
+	gint threshold = effective;
+	if (priv->repository) {
+		level = log4g_logger_repository_get_threshold(
+				priv->repository);
+		if (level && log4g_level_to_int(level) > threshold) {
+			threshold = log4g_level_to_int(level);
+		}
+	}
+	g_atomic_int_set(&priv->effective, effective);
+	g_atomic_int_set(&priv->threshold, threshold);
+	g_atomic_int_set(&priv->generation, current);
+	g_mutex_unlock(&effective_lock);
+}
+
+#define is_enabled(self, level) \
+	log4g_logger_is_enabled_for_(self, level)
+
 static void
 log4g_logger_class_init(Log4gLoggerClass *klass)
 {
@@ -182,6 +338,9 @@ log4g_logger_new(const gchar *name)
  *
  * Retrieve the fully-qualified name of a logger.
  *
+ * Logger names are interned (see g_intern_string()), so two loggers have
+ * the same name if and only if their names are the same pointer.
+ *
  * Returns: The name of @self.
  * Since: 0.1
  */
@@ -209,8 +368,7 @@ log4g_logger_set_name(Log4gLogger *self, const gchar *name)
 {
 	g_return_if_fail(name);
 	struct Private *priv = GET_PRIVATE(self);
-	g_free(priv->name);
-	priv->name = g_strdup(name);
+	priv->name = g_intern_string(name);
 }
 
 /**
@@ -245,8 +403,15 @@ log4g_logger_get_parent(Log4gLogger *self)
 void
 log4g_logger_set_parent(Log4gLogger *self, Log4gLogger *parent)
 {
+	struct Private *priv = GET_PRIVATE(self);
 	g_object_ref(parent);
-	GET_PRIVATE(self)->parent = parent;
+	Log4gLogger *old = priv->parent;
+	g_atomic_pointer_set(&priv->parent, parent);
+	if (old) {
+		g_object_unref(old);
+	}
+	g_atomic_int_inc(&generation);
+	g_atomic_int_inc(&appenders_generation);
 }
 
 /**
@@ -294,7 +459,7 @@ log4g_logger_set_level(Log4gLogger *self, Log4gLevel *level)
 gboolean
 log4g_logger_get_additivity(Log4gLogger *self)
 {
-	return GET_PRIVATE(self)->additive;
+	return g_atomic_int_get(&GET_PRIVATE(self)->additive);
 }
 
 /**
@@ -315,7 +480,8 @@ log4g_logger_get_additivity(Log4gLogger *self)
 void
 log4g_logger_set_additivity(Log4gLogger *self, gboolean additive)
 {
-	GET_PRIVATE(self)->additive = additive;
+	g_atomic_int_set(&GET_PRIVATE(self)->additive, additive);
+	g_atomic_int_inc(&appenders_generation);
 }
 
 /**
@@ -352,6 +518,7 @@ log4g_logger_set_logger_repository(Log4gLogger *self, gpointer repository)
 {
 	g_return_if_fail(LOG4G_IS_LOGGER_REPOSITORY(repository));
 	GET_PRIVATE(self)->repository = repository;
+	g_atomic_int_inc(&generation);
 }
 
 /**
@@ -370,6 +537,94 @@ log4g_logger_get_effective_level(Log4gLogger *self)
 	return LOG4G_LOGGER_GET_CLASS(self)->get_effective_level(self);
 }
 
+/**
+ * log4g_logger_get_effective_level_int:
+ * @self: A #Log4gLogger object.
+ *
+ * Retrieve the integer value of the effective level threshold of a logger.
+ *
+ * The value is cached per logger. The cache is invalidated whenever a
+ * level or a parent changes anywhere in the logger hierarchy, so in the
+ * common case this function costs a few atomic loads and a compare.
+ *
+ * See: log4g_logger_get_effective_level()
+ *
+ * Returns: The effective level threshold of @self, or %G_MAXINT if @self
+ *          does not have an effective level.
+ * Since: 0.1
+ */
+gint
+log4g_logger_get_effective_level_int(Log4gLogger *self)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	gint current = g_atomic_int_get(&generation);
+	if (G_UNLIKELY(g_atomic_int_get(&priv->generation) != current)) {
+		update_cache(self, current);
+	}
+	return g_atomic_int_get(&priv->effective);
+}
+
+/**
+ * log4g_logger_get_threshold_int:
+ * @self: A #Log4gLogger object.
+ *
+ * Retrieve the lowest integer level that @self will log.
+ *
+ * This is the greater of the effective level of @self and the threshold of
+ * the logger repository @self is attached to. Like the effective level the
+ * value is cached and only recomputed after the logger hierarchy changes.
+ *
+ * See: log4g_logger_get_effective_level_int(),
+ *      log4g_logger_repository_get_threshold()
+ *
+ * Returns: The integer level threshold of @self.
+ * Since: 0.1
+ */
+gint
+log4g_logger_get_threshold_int(Log4gLogger *self)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	gint current = g_atomic_int_get(&generation);
+	if (G_UNLIKELY(g_atomic_int_get(&priv->generation) != current)) {
+		update_cache(self, current);
+	}
+	return g_atomic_int_get(&priv->threshold);
+}
+
+/**
+ * log4g_logger_get_generation:
+ *
+ * Retrieve the current generation of the logger hierarchy.
+ *
+ * The generation changes whenever a logger level, a logger parent or a
+ * repository threshold changes. Callers may cache decisions derived from
+ * logger thresholds for as long as the generation stays the same.
+ *
+ * Returns: The current generation.
+ * Since: 0.1
+ */
+gint
+log4g_logger_get_generation(void)
+{
+	return g_atomic_int_get(&generation);
+}
+
+/**
+ * log4g_logger_invalidate_thresholds:
+ *
+ * Invalidate the cached thresholds of all loggers.
+ *
+ * Logger repositories must call this function when their threshold
+ * changes.
+ *
+ * Since: 0.1
+ */
+void
+log4g_logger_invalidate_thresholds(void)
+{
+	g_atomic_int_inc(&generation);
+}
+
 /**
  * log4g_logger_add_appender:
  * @self: A #Log4gLogger object.
@@ -396,6 +651,7 @@ log4g_logger_add_appender(Log4gLogger *self, Log4gAppender *appender)
 		}
 	}
 	log4g_appender_attachable_add_appender(priv->aai, appender);
+	update_appenders_(priv);
 	log4g_logger_repository_emit_add_appender_signal(priv->repository,
 			self, appender);
 exit:
@@ -512,6 +768,7 @@ log4g_logger_remove_all_appenders(Log4gLogger *self)
 		g_array_append_val(mine, appender);
 	}
 	log4g_appender_attachable_remove_all_appenders(priv->aai);
+	update_appenders_(priv);
 	for (guint i = 0; i < mine->len; ++i) {
 		Log4gAppender *appender =
 			g_array_index(mine, Log4gAppender *, i);
@@ -551,6 +808,7 @@ log4g_logger_remove_appender(Log4gLogger *self, Log4gAppender *appender)
 		log4g_appender_attachable_is_attached(priv->aai, appender);
 	if (attached) {
 		log4g_appender_attachable_remove_appender(priv->aai, appender);
+		update_appenders_(priv);
 		log4g_logger_repository_emit_remove_appender_signal(
 				priv->repository, self, appender);
 	}
@@ -583,6 +841,7 @@ log4g_logger_remove_appender_name(Log4gLogger *self, const gchar *name)
 	if (appender) {
 		log4g_appender_attachable_remove_appender_name(priv->aai,
 				name);
+		update_appenders_(priv);
 		log4g_logger_repository_emit_remove_appender_signal(
 				priv->repository, self, appender);
 		g_object_unref(appender);
@@ -627,6 +886,11 @@ log4g_logger_close_nested_appenders(Log4gLogger *self)
  *
  * Append a logging event to all appenders attached to this logger.
  *
+ * The appenders of @self and its additive ancestors are flattened into a
+ * single deduplicated snapshot that is read without locking. The snapshot
+ * is rebuilt the first time @self logs after appenders, additivity or a
+ * parent changes anywhere in the logger hierarchy.
+ *
  * See: #Log4gLoggingEvent
  *
  * Since: 0.1
@@ -634,23 +898,20 @@ log4g_logger_close_nested_appenders(Log4gLogger *self)
 void
 log4g_logger_call_appenders(Log4gLogger *self, Log4gLoggingEvent *event)
 {
-	guint writes = 0;
 	struct Private *priv = GET_PRIVATE(self);
-	Log4gLogger *logger = self;
-	while (logger) {
-		priv = GET_PRIVATE(logger);
-		g_mutex_lock(&priv->lock);
-		if (priv->aai) {
-			writes += log4g_appender_attachable_impl_append_loop_on_appenders(
-					priv->aai, event);
-		}
-		if (!priv->additive) {
-			g_mutex_unlock(&priv->lock);
-			break;
-		}
-		g_mutex_unlock(&priv->lock);
-		logger = priv->parent;
+	gint current = g_atomic_int_get(&appenders_generation);
+	/* read the effective appender snapshot without locking */
+	Appenders *appenders = log4g_hazard_acquire(&priv->effective_appenders);
+	if (G_UNLIKELY(!appenders || appenders->generation != current)) {
+		log4g_hazard_release();
+		update_effective_appenders_(self, current);
+		appenders = log4g_hazard_acquire(&priv->effective_appenders);
+	}
+	for (guint i = 0; i < appenders->size; ++i) {
+		log4g_appender_do_append(appenders->appender[i], event);
 	}
+	guint writes = appenders->size;
+	log4g_hazard_release();
 	if (!writes) {
 		log4g_logger_repository_emit_no_appender_warning(
 				priv->repository, self);
@@ -683,16 +944,8 @@ log4g_logger_assert_(Log4gLogger *self, gboolean assertion,
 	if (assertion) {
 		return;
 	}
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_ERROR_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->ERROR, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_ERROR_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->ERROR, function,
@@ -717,16 +970,7 @@ log4g_logger_assert_(Log4gLogger *self, gboolean assertion,
 gboolean
 log4g_logger_is_trace_enabled(Log4gLogger *self)
 {
-	if (G_UNLIKELY(!self)) {
-		return FALSE;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_TRACE_INT)) {
-		return FALSE;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	return log4g_level_is_greater_or_equal(level->TRACE, effective);
+	return is_enabled(self, LOG4G_LEVEL_TRACE_INT);
 }
 
 /**
@@ -750,16 +994,8 @@ void
 log4g_logger_trace_(Log4gLogger *self, const gchar *function,
 		const gchar *file, const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_TRACE_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->TRACE, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_TRACE_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->TRACE, function,
@@ -781,16 +1017,7 @@ log4g_logger_trace_(Log4gLogger *self, const gchar *function,
 gboolean
 log4g_logger_is_debug_enabled(Log4gLogger *self)
 {
-	if (G_UNLIKELY(!self)) {
-		return FALSE;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_DEBUG_INT)) {
-		return FALSE;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	return log4g_level_is_greater_or_equal(level->DEBUG, effective);
+	return is_enabled(self, LOG4G_LEVEL_DEBUG_INT);
 }
 
 /**
@@ -814,16 +1041,8 @@ void
 log4g_logger_debug_(Log4gLogger *self, const gchar *function,
 		const gchar *file, const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_DEBUG_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->DEBUG, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_DEBUG_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->DEBUG, function,
@@ -845,16 +1064,7 @@ log4g_logger_debug_(Log4gLogger *self, const gchar *function,
 gboolean
 log4g_logger_is_info_enabled(Log4gLogger *self)
 {
-	if (G_UNLIKELY(!self)) {
-		return FALSE;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_INFO_INT)) {
-		return FALSE;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	return log4g_level_is_greater_or_equal(level->INFO, effective);
+	return is_enabled(self, LOG4G_LEVEL_INFO_INT);
 }
 
 /**
@@ -878,16 +1088,8 @@ void
 log4g_logger_info_(Log4gLogger *self, const gchar *function, const gchar *file,
 		const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_INFO_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->INFO, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_INFO_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->INFO, function,
@@ -909,16 +1111,7 @@ log4g_logger_info_(Log4gLogger *self, const gchar *function, const gchar *file,
 gboolean
 log4g_logger_is_warn_enabled(Log4gLogger *self)
 {
-	if (G_UNLIKELY(!self)) {
-		return FALSE;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_WARN_INT)) {
-		return FALSE;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	return log4g_level_is_greater_or_equal(level->WARN, effective);
+	return is_enabled(self, LOG4G_LEVEL_WARN_INT);
 }
 
 /**
@@ -942,16 +1135,8 @@ void
 log4g_logger_warn_(Log4gLogger *self, const gchar *function, const gchar *file,
 		const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_WARN_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->WARN, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_WARN_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->WARN, function,
@@ -973,16 +1158,7 @@ log4g_logger_warn_(Log4gLogger *self, const gchar *function, const gchar *file,
 gboolean
 log4g_logger_is_error_enabled(Log4gLogger *self)
 {
-	if (G_UNLIKELY(!self)) {
-		return FALSE;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_ERROR_INT)) {
-		return FALSE;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	return log4g_level_is_greater_or_equal(level->ERROR, effective);
+	return is_enabled(self, LOG4G_LEVEL_ERROR_INT);
 }
 
 /**
@@ -1006,16 +1182,8 @@ void
 log4g_logger_error_(Log4gLogger *self, const gchar *function,
 		const gchar *file, const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_ERROR_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->ERROR, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_ERROR_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->ERROR, function,
@@ -1037,16 +1205,7 @@ log4g_logger_error_(Log4gLogger *self, const gchar *function,
 gboolean
 log4g_logger_is_fatal_enabled(Log4gLogger *self)
 {
-	if (G_UNLIKELY(!self)) {
-		return FALSE;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_FATAL_INT)) {
-		return FALSE;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	return log4g_level_is_greater_or_equal(level->FATAL, effective);
+	return is_enabled(self, LOG4G_LEVEL_FATAL_INT);
 }
 
 /**
@@ -1070,16 +1229,8 @@ void
 log4g_logger_fatal_(Log4gLogger *self, const gchar *function,
 		const gchar *file, const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				LOG4G_LEVEL_FATAL_INT)) {
-		return;
-	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
-	if (log4g_level_is_greater_or_equal(level->FATAL, effective)) {
+	if (is_enabled(self, LOG4G_LEVEL_FATAL_INT)) {
+		Log4gLevelClass *level = g_type_class_peek(LOG4G_TYPE_LEVEL);
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level->FATAL, function,
@@ -1110,15 +1261,10 @@ void
 log4g_logger_log_(Log4gLogger *self, Log4gLevel *level, const gchar *function,
 		const gchar *file, const gchar *line, const gchar *format, ...)
 {
-	if (G_UNLIKELY(!self)) {
-		return;
-	}
-	if (log4g_logger_repository_is_disabled(GET_PRIVATE(self)->repository,
-				log4g_level_to_int(level))) {
+	if (G_UNLIKELY(!level)) {
 		return;
 	}
-	Log4gLevel *effective = log4g_logger_get_effective_level(self);
-	if (log4g_level_is_greater_or_equal(level, effective)) {
+	if (is_enabled(self, log4g_level_to_int(level))) {
 		va_list ap;
 		va_start(ap, format);
 		log4g_logger_forced_log(self, level, function,
@@ -1127,6 +1273,65 @@ log4g_logger_log_(Log4gLogger *self, Log4gLevel *level, const gchar *function,
 	}
 }
 
+/**
+ * log4g_logger_log_call_site_:
+ * @self: A Log4gLogger object.
+ * @site: The call site of the logging request.
+ * @format: The format of @site.
+ * @...: Format parameters.
+ *
+ * Log a message from a static call site.
+ *
+ * The @format parameter is only present so the compiler can check the
+ * format parameters, the format of @site is used.
+ *
+ * This function is intended for use by the static logging macros.
+ *
+ * See: log4g_static_trace(), #Log4gCallSite
+ *
+ * Since: 0.1
+ */
+void
+log4g_logger_log_call_site_(Log4gLogger *self, Log4gCallSite *site,
+		G_GNUC_UNUSED const gchar *format, ...)
+{
+	if (!is_enabled(self, site->level)) {
+		return;
+	}
+	Log4gLevelClass *klass = g_type_class_peek(LOG4G_TYPE_LEVEL);
+	Log4gLevel *level;
+	switch (site->level) {
+	case LOG4G_LEVEL_TRACE_INT:
+		level = klass->TRACE;
+		break;
+	case LOG4G_LEVEL_DEBUG_INT:
+		level = klass->DEBUG;
+		break;
+	case LOG4G_LEVEL_INFO_INT:
+		level = klass->INFO;
+		break;
+	case LOG4G_LEVEL_WARN_INT:
+		level = klass->WARN;
+		break;
+	case LOG4G_LEVEL_ERROR_INT:
+		level = klass->ERROR;
+		break;
+	default:
+		level = klass->FATAL;
+		break;
+	}
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new_call_site(
+			GET_PRIVATE(self)->name, level, site, ap);
+	va_end(ap);
+	if (!event) {
+		return;
+	}
+	log4g_logger_call_appenders(self, event);
+	g_object_unref(event);
+}
+
 /**
  * log4g_logger_get_logger:
  * @name: The name of the logger to retrieve.
@@ -1208,9 +1413,9 @@ log4g_logger_forced_log(Log4gLogger *self, Log4gLevel *level,
 		const gchar *function, const gchar *file, const gchar *line,
 		const gchar *format, va_list ap)
 {
-	Log4gLoggingEvent *event =
-		log4g_logging_event_new(GET_PRIVATE(self)->name, level,
-				function, file, line, format, ap);
+	Log4gLoggingEvent *event = log4g_logging_event_new_interned(
+			GET_PRIVATE(self)->name, level, function, file, line,
+			format, ap);
 	if (!event) {
 		return;
 	}
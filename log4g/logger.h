@@ -134,6 +134,18 @@ log4g_logger_set_logger_repository(Log4gLogger *self, gpointer repository);
 Log4gLevel *
 log4g_logger_get_effective_level(Log4gLogger *self);
 
+gint
+log4g_logger_get_effective_level_int(Log4gLogger *self);
+
+gint
+log4g_logger_get_threshold_int(Log4gLogger *self);
+
+gint
+log4g_logger_get_generation(void);
+
+void
+log4g_logger_invalidate_thresholds(void);
+
 void
 log4g_logger_add_appender(Log4gLogger *self, Log4gAppender *appender);
 
@@ -220,6 +232,10 @@ log4g_logger_log_(Log4gLogger *self, Log4gLevel *level, const gchar *function,
 		const gchar *file, const gchar *line, const gchar *format, ...)
 		G_GNUC_PRINTF(6, 7);
 
+void
+log4g_logger_log_call_site_(Log4gLogger *self, Log4gCallSite *site,
+		const gchar *format, ...) G_GNUC_PRINTF(3, 4);
+
 Log4gLogger *
 log4g_logger_get_logger(const gchar *name);
 
@@ -234,6 +250,61 @@ log4g_logger_forced_log(Log4gLogger *self, Log4gLevel *level,
 		const gchar *function, const gchar *file, const gchar *line,
 		const gchar *format, va_list ap);
 
+/**
+ * log4g_logger_is_enabled_for_:
+ * @self: A #Log4gLogger object.
+ * @level: An integer log level.
+ *
+ * Determine if @self will log events of @level using only the cached
+ * integer threshold of @self.
+ *
+ * This function is meant to be used internally by the logging macros.
+ *
+ * Returns: %TRUE if @level is enabled for @self, %FALSE otherwise.
+ * Since: 0.1
+ */
+static inline gboolean
+log4g_logger_is_enabled_for_(Log4gLogger *self, gint level)
+{
+	return G_LIKELY(self) && (level >= log4g_logger_get_threshold_int(self));
+}
+
+static inline gboolean
+log4g_logger_is_trace_enabled_(Log4gLogger *self)
+{
+	return log4g_logger_is_enabled_for_(self, LOG4G_LEVEL_TRACE_INT);
+}
+
+static inline gboolean
+log4g_logger_is_debug_enabled_(Log4gLogger *self)
+{
+	return log4g_logger_is_enabled_for_(self, LOG4G_LEVEL_DEBUG_INT);
+}
+
+static inline gboolean
+log4g_logger_is_info_enabled_(Log4gLogger *self)
+{
+	return log4g_logger_is_enabled_for_(self, LOG4G_LEVEL_INFO_INT);
+}
+
+static inline gboolean
+log4g_logger_is_warn_enabled_(Log4gLogger *self)
+{
+	return log4g_logger_is_enabled_for_(self, LOG4G_LEVEL_WARN_INT);
+}
+
+static inline gboolean
+log4g_logger_is_error_enabled_(Log4gLogger *self)
+{
+	return log4g_logger_is_enabled_for_(self, LOG4G_LEVEL_ERROR_INT);
+}
+
+static inline gboolean
+log4g_logger_is_fatal_enabled_(Log4gLogger *self)
+{
+	return log4g_logger_is_enabled_for_(self, LOG4G_LEVEL_FATAL_INT);
+}
+
 G_END_DECLS
 
 #endif /* LOG4G_LOGGER_H */
@@ -23,6 +23,27 @@
  * instance is created. This instance is passed to appenders and filters to
  * perform actual logging.
  *
+ * By default the log message is formatted when the logging event is
+ * created. If deferred formatting is enabled (see
+ * log4g_logging_event_set_deferred_formatting()) the format string and a
+ * copy of its parameters are captured instead, and the message is rendered
+ * the first time it is requested. Combined with an asynchronous appender
+ * this moves the cost of formatting off of the logging thread.
+ *
+ * Events logged by the log4g_static_trace() family of macros always
+ * capture their message. They also refer to a #Log4gCallSite, which lets
+ * layouts such as #Log4gBinaryLayout record the message without formatting
+ * it at all (see log4g_logging_event_get_arguments()).
+ *
+ * Logging events are recycled through a small per-thread pool. An event
+ * released by another thread, e.g. by an asynchronous appender, is
+ * returned to the pool of the thread that created it. Logger names are
+ * interned and short messages are stored inline, so in the steady state
+ * creating a logging event does not allocate memory.
+ *
+ * Logging events are time stamped in nanoseconds by the clock source
+ * selected with log4g_clock_set_source().
+ *
  * <note><para>
  * This class is only useful to those wishing to extend Log4g.
  * </para></note>
@@ -32,7 +53,11 @@
 #include "config.h"
 #endif
 #include <errno.h>
+#include "log4g/helpers/clock.h"
 #include "log4g/helpers/thread.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include "log4g/logging-event.h"
 #include "log4g/mdc.h"
 #include "log4g/ndc.h"
@@ -46,22 +71,99 @@ G_DEFINE_TYPE(Log4gLoggingEvent, log4g_logging_event, G_TYPE_OBJECT)
 #define GET_PRIVATE(instance) \
 	((struct Private *)((Log4gLoggingEvent *)instance)->priv)
 
+/* A conversion specification within a format string */
+typedef struct Spec_ {
+	const gchar *start; /* The '%' character */
+	const gchar *end; /* One past the conversion character */
+	gboolean width; /* The field width is '*' */
+	gboolean precision; /* The precision is '*' */
+	Log4gArgumentType type;
+} Spec;
+
+/* The longest conversion specification that may be deferred */
+#define SPEC_MAX (32)
+
+/* Indicates if deferred formatting is enabled */
+static gboolean deferred = FALSE;
+
+/* The time when the logging event class was initialized (nanoseconds) */
+static gint64 start = 0;
+
+/* The size of the inline message storage */
+#define INLINE_MESSAGE (256)
+
+/* The number of format parameters stored inline */
+#define INLINE_ARGUMENTS (8)
+
+/* The maximum number of idle events kept per thread */
+#define POOL_MAX (64)
+
+/* The number of layout outputs cached per event */
+#define OUTPUT_SLOTS (4)
+
+/* The size of the inline storage for cached layout outputs, like the inline
+ * message this is kept small because every pooled event carries it */
+#define OUTPUT_ARENA (256)
+
+/* Cached outputs are stored at offsets aligned to this size */
+#define OUTPUT_ALIGN (sizeof(gpointer))
+
+/* The output of a layout, see log4g_layout_set_fingerprint() */
+struct Output {
+	const gchar *fingerprint; /* Interned */
+	gsize length;
+	gsize offset; /* The offset of the output in 'arena' */
+	gchar *heap; /* An output that did not fit in 'arena' */
+};
+
+/* A per-thread list of idle logging events */
+typedef struct Pool_ {
+	Log4gLoggingEvent *head;
+	guint size;
+	Log4gLoggingEvent *returned; /* Released by other threads */
+	gint ref; /* Held by the thread & every event it created */
+} Pool;
+
+static void
+pool_destroy_(gpointer data);
+
+static GPrivate pool = G_PRIVATE_INIT(pool_destroy_);
+
+/* Marks the returned list of a pool whose thread has exited */
+#define POOL_CLOSED ((Log4gLoggingEvent *)&pool)
+
 struct Private {
-	gchar *logger;
+	const gchar *logger; /* Interned logger name */
 	Log4gLevel *level;
 	gchar *message;
+	const gchar *format; /* The format of a captured message */
+	Log4gArgument *arguments; /* The parameters of a captured message */
+	guint size;
+	const Log4gCallSite *site;
+	Log4gLoggingEvent *next; /* The next idle event in the pool */
+	Pool *owner; /* The pool of the thread that created this event */
+	gint64 time; /* Nanoseconds since the Unix epoch */
 	GTimeVal timestamp;
 	gboolean thread_lookup_required;
-	gchar *thread;
+	const gchar *thread; /* Interned */
+	guint thread_id;
+	gint tid;
 	gboolean ndc_lookup_required;
-	gchar *ndc;
+	Log4gNDCFrame *ndc;
 	gboolean mdc_lookup_required;
-	GHashTable *mdc;
+	Log4gMDCMap *mdc;
 	const gchar *function;
 	const gchar *file;
 	const gchar *line;
 	gchar *fullinfo;
 	GArray *keys;
+	struct Output *outputs[OUTPUT_SLOTS]; /* Published with atomic set */
+	struct Output headers[OUTPUT_SLOTS];
+	gint count; /* Entries of 'headers' reserved, set with atomic add */
+	gint used; /* Bytes of 'arena' reserved, set with compare & exchange */
+	gchar arena[OUTPUT_ARENA];
+	Log4gArgument inline_arguments[INLINE_ARGUMENTS];
+	gchar buffer[INLINE_MESSAGE];
 };
 
 static void
@@ -74,6 +176,126 @@ log4g_logging_event_init(Log4gLoggingEvent *self)
 	priv->mdc_lookup_required = TRUE;
 }
 
+/**
+ * reset_:
+ * @priv: The private data of a logging event.
+ *
+ * Release all data held by a logging event.
+ */
+static void
+reset_(struct Private *priv)
+{
+	priv->logger = NULL;
+	if (priv->message != priv->buffer) {
+		g_free(priv->message);
+	}
+	priv->message = NULL;
+	for (guint i = 0; i < priv->size; ++i) {
+		if (priv->arguments[i].type == LOG4G_ARGUMENT_STRING) {
+			g_free(priv->arguments[i].value.s);
+		}
+	}
+	if (priv->arguments != priv->inline_arguments) {
+		g_free(priv->arguments);
+	}
+	priv->arguments = NULL;
+	priv->size = 0;
+	priv->format = NULL;
+	priv->site = NULL;
+	if (priv->ndc) {
+		log4g_ndc_frame_unref(priv->ndc);
+		priv->ndc = NULL;
+	}
+	g_free(priv->fullinfo);
+	priv->fullinfo = NULL;
+	priv->thread = NULL;
+	if (priv->mdc) {
+		log4g_mdc_map_unref(priv->mdc);
+		priv->mdc = NULL;
+	}
+	if (priv->keys) {
+		g_array_free(priv->keys, TRUE);
+		priv->keys = NULL;
+	}
+	for (guint i = 0; i < OUTPUT_SLOTS; ++i) {
+		if (priv->outputs[i]) {
+			g_free(priv->outputs[i]->heap);
+			priv->outputs[i] = NULL;
+		}
+	}
+	priv->count = 0;
+	priv->used = 0;
+	priv->thread_lookup_required = TRUE;
+	priv->ndc_lookup_required = TRUE;
+	priv->mdc_lookup_required = TRUE;
+	priv->function = priv->file = priv->line = NULL;
+}
+
+static void
+pool_unref_(Pool *self)
+{
+	if (g_atomic_int_dec_and_test(&self->ref)) {
+		g_free(self);
+	}
+}
+
+/**
+ * pool_destroy_:
+ * @data: The logging event pool of an exiting thread.
+ *
+ * Free all idle logging events when a thread exits. Events released by
+ * other threads afterwards are freed instead of being returned.
+ */
+static void
+pool_destroy_(gpointer data)
+{
+	Pool *self = data;
+	Log4gLoggingEvent *returned;
+	do {
+		returned = g_atomic_pointer_get(&self->returned);
+	} while (!g_atomic_pointer_compare_and_exchange(&self->returned,
+				returned, POOL_CLOSED));
+	/* nothing may be recycled into a pool that is being destroyed */
+	self->size = POOL_MAX;
+	while (self->head) {
+		Log4gLoggingEvent *event = self->head;
+		self->head = GET_PRIVATE(event)->next;
+		g_object_unref(event);
+	}
+	while (returned) {
+		Log4gLoggingEvent *event = returned;
+		returned = GET_PRIVATE(event)->next;
+		g_object_unref(event);
+	}
+	pool_unref_(self);
+}
+
+/**
+ * return_:
+ * @self: A logging event that has been reset.
+ * @owner: The pool of the thread that created @self.
+ *
+ * Push an idle event onto the returned list of another thread's pool. Only
+ * the owning thread removes events, and it takes the whole list at once,
+ * so pushing with compare & exchange is safe.
+ *
+ * Returns: %FALSE if the owning thread has exited.
+ */
+static gboolean
+return_(Log4gLoggingEvent *self, Pool *owner)
+{
+	Log4gLoggingEvent *head;
+	do {
+		head = g_atomic_pointer_get(&owner->returned);
+		if (G_UNLIKELY(POOL_CLOSED == head)) {
+			return FALSE;
+		}
+		GET_PRIVATE(self)->next = head;
+	} while (!g_atomic_pointer_compare_and_exchange(&owner->returned,
+				head, self));
+	return TRUE;
+}
+
 static void
 dispose(GObject *base)
 {
@@ -82,6 +304,31 @@ dispose(GObject *base)
 		g_object_unref(priv->level);
 		priv->level = NULL;
 	}
+	/* recycle the event into the pool of the thread that created it if
+	 * the last reference is being released */
+	Pool *owner = priv->owner;
+	if (owner && g_atomic_int_get(&base->ref_count) == 1
+			&& G_OBJECT_TYPE(base) == LOG4G_TYPE_LOGGING_EVENT) {
+		if (owner == g_private_get(&pool)) {
+			if (owner->size < POOL_MAX) {
+				reset_(priv);
+				g_object_ref(base);
+				priv->next = owner->head;
+				owner->head = LOG4G_LOGGING_EVENT(base);
+				++owner->size;
+				return;
+			}
+		} else {
+			/* e.g. released by the thread of an async appender */
+			reset_(priv);
+			g_object_ref(base);
+			if (return_(LOG4G_LOGGING_EVENT(base), owner)) {
+				return;
+			}
+			priv->next = NULL;
+			g_object_unref(base);
+		}
+	}
 	G_OBJECT_CLASS(log4g_logging_event_parent_class)->dispose(base);
 }
 
@@ -89,32 +336,584 @@ static void
 finalize(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	g_free(priv->logger);
-	g_free(priv->message);
-	g_free(priv->ndc);
-	g_free(priv->fullinfo);
-	g_free(priv->thread);
-	if (priv->mdc) {
-		g_hash_table_destroy(priv->mdc);
-	}
-	if (priv->keys) {
-		g_array_free(priv->keys, TRUE);
+	reset_(priv);
+	if (priv->owner) {
+		pool_unref_(priv->owner);
 	}
 	G_OBJECT_CLASS(log4g_logging_event_parent_class)->finalize(base);
 }
 
+/**
+ * event_new_:
+ *
+ * Retrieve an idle logging event from the pool of the calling thread, or
+ * create a new logging event if the pool is empty.
+ *
+ * Returns: A logging event object.
+ */
+static Log4gLoggingEvent *
+event_new_(void)
+{
+	Pool *idle = g_private_get(&pool);
+	if (G_UNLIKELY(!idle)) {
+		idle = g_new0(Pool, 1);
+		idle->ref = 1;
+		g_private_set(&pool, idle);
+	}
+	if (!idle->head && g_atomic_pointer_get(&idle->returned)) {
+		/* take back every event released by other threads */
+		Log4gLoggingEvent *returned;
+		do {
+			returned = g_atomic_pointer_get(&idle->returned);
+		} while (!g_atomic_pointer_compare_and_exchange(
+					&idle->returned, returned, NULL));
+		idle->head = returned;
+		while (returned) {
+			++idle->size;
+			returned = GET_PRIVATE(returned)->next;
+		}
+	}
+	if (idle->head) {
+		Log4gLoggingEvent *self = idle->head;
+		idle->head = GET_PRIVATE(self)->next;
+		GET_PRIVATE(self)->next = NULL;
+		--idle->size;
+		return self;
+	}
+	Log4gLoggingEvent *self = g_object_new(LOG4G_TYPE_LOGGING_EVENT, NULL);
+	g_atomic_int_inc(&idle->ref);
+	GET_PRIVATE(self)->owner = idle;
+	return self;
+}
+
 static void
 log4g_logging_event_class_init(Log4gLoggingEventClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 	object_class->dispose = dispose;
 	object_class->finalize = finalize;
-	GTimeVal start;
-	g_get_current_time(&start);
-	klass->start = (start.tv_sec * 1000) + (start.tv_usec * 0.001);
+	start = log4g_clock_get_time();
+	klass->start = start / G_GINT64_CONSTANT(1000000);
 	g_type_class_add_private(klass, sizeof(struct Private));
 }
 
+/**
+ * parse_spec_:
+ * @p: A pointer to a '%' character in a format string.
+ * @spec: Returns the parsed conversion specification.
+ *
+ * Parse a printf conversion specification.
+ *
+ * Positional parameters, wide characters, "%n" and "%m" as well as any
+ * conversion not listed here cannot be deferred.
+ *
+ * Returns: %TRUE if the conversion may be deferred, %FALSE otherwise.
+ */
+static gboolean
+parse_spec_(const gchar *p, Spec *spec)
+{
+	enum { NONE, H, L, LL, BIG_L, J, Z, T } length = NONE;
+	spec->start = p++;
+	spec->width = spec->precision = FALSE;
+	if (*p == '%') {
+		spec->type = LOG4G_ARGUMENT_NONE;
+		spec->end = p + 1;
+		return TRUE;
+	}
+	while (*p && strchr("-+ #0'", *p)) {
+		++p;
+	}
+	if (*p == '*') {
+		spec->width = TRUE;
+		++p;
+	} else {
+		while (g_ascii_isdigit(*p)) {
+			++p;
+		}
+	}
+	if (*p == '$') {
+		return FALSE;
+	}
+	if (*p == '.') {
+		++p;
+		if (*p == '*') {
+			spec->precision = TRUE;
+			++p;
+		} else {
+			while (g_ascii_isdigit(*p)) {
+				++p;
+			}
+		}
+	}
+	switch (*p) {
+	case 'h':
+		length = H;
+		if (*++p == 'h') {
+			++p;
+		}
+		break;
+	case 'l':
+		length = L;
+		if (*++p == 'l') {
+			length = LL;
+			++p;
+		}
+		break;
+	case 'q':
+		length = LL;
+		++p;
+		break;
+	case 'L':
+		length = BIG_L;
+		++p;
+		break;
+	case 'j':
+		length = J;
+		++p;
+		break;
+	case 'z':
+		length = Z;
+		++p;
+		break;
+	case 't':
+		length = T;
+		++p;
+		break;
+	default:
+		break;
+	}
+	switch (*p) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		switch (length) {
+		case NONE:
+		case H:
+			spec->type = LOG4G_ARGUMENT_INT;
+			break;
+		case L:
+			spec->type = LOG4G_ARGUMENT_LONG;
+			break;
+		case LL:
+			spec->type = LOG4G_ARGUMENT_LLONG;
+			break;
+		case J:
+			spec->type = LOG4G_ARGUMENT_INTMAX;
+			break;
+		case Z:
+			spec->type = LOG4G_ARGUMENT_SIZE;
+			break;
+		case T:
+			spec->type = LOG4G_ARGUMENT_PTRDIFF;
+			break;
+		default:
+			return FALSE;
+		}
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		if (length == BIG_L) {
+			spec->type = LOG4G_ARGUMENT_LDOUBLE;
+		} else if (length == NONE || length == L) {
+			spec->type = LOG4G_ARGUMENT_DOUBLE;
+		} else {
+			return FALSE;
+		}
+		break;
+	case 'c':
+		if (length != NONE) {
+			return FALSE;
+		}
+		spec->type = LOG4G_ARGUMENT_INT;
+		break;
+	case 's':
+		if (length != NONE) {
+			return FALSE;
+		}
+		spec->type = LOG4G_ARGUMENT_STRING;
+		break;
+	case 'p':
+		if (length != NONE) {
+			return FALSE;
+		}
+		spec->type = LOG4G_ARGUMENT_POINTER;
+		break;
+	default:
+		return FALSE;
+	}
+	spec->end = p + 1;
+	return (spec->end - spec->start) <= SPEC_MAX;
+}
+
+/**
+ * capture_:
+ * @arg: Returns the captured parameter.
+ * @type: The type of the parameter.
+ * @ap: A pointer to the format parameters.
+ *
+ * Copy one format parameter. String parameters are copied, all other
+ * parameters are stored by value.
+ */
+static inline void
+capture_(Log4gArgument *arg, Log4gArgumentType type, va_list *ap)
+{
+	arg->type = type;
+	switch (type) {
+	case LOG4G_ARGUMENT_NONE:
+		break;
+	case LOG4G_ARGUMENT_INT:
+		arg->value.i = va_arg(*ap, gint);
+		break;
+	case LOG4G_ARGUMENT_LONG:
+		arg->value.l = va_arg(*ap, glong);
+		break;
+	case LOG4G_ARGUMENT_LLONG:
+		arg->value.ll = va_arg(*ap, long long);
+		break;
+	case LOG4G_ARGUMENT_INTMAX:
+		arg->value.j = va_arg(*ap, intmax_t);
+		break;
+	case LOG4G_ARGUMENT_SIZE:
+		arg->value.z = va_arg(*ap, gsize);
+		break;
+	case LOG4G_ARGUMENT_PTRDIFF:
+		arg->value.t = va_arg(*ap, ptrdiff_t);
+		break;
+	case LOG4G_ARGUMENT_DOUBLE:
+		arg->value.d = va_arg(*ap, gdouble);
+		break;
+	case LOG4G_ARGUMENT_LDOUBLE:
+		arg->value.ld = va_arg(*ap, long double);
+		break;
+	case LOG4G_ARGUMENT_POINTER:
+		arg->value.p = va_arg(*ap, gpointer);
+		break;
+	case LOG4G_ARGUMENT_STRING:
+		arg->value.s = g_strdup(va_arg(*ap, const gchar *));
+		break;
+	}
+}
+
+/**
+ * arguments_new_:
+ * @priv: The private data of a logging event.
+ * @format: A printf format with static storage duration.
+ * @size: The number of parameters consumed by @format.
+ *
+ * Prepare a logging event to capture a message. Up to %INLINE_ARGUMENTS
+ * parameters are stored in the event itself.
+ *
+ * Returns: Storage for @size parameters.
+ */
+static Log4gArgument *
+arguments_new_(struct Private *priv, const gchar *format, guint size)
+{
+	priv->format = format;
+	priv->size = size;
+	priv->arguments = (size > INLINE_ARGUMENTS
+			? g_new(Log4gArgument, size) : priv->inline_arguments);
+	return priv->arguments;
+}
+
+/**
+ * types_new_:
+ * @format: A printf format.
+ * @size: Returns the number of parameters consumed by @format.
+ *
+ * Determine the type of each parameter consumed by a printf format.
+ *
+ * Returns: An array of @size parameter types terminated by
+ *          %LOG4G_ARGUMENT_NONE, or %NULL if @format cannot be captured.
+ *          Free with g_free().
+ */
+static Log4gArgumentType *
+types_new_(const gchar *format, guint *size)
+{
+	Spec spec;
+	guint n = 0;
+	for (const gchar *p = strchr(format, '%'); p;
+			p = strchr(spec.end, '%')) {
+		if (!parse_spec_(p, &spec)) {
+			return NULL;
+		}
+		n += spec.width + spec.precision
+			+ (spec.type != LOG4G_ARGUMENT_NONE);
+	}
+	Log4gArgumentType *types = g_new(Log4gArgumentType, n + 1);
+	Log4gArgumentType *type = types;
+	for (const gchar *p = strchr(format, '%'); p;
+			p = strchr(spec.end, '%')) {
+		parse_spec_(p, &spec);
+		if (spec.width) {
+			*type++ = LOG4G_ARGUMENT_INT;
+		}
+		if (spec.precision) {
+			*type++ = LOG4G_ARGUMENT_INT;
+		}
+		if (spec.type != LOG4G_ARGUMENT_NONE) {
+			*type++ = spec.type;
+		}
+	}
+	*type = LOG4G_ARGUMENT_NONE;
+	*size = n;
+	return types;
+}
+
+/**
+ * deferred_new_:
+ * @priv: The private data of a logging event.
+ * @format: A printf formatted log message.
+ * @ap: Format parameters.
+ *
+ * Capture a log message for deferred formatting.
+ *
+ * Returns: %TRUE if the message was captured, %FALSE if @format cannot be
+ *          deferred.
+ */
+static gboolean
+deferred_new_(struct Private *priv, const gchar *format, va_list ap)
+{
+	Spec spec;
+	guint size = 0;
+	for (const gchar *p = strchr(format, '%'); p;
+			p = strchr(spec.end, '%')) {
+		if (!parse_spec_(p, &spec)) {
+			return FALSE;
+		}
+		size += spec.width + spec.precision
+			+ (spec.type != LOG4G_ARGUMENT_NONE);
+	}
+	Log4gArgument *arg = arguments_new_(priv, format, size);
+	if (!size) {
+		return TRUE;
+	}
+	va_list aq;
+	va_copy(aq, ap);
+	for (const gchar *p = strchr(format, '%'); p;
+			p = strchr(spec.end, '%')) {
+		parse_spec_(p, &spec);
+		if (spec.width) {
+			capture_(arg++, LOG4G_ARGUMENT_INT, &aq);
+		}
+		if (spec.precision) {
+			capture_(arg++, LOG4G_ARGUMENT_INT, &aq);
+		}
+		if (spec.type != LOG4G_ARGUMENT_NONE) {
+			capture_(arg++, spec.type, &aq);
+		}
+	}
+	va_end(aq);
+	return TRUE;
+}
+
+/**
+ * site_capture_:
+ * @priv: The private data of a logging event.
+ * @site: A call site.
+ * @ap: Format parameters.
+ *
+ * Capture a log message from a call site. The format of a call site is
+ * parsed once, afterwards capturing a message only copies its parameters.
+ *
+ * Returns: %TRUE if the message was captured, %FALSE if the format of @site
+ *          cannot be deferred.
+ */
+static gboolean
+site_capture_(struct Private *priv, Log4gCallSite *site, va_list ap)
+{
+	if (g_once_init_enter(&site->types)) {
+		guint size = 0;
+		Log4gArgumentType *types = types_new_(site->format, &size);
+		if (types) {
+			site->size = (gint)size;
+		} else {
+			types = g_new0(Log4gArgumentType, 1);
+			site->size = -1;
+		}
+		g_once_init_leave(&site->types, types);
+	}
+	if (site->size < 0) {
+		return FALSE;
+	}
+	Log4gArgument *arg = arguments_new_(priv, site->format, site->size);
+	const Log4gArgumentType *type = site->types;
+	if (*type == LOG4G_ARGUMENT_NONE) {
+		return TRUE;
+	}
+	va_list aq;
+	va_copy(aq, ap);
+	for (; *type != LOG4G_ARGUMENT_NONE; ++type) {
+		capture_(arg++, *type, &aq);
+	}
+	va_end(aq);
+	return TRUE;
+}
+
+/**
+ * render_:
+ * @message: A printf format.
+ * @arg: The captured parameters of @message.
+ *
+ * Format a captured message.
+ *
+ * Returns: The formatted message, free with g_free().
+ */
+static gchar *
+render_(const gchar *message, const Log4gArgument *arg)
+{
+	GString *string = g_string_sized_new(strlen(message) + 64);
+	const gchar *p = message;
+	gchar format[SPEC_MAX + 24];
+	Spec spec;
+	while (*p) {
+		const gchar *percent = strchr(p, '%');
+		if (!percent) {
+			g_string_append(string, p);
+			break;
+		}
+		g_string_append_len(string, p, percent - p);
+		parse_spec_(percent, &spec);
+		p = spec.end;
+		if (spec.type == LOG4G_ARGUMENT_NONE) {
+			g_string_append_c(string, '%');
+			continue;
+		}
+		/* rewrite '*' width & precision with the captured values */
+		gsize n = 0;
+		for (const gchar *c = spec.start; c < spec.end; ++c) {
+			if (*c != '*') {
+				format[n++] = *c;
+			} else if (c[-1] == '.') {
+				gint precision = (arg++)->value.i;
+				if (precision < 0) {
+					--n; /* a negative precision is omitted */
+				} else {
+					n += g_snprintf(format + n, 12, "%d",
+							precision);
+				}
+			} else {
+				n += g_snprintf(format + n, 12, "%d",
+						(arg++)->value.i);
+			}
+		}
+		format[n] = '\0';
+		switch (arg->type) {
+		case LOG4G_ARGUMENT_INT:
+			g_string_append_printf(string, format, arg->value.i);
+			break;
+		case LOG4G_ARGUMENT_LONG:
+			g_string_append_printf(string, format, arg->value.l);
+			break;
+		case LOG4G_ARGUMENT_LLONG:
+			g_string_append_printf(string, format, arg->value.ll);
+			break;
+		case LOG4G_ARGUMENT_INTMAX:
+			g_string_append_printf(string, format, arg->value.j);
+			break;
+		case LOG4G_ARGUMENT_SIZE:
+			g_string_append_printf(string, format, arg->value.z);
+			break;
+		case LOG4G_ARGUMENT_PTRDIFF:
+			g_string_append_printf(string, format, arg->value.t);
+			break;
+		case LOG4G_ARGUMENT_DOUBLE:
+			g_string_append_printf(string, format, arg->value.d);
+			break;
+		case LOG4G_ARGUMENT_LDOUBLE:
+			g_string_append_printf(string, format, arg->value.ld);
+			break;
+		case LOG4G_ARGUMENT_POINTER:
+			g_string_append_printf(string, format, arg->value.p);
+			break;
+		case LOG4G_ARGUMENT_STRING:
+			g_string_append_printf(string, format, arg->value.s);
+			break;
+		default:
+			break;
+		}
+		++arg;
+	}
+	return g_string_free(string, FALSE);
+}
+
+/**
+ * format_:
+ * @priv: The private data of a logging event.
+ * @message: A printf formatted log message.
+ * @ap: Format parameters.
+ *
+ * Format a log message immediately. Short messages are formatted into the
+ * inline buffer of the logging event.
+ *
+ * Returns: %TRUE if the message was formatted, %FALSE otherwise.
+ */
+static gboolean
+format_(struct Private *priv, const gchar *message, va_list ap)
+{
+	va_list aq;
+	va_copy(aq, ap);
+	gint size = g_vsnprintf(priv->buffer, sizeof(priv->buffer), message, aq);
+	va_end(aq);
+	if (size >= 0 && (gsize)size < sizeof(priv->buffer)) {
+		priv->message = priv->buffer;
+	} else {
+		priv->message = g_strdup_vprintf(message, ap);
+	}
+	return priv->message != NULL;
+}
+
+/**
+ * log4g_logging_event_set_deferred_formatting:
+ * @enabled: The new deferred formatting flag.
+ *
+ * Enable or disable deferred formatting of log messages.
+ *
+ * When deferred formatting is enabled logging events capture their format
+ * string and a copy of the format parameters, and the message is rendered
+ * by the first call to log4g_logging_event_get_rendered_message(). String
+ * parameters are copied, but the format string itself is not. Only enable
+ * deferred formatting if all format strings passed to Log4g have static
+ * storage duration (e.g. string literals).
+ *
+ * Formats that cannot be captured (positional parameters, wide character
+ * conversions, "%n", "%m", etc.) are formatted immediately.
+ *
+ * Deferred formatting may be enabled at start-up by adding "deferred" to
+ * the Log4g flags.
+ *
+ * Since: 0.1
+ */
+void
+log4g_logging_event_set_deferred_formatting(gboolean enabled)
+{
+	g_atomic_int_set(&deferred, enabled);
+}
+
+/**
+ * log4g_logging_event_get_deferred_formatting:
+ *
+ * Determine if deferred formatting is enabled.
+ *
+ * See: log4g_logging_event_set_deferred_formatting()
+ *
+ * Returns: %TRUE if deferred formatting is enabled, %FALSE otherwise.
+ * Since: 0.1
+ */
+gboolean
+log4g_logging_event_get_deferred_formatting(void)
+{
+	return g_atomic_int_get(&deferred);
+}
+
 /**
  * log4g_logging_event_new:
  * @logger: The name of the logger that is creating this event.
@@ -127,6 +926,14 @@ log4g_logging_event_class_init(Log4gLoggingEventClass *klass)
  *
  * Create a new logging event.
  *
+ * The name of the logger is interned with g_intern_string(). If @logger
+ * is already interned call log4g_logging_event_new_interned() instead.
+ *
+ * If deferred formatting is enabled and @message can be captured the
+ * message will not be formatted until it is first requested.
+ *
+ * See: log4g_logging_event_set_deferred_formatting()
+ *
  * Returns: A new logging event object.
  * Since: 0.1
  */
@@ -135,37 +942,182 @@ log4g_logging_event_new(const gchar *logger, Log4gLevel *level,
 		const gchar *function, const gchar *file, const gchar *line,
 		const gchar *message, va_list ap)
 {
-	Log4gLoggingEvent *self = g_object_new(LOG4G_TYPE_LOGGING_EVENT, NULL);
+	return log4g_logging_event_new_interned(g_intern_string(logger),
+			level, function, file, line, message, ap);
+}
+
+/**
+ * log4g_logging_event_new_interned:
+ * @logger: The interned name of the logger that is creating this event.
+ * @level: The log level of this event.
+ * @function: The function where this event was logged.
+ * @file: The file where this event was logged.
+ * @line: The line in @file where this event was logged.
+ * @message: A printf formatted log message.
+ * @ap: Format parameters.
+ *
+ * Create a new logging event for a logger name returned by
+ * g_intern_string() or g_intern_static_string().
+ *
+ * The logging event borrows @logger instead of copying it. Logger names
+ * may therefore be compared by pointer, for example the names returned by
+ * log4g_logger_get_name() and log4g_logging_event_get_logger_name().
+ *
+ * See: log4g_logging_event_new()
+ *
+ * Returns: A new logging event object.
+ * Since: 0.1
+ */
+Log4gLoggingEvent *
+log4g_logging_event_new_interned(const gchar *logger, Log4gLevel *level,
+		const gchar *function, const gchar *file, const gchar *line,
+		const gchar *message, va_list ap)
+{
+	Log4gLoggingEvent *self = event_new_();
 	if (!self) {
 		return NULL;
 	}
 	struct Private *priv = GET_PRIVATE(self);
-	if (logger) {
-		priv->logger = g_strdup(logger);
-		if (!priv->logger) {
-			goto error;
-		}
-	}
+	priv->logger = logger;
 	if (level) {
 		g_object_ref(level);
 		priv->level = level;
 	}
 	if (message) {
-		priv->message = g_strdup_vprintf(message, ap);
-		if (!priv->message) {
-			goto error;
+		if (!g_atomic_int_get(&deferred)
+				|| !deferred_new_(priv, message, ap)) {
+			if (!format_(priv, message, ap)) {
+				goto error;
+			}
 		}
 	}
 	priv->function = function;
 	priv->file = file;
 	priv->line = line;
-	g_get_current_time(&priv->timestamp);
+	log4g_logging_event_set_time_stamp_ns(self, log4g_clock_get_time());
 	return self;
 error:
 	g_object_unref(self);
 	return NULL;
 }
 
+/**
+ * log4g_logging_event_new_call_site:
+ * @logger: The interned name of the logger that is creating this event.
+ * @level: The log level of this event.
+ * @site: The call site where this event was logged.
+ * @ap: Format parameters.
+ *
+ * Create a new logging event for a static call site. The call site is
+ * registered if it has not been already.
+ *
+ * The message is always captured (regardless of
+ * log4g_logging_event_get_deferred_formatting()) unless the format of
+ * @site cannot be deferred. The format of @site is parsed the first time
+ * an event is created for it, afterwards creating an event only copies the
+ * format parameters.
+ *
+ * See: #Log4gCallSite, log4g_logging_event_get_arguments()
+ *
+ * Returns: A new logging event object.
+ * Since: 0.1
+ */
+Log4gLoggingEvent *
+log4g_logging_event_new_call_site(const gchar *logger, Log4gLevel *level,
+		Log4gCallSite *site, va_list ap)
+{
+	g_return_val_if_fail(site, NULL);
+	if (G_UNLIKELY(!g_atomic_int_get(&site->id))) {
+		log4g_call_site_register(site);
+	}
+	Log4gLoggingEvent *self = event_new_();
+	if (!self) {
+		return NULL;
+	}
+	struct Private *priv = GET_PRIVATE(self);
+	priv->logger = logger;
+	if (level) {
+		g_object_ref(level);
+		priv->level = level;
+	}
+	if (!site_capture_(priv, site, ap)) {
+		if (!format_(priv, site->format, ap)) {
+			g_object_unref(self);
+			return NULL;
+		}
+	}
+	priv->site = site;
+	priv->function = site->function;
+	priv->file = site->file;
+	priv->line = site->line;
+	log4g_logging_event_set_time_stamp_ns(self, log4g_clock_get_time());
+	return self;
+}
+
+/**
+ * log4g_logging_event_new_arguments:
+ * @logger: The name of the logger that is creating this event.
+ * @level: The log level of this event.
+ * @function: The function where this event was logged.
+ * @file: The file where this event was logged.
+ * @line: The line in @file where this event was logged.
+ * @format: A printf format.
+ * @arguments: The parameters of @format.
+ * @size: The number of elements in @arguments.
+ *
+ * Create a new logging event from previously captured format parameters.
+ * This is useful to tools that replay recorded logging events.
+ *
+ * The parameters are copied, @format is not. The message is rendered when
+ * it is first requested.
+ *
+ * See: log4g_logging_event_get_arguments()
+ *
+ * Returns: A new logging event object, or %NULL if @arguments do not match
+ *          the parameters of @format.
+ * Since: 0.1
+ */
+Log4gLoggingEvent *
+log4g_logging_event_new_arguments(const gchar *logger, Log4gLevel *level,
+		const gchar *function, const gchar *file, const gchar *line,
+		const gchar *format, const Log4gArgument *arguments,
+		guint size)
+{
+	g_return_val_if_fail(format, NULL);
+	guint n = 0;
+	Log4gArgumentType *types = types_new_(format, &n);
+	gboolean match = (types && n == size);
+	for (guint i = 0; match && i < size; ++i) {
+		match = (types[i] == arguments[i].type);
+	}
+	g_free(types);
+	if (!match) {
+		return NULL;
+	}
+	Log4gLoggingEvent *self = event_new_();
+	if (!self) {
+		return NULL;
+	}
+	struct Private *priv = GET_PRIVATE(self);
+	priv->logger = g_intern_string(logger);
+	if (level) {
+		g_object_ref(level);
+		priv->level = level;
+	}
+	Log4gArgument *arg = arguments_new_(priv, format, size);
+	for (guint i = 0; i < size; ++i) {
+		arg[i] = arguments[i];
+		if (arg[i].type == LOG4G_ARGUMENT_STRING) {
+			arg[i].value.s = g_strdup(arguments[i].value.s);
+		}
+	}
+	priv->function = function;
+	priv->file = file;
+	priv->line = line;
+	log4g_logging_event_set_time_stamp_ns(self, log4g_clock_get_time());
+	return self;
+}
+
 /**
  * log4g_logging_event_get_level:
  * @self: A logging event object.
@@ -188,6 +1140,8 @@ log4g_logging_event_get_level(Log4gLoggingEvent *self)
  *
  * Retrieve the name of the logger that created a logging event.
  *
+ * Logger names are interned (see g_intern_string()).
+ *
  * Returns: The name of the logger that created @self.
  * Since: 0.1
  */
@@ -211,7 +1165,12 @@ log4g_logging_event_get_logger_name(Log4gLoggingEvent *self)
 const gchar *
 log4g_logging_event_get_rendered_message(Log4gLoggingEvent *self)
 {
-	return GET_PRIVATE(self)->message;
+	struct Private *priv = GET_PRIVATE(self);
+	if (priv->format && g_once_init_enter(&priv->message)) {
+		g_once_init_leave(&priv->message,
+				render_(priv->format, priv->arguments));
+	}
+	return priv->message;
 }
 
 /**
@@ -228,7 +1187,48 @@ log4g_logging_event_get_rendered_message(Log4gLoggingEvent *self)
 const gchar *
 log4g_logging_event_get_message(Log4gLoggingEvent *self)
 {
-	return GET_PRIVATE(self)->message;
+	return log4g_logging_event_get_rendered_message(self);
+}
+
+/**
+ * log4g_logging_event_get_call_site:
+ * @self: A logging event object.
+ *
+ * Retrieve the call site where a logging event was logged.
+ *
+ * See: log4g_static_trace()
+ *
+ * Returns: The call site of @self, or %NULL if @self was not logged by one
+ *          of the static logging macros.
+ * Since: 0.1
+ */
+const Log4gCallSite *
+log4g_logging_event_get_call_site(Log4gLoggingEvent *self)
+{
+	return GET_PRIVATE(self)->site;
+}
+
+/**
+ * log4g_logging_event_get_arguments:
+ * @self: A logging event object.
+ * @size: Returns the number of captured parameters.
+ *
+ * Retrieve the captured format parameters of a logging event. Parameters
+ * are captured for events logged from a call site and, if deferred
+ * formatting is enabled, for other events.
+ *
+ * Returns: The captured parameters of @self, or %NULL if the message was
+ *          formatted when @self was created.
+ * Since: 0.1
+ */
+const Log4gArgument *
+log4g_logging_event_get_arguments(Log4gLoggingEvent *self, guint *size)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	if (size) {
+		*size = priv->size;
+	}
+	return (priv->format ? priv->arguments : NULL);
 }
 
 /**
@@ -246,17 +1246,54 @@ log4g_logging_event_get_message(Log4gLoggingEvent *self)
 const gchar *
 log4g_logging_event_get_mdc(Log4gLoggingEvent *self, const gchar *key)
 {
-	struct Private *priv = GET_PRIVATE(self);
-	if (priv->mdc) {
-		const gchar *value = g_hash_table_lookup(priv->mdc, key);
-		if (value) {
-			return value;
-		}
+	GQuark id = g_quark_try_string(key);
+	if (!id) {
+		return NULL;
 	}
+	return log4g_logging_event_get_mdc_by_id(self, id);
+}
+
+/**
+ * log4g_logging_event_get_mdc_by_id:
+ * @self: A logging event object.
+ * @key: A key identifier from log4g_mdc_key_register().
+ *
+ * Retrieve a mapped data context value for a logging event by the
+ * identifier of its key. Layouts should resolve their keys once and call
+ * this function rather than log4g_logging_event_get_mdc().
+ *
+ * See: #Log4gMDC
+ *
+ * Returns: The MDC value for @key.
+ * Since: 0.1
+ */
+const gchar *
+log4g_logging_event_get_mdc_by_id(Log4gLoggingEvent *self, GQuark key)
+{
+	return log4g_mdc_map_lookup(log4g_logging_event_get_mdc_map(self),
+			key);
+}
+
+/**
+ * log4g_logging_event_get_mdc_map:
+ * @self: A logging event object.
+ *
+ * Retrieve the mapped data context of a logging event. Layouts that
+ * output the whole context should iterate this map by index.
+ *
+ * See: #Log4gMDC
+ *
+ * Returns: The MDC of @self, or %NULL if it is empty.
+ * Since: 0.1
+ */
+const Log4gMDCMap *
+log4g_logging_event_get_mdc_map(Log4gLoggingEvent *self)
+{
+	struct Private *priv = GET_PRIVATE(self);
 	if (priv->mdc_lookup_required) {
-		return log4g_mdc_get(key);
+		return log4g_mdc_get_map();
 	}
-	return NULL;
+	return priv->mdc;
 }
 
 /**
@@ -274,6 +1311,45 @@ log4g_logging_event_get_time_stamp(Log4gLoggingEvent *self)
 	return &GET_PRIVATE(self)->timestamp;
 }
 
+/**
+ * log4g_logging_event_get_time_stamp_ns:
+ * @self: A logging event object.
+ *
+ * Retrieve the timestamp of a logging event with nanosecond resolution.
+ *
+ * See: log4g_clock_set_source()
+ *
+ * Returns: The number of nanoseconds elapsed since the Unix epoch when
+ *          @self was created.
+ * Since: 0.1
+ */
+gint64
+log4g_logging_event_get_time_stamp_ns(Log4gLoggingEvent *self)
+{
+	return GET_PRIVATE(self)->time;
+}
+
+/**
+ * log4g_logging_event_set_time_stamp_ns:
+ * @self: A logging event object.
+ * @time: The number of nanoseconds elapsed since the Unix epoch.
+ *
+ * Set the timestamp of a logging event. This is useful to tools that
+ * replay recorded logging events.
+ *
+ * Since: 0.1
+ */
+void
+log4g_logging_event_set_time_stamp_ns(Log4gLoggingEvent *self, gint64 time)
+{
+	g_return_if_fail(LOG4G_IS_LOGGING_EVENT(self));
+	struct Private *priv = GET_PRIVATE(self);
+	priv->time = time;
+	priv->timestamp.tv_sec = time / G_GINT64_CONSTANT(1000000000);
+	priv->timestamp.tv_usec =
+		(time % G_GINT64_CONSTANT(1000000000)) / 1000;
+}
+
 /**
  * log4g_logging_event_get_thread_name:
  * @self: A logging event object.
@@ -297,66 +1373,71 @@ log4g_logging_event_get_thread_name(Log4gLoggingEvent *self)
 }
 
 /**
- * log4g_logging_event_get_ndc:
+ * log4g_logging_event_get_thread_id:
  * @self: A logging event object.
  *
- * Retrieve the nested data context for a logging event.
+ * Retrieve the identifier of the thread where a logging event was logged.
  *
- * See: #Log4gNDC
+ * See: log4g_thread_get_id()
  *
- * Returns: The rendered NDC string for @self.
+ * Returns: The identifier of the thread where @self was logged.
  * Since: 0.1
  */
-const gchar *
-log4g_logging_event_get_ndc(Log4gLoggingEvent *self)
+guint
+log4g_logging_event_get_thread_id(Log4gLoggingEvent *self)
 {
 	struct Private *priv = GET_PRIVATE(self);
-	if (priv->ndc) {
-		return priv->ndc;
-	}
-	if (priv->ndc_lookup_required) {
-		return log4g_ndc_get();
+	if (priv->thread_lookup_required) {
+		return log4g_thread_get_id();
 	}
-	return NULL;
+	return priv->thread_id;
 }
 
 /**
- * get_keys_:
- * @key: The hash table key.
- * @value: The hash table value (unused).
- * @user_data: An array to append @key to.
+ * log4g_logging_event_get_tid:
+ * @self: A logging event object.
+ *
+ * Retrieve the operating system identifier of the thread where a logging
+ * event was logged.
+ *
+ * See: log4g_thread_get_tid()
  *
- * Callback for g_hash_table_foreach().
+ * Returns: The operating system identifier of the thread where @self was
+ *          logged.
+ * Since: 0.1
  */
-static void
-get_keys_(gpointer key, G_GNUC_UNUSED gpointer value, gpointer user_data)
+gint
+log4g_logging_event_get_tid(Log4gLoggingEvent *self)
 {
-	g_array_append_val((GArray *)user_data, key);
+	struct Private *priv = GET_PRIVATE(self);
+	if (priv->thread_lookup_required) {
+		return log4g_thread_get_tid();
+	}
+	return priv->tid;
 }
 
 /**
- * get_property_key_set_:
+ * log4g_logging_event_get_ndc:
  * @self: A logging event object.
- * @mdc: The hash table to get keys from.
  *
- * Construct a key set from an MDC hash table.
+ * Retrieve the nested data context for a logging event.
+ *
+ * See: #Log4gNDC
+ *
+ * Returns: The rendered NDC string for @self.
+ * Since: 0.1
  */
-static void
-get_property_key_set_(Log4gLoggingEvent *self, GHashTable *mdc)
+const gchar *
+log4g_logging_event_get_ndc(Log4gLoggingEvent *self)
 {
-	guint size = g_hash_table_size((GHashTable *)mdc);
 	struct Private *priv = GET_PRIVATE(self);
-	if (!size) {
-		return;
-	}
-	if (priv->keys) {
-		g_array_free(priv->keys, TRUE);
+	if (priv->ndc) {
+		return log4g_ndc_frame_get_string(priv->ndc);
 	}
-	priv->keys = g_array_sized_new(FALSE, FALSE, sizeof(gchar *), size);
-	if (!priv->keys) {
-		return;
+	if (priv->ndc_lookup_required) {
+		return log4g_ndc_get();
 	}
-	g_hash_table_foreach(mdc, get_keys_, priv->keys);
+	return NULL;
 }
 
 /**
@@ -374,40 +1455,34 @@ const GArray *
 log4g_logging_event_get_property_key_set(Log4gLoggingEvent *self)
 {
 	struct Private *priv = GET_PRIVATE(self);
-	if (priv->mdc) {
-		if (!priv->keys) {
-			get_property_key_set_(self, priv->mdc);
-		}
-	} else {
-		const GHashTable *mdc = log4g_mdc_get_context();
-		if (mdc) {
-			get_property_key_set_(self, (GHashTable *)mdc);
+	const Log4gMDCMap *mdc = log4g_logging_event_get_mdc_map(self);
+	guint size = log4g_mdc_map_get_size(mdc);
+	if (priv->keys) {
+		if (!priv->mdc_lookup_required) {
+			return priv->keys;
 		}
+		g_array_free(priv->keys, TRUE);
+		priv->keys = NULL;
+	}
+	if (!size) {
+		return NULL;
+	}
+	priv->keys = g_array_sized_new(FALSE, FALSE, sizeof(gchar *), size);
+	for (guint i = 0; i < size; ++i) {
+		const gchar *key = log4g_mdc_map_get_key(mdc, i);
+		g_array_append_val(priv->keys, key);
 	}
 	return priv->keys;
 }
 
-/**
- * mdc_copy_:
- * @key: The hash table key.
- * @value: The hash table value (unused).
- * @user_data: A hash table to insert @key & @value into.
- *
- * Callback for g_hash_table_foreach().
- */
-static void
-mdc_copy_(gpointer key, gpointer value, gpointer user_data)
-{
-	g_hash_table_insert((GHashTable *)user_data, key, value);
-}
-
 /**
  * log4g_logging_event_get_thread_copy:
  * @self: A logging event object.
  *
- * Copy the current thread name into a logging object.
+ * Copy the current thread name and identifiers into a logging object.
  *
- * Asynchronous appenders should call this function.
+ * Asynchronous appenders should call this function. Thread names are
+ * interned, so this function does not allocate memory.
  *
  * See: #Log4gThreadClass
  */
@@ -419,7 +1494,9 @@ log4g_logging_event_get_thread_copy(Log4gLoggingEvent *self)
 		return;
 	}
 	priv->thread_lookup_required = FALSE;
-	priv->thread = g_strdup(log4g_thread_get_name());
+	priv->thread = log4g_thread_get_name();
+	priv->thread_id = log4g_thread_get_id();
+	priv->tid = log4g_thread_get_tid();
 }
 
 /**
@@ -428,9 +1505,10 @@ log4g_logging_event_get_thread_copy(Log4gLoggingEvent *self)
  *
  * Copy the current mapped data context into a logging event.
  *
- * Asynchronous appenders should call this function.
+ * Asynchronous appenders should call this function. The event keeps a
+ * snapshot of the context, which does not copy it.
  *
- * See #Log4gMDC
+ * See #Log4gMDC, log4g_mdc_get_snapshot()
  *
  * Since: 0.1
  */
@@ -441,18 +1519,8 @@ log4g_logging_event_get_mdc_copy(Log4gLoggingEvent *self)
 	if (!priv->mdc_lookup_required) {
 		return;
 	}
-	const GHashTable *mdc;
 	priv->mdc_lookup_required = FALSE;
-	mdc = log4g_mdc_get_context();
-	if (!mdc) {
-		return;
-	}
-	priv->mdc = g_hash_table_new_full(g_str_hash, g_str_equal,
-			g_free, g_free);
-	if (!priv->mdc) {
-		return;
-	}
-	g_hash_table_foreach((GHashTable *)mdc, mdc_copy_, priv->mdc);
+	priv->mdc = log4g_mdc_get_snapshot();
 }
 
 /**
@@ -461,9 +1529,11 @@ log4g_logging_event_get_mdc_copy(Log4gLoggingEvent *self)
  *
  * Copy the current nested data context into a logging event.
  *
- * Asynchronous appenders should call this function.
+ * Asynchronous appenders should call this function. The event keeps a
+ * reference to the innermost context frame, the context string is not
+ * rendered until log4g_logging_event_get_ndc() is called.
  *
- * See #Log4gNDC
+ * See #Log4gNDC, log4g_ndc_get_snapshot()
  *
  * Since: 0.1
  */
@@ -475,7 +1545,7 @@ log4g_logging_event_get_ndc_copy(Log4gLoggingEvent *self)
 		return;
 	}
 	priv->ndc_lookup_required = FALSE;
-	priv->ndc = g_strdup(log4g_ndc_get());
+	priv->ndc = log4g_ndc_get_snapshot();
 }
 
 /**
@@ -559,8 +1629,8 @@ log4g_logging_event_get_full_info(Log4gLoggingEvent *self)
  *
  * Retrieve the time when the log system was initialized.
  *
- * Returns: The number of seconds elapsed since the Unix epoch when the log
- *         system was initialized
+ * Returns: The number of milliseconds elapsed since the Unix epoch when the
+ *         log system was initialized
  * Since: 0.1
  */
 glong
@@ -570,3 +1640,105 @@ log4g_logging_event_get_start_time(void)
 		g_type_class_peek(LOG4G_TYPE_LOGGING_EVENT);
 	return klass->start;
 }
+
+/**
+ * log4g_logging_event_get_start_time_ns:
+ *
+ * Retrieve the time when the log system was initialized with nanosecond
+ * resolution.
+ *
+ * Returns: The number of nanoseconds elapsed since the Unix epoch when the
+ *          log system was initialized
+ * Since: 0.1
+ */
+gint64
+log4g_logging_event_get_start_time_ns(void)
+{
+	return start;
+}
+
+/**
+ * log4g_logging_event_get_cached_output:
+ * @self: A logging event object.
+ * @fingerprint: An interned layout fingerprint.
+ * @length: (out): Returns the length of the output.
+ *
+ * Retrieve the output of a layout stored with
+ * log4g_logging_event_set_cached_output().
+ *
+ * This function is called by log4g_layout_format_to(), it is not usually
+ * called directly.
+ *
+ * Returns: The output cached for @fingerprint (not nul terminated), or
+ *          %NULL if it has not been cached.
+ * Since: 0.1
+ */
+const gchar *
+log4g_logging_event_get_cached_output(Log4gLoggingEvent *self,
+		const gchar *fingerprint, gsize *length)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	/* slots may be published out of order, check every one */
+	for (guint i = 0; i < OUTPUT_SLOTS; ++i) {
+		struct Output *output = g_atomic_pointer_get(&priv->outputs[i]);
+		if (output && output->fingerprint == fingerprint) {
+			*length = output->length;
+			return output->heap ? output->heap
+				: priv->arena + output->offset;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * log4g_logging_event_set_cached_output:
+ * @self: A logging event object.
+ * @fingerprint: An interned layout fingerprint.
+ * @string: The output of a layout with @fingerprint.
+ * @length: The length of @string.
+ *
+ * Store the output of a layout so other layouts with the same fingerprint
+ * may reuse it. Only a few fingerprints are cached per event. Outputs are
+ * copied into storage inside the event, only an output that does not fit
+ * is allocated.
+ *
+ * This function may be called from several threads at once.
+ *
+ * Since: 0.1
+ */
+void
+log4g_logging_event_set_cached_output(Log4gLoggingEvent *self,
+		const gchar *fingerprint, const gchar *string, gsize length)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	gsize cached;
+	if (log4g_logging_event_get_cached_output(self, fingerprint, &cached)) {
+		return;
+	}
+	gint index = g_atomic_int_add(&priv->count, 1);
+	if (index >= OUTPUT_SLOTS) {
+		return;
+	}
+	struct Output *output = priv->headers + index;
+	output->fingerprint = fingerprint;
+	output->length = length;
+	output->offset = 0;
+	output->heap = NULL;
+	gsize size = (length + OUTPUT_ALIGN - 1) & ~(OUTPUT_ALIGN - 1);
+	for (;;) {
+		gint used = g_atomic_int_get(&priv->used);
+		if (size > (gsize)(OUTPUT_ARENA - used)) {
+			/* rare, a large output */
+			output->heap = g_malloc(length);
+			memcpy(output->heap, string, length);
+			break;
+		}
+		if (g_atomic_int_compare_and_exchange(&priv->used, used,
+					used + (gint)size)) {
+			output->offset = used;
+			memcpy(priv->arena + used, string, length);
+			break;
+		}
+	}
+	g_atomic_pointer_set(&priv->outputs[index], output);
+}
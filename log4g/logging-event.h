@@ -18,7 +18,9 @@
 #ifndef LOG4G_LOGGING_EVENT_H
 #define LOG4G_LOGGING_EVENT_H
 
+#include <log4g/call-site.h>
 #include <log4g/level.h>
+#include <log4g/mdc.h>
 
 G_BEGIN_DECLS
 
@@ -88,11 +90,32 @@ struct Log4gLoggingEventClass_ {
 GType
 log4g_logging_event_get_type(void) G_GNUC_CONST;
 
+void
+log4g_logging_event_set_deferred_formatting(gboolean enabled);
+
+gboolean
+log4g_logging_event_get_deferred_formatting(void);
+
 Log4gLoggingEvent *
 log4g_logging_event_new(const gchar *logger, Log4gLevel *level,
 		const gchar *function, const gchar *file, const gchar *line,
 		const gchar *message, va_list ap);
 
+Log4gLoggingEvent *
+log4g_logging_event_new_interned(const gchar *logger, Log4gLevel *level,
+		const gchar *function, const gchar *file, const gchar *line,
+		const gchar *message, va_list ap);
+
+Log4gLoggingEvent *
+log4g_logging_event_new_call_site(const gchar *logger, Log4gLevel *level,
+		Log4gCallSite *site, va_list ap);
+
+Log4gLoggingEvent *
+log4g_logging_event_new_arguments(const gchar *logger, Log4gLevel *level,
+		const gchar *function, const gchar *file, const gchar *line,
+		const gchar *format, const Log4gArgument *arguments,
+		guint size);
+
 Log4gLevel *
 log4g_logging_event_get_level(Log4gLoggingEvent *self);
 
@@ -105,15 +128,39 @@ log4g_logging_event_get_rendered_message(Log4gLoggingEvent *self);
 const gchar *
 log4g_logging_event_get_message(Log4gLoggingEvent *self);
 
+const Log4gCallSite *
+log4g_logging_event_get_call_site(Log4gLoggingEvent *self);
+
+const Log4gArgument *
+log4g_logging_event_get_arguments(Log4gLoggingEvent *self, guint *size);
+
 const gchar *
 log4g_logging_event_get_mdc(Log4gLoggingEvent *self, const gchar *key);
 
+const gchar *
+log4g_logging_event_get_mdc_by_id(Log4gLoggingEvent *self, GQuark key);
+
+const Log4gMDCMap *
+log4g_logging_event_get_mdc_map(Log4gLoggingEvent *self);
+
 const GTimeVal *
 log4g_logging_event_get_time_stamp(Log4gLoggingEvent *self);
 
+gint64
+log4g_logging_event_get_time_stamp_ns(Log4gLoggingEvent *self);
+
+void
+log4g_logging_event_set_time_stamp_ns(Log4gLoggingEvent *self, gint64 time);
+
 const gchar *
 log4g_logging_event_get_thread_name(Log4gLoggingEvent *self);
 
+guint
+log4g_logging_event_get_thread_id(Log4gLoggingEvent *self);
+
+gint
+log4g_logging_event_get_tid(Log4gLoggingEvent *self);
+
 const gchar *
 log4g_logging_event_get_ndc(Log4gLoggingEvent *self);
 
@@ -144,6 +191,17 @@ log4g_logging_event_get_full_info(Log4gLoggingEvent *self);
 glong
 log4g_logging_event_get_start_time(void);
 
+gint64
+log4g_logging_event_get_start_time_ns(void);
+
+const gchar *
+log4g_logging_event_get_cached_output(Log4gLoggingEvent *self,
+		const gchar *fingerprint, gsize *length);
+
+void
+log4g_logging_event_set_cached_output(Log4gLoggingEvent *self,
+		const gchar *fingerprint, const gchar *string, gsize length);
+
 G_END_DECLS
 
 #endif /* LOG4G_LOGGING_EVENT_H */
@@ -27,12 +27,27 @@
  * Mapped data context is managed on a per-thread basis. The main difference
  * between Log4g MDCs and Log4j MDCs is that Log4g contexts are
  * <emphasis>not</emphasis> inherited by child threads.
+ *
+ * Each context is a small array of key/value pairs sorted by key. Keys are
+ * interned as #GQuark values, and values that fit are stored in the array
+ * itself, so most calls to log4g_mdc_put() do not allocate. Keys that are
+ * used often may be registered ahead of time with log4g_mdc_key_register()
+ * and then read or written with log4g_mdc_get_by_id() and
+ * log4g_mdc_put_by_id(), which do not hash the key at all. The pattern
+ * layout resolves its MDC keys this way when it is activated.
+ *
+ * Appenders that log from another thread capture the context of an event
+ * with log4g_mdc_get_snapshot(). A snapshot is the context map itself with
+ * an extra reference, so capturing it does not copy anything. The map is
+ * copied the next time log4g_mdc_put() or log4g_mdc_remove() changes it
+ * after a snapshot has been taken, which leaves the snapshot unchanged.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 #include "log4g/mdc.h"
+#include <string.h>
 
 G_DEFINE_TYPE(Log4gMDC, log4g_mdc, G_TYPE_OBJECT)
 
@@ -43,8 +58,30 @@ G_DEFINE_TYPE(Log4gMDC, log4g_mdc, G_TYPE_OBJECT)
 #define GET_PRIVATE(instance) \
 	((struct Private *)((Log4gMDC *)instance)->priv)
 
+/* Values shorter than this are stored inline */
+#define INLINE_VALUE (24)
+
+struct Entry {
+	GQuark id;
+	const gchar *key; /* The interned name of 'id' */
+	gchar *value; /* NULL if the value is stored in 'buffer' */
+	gchar buffer[INLINE_VALUE];
+};
+
+struct Log4gMDCMap_ {
+	gint ref;
+	guint size;
+	guint capacity;
+	struct Entry entries[]; /* Sorted by 'id' */
+};
+
+#define VALUE_(entry) \
+	((entry)->value ? (entry)->value : (entry)->buffer)
+
 struct Private {
-	GHashTable *table;
+	Log4gMDCMap *map; /* May be shared with snapshots */
+	gboolean shared; /* 'map' must be copied before it is changed */
+	GHashTable *context; /* Cached for log4g_mdc_get_context() */
 };
 
 /* Thread specific data. */
@@ -54,9 +91,6 @@ static void
 log4g_mdc_init(Log4gMDC *self)
 {
 	self->priv = ASSIGN_PRIVATE(self);
-	struct Private *priv = GET_PRIVATE(self);
-	priv->table = g_hash_table_new_full(g_str_hash, g_str_equal,
-			g_free, g_free);
 }
 
 static GObject *
@@ -80,9 +114,13 @@ static void
 finalize(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	if (priv->table) {
-		g_hash_table_destroy(priv->table);
-		priv->table = NULL;
+	if (priv->map) {
+		log4g_mdc_map_unref(priv->map);
+		priv->map = NULL;
+	}
+	if (priv->context) {
+		g_hash_table_destroy(priv->context);
+		priv->context = NULL;
 	}
 	G_OBJECT_CLASS(log4g_mdc_parent_class)->finalize(base);
 }
@@ -114,6 +152,167 @@ log4g_mdc_get_instance(void)
 	return self;
 }
 
+/**
+ * find_:
+ * @map: A context map.
+ * @id: The key to find.
+ * @index: Returns the index of @id, or the index it should be inserted at.
+ *
+ * Binary search a context map for a key.
+ *
+ * Returns: %TRUE if @map contains @id.
+ */
+static gboolean
+find_(const Log4gMDCMap *map, GQuark id, guint *index)
+{
+	guint low = 0, high = (map ? map->size : 0);
+	while (low < high) {
+		guint middle = low + (high - low) / 2;
+		GQuark current = map->entries[middle].id;
+		if (current == id) {
+			*index = middle;
+			return TRUE;
+		}
+		if (current < id) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	*index = low;
+	return FALSE;
+}
+
+/**
+ * writable_:
+ * @priv: The private data of an MDC object.
+ * @extra: The number of entries that will be added.
+ *
+ * Copy the context map if a snapshot of it has been taken, and make room
+ * for @extra more entries.
+ *
+ * Returns: A context map that may be modified.
+ */
+static Log4gMDCMap *
+writable_(struct Private *priv, guint extra)
+{
+	Log4gMDCMap *map = priv->map;
+	guint size = (map ? map->size : 0);
+	guint capacity = (map ? map->capacity : 0);
+	if (priv->shared || size + extra > capacity) {
+		capacity = MAX(capacity, 4);
+		while (size + extra > capacity) {
+			capacity *= 2;
+		}
+	}
+	if (priv->shared) {
+		Log4gMDCMap *copy = g_malloc(sizeof *copy
+				+ (capacity * sizeof(struct Entry)));
+		copy->ref = 1;
+		copy->size = size;
+		copy->capacity = capacity;
+		memcpy(copy->entries, map->entries,
+				size * sizeof(struct Entry));
+		for (guint i = 0; i < size; ++i) {
+			struct Entry *entry = &copy->entries[i];
+			entry->value = g_strdup(entry->value);
+		}
+		log4g_mdc_map_unref(map);
+		map = copy;
+		priv->shared = FALSE;
+	} else if (!map || capacity != map->capacity) {
+		gboolean fresh = !map;
+		map = g_realloc(map, sizeof *map
+				+ (capacity * sizeof(struct Entry)));
+		if (fresh) {
+			map->ref = 1;
+			map->size = 0;
+		}
+		map->capacity = capacity;
+	}
+	priv->map = map;
+	if (priv->context) {
+		g_hash_table_destroy(priv->context);
+		priv->context = NULL;
+	}
+	return map;
+}
+
+/**
+ * put_valist_:
+ * @id: The key to associate with @format.
+ * @format: The value to associate with @id (accepts printf formats).
+ * @ap: Format parameters.
+ *
+ * Put a context value into the current thread's context map.
+ */
+static void
+put_valist_(GQuark id, const gchar *format, va_list ap)
+{
+	Log4gMDC *self = log4g_mdc_get_instance();
+	if (!self) {
+		return;
+	}
+	struct Private *priv = GET_PRIVATE(self);
+	gchar buffer[INLINE_VALUE];
+	gchar *string = NULL;
+	va_list aq;
+	va_copy(aq, ap);
+	if (g_vsnprintf(buffer, sizeof buffer, format, ap)
+			>= (gint)sizeof buffer) {
+		string = g_strdup_vprintf(format, aq);
+	}
+	va_end(aq);
+	const gchar *value = (string ? string : buffer);
+	guint index;
+	gboolean found = find_(priv->map, id, &index);
+	if (found) {
+		if (!strcmp(VALUE_(&priv->map->entries[index]), value)) {
+			/* unchanged, keep sharing the map */
+			g_free(string);
+			return;
+		}
+		struct Entry *entry = &writable_(priv, 0)->entries[index];
+		g_free(entry->value);
+		entry->value = string;
+		if (!string) {
+			strcpy(entry->buffer, buffer);
+		}
+		return;
+	}
+	Log4gMDCMap *map = writable_(priv, 1);
+	struct Entry *entry = &map->entries[index];
+	memmove(entry + 1, entry,
+			(map->size - index) * sizeof(struct Entry));
+	++map->size;
+	entry->id = id;
+	entry->key = g_quark_to_string(id);
+	entry->value = string;
+	if (!string) {
+		strcpy(entry->buffer, buffer);
+	}
+}
+
+/**
+ * log4g_mdc_key_register:
+ * @key: A context key.
+ *
+ * Register a context key ahead of time. The identifier that is returned
+ * may be passed to log4g_mdc_put_by_id(), log4g_mdc_get_by_id() and
+ * log4g_mdc_map_lookup(), which are faster than the functions that take
+ * the name of a key. Registering a key more than once returns the same
+ * identifier.
+ *
+ * Returns: The identifier of @key.
+ * Since: 0.1
+ */
+GQuark
+log4g_mdc_key_register(const gchar *key)
+{
+	g_return_val_if_fail(key, 0);
+	return g_quark_from_string(key);
+}
+
 /**
  * log4g_mdc_put:
  * @key: The key to associate with @value.
@@ -131,14 +330,32 @@ log4g_mdc_get_instance(void)
 void
 log4g_mdc_put(const gchar *key, const gchar *value, ...)
 {
-	Log4gMDC *self = log4g_mdc_get_instance();
-	if (!self) {
-		return;
-	}
 	va_list ap;
 	va_start(ap, value);
-	g_hash_table_insert(GET_PRIVATE(self)->table, g_strdup(key),
-			g_strdup_vprintf(value, ap));
+	put_valist_(log4g_mdc_key_register(key), value, ap);
+	va_end(ap);
+}
+
+/**
+ * log4g_mdc_put_by_id:
+ * @key: A key identifier from log4g_mdc_key_register().
+ * @value: The value to associate with @key (accepts printf formats).
+ * @...: Format parameters.
+ *
+ * Put a context @value as identified by a registered @key into the current
+ * thread's context map.
+ *
+ * See: log4g_mdc_put()
+ *
+ * Since: 0.1
+ */
+void
+log4g_mdc_put_by_id(GQuark key, const gchar *value, ...)
+{
+	g_return_if_fail(key);
+	va_list ap;
+	va_start(ap, value);
+	put_valist_(key, value, ap);
 	va_end(ap);
 }
 
@@ -154,12 +371,32 @@ log4g_mdc_put(const gchar *key, const gchar *value, ...)
  */
 const gchar *
 log4g_mdc_get(const gchar *key)
+{
+	GQuark id = g_quark_try_string(key);
+	if (!id) {
+		return NULL;
+	}
+	return log4g_mdc_get_by_id(id);
+}
+
+/**
+ * log4g_mdc_get_by_id:
+ * @key: A key identifier from log4g_mdc_key_register().
+ *
+ * Retrieve the context value associated with a registered @key from the
+ * current thread's context map.
+ *
+ * Returns: The context value associated with @key.
+ * Since: 0.1
+ */
+const gchar *
+log4g_mdc_get_by_id(GQuark key)
 {
 	Log4gMDC *self = log4g_mdc_get_instance();
 	if (!self) {
 		return NULL;
 	}
-	return g_hash_table_lookup(GET_PRIVATE(self)->table, key);
+	return log4g_mdc_map_lookup(GET_PRIVATE(self)->map, key);
 }
 
 /**
@@ -174,11 +411,25 @@ log4g_mdc_get(const gchar *key)
 void
 log4g_mdc_remove(const gchar *key)
 {
+	GQuark id = g_quark_try_string(key);
+	if (!id) {
+		return;
+	}
 	Log4gMDC *self = log4g_mdc_get_instance();
 	if (!self) {
 		return;
 	}
-	g_hash_table_remove(GET_PRIVATE(self)->table, key);
+	struct Private *priv = GET_PRIVATE(self);
+	guint index;
+	if (!find_(priv->map, id, &index)) {
+		return;
+	}
+	Log4gMDCMap *map = writable_(priv, 0);
+	struct Entry *entry = &map->entries[index];
+	g_free(entry->value);
+	--map->size;
+	memmove(entry, entry + 1,
+			(map->size - index) * sizeof(struct Entry));
 }
 
 /**
@@ -186,7 +437,9 @@ log4g_mdc_remove(const gchar *key)
  *
  * Retrieve the current thread's MDC as a hash table.
  *
- * This function is used internally by appenders that log asynchronously.
+ * The hash table is built from the context map when this function is
+ * called and remains valid until the MDC of the current thread is
+ * changed. Layouts should use log4g_mdc_get_map() instead.
  *
  * Returns: The current MDC context as a hash table.
  *
@@ -199,5 +452,176 @@ log4g_mdc_get_context(void)
 	if (!self) {
 		return NULL;
 	}
-	return GET_PRIVATE(self)->table;
+	struct Private *priv = GET_PRIVATE(self);
+	if (!priv->context) {
+		priv->context = g_hash_table_new_full(g_str_hash, g_str_equal,
+				NULL, NULL);
+		guint size = log4g_mdc_map_get_size(priv->map);
+		for (guint i = 0; i < size; ++i) {
+			struct Entry *entry = &priv->map->entries[i];
+			g_hash_table_insert(priv->context, (gpointer)entry->key,
+					VALUE_(entry));
+		}
+	}
+	return priv->context;
+}
+
+/**
+ * log4g_mdc_get_map:
+ *
+ * Retrieve the current thread's context map without taking a reference.
+ *
+ * The map remains valid until the MDC of the current thread is changed.
+ * Use log4g_mdc_get_snapshot() to keep it for longer.
+ *
+ * Returns: The current context map, or %NULL if the MDC is empty.
+ * Since: 0.1
+ */
+const Log4gMDCMap *
+log4g_mdc_get_map(void)
+{
+	Log4gMDC *self = log4g_mdc_get_instance();
+	if (!self) {
+		return NULL;
+	}
+	return GET_PRIVATE(self)->map;
+}
+
+/**
+ * log4g_mdc_get_snapshot:
+ *
+ * Retrieve an immutable snapshot of the current thread's MDC.
+ *
+ * Taking a snapshot only adds a reference to the context map. Later
+ * changes to the MDC of the current thread do not affect the snapshot.
+ *
+ * This function is used internally by appenders that log asynchronously.
+ *
+ * Returns: (transfer full): A snapshot of the current MDC, or %NULL if the
+ *          MDC is empty. Release the snapshot with log4g_mdc_map_unref().
+ * Since: 0.1
+ */
+Log4gMDCMap *
+log4g_mdc_get_snapshot(void)
+{
+	Log4gMDC *self = log4g_mdc_get_instance();
+	if (!self) {
+		return NULL;
+	}
+	struct Private *priv = GET_PRIVATE(self);
+	if (!log4g_mdc_map_get_size(priv->map)) {
+		return NULL;
+	}
+	priv->shared = TRUE;
+	return log4g_mdc_map_ref(priv->map);
+}
+
+/**
+ * log4g_mdc_map_ref:
+ * @self: A context map.
+ *
+ * Add a reference to a context map.
+ *
+ * Returns: @self
+ * Since: 0.1
+ */
+Log4gMDCMap *
+log4g_mdc_map_ref(Log4gMDCMap *self)
+{
+	g_return_val_if_fail(self, NULL);
+	g_atomic_int_inc(&self->ref);
+	return self;
+}
+
+/**
+ * log4g_mdc_map_unref:
+ * @self: A context map.
+ *
+ * Release a reference to a context map. The map is freed when the last
+ * reference is released.
+ *
+ * Since: 0.1
+ */
+void
+log4g_mdc_map_unref(Log4gMDCMap *self)
+{
+	g_return_if_fail(self);
+	if (!g_atomic_int_dec_and_test(&self->ref)) {
+		return;
+	}
+	for (guint i = 0; i < self->size; ++i) {
+		g_free(self->entries[i].value);
+	}
+	g_free(self);
+}
+
+/**
+ * log4g_mdc_map_get_size:
+ * @self: A context map, or %NULL.
+ *
+ * Determine the number of entries in a context map.
+ *
+ * Returns: The number of entries in @self.
+ * Since: 0.1
+ */
+guint
+log4g_mdc_map_get_size(const Log4gMDCMap *self)
+{
+	return (self ? self->size : 0);
+}
+
+/**
+ * log4g_mdc_map_get_key:
+ * @self: A context map.
+ * @index: An entry index less than log4g_mdc_map_get_size().
+ *
+ * Retrieve the key of a context map entry. Entries are sorted by key
+ * identifier.
+ *
+ * Returns: The interned key of entry @index.
+ * Since: 0.1
+ */
+const gchar *
+log4g_mdc_map_get_key(const Log4gMDCMap *self, guint index)
+{
+	g_return_val_if_fail(self && index < self->size, NULL);
+	return self->entries[index].key;
+}
+
+/**
+ * log4g_mdc_map_get_value:
+ * @self: A context map.
+ * @index: An entry index less than log4g_mdc_map_get_size().
+ *
+ * Retrieve the value of a context map entry.
+ *
+ * Returns: The value of entry @index.
+ * Since: 0.1
+ */
+const gchar *
+log4g_mdc_map_get_value(const Log4gMDCMap *self, guint index)
+{
+	g_return_val_if_fail(self && index < self->size, NULL);
+	return VALUE_(&self->entries[index]);
+}
+
+/**
+ * log4g_mdc_map_lookup:
+ * @self: A context map, or %NULL.
+ * @key: A key identifier from log4g_mdc_key_register().
+ *
+ * Retrieve a value from a context map.
+ *
+ * Returns: The value associated with @key, or %NULL if @self does not
+ *          contain @key.
+ * Since: 0.1
+ */
+const gchar *
+log4g_mdc_map_lookup(const Log4gMDCMap *self, GQuark key)
+{
+	guint index;
+	if (!find_(self, key, &index)) {
+		return NULL;
+	}
+	return VALUE_(&self->entries[index]);
 }
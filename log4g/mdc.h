@@ -44,6 +44,15 @@ typedef struct Log4gMDC_ Log4gMDC;
 
 typedef struct Log4gMDCClass_ Log4gMDCClass;
 
+/**
+ * Log4gMDCMap:
+ *
+ * An immutable, reference counted snapshot of a mapped data context. The
+ * <structname>Log4gMDCMap</structname> structure does not have any public
+ * members.
+ */
+typedef struct Log4gMDCMap_ Log4gMDCMap;
+
 /**
  * Log4gMDC:
  *
@@ -70,18 +79,51 @@ struct Log4gMDCClass_ {
 GType
 log4g_mdc_get_type(void) G_GNUC_CONST;
 
+GQuark
+log4g_mdc_key_register(const gchar *key);
+
 void
 log4g_mdc_put(const gchar *key, const gchar *value, ...) G_GNUC_PRINTF(2, 3);
 
+void
+log4g_mdc_put_by_id(GQuark key, const gchar *value, ...) G_GNUC_PRINTF(2, 3);
+
 const gchar *
 log4g_mdc_get(const gchar *key);
 
+const gchar *
+log4g_mdc_get_by_id(GQuark key);
+
 void
 log4g_mdc_remove(const gchar *key);
 
 const GHashTable *
 log4g_mdc_get_context(void);
 
+const Log4gMDCMap *
+log4g_mdc_get_map(void);
+
+Log4gMDCMap *
+log4g_mdc_get_snapshot(void);
+
+Log4gMDCMap *
+log4g_mdc_map_ref(Log4gMDCMap *self);
+
+void
+log4g_mdc_map_unref(Log4gMDCMap *self);
+
+guint
+log4g_mdc_map_get_size(const Log4gMDCMap *self);
+
+const gchar *
+log4g_mdc_map_get_key(const Log4gMDCMap *self, guint index);
+
+const gchar *
+log4g_mdc_map_get_value(const Log4gMDCMap *self, guint index);
+
+const gchar *
+log4g_mdc_map_lookup(const Log4gMDCMap *self, GQuark key);
+
 G_END_DECLS
 
 #endif /* LOG4G_MDC_H */
@@ -47,6 +47,13 @@
  * Child threads do not automatically inherit the NDC of their parent. To
  * force a thread to inherit a nested data context use log4g_ndc_clone() &
  * log4g_ndc_inherit().
+ *
+ * Each call to log4g_ndc_push() creates an immutable, reference counted
+ * #Log4gNDCFrame that points to the frame it encloses. Asynchronous
+ * appenders capture the context of an event by adding a reference to the
+ * innermost frame, see log4g_ndc_get_snapshot(). The complete context
+ * string is only rendered when a layout asks for it, and is cached in the
+ * frame.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -54,6 +61,7 @@
 #endif
 #include "log4g/helpers/thread.h"
 #include "log4g/ndc.h"
+#include <string.h>
 
 G_DEFINE_TYPE(Log4gNDC, log4g_ndc, G_TYPE_OBJECT)
 
@@ -65,112 +73,174 @@ G_DEFINE_TYPE(Log4gNDC, log4g_ndc, G_TYPE_OBJECT)
 
 /**
  * Private:
- * @stack: The NDC stack
- * @pop: The most recently popped complete context
+ * @top: The innermost context frame
+ * @pop: The most recently popped context frame
  */
 struct Private {
-	GArray *stack;
-	gchar *pop;
+	Log4gNDCFrame *top;
+	Log4gNDCFrame *pop;
 };
 
 /**
- * Log4gDiagnosticContext:
- * @message: The current diagnostic context
- * @full: The complete diagnostic context
+ * Log4gNDCFrame:
+ * @ref: The reference count
+ * @depth: The number of frames in this context, including this one
+ * @parent: The enclosing context frame
+ * @message: The diagnostic context message of this frame
+ * @full: The complete diagnostic context, rendered on demand
  */
-typedef struct Log4gDiagnosticContext_ Log4gDiagnosticContext;
-
-struct Log4gDiagnosticContext_ {
+struct Log4gNDCFrame_ {
+	gint ref;
+	guint depth;
+	Log4gNDCFrame *parent;
 	gchar *message;
 	gchar *full;
 };
 
 /**
- * log4g_diagnostic_context_destroy:
- * @self: A diagnostic context object.
- *
- * Free dynamic resources used by a diagnostic context object.
- */
-static void
-log4g_diagnostic_context_destroy(Log4gDiagnosticContext *self)
-{
-	if (self) {
-		g_free(self->message);
-		g_free(self->full);
-		g_slice_free(Log4gDiagnosticContext, self);
-	}
-}
-
-/**
- * log4g_diagnostic_context_new:
- * @parent: The parent diagnostic context.
+ * log4g_ndc_frame_new:
+ * @parent: The enclosing context frame.
  * @message: The current diagnostic context message.
  * @ap: Format parameters for @message.
  *
- * Create a new diagnostic context object.
+ * Create a new context frame. The new frame holds a reference to @parent.
  *
- * Returns: A new diagnostic context object.
+ * Returns: A new context frame.
  */
-static Log4gDiagnosticContext *
-log4g_diagnostic_context_new(Log4gDiagnosticContext *parent,
-		const gchar *message, va_list ap)
+static Log4gNDCFrame *
+log4g_ndc_frame_new(Log4gNDCFrame *parent, const gchar *message, va_list ap)
 {
-	Log4gDiagnosticContext *self = g_slice_new0(Log4gDiagnosticContext);
+	Log4gNDCFrame *self = g_slice_new0(Log4gNDCFrame);
 	if (!self) {
 		return NULL;
 	}
 	self->message = g_strdup_vprintf(message, ap);
 	if (!self->message) {
-		goto error;
+		g_slice_free(Log4gNDCFrame, self);
+		return NULL;
 	}
+	self->ref = 1;
 	if (parent) {
-		self->full = g_strjoin(" ", parent->full, self->message, NULL);
-		if (!self->full) {
-			goto error;
-		}
+		self->parent = log4g_ndc_frame_ref(parent);
+		self->depth = parent->depth + 1;
 	} else {
-		self->full = g_strdup(self->message);
-		if (!self->full) {
-			goto error;
-		}
+		self->depth = 1;
 	}
 	return self;
-error:
-	log4g_diagnostic_context_destroy(self);
-	return NULL;
 }
 
 /**
- * log4g_diagnostic_context_clone:
- * @self: The object to clone.
+ * log4g_ndc_frame_ref:
+ * @self: A context frame.
  *
- * Clone a diagnostic context object.
+ * Add a reference to a context frame.
  *
- * Returns: An exact copy of @self.
+ * Returns: @self
+ * Since: 0.1
  */
-static Log4gDiagnosticContext *
-log4g_diagnostic_context_clone(const Log4gDiagnosticContext *self)
+Log4gNDCFrame *
+log4g_ndc_frame_ref(Log4gNDCFrame *self)
 {
-	Log4gDiagnosticContext *clone = g_slice_new0(Log4gDiagnosticContext);
-	if (!clone) {
-		return NULL;
+	g_return_val_if_fail(self, NULL);
+	g_atomic_int_inc(&self->ref);
+	return self;
+}
+
+/**
+ * log4g_ndc_frame_unref:
+ * @self: A context frame.
+ *
+ * Release a reference to a context frame. The frame is freed when the last
+ * reference is released, which in turn releases its parent.
+ *
+ * Since: 0.1
+ */
+void
+log4g_ndc_frame_unref(Log4gNDCFrame *self)
+{
+	/* iterate rather than recurse, stacks may be deep */
+	while (self && g_atomic_int_dec_and_test(&self->ref)) {
+		Log4gNDCFrame *parent = self->parent;
+		g_free(self->message);
+		g_free(self->full);
+		g_slice_free(Log4gNDCFrame, self);
+		self = parent;
 	}
-	if (self->message) {
-		clone->message = g_strdup(self->message);
-		if (!clone->message) {
-			goto error;
+}
+
+/**
+ * log4g_ndc_frame_get_message:
+ * @self: A context frame.
+ *
+ * Retrieve the message that was pushed to create a context frame.
+ *
+ * Returns: The innermost diagnostic context of @self.
+ * Since: 0.1
+ */
+const gchar *
+log4g_ndc_frame_get_message(const Log4gNDCFrame *self)
+{
+	g_return_val_if_fail(self, NULL);
+	return self->message;
+}
+
+/**
+ * log4g_ndc_frame_get_string:
+ * @self: A context frame.
+ *
+ * Retrieve the complete diagnostic context of a frame, the messages of
+ * all enclosing frames separated by spaces.
+ *
+ * The string is rendered the first time it is requested and cached in
+ * the frame. Rendering stops at the nearest enclosing frame that has
+ * already been rendered.
+ *
+ * Returns: The complete diagnostic context of @self.
+ * Since: 0.1
+ */
+const gchar *
+log4g_ndc_frame_get_string(Log4gNDCFrame *self)
+{
+	g_return_val_if_fail(self, NULL);
+	gchar *full = g_atomic_pointer_get(&self->full);
+	if (full) {
+		return full;
+	}
+	/* measure up to the nearest rendered frame */
+	const gchar *prefix = NULL;
+	gsize length = 0;
+	Log4gNDCFrame *frame;
+	for (frame = self; frame; frame = frame->parent) {
+		prefix = g_atomic_pointer_get(&frame->full);
+		if (prefix) {
+			length += strlen(prefix);
+			break;
 		}
-	}
-	if (self->full) {
-		clone->full = g_strdup(self->full);
-		if (!clone->full) {
-			goto error;
+		length += strlen(frame->message) + 1;
+	}
+	if (!prefix) {
+		--length; /* no separator before the outermost message */
+	}
+	full = g_malloc(length + 1);
+	gchar *p = full + length;
+	*p = '\0';
+	for (Log4gNDCFrame *f = self; f != frame; f = f->parent) {
+		gsize n = strlen(f->message);
+		p -= n;
+		memcpy(p, f->message, n);
+		if (p != full) {
+			*--p = ' ';
 		}
 	}
-	return clone;
-error:
-	log4g_diagnostic_context_destroy(clone);
-	return NULL;
+	if (prefix) {
+		memcpy(full, prefix, p - full);
+	}
+	if (!g_atomic_pointer_compare_and_exchange(&self->full, NULL, full)) {
+		/* another thread rendered it first */
+		g_free(full);
+		full = g_atomic_pointer_get(&self->full);
+	}
+	return full;
 }
 
 /** Thread specific data */
@@ -199,29 +269,13 @@ constructor(GType type, guint n, GObjectConstructParam *params)
 	return self;
 }
 
-static void
-free_array(GArray *data, gboolean free)
-{
-	GArray *array = (GArray *)data;
-	for (guint i = 0; i < array->len; ++i) {
-		Log4gDiagnosticContext *context =
-			g_array_index(array, Log4gDiagnosticContext *, i);
-		log4g_diagnostic_context_destroy(context);
-	}
-	if (free) {
-		g_array_free(array, TRUE);
-	}
-}
-
 static void
 finalize(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	if (priv->stack) {
-		free_array(priv->stack, TRUE);
-		priv->stack = NULL;
-	}
-	g_free(priv->pop);
+	log4g_ndc_frame_unref(priv->top);
+	priv->top = NULL;
+	log4g_ndc_frame_unref(priv->pop);
 	priv->pop = NULL;
 	G_OBJECT_CLASS(log4g_ndc_parent_class)->finalize(base);
 }
@@ -244,20 +298,34 @@ log4g_ndc_get_instance(void)
 }
 
 /**
- * log4g_ndc_get_current_stack:
+ * log4g_ndc_get_top:
  *
- * Get the current NDC stack.
+ * Get the innermost frame of the current NDC.
  *
- * Returns: The current NDC stack or NULL if none exists.
+ * Returns: The innermost context frame or NULL if the NDC is empty.
  */
-static GArray *
-log4g_ndc_get_current_stack(void)
+static Log4gNDCFrame *
+log4g_ndc_get_top(void)
 {
 	Log4gNDC *self = log4g_ndc_get_instance();
 	if (!self) {
 		return NULL;
 	}
-	return GET_PRIVATE(self)->stack;
+	return GET_PRIVATE(self)->top;
+}
+
+/**
+ * set_top_:
+ * @priv: The private data of an NDC object.
+ * @frame: The new innermost frame, the reference is transferred.
+ *
+ * Replace the innermost frame of an NDC.
+ */
+static void
+set_top_(struct Private *priv, Log4gNDCFrame *frame)
+{
+	log4g_ndc_frame_unref(priv->top);
+	priv->top = frame;
 }
 
 static void
@@ -283,10 +351,9 @@ log4g_ndc_class_init(Log4gNDCClass *klass)
 void
 log4g_ndc_clear(void)
 {
-	GArray *stack = log4g_ndc_get_current_stack();
-	if (stack) {
-		free_array(stack, FALSE);
-		g_array_set_size(stack, 0);
+	Log4gNDC *self = log4g_ndc_get_instance();
+	if (self) {
+		set_top_(GET_PRIVATE(self), NULL);
 	}
 }
 
@@ -298,45 +365,35 @@ log4g_ndc_clear(void)
  * Another thread may inherit the value returned by this function by calling
  * log4g_ndc_inherit().
  *
+ * The returned array holds a reference to each #Log4gNDCFrame of the
+ * context, outermost first. Frames are immutable, so cloning does not copy
+ * any messages.
+ *
  * <note><para>
  * The caller is responsible for calling g_array_free() or log4g_ndc_inherit()
  * for the returned value.
  * </para></note>
  *
- * Returns: (transfer container): A clone of the current nested data context.
+ * Returns: (transfer full): A clone of the current nested data context.
  * Since: 0.1
  */
 GArray *
 log4g_ndc_clone(void)
 {
-	GArray *stack = log4g_ndc_get_current_stack();
-	if (!stack) {
-		return NULL;
-	}
-	GArray *clone =
-		g_array_sized_new(FALSE, TRUE, sizeof(gchar *), stack->len);
+	Log4gNDCFrame *top = log4g_ndc_get_top();
+	guint depth = (top ? top->depth : 0);
+	GArray *clone = g_array_sized_new(FALSE, TRUE,
+			sizeof(Log4gNDCFrame *), depth);
 	if (!clone) {
 		return NULL;
 	}
-	for (guint i = 0; i < stack->len; ++i) {
-		Log4gDiagnosticContext *context =
-			g_array_index(stack, Log4gDiagnosticContext *, i);
-		if (!context) {
-			continue;
-		}
-		Log4gDiagnosticContext *copy =
-			log4g_diagnostic_context_clone(context);
-		if (!copy) {
-			goto error;
-		}
-		g_array_insert_val(clone, i, copy);
+	g_array_set_clear_func(clone, (GDestroyNotify)log4g_ndc_frame_unref);
+	g_array_set_size(clone, depth);
+	for (Log4gNDCFrame *frame = top; frame; frame = frame->parent) {
+		g_array_index(clone, Log4gNDCFrame *, frame->depth - 1) =
+			log4g_ndc_frame_ref(frame);
 	}
 	return clone;
-error:
-	if (clone) {
-		free_array(clone, TRUE);
-	}
-	return NULL;
 }
 
 /**
@@ -356,16 +413,21 @@ error:
 void
 log4g_ndc_inherit(GArray *stack)
 {
+	g_return_if_fail(stack);
 	Log4gNDC *self = log4g_ndc_get_instance();
 	if (!self) {
+		g_array_free(stack, TRUE);
 		return;
 	}
-	g_return_if_fail(stack);
-	struct Private *priv = GET_PRIVATE(self);
-	if (priv->stack) {
-		free_array(priv->stack, TRUE);
+	Log4gNDCFrame *top = NULL;
+	if (stack->len) {
+		top = g_array_index(stack, Log4gNDCFrame *, stack->len - 1);
+		if (top) {
+			log4g_ndc_frame_ref(top);
+		}
 	}
-	priv->stack = stack;
+	set_top_(GET_PRIVATE(self), top);
+	g_array_free(stack, TRUE);
 }
 
 /**
@@ -383,15 +445,36 @@ log4g_ndc_inherit(GArray *stack)
 const gchar *
 log4g_ndc_get(void)
 {
-	GArray *stack = log4g_ndc_get_current_stack();
-	if (!stack) {
+	Log4gNDCFrame *top = log4g_ndc_get_top();
+	if (!top) {
 		return NULL;
 	}
-	if (!stack->len) {
+	return log4g_ndc_frame_get_string(top);
+}
+
+/**
+ * log4g_ndc_get_snapshot:
+ *
+ * Retrieve the innermost frame of the current diagnostic context.
+ *
+ * Frames are immutable, so a snapshot is not affected by later calls to
+ * log4g_ndc_push() or log4g_ndc_pop(). Taking a snapshot only adds a
+ * reference.
+ *
+ * This function is used internally by appenders that log asynchronously.
+ *
+ * Returns: (transfer full): The innermost context frame, or %NULL if the
+ *          NDC is empty. Release the frame with log4g_ndc_frame_unref().
+ * Since: 0.1
+ */
+Log4gNDCFrame *
+log4g_ndc_get_snapshot(void)
+{
+	Log4gNDCFrame *top = log4g_ndc_get_top();
+	if (!top) {
 		return NULL;
 	}
-	return g_array_index(stack, Log4gDiagnosticContext *,
-			stack->len - 1)->full;
+	return log4g_ndc_frame_ref(top);
 }
 
 /**
@@ -405,11 +488,8 @@ log4g_ndc_get(void)
 guint
 log4g_ndc_size(void)
 {
-	GArray *stack = log4g_ndc_get_current_stack();
-	if (!stack) {
-		return 0;
-	}
-	return stack->len;
+	Log4gNDCFrame *top = log4g_ndc_get_top();
+	return (top ? top->depth : 0);
 }
 
 /**
@@ -432,19 +512,14 @@ log4g_ndc_pop(void)
 		return NULL;
 	}
 	struct Private *priv = GET_PRIVATE(self);
-	if (!priv->stack || !priv->stack->len) {
+	Log4gNDCFrame *top = priv->top;
+	if (!top) {
 		return NULL;
 	}
-	Log4gDiagnosticContext *context = g_array_index(priv->stack,
-			Log4gDiagnosticContext *, priv->stack->len - 1);
-	if (context) {
-		g_free(priv->pop);
-		priv->pop = context->message;
-		context->message = NULL;
-		log4g_diagnostic_context_destroy(context);
-	}
-	g_array_remove_index(priv->stack, priv->stack->len - 1);
-	return priv->pop;
+	priv->top = (top->parent ? log4g_ndc_frame_ref(top->parent) : NULL);
+	log4g_ndc_frame_unref(priv->pop);
+	priv->pop = top;
+	return top->message;
 }
 
 /**
@@ -462,14 +537,11 @@ log4g_ndc_pop(void)
 const gchar *
 log4g_ndc_peek(void)
 {
-	GArray *stack = log4g_ndc_get_current_stack();
-	Log4gDiagnosticContext *context;
-	if (!stack || !stack->len) {
+	Log4gNDCFrame *top = log4g_ndc_get_top();
+	if (!top) {
 		return NULL;
 	}
-	context = g_array_index(stack, Log4gDiagnosticContext *,
-			stack->len - 1);
-	return context->message;
+	return top->message;
 }
 
 /**
@@ -485,47 +557,16 @@ void
 log4g_ndc_push(const char *message, ...)
 {
 	Log4gNDC *self = log4g_ndc_get_instance();
-	va_list ap;
 	if (!self) {
 		return;
 	}
 	struct Private *priv = GET_PRIVATE(self);
-	if (!priv->stack) {
-		Log4gDiagnosticContext *context;
-		va_start(ap, message);
-		context = log4g_diagnostic_context_new(NULL, message, ap);
-		va_end(ap);
-		if (!context) {
-			return;
-		}
-		priv->stack = g_array_sized_new(FALSE, TRUE,
-				sizeof(gchar *), 1);
-		if (!priv->stack) {
-			log4g_diagnostic_context_destroy(context);
-			return;
-		}
-		g_array_append_val(priv->stack, context);
-	} else if (!priv->stack->len) {
-		Log4gDiagnosticContext *context;
-		va_start(ap, message);
-		context = log4g_diagnostic_context_new(NULL, message, ap);
-		va_end(ap);
-		if (!context) {
-			return;
-		}
-		g_array_append_val(priv->stack, context);
-	} else {
-		Log4gDiagnosticContext *context;
-		Log4gDiagnosticContext *parent =
-			g_array_index(priv->stack, Log4gDiagnosticContext *,
-					priv->stack->len - 1);
-		va_start(ap, message);
-		context = log4g_diagnostic_context_new(parent, message, ap);
-		va_end(ap);
-		if (!context) {
-			return;
-		}
-		g_array_append_val(priv->stack, context);
+	va_list ap;
+	va_start(ap, message);
+	Log4gNDCFrame *frame = log4g_ndc_frame_new(priv->top, message, ap);
+	va_end(ap);
+	if (frame) {
+		set_top_(priv, frame);
 	}
 }
 
@@ -573,14 +614,17 @@ log4g_ndc_remove(void)
 void
 log4g_ndc_set_max_depth(guint maxdepth)
 {
-	GArray *stack = log4g_ndc_get_current_stack();
-	if (!stack || (stack->len < maxdepth)) {
+	Log4gNDC *self = log4g_ndc_get_instance();
+	if (!self) {
+		return;
+	}
+	struct Private *priv = GET_PRIVATE(self);
+	Log4gNDCFrame *frame = priv->top;
+	if (!frame || frame->depth <= maxdepth) {
 		return;
 	}
-	for (guint i = stack->len - 1; i > maxdepth - 1; --i) {
-		Log4gDiagnosticContext *context =
-			g_array_index(stack, Log4gDiagnosticContext *, i);
-		log4g_diagnostic_context_destroy(context);
+	while (frame && frame->depth > maxdepth) {
+		frame = frame->parent;
 	}
-	g_array_set_size(stack, maxdepth);
+	set_top_(priv, (frame ? log4g_ndc_frame_ref(frame) : NULL));
 }
@@ -44,6 +44,15 @@ typedef struct Log4gNDC_ Log4gNDC;
 
 typedef struct Log4gNDCClass_ Log4gNDCClass;
 
+/**
+ * Log4gNDCFrame:
+ *
+ * An immutable, reference counted frame of a nested data context. The
+ * <structname>Log4gNDCFrame</structname> structure does not have any public
+ * members.
+ */
+typedef struct Log4gNDCFrame_ Log4gNDCFrame;
+
 /**
  * Log4gNDC:
  *
@@ -82,6 +91,9 @@ log4g_ndc_inherit(GArray *stack);
 const gchar *
 log4g_ndc_get(void);
 
+Log4gNDCFrame *
+log4g_ndc_get_snapshot(void);
+
 guint
 log4g_ndc_size(void);
 
@@ -100,6 +112,18 @@ log4g_ndc_remove(void);
 void
 log4g_ndc_set_max_depth(guint maxdepth);
 
+Log4gNDCFrame *
+log4g_ndc_frame_ref(Log4gNDCFrame *self);
+
+void
+log4g_ndc_frame_unref(Log4gNDCFrame *self);
+
+const gchar *
+log4g_ndc_frame_get_message(const Log4gNDCFrame *self);
+
+const gchar *
+log4g_ndc_frame_get_string(Log4gNDCFrame *self);
+
 G_END_DECLS
 
 #endif /* LOG4G_NDC_H */
@@ -26,6 +26,12 @@
  *
  * The initialization process will set the name of the main thread to "main".
  *
+ * Each thread that logs is also given a small integer identifier, see
+ * log4g_thread_get_id(), and log4g_thread_get_tid() returns the operating
+ * system identifier of the thread. The identifiers and the thread name are
+ * kept in thread local storage. Names are interned and never freed, so
+ * logging events can refer to them without copying.
+ *
  * <note><para>
  * The thread numbers are created in the order that messages are logged not
  * the order that the threads were created. If you are debugging a thread
@@ -37,85 +43,119 @@
 #include "config.h"
 #endif
 #include "log4g/helpers/thread.h"
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#include <pthread.h>
+#include <unistd.h>
 
 G_DEFINE_TYPE(Log4gThread, log4g_thread, G_TYPE_OBJECT)
 
-#define ASSIGN_PRIVATE(instance) \
-	(G_TYPE_INSTANCE_GET_PRIVATE(instance, LOG4G_TYPE_THREAD, \
-		struct Private))
-
-#define GET_PRIVATE(instance) \
-	((struct Private *)((Log4gThread *)instance)->priv)
-
-struct Private {
-	gchar *name;
+/* The identity of a thread */
+struct Current {
+	guint id; /* Zero until the thread first logs */
+	gint tid; /* Zero until requested */
+	const gchar *name; /* Interned */
 };
 
+#ifdef HAVE_TLS
+static __thread struct Current current;
+
+#define CURRENT_() (&current)
+#else
 /* Thread specific data. */
-static GPrivate priv = G_PRIVATE_INIT(g_object_unref);
+static GPrivate current = G_PRIVATE_INIT(g_free);
+
+static struct Current *
+current_(void)
+{
+	struct Current *self = g_private_get(&current);
+	if (!self) {
+		self = g_new0(struct Current, 1);
+		g_private_set(&current, self);
+	}
+	return self;
+}
+
+#define CURRENT_() current_()
+#endif
 
-/* Count the number of thread name requests. */
+/* The most recently assigned thread identifier. */
 static gint counter = 0;
 
 static void
-log4g_thread_init(Log4gThread *self)
+log4g_thread_init(G_GNUC_UNUSED Log4gThread *self)
 {
-	self->priv = ASSIGN_PRIVATE(self);
+	/* do nothing */
 }
 
-static GObject *
-constructor(GType type, guint n, GObjectConstructParam *params)
+static void
+log4g_thread_class_init(G_GNUC_UNUSED Log4gThreadClass *klass)
 {
-	GObject *self = g_private_get(&priv);
-	if (!self) {
-		self = G_OBJECT_CLASS(log4g_thread_parent_class)->
-			constructor(type, n, params);
-		if (!self) {
-			return NULL;
-		}
-		g_private_set(&priv, self);
-	} else {
-		g_object_ref(self);
-	}
-	return self;
+	/* do nothing */
 }
 
-static void
-finalize(GObject *base)
+/**
+ * log4g_thread_get_id:
+ *
+ * Retrieve the identifier of the current thread.
+ *
+ * Identifiers are small integers starting at one (1), assigned in the
+ * order that threads first log. They are never reused within a process.
+ *
+ * Returns: The identifier of the current thread.
+ * Since: 0.1
+ */
+guint
+log4g_thread_get_id(void)
 {
-	struct Private *priv = GET_PRIVATE(base);
-	g_free(priv->name);
-	priv->name = NULL;
-	G_OBJECT_CLASS(log4g_thread_parent_class)->finalize(base);
+	struct Current *self = CURRENT_();
+	if (G_UNLIKELY(!self->id)) {
+		self->id = (guint)g_atomic_int_add(&counter, 1) + 1;
+	}
+	return self->id;
 }
 
+/**
+ * forked_:
+ *
+ * Forget the cached operating system thread identifier in the child of a
+ * fork(), where the calling thread has a new identifier.
+ */
 static void
-log4g_thread_class_init(Log4gThreadClass *klass)
+forked_(void)
 {
-	GObjectClass *object_class = G_OBJECT_CLASS(klass);
-	g_private_set(&priv, NULL);
-	object_class->constructor = constructor;
-	object_class->finalize = finalize;
-	g_type_class_add_private(klass, sizeof(struct Private));
+	CURRENT_()->tid = 0;
 }
 
 /**
- * log4g_thread_get_instance:
- *
- * Retrieve a Log4gThread object.
+ * log4g_thread_get_tid:
  *
- * If one does not exist a new one will be created.
+ * Retrieve the operating system identifier of the current thread, as
+ * returned by gettid() on Linux. The identifier is cached after the
+ * first call.
  *
- * Returns: A Log4gThread object.
+ * Returns: The operating system thread identifier, or the process
+ *          identifier where thread identifiers are not available.
+ * Since: 0.1
  */
-static Log4gThread *
-log4g_thread_get_instance(void)
+gint
+log4g_thread_get_tid(void)
 {
-	Log4gThread *self = (Log4gThread *)g_private_get(&priv);
-	if (!self) {
-		self = g_object_new(LOG4G_TYPE_THREAD, NULL);
+	struct Current *self = CURRENT_();
+	if (G_UNLIKELY(!self->tid)) {
+		static gsize once = 0;
+		if (g_once_init_enter(&once)) {
+			pthread_atfork(NULL, NULL, forked_);
+			g_once_init_leave(&once, 1);
+		}
+#ifdef SYS_gettid
+		self->tid = (gint)syscall(SYS_gettid);
+#else
+		self->tid = (gint)getpid();
+#endif
 	}
-	return self;
+	return self->tid;
 }
 
 /**
@@ -123,23 +163,20 @@ log4g_thread_get_instance(void)
  *
  * Retrieve the name of the current thread.
  *
- * Returns: The name of the current thread.
+ * Returns: The interned name of the current thread.
  * Since: 0.1
  */
 const gchar *
 log4g_thread_get_name(void)
 {
-	Log4gThread *self = log4g_thread_get_instance();
-	if (!self) {
-		return NULL;
-	}
-	struct Private *priv = GET_PRIVATE(self);
-	if (!priv->name) {
-		g_atomic_int_inc(&counter);
-		priv->name = g_strdup_printf("thread%d",
-				g_atomic_int_get(&counter));
+	struct Current *self = CURRENT_();
+	if (G_UNLIKELY(!self->name)) {
+		gchar name[32];
+		g_snprintf(name, sizeof name, "thread%u",
+				log4g_thread_get_id());
+		self->name = g_intern_string(name);
 	}
-	return priv->name;
+	return self->name;
 }
 
 /**
@@ -148,16 +185,13 @@ log4g_thread_get_name(void)
  *
  * Set the name of the current thread.
  *
+ * The name is interned, so each distinct name is kept until the process
+ * exits.
+ *
  * Since: 0.1
  */
 void
 log4g_thread_set_name(const gchar *name)
 {
-	Log4gThread *self = log4g_thread_get_instance();
-	if (!self) {
-		return;
-	}
-	struct Private *priv = GET_PRIVATE(self);
-	g_free(priv->name);
-	priv->name = g_strdup(name);
+	CURRENT_()->name = g_intern_string(name);
 }
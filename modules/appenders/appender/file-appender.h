@@ -129,6 +129,9 @@ log4g_file_appender_get_buffered_io(Log4gAppender *base);
 G_GNUC_INTERNAL guint
 log4g_file_appender_get_buffer_size(Log4gAppender *base);
 
+G_GNUC_INTERNAL gboolean
+log4g_file_appender_get_io_uring(Log4gAppender *base);
+
 G_END_DECLS
 
 #endif /* LOG4G_FILE_APPENDER_H */
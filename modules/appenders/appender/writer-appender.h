@@ -62,12 +62,31 @@ struct Log4gWriterAppender_ {
  * Actual writing occurs here.
  *
  * Most subclasses of writer appender will need to override this method.
+ * It may be called from several threads at once, see
+ * log4g_writer_appender_lock().
  *
  * Since: 0.1
  */
 typedef void
 (*Log4gWriterAppenderSubAppend)(Log4gAppender *base, Log4gLoggingEvent *event);
 
+/**
+ * Log4gWriterAppenderSubAppendBatch:
+ * @base: A writer appender object.
+ * @events: The log events to append.
+ * @n: The number of events in @events.
+ *
+ * Actual writing of several events occurs here.
+ *
+ * The default implementation formats all events into one per-thread buffer
+ * and writes it with a single call to the quiet writer.
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gWriterAppenderSubAppendBatch)(Log4gAppender *base,
+		Log4gLoggingEvent **events, guint n);
+
 /**
  * Log4gWriterAppenderCloseWriter:
  * @base: A writer appender object.
@@ -97,6 +116,7 @@ typedef void
  * @sub_append: Actual writing occurs here.
  * @close_writer: Close the underlying stream.
  * @reset: Clear internal references and variables.
+ * @sub_append_batch: Actual writing of several events occurs here.
  */
 struct Log4gWriterAppenderClass_ {
 	/*< private >*/
@@ -105,6 +125,7 @@ struct Log4gWriterAppenderClass_ {
 	Log4gWriterAppenderSubAppend sub_append;
 	Log4gWriterAppenderCloseWriter close_writer;
 	Log4gWriterAppenderReset reset;
+	Log4gWriterAppenderSubAppendBatch sub_append_batch;
 };
 
 G_GNUC_INTERNAL GType
@@ -126,9 +147,19 @@ G_GNUC_INTERNAL void
 log4g_writer_appender_sub_append(Log4gAppender *base,
 		Log4gLoggingEvent *event);
 
+G_GNUC_INTERNAL void
+log4g_writer_appender_sub_append_batch(Log4gAppender *base,
+		Log4gLoggingEvent **events, guint n);
+
 G_GNUC_INTERNAL void
 log4g_writer_appender_reset(Log4gAppender *base);
 
+G_GNUC_INTERNAL void
+log4g_writer_appender_lock(Log4gAppender *base);
+
+G_GNUC_INTERNAL void
+log4g_writer_appender_unlock(Log4gAppender *base);
+
 G_GNUC_INTERNAL void
 log4g_writer_appender_write_footer(Log4gAppender *base);
 
@@ -27,6 +27,17 @@
  * buffer. You must call g_thread_init() before attempting to configure an
  * async appender.
  *
+ * Events are queued in a bounded ring buffer that is shared by all logging
+ * threads. Each slot carries a sequence number, a logging thread reserves
+ * a slot with a compare & exchange and publishes its event by advancing
+ * the sequence, so producers never take a lock while there is room. The
+ * consumer thread removes every queued event in a single pass and hands
+ * the whole batch to each attached appender with
+ * log4g_appender_do_append_batch(). The mutex and condition variables are
+ * only used to sleep: a logging thread that finds the buffer full waits
+ * until the consumer frees space, and the consumer waits while the buffer
+ * is empty.
+ *
  * Async appenders accept the following properties:
  * <orderedlist>
  * <listitem><para>blocking</para></listitem>
@@ -41,11 +52,10 @@
  * value is %TRUE.
  *
  * The buffer-size property determines how many messages are allowed in the
- * buffer before the client will block. The default value is 128.
- *
- * <note><para>
- * If blocking is %FALSE then the value of buffer-size has no effect.
- * </para></note>
+ * buffer before the client will block (or the event is discarded). It is
+ * rounded up to a power of two. The buffer is allocated when the first
+ * event is appended, changing buffer-size after that point has no effect.
+ * The default value is 128.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -141,7 +151,7 @@ log4g_discard_summary_create_event0(Log4gDiscardSummary *self,
 {
 	va_list ap;
 	va_start(ap, message);
-	Log4gLoggingEvent *event = log4g_logging_event_new(
+	Log4gLoggingEvent *event = log4g_logging_event_new_interned(
 			log4g_logging_event_get_logger_name(self->event),
 			log4g_logging_event_get_level(self->event),
 			NULL, NULL, NULL, message, ap);
@@ -166,13 +176,32 @@ log4g_discard_summary_create_event(Log4gDiscardSummary *self)
 			log4g_logging_event_get_message(self->event));
 }
 
+/* A slot of the event buffer. A slot at position 'pos' may be written
+ * when its sequence is 'pos', and read when its sequence is 'pos + 1'. */
+typedef struct Slot_ {
+	gint sequence;
+	Log4gLoggingEvent *event;
+} Slot;
+
 struct Private {
 	Log4gAppenderAttachable *appenders; /* Asynchronous appenders */
 	GHashTable *summary; /* Summary of discarded events */
-	GThreadPool *pool; /* Worker thread pool */
+	GThread *thread; /* Consumer thread */
+	Slot *ring; /* Bounded event buffer */
+	guint mask; /* Number of slots in \e ring minus one */
+	gint tail; /* Next position to write, reserved with CAS */
+	guint head; /* Next position to read, used by the consumer only */
+	gint producers; /* Number of threads in append() */
+	gint sleeping; /* The consumer waits for \e not_empty */
+	gint waiting; /* Number of producers waiting for \e not_full */
+	gint shutdown; /* Indicates producers should discard events */
+	gboolean stop; /* Indicates the consumer thread should exit */
 	gboolean blocking; /* Indicates if logging thread should block */
 	gsize size; /* Maximum size of the event queue */
 	GMutex lock; /* Synchronizes access to \e appenders */
+	GMutex queue; /* Guards sleeping on \e not_empty & \e not_full */
+	GCond not_empty; /* Signaled when an event is queued */
+	GCond not_full; /* Signaled when the consumer frees slots */
 	GMutex discard; /* Synchronizes access to \e summary */
 };
 
@@ -222,22 +251,147 @@ discarded_(G_GNUC_UNUSED gpointer key, gpointer value, gpointer user_data)
 }
 
 static void
-run_(gpointer data, gpointer user_data)
+flush_summary_(struct Private *priv)
 {
-	struct Private *priv = GET_PRIVATE(user_data);
-	g_mutex_lock(&priv->lock);
-	log4g_appender_attachable_impl_append_loop_on_appenders(
-			priv->appenders, LOG4G_LOGGING_EVENT(data));
-	g_object_unref(data);
-	if (g_atomic_int_get(&priv->blocking)) {
-		g_mutex_lock(&priv->discard);
-		if (priv->summary && g_hash_table_size(priv->summary)) {
-			g_hash_table_foreach(priv->summary, discarded_, priv);
-			g_hash_table_remove_all(priv->summary);
+	g_mutex_lock(&priv->discard);
+	if (g_hash_table_size(priv->summary)) {
+		g_hash_table_foreach(priv->summary, discarded_, priv);
+		g_hash_table_remove_all(priv->summary);
+	}
+	g_mutex_unlock(&priv->discard);
+}
+
+/* Determine if the slot at the tail of the buffer is still in use */
+static gboolean
+full_(struct Private *priv)
+{
+	guint pos = g_atomic_int_get(&priv->tail);
+	Slot *slot = priv->ring + (pos & priv->mask);
+	return (gint)((guint)g_atomic_int_get(&slot->sequence) - pos) < 0;
+}
+
+/* Determine if the slot at the head of the buffer has been published,
+ * called by the consumer */
+static gboolean
+ready_(struct Private *priv)
+{
+	Slot *slot = priv->ring + (priv->head & priv->mask);
+	return (guint)g_atomic_int_get(&slot->sequence) == priv->head + 1;
+}
+
+/* Reserve a slot & publish an event. Returns FALSE if the buffer is full. */
+static gboolean
+push_(struct Private *priv, Log4gLoggingEvent *event)
+{
+	for (;;) {
+		guint pos = g_atomic_int_get(&priv->tail);
+		Slot *slot = priv->ring + (pos & priv->mask);
+		gint diff = (gint)((guint)g_atomic_int_get(&slot->sequence)
+				- pos);
+		if (!diff) {
+			if (g_atomic_int_compare_and_exchange(&priv->tail,
+						(gint)pos, (gint)(pos + 1))) {
+				slot->event = event;
+				g_atomic_int_set(&slot->sequence,
+						(gint)(pos + 1));
+				return TRUE;
+			}
+		} else if (diff < 0) {
+			/* the consumer has not read this slot yet */
+			return FALSE;
 		}
-		g_mutex_unlock(&priv->discard);
+		/* another producer reserved 'pos' */
 	}
+}
+
+/* Remove every published event, called by the consumer */
+static gsize
+pop_(struct Private *priv, Log4gLoggingEvent **batch)
+{
+	gsize n = 0;
+	while (n <= priv->mask && ready_(priv)) {
+		Slot *slot = priv->ring + (priv->head & priv->mask);
+		batch[n++] = slot->event;
+		slot->event = NULL;
+		g_atomic_int_set(&slot->sequence,
+				(gint)(priv->head + priv->mask + 1));
+		++priv->head;
+	}
+	return n;
+}
+
+static gpointer
+run_(gpointer data)
+{
+	struct Private *priv = GET_PRIVATE(data);
+	Log4gLoggingEvent **batch =
+		g_new(Log4gLoggingEvent *, priv->mask + 1);
+	for (;;) {
+		gsize n = pop_(priv, batch);
+		if (!n) {
+			g_mutex_lock(&priv->queue);
+			g_atomic_int_set(&priv->sleeping, TRUE);
+			while (!ready_(priv) && !priv->stop) {
+				g_cond_wait(&priv->not_empty, &priv->queue);
+			}
+			g_atomic_int_set(&priv->sleeping, FALSE);
+			gboolean stop = !ready_(priv);
+			g_mutex_unlock(&priv->queue);
+			if (stop) {
+				/* stopped with an empty buffer */
+				break;
+			}
+			continue;
+		}
+		if (g_atomic_int_get(&priv->waiting)) {
+			g_mutex_lock(&priv->queue);
+			g_cond_broadcast(&priv->not_full);
+			g_mutex_unlock(&priv->queue);
+		}
+		g_mutex_lock(&priv->lock);
+		log4g_appender_attachable_impl_append_batch_loop_on_appenders(
+				priv->appenders, batch, n);
+		flush_summary_(priv);
+		g_mutex_unlock(&priv->lock);
+		for (gsize i = 0; i < n; ++i) {
+			g_object_unref(batch[i]);
+		}
+	}
+	g_mutex_lock(&priv->lock);
+	flush_summary_(priv);
 	g_mutex_unlock(&priv->lock);
+	g_free(batch);
+	return NULL;
+}
+
+/* priv->queue must be held */
+static gboolean
+start_(Log4gAppender *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	GError *error = NULL;
+	guint capacity = 1;
+	while (capacity < priv->size && capacity <= G_MAXINT / 4) {
+		capacity <<= 1;
+	}
+	Slot *ring = g_new0(Slot, capacity);
+	for (guint i = 0; i < capacity; ++i) {
+		ring[i].sequence = (gint)i;
+	}
+	priv->mask = capacity - 1;
+	priv->head = 0;
+	priv->tail = 0;
+	priv->stop = FALSE;
+	g_atomic_pointer_set(&priv->ring, ring);
+	priv->thread = g_thread_try_new("log4g-async", run_, base, &error);
+	if (!priv->thread) {
+		log4g_log_warn("g_thread_try_new(): %s", error->message);
+		g_error_free(error);
+		g_atomic_pointer_set(&priv->ring, NULL);
+		g_free(ring);
+		return FALSE;
+	}
+	return TRUE;
 }
 
 static void
@@ -245,15 +399,15 @@ log4g_async_appender_init(Log4gAsyncAppender *self)
 {
 	self->priv = ASSIGN_PRIVATE(self);
 	struct Private *priv = GET_PRIVATE(self);
-	GError *error = NULL;
 	priv->appenders = log4g_appender_attachable_impl_new();
+	/* keyed by interned logger name */
+	priv->summary = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, (GDestroyNotify)log4g_discard_summary_destroy);
 	priv->blocking = TRUE;
 	priv->size = 128;
-	priv->pool = g_thread_pool_new(run_, self, 1, TRUE, &error);
-	if (error) {
-		log4g_log_warn("g_thread_pool_new(): %s", error->message);
-		g_error_free(error);
-	}
+	g_mutex_init(&priv->queue);
+	g_cond_init(&priv->not_empty);
+	g_cond_init(&priv->not_full);
 }
 
 static void
@@ -277,6 +431,9 @@ finalize(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
 	g_mutex_clear(&priv->lock);
+	g_mutex_clear(&priv->queue);
+	g_cond_clear(&priv->not_empty);
+	g_cond_clear(&priv->not_full);
 	g_mutex_clear(&priv->discard);
 	G_OBJECT_CLASS(log4g_async_appender_parent_class)->finalize(base);
 }
@@ -292,25 +449,13 @@ static void
 set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	gboolean blocking;
 	switch (id) {
 	case PROP_BLOCKING:
-		blocking = g_value_get_boolean(value);
-		g_mutex_lock(&priv->discard);
-		if (blocking) {
-			if (!priv->summary) {
-				priv->summary = g_hash_table_new_full(
-						g_str_hash, g_str_equal, NULL,
-						(GDestroyNotify)log4g_discard_summary_destroy);
-			}
-		} else {
-			if (priv->summary) {
-				g_hash_table_destroy(priv->summary);
-				priv->summary = NULL;
-			}
-		}
-		g_atomic_int_set(&priv->blocking, blocking);
-		g_mutex_unlock(&priv->discard);
+		g_mutex_lock(&priv->queue);
+		g_atomic_int_set(&priv->blocking, g_value_get_boolean(value));
+		/* release producers waiting for room */
+		g_cond_broadcast(&priv->not_full);
+		g_mutex_unlock(&priv->queue);
 		break;
 	case PROP_BUFFER_SIZE:
 		priv->size = g_value_get_int(value);
@@ -321,12 +466,29 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	}
 }
 
+static void
+discard_(struct Private *priv, Log4gLoggingEvent *event)
+{
+	Log4gDiscardSummary *summary;
+	const gchar *name = log4g_logging_event_get_logger_name(event);
+	g_mutex_lock(&priv->discard);
+	summary = g_hash_table_lookup(priv->summary, name);
+	if (!summary) {
+		summary = log4g_discard_summary_new(event);
+		if (summary) {
+			g_hash_table_insert(priv->summary, (gpointer)name,
+					summary);
+		}
+	} else {
+		log4g_discard_summary_add(summary, event);
+	}
+	g_mutex_unlock(&priv->discard);
+}
+
 static void
 append(Log4gAppender *base, Log4gLoggingEvent *event)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	gboolean blocking = g_atomic_int_get(&priv->blocking);
-	gboolean discard = FALSE;
 	if (!g_thread_supported()) {
 		log4g_log_warn("Log4gAsyncAppender: threading is not enabled "
 				"(message discarded)");
@@ -335,44 +497,46 @@ append(Log4gAppender *base, Log4gLoggingEvent *event)
 	log4g_logging_event_get_thread_copy(event);
 	log4g_logging_event_get_ndc_copy(event);
 	log4g_logging_event_get_mdc_copy(event);
-	if (blocking) {
-		while (g_thread_pool_unprocessed(priv->pool) >= priv->size) {
-			g_usleep(5000); /* sleep 5 milliseconds */
-		}
-	} else {
-		if (G_UNLIKELY(g_thread_pool_unprocessed(priv->pool)
-					> priv->size)) {
-			discard = TRUE;
-		}
+	/* close_() frees the buffer once no thread is in append() */
+	g_atomic_int_inc(&priv->producers);
+	if (G_UNLIKELY(g_atomic_int_get(&priv->shutdown))) {
+		goto exit;
 	}
-	if (!discard) {
-		g_object_ref(event);
-		GError *error = NULL;
-		g_thread_pool_push(priv->pool, event, &error);
-		if (error) {
-			log4g_log_error("g_thread_pool_push(): %s",
-					error->message);
-			g_error_free(error);
-			discard = TRUE;
+	if (G_UNLIKELY(!g_atomic_pointer_get(&priv->ring))) {
+		g_mutex_lock(&priv->queue);
+		gboolean started = priv->ring || start_(base);
+		g_mutex_unlock(&priv->queue);
+		if (!started) {
+			goto exit;
 		}
 	}
-	if (G_UNLIKELY(discard)) {
-		Log4gDiscardSummary *summary;
-		const gchar *name = log4g_logging_event_get_logger_name(event);
-		g_mutex_lock(&priv->discard);
-		summary = g_hash_table_lookup(priv->summary, name);
-		if (!summary) {
-			summary = log4g_discard_summary_new(event);
-			if (!summary) {
-				return;
-			}
-			g_hash_table_insert(priv->summary, (gpointer)name,
-					summary);
-		} else {
-			log4g_discard_summary_add(summary, event);
+	g_object_ref(event);
+	while (!push_(priv, event)) {
+		if (!g_atomic_int_get(&priv->blocking)) {
+			discard_(priv, event);
+			g_object_unref(event);
+			goto exit;
+		}
+		g_mutex_lock(&priv->queue);
+		g_atomic_int_inc(&priv->waiting);
+		while (full_(priv) && g_atomic_int_get(&priv->blocking)
+				&& !g_atomic_int_get(&priv->shutdown)) {
+			g_cond_wait(&priv->not_full, &priv->queue);
+		}
+		g_atomic_int_add(&priv->waiting, -1);
+		g_mutex_unlock(&priv->queue);
+		if (G_UNLIKELY(g_atomic_int_get(&priv->shutdown))) {
+			g_object_unref(event);
+			goto exit;
 		}
-		g_mutex_unlock(&priv->discard);
 	}
+	if (g_atomic_int_get(&priv->sleeping)) {
+		g_mutex_lock(&priv->queue);
+		g_cond_signal(&priv->not_empty);
+		g_mutex_unlock(&priv->queue);
+	}
+exit:
+	g_atomic_int_add(&priv->producers, -1);
 }
 
 static void
@@ -381,10 +545,26 @@ close_(Log4gAppender *base)
 	struct Private *priv = GET_PRIVATE(base);
 	if (!log4g_appender_get_closed(base)) {
 		log4g_appender_set_closed(base, TRUE);
-		if (priv->pool) {
-			g_thread_pool_free(priv->pool, FALSE, TRUE);
-			priv->pool = NULL;
+		g_mutex_lock(&priv->queue);
+		g_atomic_int_set(&priv->shutdown, TRUE);
+		g_cond_broadcast(&priv->not_full);
+		g_mutex_unlock(&priv->queue);
+		/* wait for producers to publish or discard their events */
+		while (g_atomic_int_get(&priv->producers)) {
+			g_thread_yield();
+		}
+		g_mutex_lock(&priv->queue);
+		priv->stop = TRUE;
+		g_cond_signal(&priv->not_empty);
+		GThread *thread = priv->thread;
+		priv->thread = NULL;
+		g_mutex_unlock(&priv->queue);
+		if (thread) {
+			/* the consumer drains the buffer before exiting */
+			g_thread_join(thread);
 		}
+		g_free(priv->ring);
+		priv->ring = NULL;
 	}
 }
 
@@ -405,6 +585,8 @@ log4g_async_appender_class_init(Log4gAsyncAppenderClass *klass)
 	appender_class->append = append;
 	appender_class->close = close_;
 	appender_class->requires_layout = requires_layout;
+	/* slots of the event buffer are reserved atomically */
+	appender_class->concurrent_append = TRUE;
 	g_type_class_add_private(klass, sizeof(struct Private));
 	/* install properties */
 	g_object_class_install_property(object_class, PROP_BLOCKING,
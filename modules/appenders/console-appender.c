@@ -177,6 +177,8 @@ log4g_console_appender_class_init(Log4gConsoleAppenderClass *klass)
 	Log4gAppenderClass *appender_class = LOG4G_APPENDER_CLASS(klass);
 	appender_class->close = close_;
 	appender_class->activate_options = activate_options;
+	/* the target is only written under the writer appender lock */
+	appender_class->concurrent_append = TRUE;
 	Log4gWriterAppenderClass *writer_class =
 		LOG4G_WRITER_APPENDER_CLASS(klass);
 	writer_class->close_writer = close_writer;
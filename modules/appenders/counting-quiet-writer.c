@@ -50,18 +50,18 @@ log4g_counting_quiet_writer_init(Log4gCountingQuietWriter *self)
 }
 
 static void
-write_(Log4gQuietWriter *self, const gchar *string)
+write_len(Log4gQuietWriter *self, const gchar *buffer, gsize length)
 {
 	LOG4G_QUIET_WRITER_CLASS(log4g_counting_quiet_writer_parent_class)->
-		write(self, string);
-	GET_PRIVATE(self)->count += strlen(string);
+		write_len(self, buffer, length);
+	GET_PRIVATE(self)->count += length;
 }
 
 static void
 log4g_counting_quiet_writer_class_init(Log4gCountingQuietWriterClass *klass)
 {
 	Log4gQuietWriterClass *qw_class = LOG4G_QUIET_WRITER_CLASS(klass);
-	qw_class->write = write_;
+	qw_class->write_len = write_len;
 	g_type_class_add_private(klass, sizeof(struct Private));
 }
 
@@ -27,6 +27,7 @@
  * <listitem><para>append</para></listitem>
  * <listitem><para>buffered-io</para></listitem>
  * <listitem><para>buffer-size</para></listitem>
+ * <listitem><para>io-uring</para></listitem>
  * </orderedlist>
  *
  * The value of file specifies the location of the output. This may be an
@@ -41,12 +42,22 @@
  *
  * The buffer-size property controls the size of the I/O buffer. The default
  * value is eight kilobytes (8192 bytes).
+ *
+ * The value of io-uring determines if output is written by a completion
+ * thread instead of the logging thread. Events are copied to a buffer that
+ * the completion thread submits to an io_uring(7) in batches, and flushes
+ * become an fdatasync(2) linked after the write. The buffered-io and
+ * buffer-size properties have no effect when this property is set. The
+ * default value is %FALSE.
+ *
+ * @See: #Log4gUringQuietWriter
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 #include "appender/file-appender.h"
+#include "helpers/uring-quiet-writer.h"
 #include <errno.h>
 
 G_DEFINE_DYNAMIC_TYPE(Log4gFileAppender, log4g_file_appender,
@@ -64,6 +75,7 @@ struct Private {
 	gchar *file;
 	gboolean buffered;
 	guint size;
+	gboolean uring;
 	GMutex lock;
 };
 
@@ -100,6 +112,7 @@ enum Properties {
 	PROP_APPEND,
 	PROP_BUFFERED_IO,
 	PROP_BUFFER_SIZE,
+	PROP_IO_URING,
 	PROP_MAX
 };
 
@@ -135,6 +148,9 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	case PROP_BUFFER_SIZE:
 		priv->size = g_value_get_uint(value);
 		break;
+	case PROP_IO_URING:
+		priv->uring = g_value_get_boolean(value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(base, id, pspec);
 		break;
@@ -163,7 +179,9 @@ static void
 set_qw_for_files(Log4gAppender *base, FILE *file)
 {
 	GObject *error = log4g_appender_get_error_handler(base);
-	Log4gQuietWriter *writer = log4g_quiet_writer_new(file, error);
+	Log4gQuietWriter *writer = (GET_PRIVATE(base)->uring
+			? log4g_uring_quiet_writer_new(file, error)
+			: log4g_quiet_writer_new(file, error));
 	if (writer) {
 		log4g_writer_appender_set_quiet_writer(base, writer);
 		g_object_unref(writer);
@@ -224,6 +242,8 @@ log4g_file_appender_class_init(Log4gFileAppenderClass *klass)
 	object_class->set_property = set_property;
 	Log4gAppenderClass *appender_class = LOG4G_APPENDER_CLASS(klass);
 	appender_class->activate_options = activate_options;
+	/* files are opened & written under the writer appender lock */
+	appender_class->concurrent_append = TRUE;
 	Log4gWriterAppenderClass *writer_class =
 		LOG4G_WRITER_APPENDER_CLASS(klass);
 	writer_class->reset = reset;
@@ -245,6 +265,10 @@ log4g_file_appender_class_init(Log4gFileAppenderClass *klass)
 		g_param_spec_uint("buffer-size", Q_("Buffer Size"),
 			Q_("Size of the output buffer"),
 			0, G_MAXUINT, 8 * 1024, G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_IO_URING,
+		g_param_spec_boolean("io-uring", Q_("io_uring"),
+			Q_("Write from an io_uring completion thread"),
+			FALSE, G_PARAM_WRITABLE));
 }
 
 static void
@@ -258,6 +282,8 @@ void
 log4g_file_appender_register(GTypeModule *module)
 {
     log4g_quiet_writer_register(module);
+    log4g_counting_quiet_writer_register(module);
+    log4g_uring_quiet_writer_register(module);
     log4g_file_appender_register_type(module);
 }
 
@@ -367,3 +393,19 @@ log4g_file_appender_get_buffer_size(Log4gAppender *base)
 	g_return_val_if_fail(LOG4G_IS_FILE_APPENDER(base), FALSE);
 	return GET_PRIVATE(base)->size;
 }
+
+/**
+ * log4g_file_appender_get_io_uring:
+ * @base: A file appender object.
+ *
+ * Retrieve the io-uring property.
+ *
+ * Returns: The io-uring value for @base.
+ * Since: 0.1
+ */
+gboolean
+log4g_file_appender_get_io_uring(Log4gAppender *base)
+{
+	g_return_val_if_fail(LOG4G_IS_FILE_APPENDER(base), FALSE);
+	return GET_PRIVATE(base)->uring;
+}
@@ -72,15 +72,64 @@ struct Log4gQuietWriter_ {
 typedef void
 (*Log4gQuietWriterWrite)(Log4gQuietWriter *self, const gchar *string);
 
+/**
+ * Log4gQuietWriterWriteLen:
+ * @self: A quiet writer object.
+ * @buffer: The bytes to write.
+ * @length: The number of bytes in @buffer.
+ *
+ * Write @length bytes to a stdio(3) stream.
+ *
+ * The buffer does not need to be nul-terminated and may contain embedded
+ * nul bytes.
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gQuietWriterWriteLen)(Log4gQuietWriter *self, const gchar *buffer,
+		gsize length);
+
+/**
+ * Log4gQuietWriterFlush:
+ * @self: A quiet writer object.
+ *
+ * Flush a stdio(3) stream.
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gQuietWriterFlush)(Log4gQuietWriter *self);
+
+/**
+ * Log4gQuietWriterClose:
+ * @self: A quiet writer object.
+ *
+ * Close a stdio(3) stream.
+ *
+ * Since: 0.1
+ */
+typedef void
+(*Log4gQuietWriterClose)(Log4gQuietWriter *self);
+
 /**
  * Log4gQuietWriterClass:
  * @write: Write to a stdio(3) stream.
+ * @write_len: Write a sized buffer to a stdio(3) stream.
+ * @flush: Flush a stdio(3) stream.
+ * @close: Close a stdio(3) stream.
+ *
+ * The default @write implementation calls @write_len, sub-classes that
+ * need to observe every write should override @write_len. Sub-classes that
+ * bypass the stdio(3) stream should also override @flush and @close.
  */
 struct Log4gQuietWriterClass_ {
 	/*< private >*/
 	GObjectClass parent_class;
 	/*< public >*/
 	Log4gQuietWriterWrite write;
+	Log4gQuietWriterWriteLen write_len;
+	Log4gQuietWriterFlush flush;
+	Log4gQuietWriterClose close;
 };
 
 G_GNUC_INTERNAL GType
@@ -98,6 +147,10 @@ log4g_quiet_writer_close(Log4gQuietWriter *self);
 G_GNUC_INTERNAL void
 log4g_quiet_writer_write(Log4gQuietWriter *self, const char *string);
 
+G_GNUC_INTERNAL void
+log4g_quiet_writer_write_len(Log4gQuietWriter *self, const gchar *buffer,
+		gsize length);
+
 G_GNUC_INTERNAL void
 log4g_quiet_writer_flush(Log4gQuietWriter *self);
 
@@ -0,0 +1,85 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG4G_URING_QUIET_WRITER_H
+#define LOG4G_URING_QUIET_WRITER_H
+
+#include "helpers/counting-quiet-writer.h"
+
+G_BEGIN_DECLS
+
+#define LOG4G_TYPE_URING_QUIET_WRITER \
+	(log4g_uring_quiet_writer_get_type())
+
+#define LOG4G_URING_QUIET_WRITER(instance) \
+	(G_TYPE_CHECK_INSTANCE_CAST((instance), \
+		LOG4G_TYPE_URING_QUIET_WRITER, Log4gUringQuietWriter))
+
+#define LOG4G_IS_URING_QUIET_WRITER(instance) \
+	(G_TYPE_CHECK_INSTANCE_TYPE((instance), \
+		LOG4G_TYPE_URING_QUIET_WRITER))
+
+#define LOG4G_URING_QUIET_WRITER_CLASS(klass) \
+	(G_TYPE_CHECK_CLASS_CAST((klass), LOG4G_TYPE_URING_QUIET_WRITER, \
+		Log4gUringQuietWriterClass))
+
+#define LOG4G_IS_URING_QUIET_WRITER_CLASS(klass) \
+	(G_TYPE_CHECK_CLASS_TYPE((klass), LOG4G_TYPE_URING_QUIET_WRITER))
+
+#define LOG4G_URING_QUIET_WRITER_GET_CLASS(instance) \
+	(G_TYPE_INSTANCE_GET_CLASS((instance), \
+		LOG4G_TYPE_URING_QUIET_WRITER, Log4gUringQuietWriterClass))
+
+typedef struct Log4gUringQuietWriter_ Log4gUringQuietWriter;
+
+typedef struct Log4gUringQuietWriterClass_ Log4gUringQuietWriterClass;
+
+/**
+ * Log4gUringQuietWriter:
+ *
+ * The <structname>Log4gUringQuietWriter</structname> structure does not
+ * have any public members.
+ */
+struct Log4gUringQuietWriter_ {
+	/*< private >*/
+	Log4gCountingQuietWriter parent_instance;
+	gpointer priv;
+};
+
+/**
+ * Log4gUringQuietWriterClass:
+ *
+ * The <structname>Log4gUringQuietWriterClass</structname> structure does
+ * not have any public members.
+ */
+struct Log4gUringQuietWriterClass_ {
+	/*< private >*/
+	Log4gCountingQuietWriterClass parent_class;
+};
+
+G_GNUC_INTERNAL GType
+log4g_uring_quiet_writer_get_type(void);
+
+G_GNUC_INTERNAL void
+log4g_uring_quiet_writer_register(GTypeModule *module);
+
+G_GNUC_INTERNAL Log4gQuietWriter *
+log4g_uring_quiet_writer_new(FILE *file, GObject *error);
+
+G_END_DECLS
+
+#endif /* LOG4G_URING_QUIET_WRITER_H */
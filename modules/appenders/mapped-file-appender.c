@@ -0,0 +1,735 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: mapped-file-appender
+ * @short_description: Log events to a memory mapped file
+ * @see_also: #Log4gFileAppender
+ *
+ * The mapped file appender logs events to a regular file through a shared
+ * memory mapping instead of a stdio(3) stream.
+ *
+ * The file is mapped in fixed size segments. Events are formatted on the
+ * calling thread and space is reserved for them in the current segment
+ * with an atomic compare & exchange, so threads copy their events into the
+ * file in parallel without taking a lock or making a system call. A
+ * background thread allocates and maps the next segment ahead of time and
+ * unmaps segments once they have been filled. If a segment cannot be
+ * mapped the error handler of the appender is notified, and mapping is
+ * tried again by the next event.
+ *
+ * Events are in the page cache as soon as they have been copied, so they
+ * are not lost if the application crashes. They may still be lost if the
+ * operating system crashes before the pages are written back.
+ *
+ * The file grows one segment at a time and is truncated to the length of
+ * the data written when the appender is closed. While the file is open a
+ * marker file of the same name with the suffix ".open" exists next to it.
+ * After a crash the marker is left behind and the file ends with unused
+ * zero bytes, which are removed the next time it is opened in append mode.
+ * Output that ends with a zero byte is only trimmed in this case.
+ *
+ * Mapped file appenders accept the following properties:
+ * <orderedlist>
+ * <listitem><para>file</para></listitem>
+ * <listitem><para>append</para></listitem>
+ * <listitem><para>segment-size</para></listitem>
+ * </orderedlist>
+ *
+ * The value of file specifies the location of the output. This may be an
+ * absolute or relative path.
+ *
+ * The value of append determines if the file will be truncated when it is
+ * opened for writing. The default value is %TRUE (i.e. do not truncate).
+ *
+ * The value of segment-size is the size of each mapping. It is rounded up
+ * to a multiple of the page size. The default value is four megabytes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "appender/mapped-file-appender.h"
+#include "log4g/helpers/hazard.h"
+#include "log4g/interface/error-handler.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+G_DEFINE_DYNAMIC_TYPE(Log4gMappedFileAppender, log4g_mapped_file_appender,
+		LOG4G_TYPE_APPENDER)
+
+#define ASSIGN_PRIVATE(instance) \
+	(G_TYPE_INSTANCE_GET_PRIVATE(instance, \
+		LOG4G_TYPE_MAPPED_FILE_APPENDER, struct Private))
+
+#define GET_PRIVATE(instance) \
+	((struct Private *)((Log4gMappedFileAppender *)instance)->priv)
+
+/** \brief The default segment size */
+#define SEGMENT_SIZE (4 * 1024 * 1024)
+
+/** \brief The largest segment size */
+#define MAX_SEGMENT_SIZE (256 * 1024 * 1024)
+
+/** \brief Formatted events larger than this are discarded */
+#define MAX_RECORD (64 * 1024 * 1024)
+
+/* Reservations never pass the end of a segment by more than one record */
+G_STATIC_ASSERT(MAX_SEGMENT_SIZE + (gint64)MAX_RECORD <= G_MAXINT);
+
+/** \brief The suffix of the marker that exists while the file is open */
+#define MARKER ".open"
+
+/** \brief The initial size of a per-thread format buffer */
+#define BUF_SIZE (256)
+
+/** \brief Per-thread format buffers larger than this are released */
+#define MAX_CAPACITY (64 * 1024)
+
+/* A mapped region of the file */
+typedef struct Segment_ {
+	gchar *map;
+	goffset offset; /* The file offset of 'map' */
+	gint size; /* The length of 'map' */
+	gint reserved; /* Bytes reserved by writers, may exceed 'size' by
+			  less than MAX_RECORD, see write_() */
+	gint committed; /* Bytes copied into 'map' */
+} Segment;
+
+struct Private {
+	gchar *file;
+	gchar *marker; /* Exists while 'fd' is open */
+	gboolean append;
+	guint size;
+	gint length; /* 'size' rounded up to a multiple of the page size */
+	gint fd;
+	goffset end; /* The length of the file when it is closed */
+	Segment *current; /* Read via hazard pointers, see write_() */
+	Segment *spare; /* The segment after 'current', mapped ahead of time */
+	goffset ahead; /* The offset of the last segment mapped ahead */
+	GQueue full; /* Replaced segments waiting to be unmapped */
+	GThread *thread; /* Maps & unmaps segments */
+	gboolean shutdown;
+	GMutex lock; /* Guards everything except reading 'current' */
+	GCond wake;
+};
+
+static void
+buffer_free_(gpointer string)
+{
+	g_string_free(string, TRUE);
+}
+
+static GPrivate buffer = G_PRIVATE_INIT(buffer_free_);
+
+/* Retrieve the (empty) per-thread buffer events are formatted into */
+static GString *
+buffer_(void)
+{
+	GString *string = g_private_get(&buffer);
+	if (G_UNLIKELY(!string || string->allocated_len > MAX_CAPACITY)) {
+		string = g_string_sized_new(BUF_SIZE);
+		g_private_replace(&buffer, string);
+	} else {
+		g_string_set_size(string, 0);
+	}
+	return string;
+}
+
+/* Allocate the file blocks in [offset, offset + size) and map them */
+static Segment *
+map_(struct Private *priv, goffset offset, gint size)
+{
+	gint error = posix_fallocate(priv->fd, offset, size);
+	if (error) {
+		log4g_log_error("posix_fallocate(): %s", g_strerror(error));
+		return NULL;
+	}
+	gpointer map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			priv->fd, offset);
+	if (MAP_FAILED == map) {
+		log4g_log_error("mmap(): %s", g_strerror(errno));
+		return NULL;
+	}
+	Segment *self = g_new0(Segment, 1);
+	self->map = map;
+	self->offset = offset;
+	self->size = size;
+	return self;
+}
+
+/* Schedule the write back of a segment and release its mapping */
+static void
+unmap_(Segment *self)
+{
+	if (msync(self->map, self->size, MS_ASYNC)) {
+		log4g_log_error("msync(): %s", g_strerror(errno));
+	}
+	if (munmap(self->map, self->size)) {
+		log4g_log_error("munmap(): %s", g_strerror(errno));
+	}
+	self->map = NULL;
+}
+
+/* Replace the full segment 'seg', priv->lock must be held. The caller
+ * claims the first 'reserved' bytes of the returned segment. */
+static Segment *
+advance_(struct Private *priv, Segment *seg, gint reserved)
+{
+	if (priv->shutdown) {
+		/* close_file_() seals 'seg' */
+		return NULL;
+	}
+	goffset offset = seg->offset + seg->size;
+	Segment *next = priv->spare;
+	priv->spare = NULL;
+	if (next && next->offset != offset) {
+		unmap_(next);
+		g_free(next);
+		next = NULL;
+	}
+	if (!next) {
+		next = map_(priv, offset, seg->size);
+	}
+	if (next) {
+		next->reserved = reserved;
+	}
+	g_queue_push_tail(&priv->full, seg);
+	priv->end = offset;
+	/* writers waiting for 'seg' call remap_() if 'next' is NULL */
+	g_atomic_pointer_set(&priv->current, next);
+	g_cond_signal(&priv->wake);
+	return next;
+}
+
+/* Copy the end of a buffer that did not fit into the segment 'seg',
+ * advancing as many times as it takes. Returns FALSE if the next segment
+ * could not be mapped. */
+static gboolean
+spill_(struct Private *priv, Segment *seg, gint pos, const gchar *data,
+		gsize len)
+{
+	gint size = seg->size;
+	gint n = size - pos;
+	memcpy(seg->map + pos, data, n);
+	g_atomic_int_add(&seg->committed, n);
+	data += n;
+	len -= n;
+	for (;;) {
+		n = MIN(len, (gsize)size);
+		g_mutex_lock(&priv->lock);
+		seg = advance_(priv, seg, n);
+		gboolean closed = priv->shutdown;
+		g_mutex_unlock(&priv->lock);
+		if (!seg) {
+			return closed;
+		}
+		memcpy(seg->map, data, n);
+		g_atomic_int_add(&seg->committed, n);
+		if (n < size) {
+			return TRUE;
+		}
+		/* this buffer filled the new segment as well */
+		data += n;
+		len -= n;
+	}
+}
+
+/* Map a segment at the end of the file after advance_() failed to.
+ * Returns FALSE if the mapping failed again, TRUE otherwise. */
+static gboolean
+remap_(struct Private *priv)
+{
+	gboolean mapped = TRUE;
+	g_mutex_lock(&priv->lock);
+	if (!priv->shutdown && priv->fd >= 0 && !priv->current) {
+		Segment *seg = map_(priv, priv->end, priv->length);
+		if (seg) {
+			g_atomic_pointer_set(&priv->current, seg);
+			g_cond_signal(&priv->wake);
+		} else {
+			mapped = FALSE;
+		}
+	}
+	g_mutex_unlock(&priv->lock);
+	return mapped;
+}
+
+/* Copy a formatted buffer into the file. Space is reserved with a compare
+ * & exchange that fails once a segment is full, so no reservation passes
+ * its end by more than one record. The single writer whose reservation
+ * reaches the end installs the next segment while the rest wait for it.
+ * Returns FALSE if the buffer was lost because no segment could be
+ * mapped. */
+static gboolean
+write_(struct Private *priv, const gchar *data, gsize len)
+{
+	if (G_UNLIKELY(!len || len > MAX_RECORD)) {
+		return TRUE;
+	}
+	for (;;) {
+		Segment *seg = log4g_hazard_acquire((gpointer *)&priv->current);
+		if (G_UNLIKELY(!seg)) {
+			log4g_hazard_release();
+			/* closed, or the last segment could not be mapped */
+			if (!remap_(priv)) {
+				return FALSE;
+			}
+			if (!g_atomic_pointer_get(&priv->current)) {
+				return TRUE;
+			}
+			continue;
+		}
+		gint pos = g_atomic_int_get(&seg->reserved);
+		while (pos < seg->size
+				&& !g_atomic_int_compare_and_exchange(
+					&seg->reserved, pos, pos + (gint)len)) {
+			pos = g_atomic_int_get(&seg->reserved);
+		}
+		if (G_LIKELY(pos + (gint)len < seg->size)) {
+			memcpy(seg->map + pos, data, len);
+			g_atomic_int_add(&seg->committed, (gint)len);
+			log4g_hazard_release();
+			return TRUE;
+		}
+		if (pos < seg->size) {
+			gboolean written = spill_(priv, seg, pos, data, len);
+			log4g_hazard_release();
+			return written;
+		}
+		while (g_atomic_pointer_get(&priv->current) == seg) {
+			g_thread_yield();
+		}
+		log4g_hazard_release();
+	}
+}
+
+/* Notify the error handler of an appender that output was lost */
+static void
+error_(Log4gAppender *base, Log4gLoggingEvent *event)
+{
+	Log4gErrorHandler *error = (Log4gErrorHandler *)
+		log4g_appender_get_error_handler(base);
+	if (error) {
+		log4g_error_handler_error(error, event,
+				Q_("failed to map [%s] for the appender "
+				"named [%s]"), GET_PRIVATE(base)->file,
+				log4g_appender_get_name(base));
+	}
+}
+
+/* Wait for writers to finish copying the first 'length' bytes of a
+ * replaced segment */
+static void
+wait_(Segment *seg, gint length)
+{
+	while (g_atomic_int_get(&seg->committed) < length) {
+		g_thread_yield();
+	}
+}
+
+static gpointer
+run_(gpointer data)
+{
+	struct Private *priv = data;
+	g_mutex_lock(&priv->lock);
+	for (;;) {
+		Segment *seg = g_queue_peek_head(&priv->full);
+		if (seg && g_atomic_int_get(&seg->committed) == seg->size) {
+			g_queue_pop_head(&priv->full);
+			g_mutex_unlock(&priv->lock);
+			unmap_(seg);
+			log4g_hazard_retire(seg, g_free);
+			g_mutex_lock(&priv->lock);
+			continue;
+		}
+		Segment *current = priv->current;
+		if (current && !priv->spare && !priv->shutdown
+				&& priv->ahead != current->offset + current->size) {
+			/* only the thread that replaces 'current' frees it */
+			gint size = current->size;
+			goffset offset = priv->ahead = current->offset + size;
+			g_mutex_unlock(&priv->lock);
+			Segment *spare = map_(priv, offset, size);
+			g_mutex_lock(&priv->lock);
+			if (spare && (priv->spare || priv->shutdown)) {
+				unmap_(spare);
+				g_free(spare);
+			} else if (spare) {
+				priv->spare = spare;
+			}
+			continue;
+		}
+		if (seg) {
+			/* writers are still copying into 'seg' */
+			g_cond_wait_until(&priv->wake, &priv->lock,
+					g_get_monotonic_time()
+					+ G_TIME_SPAN_MILLISECOND);
+		} else if (priv->shutdown) {
+			break;
+		} else {
+			g_cond_wait(&priv->wake, &priv->lock);
+		}
+	}
+	g_mutex_unlock(&priv->lock);
+	return NULL;
+}
+
+/* Stop writers, unmap every segment and truncate the file to the length
+ * of the data written */
+static void
+close_file_(struct Private *priv)
+{
+	g_mutex_lock(&priv->lock);
+	Segment *seg = priv->current;
+	g_atomic_pointer_set(&priv->current, NULL);
+	priv->shutdown = TRUE;
+	g_cond_signal(&priv->wake);
+	GThread *thread = priv->thread;
+	priv->thread = NULL;
+	g_mutex_unlock(&priv->lock);
+	if (thread) {
+		/* the background thread unmaps full segments before exiting */
+		g_thread_join(thread);
+	}
+	Segment *full;
+	while ((full = g_queue_pop_head(&priv->full))) {
+		wait_(full, full->size);
+		unmap_(full);
+		log4g_hazard_retire(full, g_free);
+	}
+	if (priv->spare) {
+		unmap_(priv->spare);
+		g_free(priv->spare);
+		priv->spare = NULL;
+	}
+	if (seg) {
+		/* claim the rest of the segment, if a writer already
+		 * reached the end it finds priv->shutdown set */
+		gint end = g_atomic_int_add(&seg->reserved, seg->size);
+		end = MIN(end, seg->size);
+		wait_(seg, end);
+		priv->end = seg->offset + end;
+		unmap_(seg);
+		log4g_hazard_retire(seg, g_free);
+	}
+	if (priv->fd >= 0) {
+		gboolean clean = TRUE;
+		if (ftruncate(priv->fd, priv->end)) {
+			log4g_log_error("ftruncate(): %s", g_strerror(errno));
+			clean = FALSE;
+		}
+		if (close(priv->fd)) {
+			log4g_log_error("close(): %s", g_strerror(errno));
+			clean = FALSE;
+		}
+		priv->fd = -1;
+		/* the zero bytes at the end have been removed */
+		if (clean && g_unlink(priv->marker)) {
+			log4g_log_error("%s: %s", priv->marker,
+					g_strerror(errno));
+		}
+	}
+}
+
+/* Determine the length of a file without the zero bytes left at the end
+ * of the last segment by a crash, and truncate it. Only called if the
+ * marker of the file shows it was not closed. */
+static goffset
+trim_(gint fd)
+{
+	struct stat st;
+	if (fstat(fd, &st)) {
+		return -1;
+	}
+	gchar block[4096];
+	goffset end = st.st_size;
+	while (end > 0) {
+		gsize n = MIN((gsize)end, sizeof block);
+		if (pread(fd, block, n, end - n) != (gssize)n) {
+			return -1;
+		}
+		gsize i = n;
+		while (i && !block[i - 1]) {
+			--i;
+		}
+		end -= n - i;
+		if (i) {
+			break;
+		}
+	}
+	if (end != st.st_size && ftruncate(fd, end)) {
+		return -1;
+	}
+	return end;
+}
+
+static void
+write_string_(Log4gAppender *base, const gchar *string)
+{
+	if (string && !write_(GET_PRIVATE(base), string, strlen(string))) {
+		error_(base, NULL);
+	}
+}
+
+static void
+log4g_mapped_file_appender_init(Log4gMappedFileAppender *self)
+{
+	self->priv = ASSIGN_PRIVATE(self);
+	struct Private *priv = GET_PRIVATE(self);
+	priv->append = TRUE;
+	priv->size = SEGMENT_SIZE;
+	priv->fd = -1;
+	g_queue_init(&priv->full);
+	g_mutex_init(&priv->lock);
+	g_cond_init(&priv->wake);
+}
+
+static void
+dispose(GObject *base)
+{
+	log4g_appender_close(LOG4G_APPENDER(base));
+	G_OBJECT_CLASS(log4g_mapped_file_appender_parent_class)->dispose(base);
+}
+
+static void
+finalize(GObject *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	g_free(priv->file);
+	g_free(priv->marker);
+	g_mutex_clear(&priv->lock);
+	g_cond_clear(&priv->wake);
+	G_OBJECT_CLASS(log4g_mapped_file_appender_parent_class)->
+		finalize(base);
+}
+
+enum Properties {
+	PROP_O = 0,
+	PROP_FILE,
+	PROP_APPEND,
+	PROP_SEGMENT_SIZE,
+	PROP_MAX
+};
+
+static void
+set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	switch (id) {
+	case PROP_FILE:
+		g_mutex_lock(&priv->lock);
+		g_free(priv->file);
+		priv->file = NULL;
+		const gchar *file = g_value_get_string(value);
+		if (file) {
+			priv->file = g_strdup(file);
+			if (priv->file) {
+				g_strstrip(priv->file);
+			}
+		}
+		g_mutex_unlock(&priv->lock);
+		break;
+	case PROP_APPEND:
+		priv->append = g_value_get_boolean(value);
+		break;
+	case PROP_SEGMENT_SIZE:
+		priv->size = g_value_get_uint(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(base, id, pspec);
+		break;
+	}
+}
+
+static void
+append(Log4gAppender *base, Log4gLoggingEvent *event)
+{
+	Log4gLayout *layout = log4g_appender_get_layout(base);
+	if (G_UNLIKELY(!layout)) {
+		return;
+	}
+	GString *string = buffer_();
+	log4g_layout_format_to(layout, event, string);
+	if (!write_(GET_PRIVATE(base), string->str, string->len)) {
+		error_(base, event);
+	}
+}
+
+static void
+append_batch(Log4gAppender *base, Log4gLoggingEvent **events, guint n)
+{
+	Log4gLayout *layout = log4g_appender_get_layout(base);
+	if (G_UNLIKELY(!layout)) {
+		return;
+	}
+	GString *string = buffer_();
+	for (guint i = 0; i < n; ++i) {
+		log4g_layout_format_to(layout, events[i], string);
+	}
+	if (!write_(GET_PRIVATE(base), string->str, string->len)) {
+		error_(base, events[0]);
+	}
+}
+
+static void
+close_(Log4gAppender *base)
+{
+	if (!log4g_appender_get_closed(base)) {
+		Log4gLayout *layout = log4g_appender_get_layout(base);
+		if (layout) {
+			write_string_(base, log4g_layout_get_footer(layout));
+		}
+		log4g_appender_set_closed(base, TRUE);
+		close_file_(GET_PRIVATE(base));
+	}
+}
+
+static gboolean
+requires_layout(G_GNUC_UNUSED Log4gAppender *self)
+{
+	return TRUE;
+}
+
+static void
+activate_options(Log4gAppender *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	GError *error = NULL;
+	close_file_(priv);
+	g_mutex_lock(&priv->lock);
+	if (G_UNLIKELY(!priv->file)) {
+		log4g_log_warn(Q_("file option not set for appender [%s]"),
+				log4g_appender_get_name(base));
+		goto exit;
+	}
+	g_free(priv->marker);
+	priv->marker = g_strconcat(priv->file, MARKER, NULL);
+	/* a marker left behind means the file was not closed */
+	gboolean crashed = g_file_test(priv->marker, G_FILE_TEST_EXISTS);
+	priv->fd = open(priv->file,
+			O_RDWR | O_CREAT | (priv->append ? 0 : O_TRUNC), 0666);
+	if (priv->fd < 0) {
+		log4g_log_error("%s: %s", priv->file, g_strerror(errno));
+		goto exit;
+	}
+	goffset end = 0;
+	if (priv->append) {
+		end = crashed ? trim_(priv->fd) : lseek(priv->fd, 0, SEEK_END);
+		if (end < 0) {
+			log4g_log_error("%s: %s", priv->file,
+					g_strerror(errno));
+			goto error;
+		}
+	}
+	gint marker = open(priv->marker, O_WRONLY | O_CREAT, 0666);
+	if (marker < 0) {
+		log4g_log_error("%s: %s", priv->marker, g_strerror(errno));
+		goto error;
+	}
+	close(marker);
+	/* segments start on a page boundary */
+	gint page = sysconf(_SC_PAGESIZE);
+	gint size = MAX(priv->size, 1);
+	size = ((size + page - 1) / page) * page;
+	priv->length = size;
+	goffset offset = end - end % page;
+	Segment *seg = map_(priv, offset, size);
+	if (!seg) {
+		/* release the space allocated, the file is closed cleanly */
+		if (ftruncate(priv->fd, end)) {
+			log4g_log_error("ftruncate(): %s", g_strerror(errno));
+		} else {
+			g_unlink(priv->marker);
+		}
+		goto error;
+	}
+	/* the data already in the file counts as written */
+	seg->reserved = seg->committed = end - offset;
+	priv->end = end;
+	priv->ahead = offset;
+	priv->shutdown = FALSE;
+	priv->thread = g_thread_try_new("log4g-mapped-file", run_, priv,
+			&error);
+	if (!priv->thread) {
+		/* writers map segments themselves, full segments are
+		 * unmapped when the file is closed */
+		log4g_log_warn("g_thread_try_new(): %s", error->message);
+		g_error_free(error);
+	}
+	g_atomic_pointer_set(&priv->current, seg);
+	g_mutex_unlock(&priv->lock);
+	Log4gLayout *layout = log4g_appender_get_layout(base);
+	if (layout) {
+		write_string_(base, log4g_layout_get_header(layout));
+	}
+	return;
+error:
+	close(priv->fd);
+	priv->fd = -1;
+exit:
+	g_mutex_unlock(&priv->lock);
+}
+
+static void
+log4g_mapped_file_appender_class_init(Log4gMappedFileAppenderClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->dispose = dispose;
+	object_class->finalize = finalize;
+	object_class->set_property = set_property;
+	Log4gAppenderClass *appender_class = LOG4G_APPENDER_CLASS(klass);
+	appender_class->append = append;
+	appender_class->append_batch = append_batch;
+	appender_class->close = close_;
+	appender_class->requires_layout = requires_layout;
+	appender_class->activate_options = activate_options;
+	/* space in the mapping is reserved atomically */
+	appender_class->concurrent_append = TRUE;
+	g_type_class_add_private(klass, sizeof(struct Private));
+	/* install properties */
+	g_object_class_install_property(object_class, PROP_FILE,
+		g_param_spec_string("file", Q_("File"),
+			Q_("Output file name"), NULL, G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_APPEND,
+		g_param_spec_boolean("append", Q_("Append"),
+			Q_("Append or overwrite file"), TRUE,
+			G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_SEGMENT_SIZE,
+		g_param_spec_uint("segment-size", Q_("Segment Size"),
+			Q_("Size of each mapping of the file"),
+			1, MAX_SEGMENT_SIZE, SEGMENT_SIZE,
+			G_PARAM_WRITABLE));
+}
+
+static void
+log4g_mapped_file_appender_class_finalize(
+		G_GNUC_UNUSED Log4gMappedFileAppenderClass *klass)
+{
+	/* do nothing */
+}
+
+void
+log4g_mapped_file_appender_register(GTypeModule *module)
+{
+	log4g_mapped_file_appender_register_type(module);
+}
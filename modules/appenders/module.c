@@ -21,12 +21,14 @@
 #include "appender/async-appender.h"
 #include "appender/console-appender.h"
 #include "appender/file-appender.h"
+#include "appender/mapped-file-appender.h"
 #include "appender/null-appender.h"
 #include "appender/rolling-file-appender.h"
 #include "appender/syslog-appender.h"
 #include "appender/writer-appender.h"
 #include "helpers/counting-quiet-writer.h"
 #include "helpers/quiet-writer.h"
+#include "helpers/uring-quiet-writer.h"
 #include <log4g/module.h>
 
 void
@@ -38,8 +40,10 @@ log4g_module_load(GTypeModule *module)
 	log4g_console_appender_register(module);
 	log4g_counting_quiet_writer_register(module);
 	log4g_file_appender_register(module);
+	log4g_mapped_file_appender_register(module);
 	log4g_null_appender_register(module);
 	log4g_quiet_writer_register(module);
 	log4g_rolling_file_appender_register(module);
 	log4g_syslog_appender_register(module);
+	log4g_uring_quiet_writer_register(module);
 }
@@ -69,18 +69,54 @@ finalize(GObject *base)
 	G_OBJECT_CLASS(log4g_quiet_writer_parent_class)->finalize(base);
 }
 
-void
+static void
 write_(Log4gQuietWriter *self, const char *string)
+{
+	log4g_quiet_writer_write_len(self, string, strlen(string));
+}
+
+static void
+write_len(Log4gQuietWriter *self, const gchar *buffer, gsize length)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	if (!priv->file || !length) {
+		return;
+	}
+	if (length != fwrite(buffer, 1, length, priv->file)) {
+		log4g_error_handler_error(priv->error, NULL,
+				Q_("failed to write %" G_GSIZE_FORMAT
+					" bytes: %s"),
+				length, g_strerror(errno));
+	}
+}
+
+static void
+flush_(Log4gQuietWriter *self)
 {
 	struct Private *priv = GET_PRIVATE(self);
 	if (!priv->file) {
 		return;
 	}
-	if (EOF == fputs(string, priv->file)) {
+	if (EOF == fflush(priv->file)) {
 		log4g_error_handler_error(priv->error, NULL,
-				Q_("failed to write [%s]: %s"),
-				string, g_strerror(errno));
+				Q_("failed to flush writer: %s"),
+				g_strerror(errno));
+	}
+}
+
+static void
+close_(Log4gQuietWriter *self)
+{
+	struct Private *priv = GET_PRIVATE(self);
+	if (!priv->file) {
+		return;
+	}
+	if (EOF == fclose(priv->file)) {
+		log4g_error_handler_error(priv->error, NULL,
+				Q_("failed to close writer: %s"),
+				g_strerror(errno));
 	}
+	priv->file = NULL;
 }
 
 static void
@@ -90,6 +126,9 @@ log4g_quiet_writer_class_init(Log4gQuietWriterClass *klass)
 	object_class->dispose = dispose;
 	object_class->finalize = finalize;
 	klass->write = write_;
+	klass->write_len = write_len;
+	klass->flush = flush_;
+	klass->close = close_;
 	g_type_class_add_private(klass, sizeof(struct Private));
 }
 
@@ -136,7 +175,10 @@ log4g_quiet_writer_new(FILE *file, gpointer error)
  * log4g_quiet_writer_close:
  * @self: A quiet writer object.
  *
- * Close the stdio(3) stream held by a quiet writer object.
+ * Call the @close function from the #Log4gQuietWriterClass of @self.
+ *
+ * The default implementation closes the stdio(3) stream held by a quiet
+ * writer object.
  *
  * @See: stdio(3)
  *
@@ -145,16 +187,8 @@ log4g_quiet_writer_new(FILE *file, gpointer error)
 void
 log4g_quiet_writer_close(Log4gQuietWriter *self)
 {
-	struct Private *priv = GET_PRIVATE(self);
-	if (!priv->file) {
-		return;
-	}
-	if (EOF == fclose(priv->file)) {
-		log4g_error_handler_error(priv->error, NULL,
-				Q_("failed to close writer: %s"),
-				g_strerror(errno));
-	}
-	priv->file = NULL;
+	g_return_if_fail(LOG4G_IS_QUIET_WRITER(self));
+	LOG4G_QUIET_WRITER_GET_CLASS(self)->close(self);
 }
 
 /**
@@ -173,11 +207,31 @@ log4g_quiet_writer_write(Log4gQuietWriter *self, const char *string)
 	LOG4G_QUIET_WRITER_GET_CLASS(self)->write(self, string);
 }
 
+/**
+ * log4g_quiet_writer_write_len:
+ * @self: A quiet writer object.
+ * @buffer: The bytes to write.
+ * @length: The number of bytes in @buffer.
+ *
+ * Call the @write_len function from the #Log4gQuietWriterClass of @self.
+ *
+ * Since: 0.1
+ */
+void
+log4g_quiet_writer_write_len(Log4gQuietWriter *self, const gchar *buffer,
+		gsize length)
+{
+	g_return_if_fail(LOG4G_IS_QUIET_WRITER(self));
+	LOG4G_QUIET_WRITER_GET_CLASS(self)->write_len(self, buffer, length);
+}
+
 /**
  * log4g_quiet_writer_flush:
  * @self: A quiet writer object.
  *
- * Flush the stdio(3) stream.
+ * Call the @flush function from the #Log4gQuietWriterClass of @self.
+ *
+ * The default implementation flushes the stdio(3) stream.
  *
  * @See: stdio(3)
  *
@@ -186,15 +240,8 @@ log4g_quiet_writer_write(Log4gQuietWriter *self, const char *string)
 void
 log4g_quiet_writer_flush(Log4gQuietWriter *self)
 {
-	struct Private *priv = GET_PRIVATE(self);
-	if (!priv->file) {
-		return;
-	}
-	if (EOF == fflush(priv->file)) {
-		log4g_error_handler_error(priv->error, NULL,
-				Q_("failed to flush writer: %s"),
-				g_strerror(errno));
-	}
+	g_return_if_fail(LOG4G_IS_QUIET_WRITER(self));
+	LOG4G_QUIET_WRITER_GET_CLASS(self)->flush(self);
 }
 
 /**
@@ -22,10 +22,11 @@
  * This class extends #Log4gFileAppenderClass to backup log files when they
  * reach a specified size.
  *
- * Rolling file appenders accept two properties:
+ * Rolling file appenders accept the following properties:
  * <orderedlist>
  * <listitem><para>max-backup-index</para></listitem>
  * <listitem><para>maximum-file-size</para></listitem>
+ * <listitem><para>async-roll-over</para></listitem>
  * </orderedlist>
  *
  * The value of max-backup-index sets the number of backup files that will
@@ -34,6 +35,21 @@
  *
  * The log files will be rotated when the current log file reaches a size of
  * maximum-file-size or larger. The default value is ten megabytes.
+ *
+ * The value of async-roll-over determines if the backup files are renamed
+ * by a background thread. When it is set the log file is renamed to a
+ * temporary name (the file name followed by a process ID, a sequence
+ * number and ".rolling") and reopened immediately, and a worker thread
+ * shifts the backup indexes and then renames the temporary file to backup
+ * one. Roll-overs are completed in the order they happened. If the
+ * application exits abnormally the temporary files may be left behind. The
+ * default value is %FALSE.
+ *
+ * <note><para>
+ * When events are delivered in batches the size is checked after the whole
+ * batch has been written, so a log file may exceed maximum-file-size by at
+ * most one batch.
+ * </para></note>
  */
 
 #ifdef HAVE_CONFIG_H
@@ -42,7 +58,9 @@
 #include "appender/rolling-file-appender.h"
 #include <errno.h>
 #include <glib/gstdio.h>
+#include <unistd.h>
 #include "helpers/counting-quiet-writer.h"
+#include "helpers/uring-quiet-writer.h"
 
 G_DEFINE_DYNAMIC_TYPE(Log4gRollingFileAppender, log4g_rolling_file_appender,
         LOG4G_TYPE_FILE_APPENDER)
@@ -58,8 +76,24 @@ struct Private {
 	guint backup; /* The number of backup indexes to keep */
 	gulong max; /* The maximum file size (default is 10MB) */
 	gulong next;
+	gboolean async; /* Shift backups from the worker thread */
+	guint serial; /* Names the temporary files */
+	GQueue jobs; /* Roll-overs waiting for the worker */
+	gboolean busy; /* The worker is shifting backups */
+	gboolean shutdown;
+	GThread *worker;
+	GMutex lock; /* Guards the roll-over queue & worker state */
+	GCond wake; /* Signals the worker */
+	GCond idle; /* Signals that the queue has drained */
 };
 
+/* A roll-over waiting for the worker */
+typedef struct Job_ {
+	gchar *file; /* The log file name */
+	gchar *staged; /* The temporary name of the rolled file */
+	guint backup; /* The number of backup indexes to keep */
+} Job;
+
 static void
 log4g_rolling_file_appender_init(Log4gRollingFileAppender *self)
 {
@@ -67,12 +101,28 @@ log4g_rolling_file_appender_init(Log4gRollingFileAppender *self)
 	struct Private *priv = GET_PRIVATE(self);
 	priv->backup = 1;
 	priv->max = 10 * 1024 * 1024; /* 10MB */
+	g_queue_init(&priv->jobs);
+	g_mutex_init(&priv->lock);
+	g_cond_init(&priv->wake);
+	g_cond_init(&priv->idle);
+}
+
+static void
+finalize(GObject *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	g_mutex_clear(&priv->lock);
+	g_cond_clear(&priv->wake);
+	g_cond_clear(&priv->idle);
+	G_OBJECT_CLASS(log4g_rolling_file_appender_parent_class)->
+		finalize(base);
 }
 
 enum Properties {
 	PROP_O = 0,
 	PROP_MAX_BACKUP_INDEX,
 	PROP_MAXIMUM_FILE_SIZE,
+	PROP_ASYNC_ROLL_OVER,
 	PROP_MAX
 };
 
@@ -87,26 +137,47 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	case PROP_MAXIMUM_FILE_SIZE:
 		priv->max = g_value_get_ulong(value);
 		break;
+	case PROP_ASYNC_ROLL_OVER:
+		priv->async = g_value_get_boolean(value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(base, id, pspec);
 		break;
 	}
 }
 
+/* Other threads may be appending, roll over while holding the write lock so
+ * no event is written to a file that is being renamed. */
 static void
-sub_append(Log4gAppender *base, Log4gLoggingEvent *event)
+check_roll_over_(Log4gAppender *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
+	log4g_writer_appender_lock(base);
 	Log4gQuietWriter *writer =
 		log4g_writer_appender_get_quiet_writer(base);
-	LOG4G_WRITER_APPENDER_CLASS(log4g_rolling_file_appender_parent_class)->
-		sub_append(base, event);
 	if (log4g_file_appender_get_file(base) && writer) {
 		gulong size = log4g_counting_quiet_writer_get_count(writer);
 		if ((size >= priv->max) && (size >= priv->next)) {
 			log4g_rolling_file_appender_roll_over(base);
 		}
 	}
+	log4g_writer_appender_unlock(base);
+}
+
+static void
+sub_append(Log4gAppender *base, Log4gLoggingEvent *event)
+{
+	LOG4G_WRITER_APPENDER_CLASS(log4g_rolling_file_appender_parent_class)->
+		sub_append(base, event);
+	check_roll_over_(base);
+}
+
+static void
+sub_append_batch(Log4gAppender *base, Log4gLoggingEvent **events, guint n)
+{
+	LOG4G_WRITER_APPENDER_CLASS(log4g_rolling_file_appender_parent_class)->
+		sub_append_batch(base, events, n);
+	check_roll_over_(base);
 }
 
 static void
@@ -134,13 +205,125 @@ static void
 set_qw_for_files(Log4gAppender *base, FILE *file)
 {
 	GObject *error = log4g_appender_get_error_handler(base);
-	Log4gQuietWriter *writer = log4g_counting_quiet_writer_new(file, error);
+	Log4gQuietWriter *writer = (log4g_file_appender_get_io_uring(base)
+			? log4g_uring_quiet_writer_new(file, error)
+			: log4g_counting_quiet_writer_new(file, error));
 	if (writer) {
 		log4g_writer_appender_set_quiet_writer(base, writer);
 		g_object_unref(writer);
 	}
 }
 
+/* Shift the backups of 'file' up by one index and rename 'staged' to
+ * backup one. If no backups are kept 'staged' is removed. */
+static void
+shift_(const gchar *file, guint backup, const gchar *staged)
+{
+	if (!backup) {
+		g_unlink(staged);
+		return;
+	}
+	GString *source = g_string_sized_new(128);
+	GString *target = g_string_sized_new(128);
+	for (guint i = backup - 1; i >= 1; --i) {
+		g_string_printf(source, "%s.%u", file, i);
+		g_string_printf(target, "%s.%u", file, i + 1);
+		g_rename(source->str, target->str);
+	}
+	g_string_printf(target, "%s.%u", file, 1);
+	if (g_rename(staged, target->str)) {
+		log4g_log_error("g_rename(): %s", g_strerror(errno));
+	}
+	g_string_free(source, TRUE);
+	g_string_free(target, TRUE);
+}
+
+static gpointer
+run_(gpointer data)
+{
+	struct Private *priv = data;
+	g_mutex_lock(&priv->lock);
+	for (;;) {
+		while (g_queue_is_empty(&priv->jobs) && !priv->shutdown) {
+			g_cond_wait(&priv->wake, &priv->lock);
+		}
+		Job *job = g_queue_pop_head(&priv->jobs);
+		if (!job) {
+			/* shut down with an empty queue */
+			break;
+		}
+		priv->busy = TRUE;
+		g_mutex_unlock(&priv->lock);
+		shift_(job->file, job->backup, job->staged);
+		g_free(job->file);
+		g_free(job->staged);
+		g_free(job);
+		g_mutex_lock(&priv->lock);
+		priv->busy = FALSE;
+		if (g_queue_is_empty(&priv->jobs)) {
+			g_cond_broadcast(&priv->idle);
+		}
+	}
+	g_mutex_unlock(&priv->lock);
+	return NULL;
+}
+
+/* Wait for the worker to finish every queued roll-over */
+static void
+wait_idle_(struct Private *priv)
+{
+	g_mutex_lock(&priv->lock);
+	while (!g_queue_is_empty(&priv->jobs) || priv->busy) {
+		g_cond_wait(&priv->idle, &priv->lock);
+	}
+	g_mutex_unlock(&priv->lock);
+}
+
+/* Move the log file to a temporary name, reopen it and queue the backup
+ * shifting for the worker. Returns FALSE if the worker is not running. */
+static gboolean
+roll_over_async_(Log4gAppender *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	GError *error = NULL;
+	g_mutex_lock(&priv->lock);
+	if (!priv->worker && !priv->shutdown) {
+		priv->worker = g_thread_try_new("log4g-roll-over", run_, priv,
+				&error);
+		if (!priv->worker) {
+			log4g_log_warn("g_thread_try_new(): %s",
+					error->message);
+			g_error_free(error);
+		}
+	}
+	gboolean running = (priv->worker != NULL);
+	g_mutex_unlock(&priv->lock);
+	if (!running) {
+		return FALSE;
+	}
+	const gchar *file = log4g_file_appender_get_file(base);
+	gchar *staged = g_strdup_printf("%s.%d.%u.rolling", file,
+			(gint)getpid(), ++priv->serial);
+	if (g_rename(file, staged)) {
+		log4g_log_error("g_rename(): %s", g_strerror(errno));
+		g_free(staged);
+		return TRUE;
+	}
+	Job *job = g_new(Job, 1);
+	/* set_file_full() replaces the string returned by get_file() */
+	job->file = g_strdup(file);
+	job->staged = staged;
+	job->backup = priv->backup;
+	log4g_file_appender_set_file_full(base, job->file, TRUE,
+			log4g_file_appender_get_buffered_io(base),
+			log4g_file_appender_get_buffer_size(base));
+	g_mutex_lock(&priv->lock);
+	g_queue_push_tail(&priv->jobs, job);
+	g_cond_signal(&priv->wake);
+	g_mutex_unlock(&priv->lock);
+	return TRUE;
+}
+
 static void
 roll_over(Log4gAppender *base)
 {
@@ -150,7 +333,13 @@ roll_over(Log4gAppender *base)
 		gulong size = log4g_counting_quiet_writer_get_count(writer);
 		priv->next = size + priv->max;
 	}
+	if (priv->max > 0 && priv->async && roll_over_async_(base)) {
+		priv->next = 0;
+		return;
+	}
 	if (priv->max > 0) {
+		/* earlier roll-overs must reach their backup index first */
+		wait_idle_(priv);
 		GString *source = g_string_sized_new(128);
 		if (G_UNLIKELY(!source)) {
 			return;
@@ -179,14 +368,55 @@ roll_over(Log4gAppender *base)
 	priv->next = 0;
 }
 
+/* A closed appender may be reopened, the worker is started again on the
+ * next roll-over */
+static void
+activate_options(Log4gAppender *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	g_mutex_lock(&priv->lock);
+	priv->shutdown = FALSE;
+	g_mutex_unlock(&priv->lock);
+	LOG4G_APPENDER_CLASS(log4g_rolling_file_appender_parent_class)->
+		activate_options(base);
+}
+
+static void
+close_(Log4gAppender *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (log4g_appender_get_closed(base)) {
+		return;
+	}
+	LOG4G_APPENDER_CLASS(log4g_rolling_file_appender_parent_class)->
+		close(base);
+	g_mutex_lock(&priv->lock);
+	priv->shutdown = TRUE;
+	g_cond_signal(&priv->wake);
+	GThread *worker = priv->worker;
+	priv->worker = NULL;
+	g_mutex_unlock(&priv->lock);
+	if (worker) {
+		/* the worker completes queued roll-overs before exiting */
+		g_thread_join(worker);
+	}
+}
+
 static void
 log4g_rolling_file_appender_class_init(Log4gRollingFileAppenderClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = finalize;
 	object_class->set_property = set_property;
+	Log4gAppenderClass *appender_class = LOG4G_APPENDER_CLASS(klass);
+	appender_class->activate_options = activate_options;
+	appender_class->close = close_;
+	/* roll-over happens under the writer appender lock */
+	appender_class->concurrent_append = TRUE;
 	Log4gWriterAppenderClass *writer_class =
 		LOG4G_WRITER_APPENDER_CLASS(klass);
 	writer_class->sub_append = sub_append;
+	writer_class->sub_append_batch = sub_append_batch;
 	Log4gFileAppenderClass *file_class =
 		LOG4G_FILE_APPENDER_CLASS(klass);
 	file_class->set_file_full = set_file_full;
@@ -204,6 +434,11 @@ log4g_rolling_file_appender_class_init(Log4gRollingFileAppenderClass *klass)
 			Q_("Maximum File Size"),
 			Q_("Maximum size a log file may grow to"),
 			0, G_MAXULONG, 10 * 1024 * 1024, G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_ASYNC_ROLL_OVER,
+		g_param_spec_boolean("async-roll-over",
+			Q_("Asynchronous Roll Over"),
+			Q_("Rename backup files from a background thread"),
+			FALSE, G_PARAM_WRITABLE));
 }
 
 static void
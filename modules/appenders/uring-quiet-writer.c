@@ -0,0 +1,386 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: uring-quiet-writer
+ * @short_description: Write to a file from a completion thread
+ * @see_also: #Log4gQuietWriterClass, #Log4gFileAppender
+ *
+ * A counting quiet writer that does not block the threads that write to
+ * it on disk I/O.
+ *
+ * Writes are appended to a pending buffer. A dedicated completion thread
+ * takes the whole buffer at once and submits it to an io_uring(7) as a
+ * single write, so bursts of events are batched into one request. A flush
+ * requests an fdatasync(2), which is submitted linked after the write so
+ * that it only runs once the write has completed. Flushes that arrive
+ * while a batch is in flight are coalesced into one.
+ *
+ * If Log4g was built without liburing, or the kernel does not support
+ * io_uring(7), the completion thread calls pwrite(2) and fdatasync(2)
+ * instead.
+ *
+ * The stdio(3) stream is only used to find the file descriptor, it is
+ * closed once the completion thread has written everything.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "helpers/uring-quiet-writer.h"
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+G_DEFINE_DYNAMIC_TYPE(Log4gUringQuietWriter, log4g_uring_quiet_writer,
+		LOG4G_TYPE_COUNTING_QUIET_WRITER)
+
+#define ASSIGN_PRIVATE(instance) \
+	(G_TYPE_INSTANCE_GET_PRIVATE(instance, \
+		LOG4G_TYPE_URING_QUIET_WRITER, struct Private))
+
+#define GET_PRIVATE(instance) \
+	((struct Private *)((Log4gUringQuietWriter *)instance)->priv)
+
+/** \brief Writers block while this many bytes are pending */
+#define MAX_PENDING (8 * 1024 * 1024)
+
+/** \brief The largest single write request */
+#define MAX_WRITE (1024 * 1024 * 1024)
+
+struct Private {
+	gint fd;
+	goffset offset; /* The file offset of the next write */
+	GString *pending; /* Appended to by writers */
+	GString *inflight; /* Owned by the completion thread */
+	gboolean sync; /* A flush was requested */
+	gboolean closing;
+	GThread *thread;
+	GMutex lock; /* Guards 'pending', 'sync' & 'closing' */
+	GCond wake; /* Signals the completion thread */
+	GCond drained; /* Signals writers waiting for room */
+#ifdef HAVE_LIBURING
+	struct io_uring ring;
+	gboolean uring; /* 'ring' was initialized */
+#endif
+};
+
+static void
+log4g_uring_quiet_writer_init(Log4gUringQuietWriter *self)
+{
+	self->priv = ASSIGN_PRIVATE(self);
+	struct Private *priv = GET_PRIVATE(self);
+	priv->fd = -1;
+	priv->pending = g_string_sized_new(4096);
+	priv->inflight = g_string_sized_new(4096);
+	g_mutex_init(&priv->lock);
+	g_cond_init(&priv->wake);
+	g_cond_init(&priv->drained);
+}
+
+static void
+finalize(GObject *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	log4g_quiet_writer_close(LOG4G_QUIET_WRITER(base));
+	g_string_free(priv->pending, TRUE);
+	g_string_free(priv->inflight, TRUE);
+	g_mutex_clear(&priv->lock);
+	g_cond_clear(&priv->wake);
+	g_cond_clear(&priv->drained);
+	G_OBJECT_CLASS(log4g_uring_quiet_writer_parent_class)->finalize(base);
+}
+
+#ifdef HAVE_LIBURING
+/* Write a buffer with an optional fdatasync(2) linked after it. Returns
+ * FALSE if the ring failed, the arguments are updated with what is left
+ * to do. */
+static gboolean
+uring_(struct Private *priv, const gchar **buffer, gsize *length,
+		gboolean *sync)
+{
+	while (*length || *sync) {
+		struct io_uring_sqe *sqe;
+		struct io_uring_cqe *cqe;
+		guint n = 0;
+		if (*length) {
+			sqe = io_uring_get_sqe(&priv->ring);
+			io_uring_prep_write(sqe, priv->fd, *buffer,
+					MIN(*length, MAX_WRITE), priv->offset);
+			io_uring_sqe_set_data(sqe, NULL);
+			if (*sync) {
+				io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+			}
+			++n;
+		}
+		if (*sync) {
+			sqe = io_uring_get_sqe(&priv->ring);
+			io_uring_prep_fsync(sqe, priv->fd,
+					IORING_FSYNC_DATASYNC);
+			io_uring_sqe_set_data(sqe, priv);
+			++n;
+		}
+		gint error = io_uring_submit(&priv->ring);
+		if (error < 0) {
+			log4g_log_error("io_uring_submit(): %s",
+					g_strerror(-error));
+			return FALSE;
+		}
+		for (guint i = 0; i < n; ++i) {
+			error = io_uring_wait_cqe(&priv->ring, &cqe);
+			if (error < 0) {
+				log4g_log_error("io_uring_wait_cqe(): %s",
+						g_strerror(-error));
+				return FALSE;
+			}
+			gint res = cqe->res;
+			gboolean fsync = (io_uring_cqe_get_data(cqe) != NULL);
+			io_uring_cqe_seen(&priv->ring, cqe);
+			if (fsync) {
+				/* a short write cancels the fdatasync(2) */
+				if (-ECANCELED == res) {
+					continue;
+				}
+				if (res < 0) {
+					log4g_log_error("fdatasync(): %s",
+							g_strerror(-res));
+				}
+				*sync = FALSE;
+			} else if (res > 0) {
+				*buffer += res;
+				*length -= res;
+				priv->offset += res;
+			} else {
+				log4g_log_error(Q_("failed to write: %s"),
+						g_strerror(res ? -res : ENOSPC));
+				*length = 0;
+			}
+		}
+	}
+	return TRUE;
+}
+#endif
+
+/* Write a buffer and optionally wait for it to reach the disk */
+static void
+write_(struct Private *priv, const gchar *buffer, gsize length,
+		gboolean sync)
+{
+#ifdef HAVE_LIBURING
+	if (priv->uring) {
+		if (uring_(priv, &buffer, &length, &sync)) {
+			return;
+		}
+		/* fall back to system calls for the rest of this file */
+		io_uring_queue_exit(&priv->ring);
+		priv->uring = FALSE;
+	}
+#endif
+	while (length) {
+		gssize n = pwrite(priv->fd, buffer, MIN(length, MAX_WRITE),
+				priv->offset);
+		if (n < 0 && EINTR == errno) {
+			continue;
+		}
+		if (n <= 0) {
+			log4g_log_error(Q_("failed to write: %s"),
+					g_strerror(n ? errno : ENOSPC));
+			return;
+		}
+		buffer += n;
+		length -= n;
+		priv->offset += n;
+	}
+	if (sync && fdatasync(priv->fd)) {
+		log4g_log_error("fdatasync(): %s", g_strerror(errno));
+	}
+}
+
+static gpointer
+run_(gpointer data)
+{
+	struct Private *priv = data;
+	g_mutex_lock(&priv->lock);
+	for (;;) {
+		while (!priv->pending->len && !priv->sync && !priv->closing) {
+			g_cond_wait(&priv->wake, &priv->lock);
+		}
+		if (!priv->pending->len && !priv->sync) {
+			/* closing with nothing left to write */
+			break;
+		}
+		/* take everything that is pending in one pass */
+		GString *batch = priv->pending;
+		priv->pending = priv->inflight;
+		priv->inflight = batch;
+		gboolean sync = priv->sync;
+		priv->sync = FALSE;
+		g_cond_broadcast(&priv->drained);
+		g_mutex_unlock(&priv->lock);
+		write_(priv, batch->str, batch->len, sync);
+		g_string_set_size(batch, 0);
+		g_mutex_lock(&priv->lock);
+	}
+	g_mutex_unlock(&priv->lock);
+	return NULL;
+}
+
+static void
+write_len(Log4gQuietWriter *base, const gchar *buffer, gsize length)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (priv->fd < 0 || !length) {
+		return;
+	}
+	if (G_UNLIKELY(!priv->thread)) {
+		write_(priv, buffer, length, FALSE);
+	} else {
+		g_mutex_lock(&priv->lock);
+		while (priv->pending->len >= MAX_PENDING) {
+			g_cond_wait(&priv->drained, &priv->lock);
+		}
+		if (!priv->pending->len) {
+			g_cond_signal(&priv->wake);
+		}
+		g_string_append_len(priv->pending, buffer, length);
+		g_mutex_unlock(&priv->lock);
+	}
+	log4g_counting_quiet_writer_set_count(base,
+			log4g_counting_quiet_writer_get_count(base) + length);
+}
+
+static void
+flush_(Log4gQuietWriter *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (priv->fd < 0) {
+		return;
+	}
+	if (G_UNLIKELY(!priv->thread)) {
+		write_(priv, NULL, 0, TRUE);
+	} else {
+		g_mutex_lock(&priv->lock);
+		priv->sync = TRUE;
+		g_cond_signal(&priv->wake);
+		g_mutex_unlock(&priv->lock);
+	}
+}
+
+static void
+close_(Log4gQuietWriter *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (priv->thread) {
+		g_mutex_lock(&priv->lock);
+		priv->closing = TRUE;
+		g_cond_signal(&priv->wake);
+		g_mutex_unlock(&priv->lock);
+		/* the completion thread writes everything before exiting */
+		g_thread_join(priv->thread);
+		priv->thread = NULL;
+	}
+#ifdef HAVE_LIBURING
+	if (priv->uring) {
+		io_uring_queue_exit(&priv->ring);
+		priv->uring = FALSE;
+	}
+#endif
+	priv->fd = -1;
+	LOG4G_QUIET_WRITER_CLASS(log4g_uring_quiet_writer_parent_class)->
+		close(base);
+}
+
+static void
+log4g_uring_quiet_writer_class_init(Log4gUringQuietWriterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = finalize;
+	Log4gQuietWriterClass *qw_class = LOG4G_QUIET_WRITER_CLASS(klass);
+	qw_class->write_len = write_len;
+	qw_class->flush = flush_;
+	qw_class->close = close_;
+	g_type_class_add_private(klass, sizeof(struct Private));
+}
+
+static void
+log4g_uring_quiet_writer_class_finalize(
+		G_GNUC_UNUSED Log4gUringQuietWriterClass *klass)
+{
+	/* do nothing */
+}
+
+void
+log4g_uring_quiet_writer_register(GTypeModule *module)
+{
+	log4g_uring_quiet_writer_register_type(module);
+}
+
+/**
+ * log4g_uring_quiet_writer_new:
+ * @file: An open stdio(3) stream to write to.
+ * @error: The error handler to use.
+ *
+ * Create a new io_uring quiet writer object and start its completion
+ * thread. Nothing should be written to @file through stdio(3) after this
+ * function returns.
+ *
+ * @See: io_uring(7), #Log4gErrorHandlerInterface
+ *
+ * Returns: A new io_uring quiet writer object.
+ * Since: 0.1
+ */
+Log4gQuietWriter *
+log4g_uring_quiet_writer_new(FILE *file, GObject *error)
+{
+	g_return_val_if_fail(file, NULL);
+	g_return_val_if_fail(error, NULL);
+	Log4gQuietWriter *self =
+		g_object_new(LOG4G_TYPE_URING_QUIET_WRITER, NULL);
+	if (!self) {
+		return NULL;
+	}
+	log4g_quiet_writer_set_error_handler(self, error);
+	log4g_quiet_writer_set_file(self, file);
+	struct Private *priv = GET_PRIVATE(self);
+	if (EOF == fflush(file)) {
+		log4g_log_error("fflush(): %s", g_strerror(errno));
+	}
+	priv->fd = fileno(file);
+	priv->offset = lseek(priv->fd, 0, SEEK_END);
+	if (priv->offset < 0) {
+		priv->offset = 0;
+	}
+#ifdef HAVE_LIBURING
+	gint status = io_uring_queue_init(8, &priv->ring, 0);
+	if (status < 0) {
+		log4g_log_warn("io_uring_queue_init(): %s",
+				g_strerror(-status));
+	} else {
+		priv->uring = TRUE;
+	}
+#endif
+	GError *e = NULL;
+	priv->thread = g_thread_try_new("log4g-uring", run_, priv, &e);
+	if (!priv->thread) {
+		/* write from the calling thread instead */
+		log4g_log_warn("g_thread_try_new(): %s", e->message);
+		g_error_free(e);
+	}
+	return self;
+}
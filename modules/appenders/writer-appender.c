@@ -29,6 +29,14 @@
  *
  * The value of immediate-flush determines if the I/O stream will be flushed
  * after each write. The default value is %TRUE.
+ *
+ * When events are delivered in batches (e.g. by an async appender) the
+ * whole batch is formatted into a single buffer and written at once, so
+ * immediate-flush applies once per batch rather than once per event.
+ *
+ * Writer appenders may be called from several threads at once. Events are
+ * formatted into a per-thread buffer without holding any lock, only the
+ * write to the underlying quiet writer is serialized.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -50,9 +58,37 @@ G_DEFINE_DYNAMIC_TYPE(Log4gWriterAppender, log4g_writer_appender,
 struct Private {
 	gboolean flush;
 	Log4gQuietWriter *writer;
-	GMutex lock;
+	GMutex lock; /* Serializes access to 'writer' */
 };
 
+/** \brief The initial size of a per-thread format buffer */
+#define BUF_SIZE (256)
+
+/** \brief Per-thread format buffers larger than this are released */
+#define MAX_CAPACITY (64 * 1024)
+
+static void
+buffer_free_(gpointer string)
+{
+	g_string_free(string, TRUE);
+}
+
+static GPrivate buffer = G_PRIVATE_INIT(buffer_free_);
+
+/* Retrieve the (empty) per-thread buffer events are formatted into */
+static GString *
+buffer_(void)
+{
+	GString *string = g_private_get(&buffer);
+	if (G_UNLIKELY(!string || string->allocated_len > MAX_CAPACITY)) {
+		string = g_string_sized_new(BUF_SIZE);
+		g_private_replace(&buffer, string);
+	} else {
+		g_string_set_size(string, 0);
+	}
+	return string;
+}
+
 static void
 log4g_writer_appender_init(Log4gWriterAppender *self)
 {
@@ -125,6 +161,15 @@ append(Log4gAppender *base, Log4gLoggingEvent *event)
 	log4g_writer_appender_sub_append(base, event);
 }
 
+static void
+append_batch(Log4gAppender *base, Log4gLoggingEvent **events, guint n)
+{
+	if (!log4g_writer_appender_check_entry_conditions(base)) {
+		return;
+	}
+	log4g_writer_appender_sub_append_batch(base, events, n);
+}
+
 static void
 close_(Log4gAppender *base)
 {
@@ -144,16 +189,41 @@ requires_layout(G_GNUC_UNUSED Log4gAppender *self)
 	return TRUE;
 }
 
-void
+/* Write a formatted buffer, the writer is re-checked under the lock since
+ * the appender may have been closed or reset while formatting. */
+static void
+write_(Log4gAppender *base, GString *string)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	g_mutex_lock(&priv->lock);
+	if (priv->writer) {
+		log4g_quiet_writer_write_len(priv->writer, string->str,
+				string->len);
+		if (priv->flush) {
+			log4g_quiet_writer_flush(priv->writer);
+		}
+	}
+	g_mutex_unlock(&priv->lock);
+}
+
+static void
 sub_append(Log4gAppender *base, Log4gLoggingEvent *event)
 {
 	Log4gLayout *layout = log4g_appender_get_layout(base);
-	const char *message = log4g_layout_format(layout, event);
-	struct Private *priv = GET_PRIVATE(base);
-	log4g_quiet_writer_write(priv->writer, message);
-	if (priv->flush) {
-		log4g_quiet_writer_flush(priv->writer);
+	GString *string = buffer_();
+	log4g_layout_format_to(layout, event, string);
+	write_(base, string);
+}
+
+static void
+sub_append_batch(Log4gAppender *base, Log4gLoggingEvent **events, guint n)
+{
+	Log4gLayout *layout = log4g_appender_get_layout(base);
+	GString *string = buffer_();
+	for (guint i = 0; i < n; ++i) {
+		log4g_layout_format_to(layout, events[i], string);
 	}
+	write_(base, string);
 }
 
 static void
@@ -185,9 +255,12 @@ log4g_writer_appender_class_init(Log4gWriterAppenderClass *klass)
 	object_class->set_property = set_property;
 	Log4gAppenderClass *appender_class = LOG4G_APPENDER_CLASS(klass);
 	appender_class->append = append;
+	appender_class->append_batch = append_batch;
 	appender_class->close = close_;
 	appender_class->requires_layout = requires_layout;
+	appender_class->concurrent_append = TRUE;
 	klass->sub_append = sub_append;
+	klass->sub_append_batch = sub_append_batch;
 	klass->close_writer = close_writer;
 	klass->reset = reset;
 	g_type_class_add_private(klass, sizeof(struct Private));
@@ -314,6 +387,26 @@ log4g_writer_appender_sub_append(Log4gAppender *base,
 	LOG4G_WRITER_APPENDER_GET_CLASS(base)->sub_append(base, event);
 }
 
+/**
+ * log4g_writer_appender_sub_append_batch:
+ * @base: A writer appender object.
+ * @events: The log events to append.
+ * @n: The number of events in @events.
+ *
+ * Calls the @sub_append_batch function from the #Log4gWriterAppender of
+ * @self.
+ *
+ * Since: 0.1
+ */
+void
+log4g_writer_appender_sub_append_batch(Log4gAppender *base,
+		Log4gLoggingEvent **events, guint n)
+{
+	g_return_if_fail(LOG4G_IS_WRITER_APPENDER(base));
+	LOG4G_WRITER_APPENDER_GET_CLASS(base)->sub_append_batch(base, events,
+			n);
+}
+
 /**
  * log4g_writer_appender_reset:
  * @base: A writer appender object.
@@ -329,6 +422,39 @@ log4g_writer_appender_reset(Log4gAppender *base)
 	LOG4G_WRITER_APPENDER_GET_CLASS(base)->reset(base);
 }
 
+/**
+ * log4g_writer_appender_lock:
+ * @base: A writer appender object.
+ *
+ * Acquire the lock that serializes writes to the quiet writer.
+ *
+ * Sub-classes that replace or inspect the quiet writer while other threads
+ * may be appending (e.g. to roll over a file) must hold this lock.
+ *
+ * Since: 0.1
+ */
+void
+log4g_writer_appender_lock(Log4gAppender *base)
+{
+	g_return_if_fail(LOG4G_IS_WRITER_APPENDER(base));
+	g_mutex_lock(&GET_PRIVATE(base)->lock);
+}
+
+/**
+ * log4g_writer_appender_unlock:
+ * @base: A writer appender object.
+ *
+ * Release the lock acquired by log4g_writer_appender_lock().
+ *
+ * Since: 0.1
+ */
+void
+log4g_writer_appender_unlock(Log4gAppender *base)
+{
+	g_return_if_fail(LOG4G_IS_WRITER_APPENDER(base));
+	g_mutex_unlock(&GET_PRIVATE(base)->lock);
+}
+
 /**
  * log4g_writer_appender_write_footer:
  * @base: A writer appender object.
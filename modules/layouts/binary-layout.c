@@ -0,0 +1,531 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: binary-layout
+ * @short_description: A compact binary encoding of logging events
+ * @see_also: #Log4gFileAppenderClass, #Log4gPatternLayoutClass
+ *
+ * The binary layout encodes every field of a logging event (time stamp,
+ * level, logger, thread, location, message, NDC and MDC) into a compact
+ * binary record. Integers are written as variable length integers and time
+ * stamps as the difference from the previous event.
+ *
+ * Logger names, thread names, locations and MDC keys are written once per
+ * file into a string dictionary and referred to by number afterwards. Each
+ * logging thread keeps its own dictionary, so events may be encoded by many
+ * threads at once without locking. A thread keeps dictionaries for the
+ * four binary layouts it used most recently, a thread that alternates
+ * between more layouts than that starts a new dictionary each time. Logger names, thread names and
+ * locations are looked up by address, they must have static storage
+ * duration (as they do when the Log4g logging macros are used, and as
+ * thread names always do since they are interned).
+ *
+ * Binary output contains nul bytes. It must be written by an appender that
+ * formats events with log4g_layout_format_to(), e.g. #Log4gFileAppender or
+ * #Log4gRollingFileAppender. The header written at the start of every file
+ * resets the dictionaries. Use the <command>log4g-decode</command> tool to
+ * render binary files with a conversion pattern, for example:
+ *
+ * |[
+ * log4g-decode --pattern='%d{%H:%M:%S.%6N} %-5p [%t] %c - %m%n' app.log4g
+ * ]|
+ *
+ * Events logged with the log4g_static_trace() family of macros are
+ * written more compactly still. The level, location and format string of
+ * each call site are written once per file, and each event records only
+ * the call site, time stamp and the raw format parameters. The message is
+ * not formatted by the logging thread at all, the decoder formats it.
+ * Long double parameters are stored with double precision.
+ *
+ * <note><para>
+ * Events formatted just before a rolling file appender rolls over may be
+ * written to the new file and refer to strings defined in the previous
+ * file. The decoder prints such strings as "?".
+ * </para></note>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "helpers/binary-format.h"
+#include "layout/binary-layout.h"
+#include <string.h>
+
+G_DEFINE_DYNAMIC_TYPE(Log4gBinaryLayout, log4g_binary_layout,
+		LOG4G_TYPE_LAYOUT)
+
+#define ASSIGN_PRIVATE(instance) \
+	(G_TYPE_INSTANCE_GET_PRIVATE(instance, LOG4G_TYPE_BINARY_LAYOUT, \
+		struct Private))
+
+#define GET_PRIVATE(instance) \
+	((struct Private *)((Log4gBinaryLayout *)instance)->priv)
+
+struct Private {
+	guint id; /* Identifies this layout in per-thread streams */
+	gint epoch; /* Incremented for each new file */
+	gint streams; /* Allocates stream numbers */
+	GString *string;
+};
+
+/** \brief The number of binary layouts each thread keeps a stream for,
+ * beyond this the least recently used stream is recycled */
+#define STREAM_MAX (4)
+
+/** \brief The largest dictionary before it is cleared */
+#define DICTIONARY_MAX (4096)
+
+/** \brief The largest fixed size part of an event record */
+#define RECORD_MAX (2 + (10 * LOG4G_BINARY_VARINT_MAX))
+
+/* Default string buffer size */
+#define BUF_SIZE (256)
+
+/* Maximum string buffer size */
+#define MAX_CAPACITY (1024)
+
+/* The state of one thread writing to one binary layout */
+struct Stream {
+	guint layout; /* Layout id + 1, zero if unused */
+	gint epoch;
+	guint number;
+	guint next; /* The next string id */
+	gint64 time; /* The time of the previous event */
+	GHashTable *pointers; /* Static strings, by address */
+	GHashTable *strings; /* Transient strings, by value */
+	guchar *sites; /* Indexed by call site id, non-zero if defined */
+	guint capacity; /* The size of sites */
+};
+
+static void
+streams_free_(gpointer data);
+
+static GPrivate streams = G_PRIVATE_INIT(streams_free_);
+
+static gint next = 0;
+
+static void
+streams_free_(gpointer data)
+{
+	struct Stream *stream = data;
+	for (guint i = 0; i < STREAM_MAX; ++i) {
+		if (stream[i].pointers) {
+			g_hash_table_destroy(stream[i].pointers);
+		}
+		if (stream[i].strings) {
+			g_hash_table_destroy(stream[i].strings);
+		}
+		g_free(stream[i].sites);
+	}
+	g_free(stream);
+}
+
+static void
+log4g_binary_layout_init(Log4gBinaryLayout *self)
+{
+	self->priv = ASSIGN_PRIVATE(self);
+	struct Private *priv = GET_PRIVATE(self);
+	priv->id = (guint)g_atomic_int_add(&next, 1);
+	priv->string = g_string_sized_new(BUF_SIZE);
+}
+
+static void
+finalize(GObject *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (priv->string) {
+		g_string_free(priv->string, TRUE);
+	}
+	G_OBJECT_CLASS(log4g_binary_layout_parent_class)->finalize(base);
+}
+
+/* Clear the dictionary of a stream, the time stamp base is kept because
+ * the decoder only resets it at the start of a file */
+static void
+stream_reset_(struct Stream *stream)
+{
+	g_hash_table_remove_all(stream->pointers);
+	g_hash_table_remove_all(stream->strings);
+	if (stream->sites) {
+		memset(stream->sites, 0, stream->capacity);
+	}
+	stream->next = 1;
+}
+
+/* Find the stream of the calling thread, the most recently used stream is
+ * kept first */
+static struct Stream *
+stream_(Log4gLayout *base)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	struct Stream *slots = g_private_get(&streams);
+	if (G_UNLIKELY(!slots)) {
+		slots = g_new0(struct Stream, STREAM_MAX);
+		g_private_set(&streams, slots);
+	}
+	struct Stream *stream = slots;
+	gint epoch = g_atomic_int_get(&priv->epoch);
+	if (G_UNLIKELY(stream->layout != priv->id + 1)) {
+		guint i = 1;
+		while (i < STREAM_MAX - 1
+				&& slots[i].layout != priv->id + 1) {
+			++i;
+		}
+		/* move the stream (or the least recently used) to the front */
+		struct Stream found = slots[i];
+		memmove(slots + 1, slots, i * sizeof(*slots));
+		*stream = found;
+		if (stream->layout != priv->id + 1) {
+			if (!stream->pointers) {
+				stream->pointers =
+					g_hash_table_new(NULL, NULL);
+				stream->strings = g_hash_table_new_full(
+						g_str_hash, g_str_equal,
+						g_free, NULL);
+			}
+			stream->layout = priv->id + 1;
+			stream->number = (guint)g_atomic_int_add(
+					&priv->streams, 1);
+			stream->epoch = epoch;
+			stream->time = 0;
+			stream_reset_(stream);
+		}
+	}
+	if (G_UNLIKELY(stream->epoch != epoch)) {
+		/* the decoder resets every stream at the start of a file */
+		stream->epoch = epoch;
+		stream->time = 0;
+		stream_reset_(stream);
+	} else if (G_UNLIKELY(stream->next > DICTIONARY_MAX)) {
+		stream_reset_(stream);
+	}
+	return stream;
+}
+
+static void
+define_(GString *string, struct Stream *stream, guint id, const gchar *value)
+{
+	guchar header[1 + (3 * LOG4G_BINARY_VARINT_MAX)];
+	gsize length = strlen(value);
+	guchar *p = header;
+	*p++ = LOG4G_BINARY_STRING;
+	p = log4g_binary_put_varint(p, stream->number);
+	p = log4g_binary_put_varint(p, id);
+	p = log4g_binary_put_varint(p, length);
+	g_string_append_len(string, (const gchar *)header, p - header);
+	g_string_append_len(string, value, length);
+}
+
+/* Look up a string with static storage duration, defining it if needed */
+static guint
+static_(GString *string, struct Stream *stream, const gchar *value)
+{
+	if (!value) {
+		return 0;
+	}
+	guint id = GPOINTER_TO_UINT(g_hash_table_lookup(stream->pointers,
+				value));
+	if (G_UNLIKELY(!id)) {
+		id = stream->next++;
+		g_hash_table_insert(stream->pointers, (gpointer)value,
+				GUINT_TO_POINTER(id));
+		define_(string, stream, id, value);
+	}
+	return id;
+}
+
+/* Look up a transient string, defining it if needed */
+static guint
+transient_(GString *string, struct Stream *stream, const gchar *value)
+{
+	if (!value) {
+		return 0;
+	}
+	guint id = GPOINTER_TO_UINT(g_hash_table_lookup(stream->strings,
+				value));
+	if (G_UNLIKELY(!id)) {
+		id = stream->next++;
+		g_hash_table_insert(stream->strings, g_strdup(value),
+				GUINT_TO_POINTER(id));
+		define_(string, stream, id, value);
+	}
+	return id;
+}
+
+/* Append a length prefixed string */
+static void
+bytes_(GString *string, const gchar *value)
+{
+	guchar header[LOG4G_BINARY_VARINT_MAX];
+	if (!value) {
+		g_string_append_c(string, 0);
+		return;
+	}
+	gsize length = strlen(value);
+	guchar *p = log4g_binary_put_varint(header, length + 1);
+	g_string_append_len(string, (const gchar *)header, p - header);
+	g_string_append_len(string, value, length);
+}
+
+/* Append a variable length integer */
+static void
+varint_(GString *string, guint64 value)
+{
+	guchar buffer[LOG4G_BINARY_VARINT_MAX];
+	guchar *p = log4g_binary_put_varint(buffer, value);
+	g_string_append_len(string, (const gchar *)buffer, p - buffer);
+}
+
+/* Define a call site once per stream */
+static void
+site_(GString *string, struct Stream *stream, const Log4gCallSite *site)
+{
+	guint id = (guint)site->id;
+	if (G_LIKELY(id < stream->capacity && stream->sites[id])) {
+		return;
+	}
+	if (id >= stream->capacity) {
+		guint capacity = MAX(stream->capacity * 2, 64);
+		while (capacity <= id) {
+			capacity *= 2;
+		}
+		stream->sites = g_realloc(stream->sites, capacity);
+		memset(stream->sites + stream->capacity, 0,
+				capacity - stream->capacity);
+		stream->capacity = capacity;
+	}
+	guint file = static_(string, stream, site->file);
+	guint line = static_(string, stream, site->line);
+	guint function = static_(string, stream, site->function);
+	guint format = static_(string, stream, site->format);
+	g_string_append_c(string, LOG4G_BINARY_CALL_SITE);
+	varint_(string, stream->number);
+	varint_(string, id);
+	varint_(string, LOG4G_BINARY_ZIGZAG(site->level));
+	varint_(string, file);
+	varint_(string, line);
+	varint_(string, function);
+	varint_(string, format);
+	stream->sites[id] = 1;
+}
+
+/* Append a captured format parameter */
+static void
+argument_(GString *string, const Log4gArgument *arg)
+{
+	guint64 bits;
+	gdouble d;
+	g_string_append_c(string, (gchar)arg->type);
+	switch (arg->type) {
+	case LOG4G_ARGUMENT_INT:
+		varint_(string, LOG4G_BINARY_ZIGZAG(arg->value.i));
+		break;
+	case LOG4G_ARGUMENT_LONG:
+		varint_(string, LOG4G_BINARY_ZIGZAG(arg->value.l));
+		break;
+	case LOG4G_ARGUMENT_LLONG:
+		varint_(string, LOG4G_BINARY_ZIGZAG(arg->value.ll));
+		break;
+	case LOG4G_ARGUMENT_INTMAX:
+		varint_(string, LOG4G_BINARY_ZIGZAG(arg->value.j));
+		break;
+	case LOG4G_ARGUMENT_PTRDIFF:
+		varint_(string, LOG4G_BINARY_ZIGZAG(arg->value.t));
+		break;
+	case LOG4G_ARGUMENT_SIZE:
+		varint_(string, arg->value.z);
+		break;
+	case LOG4G_ARGUMENT_POINTER:
+		varint_(string, (guintptr)arg->value.p);
+		break;
+	case LOG4G_ARGUMENT_DOUBLE:
+	case LOG4G_ARGUMENT_LDOUBLE:
+		d = (arg->type == LOG4G_ARGUMENT_DOUBLE
+				? arg->value.d : (gdouble)arg->value.ld);
+		memcpy(&bits, &d, sizeof(bits));
+		bits = GUINT64_TO_LE(bits);
+		g_string_append_len(string, (const gchar *)&bits,
+				sizeof(bits));
+		break;
+	case LOG4G_ARGUMENT_STRING:
+		bytes_(string, arg->value.s);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Append the MDC of an event */
+static void
+properties_(GString *string, struct Stream *stream, const Log4gMDCMap *mdc)
+{
+	guint size = log4g_mdc_map_get_size(mdc);
+	varint_(string, size);
+	for (guint i = 0; i < size; ++i) {
+		varint_(string, transient_(string, stream,
+					log4g_mdc_map_get_key(mdc, i)));
+		bytes_(string, log4g_mdc_map_get_value(mdc, i));
+	}
+}
+
+/* Encode an event logged from a call site, without its message */
+static void
+call_(GString *string, struct Stream *stream, Log4gLoggingEvent *event,
+		const Log4gCallSite *site, const Log4gArgument *args,
+		guint count)
+{
+	site_(string, stream, site);
+	guint logger = static_(string, stream,
+			log4g_logging_event_get_logger_name(event));
+	guint thread = static_(string, stream,
+			log4g_logging_event_get_thread_name(event));
+	const Log4gMDCMap *mdc = log4g_logging_event_get_mdc_map(event);
+	guint size = log4g_mdc_map_get_size(mdc);
+	for (guint i = 0; i < size; ++i) {
+		transient_(string, stream, log4g_mdc_map_get_key(mdc, i));
+	}
+	/* fixed size fields */
+	gsize start = string->len;
+	g_string_set_size(string, start + RECORD_MAX);
+	guchar *p = (guchar *)string->str + start;
+	*p++ = LOG4G_BINARY_CALL;
+	p = log4g_binary_put_varint(p, stream->number);
+	gint64 time = log4g_logging_event_get_time_stamp_ns(event);
+	p = log4g_binary_put_varint(p,
+			LOG4G_BINARY_ZIGZAG(time - stream->time));
+	stream->time = time;
+	p = log4g_binary_put_varint(p, (guint)site->id);
+	p = log4g_binary_put_varint(p, logger);
+	p = log4g_binary_put_varint(p, thread);
+	p = log4g_binary_put_varint(p, count);
+	g_string_set_size(string, p - (guchar *)string->str);
+	/* variable size fields */
+	for (guint i = 0; i < count; ++i) {
+		argument_(string, &args[i]);
+	}
+	bytes_(string, log4g_logging_event_get_ndc(event));
+	properties_(string, stream, mdc);
+}
+
+static void
+format_to(Log4gLayout *base, Log4gLoggingEvent *event, GString *string)
+{
+	struct Stream *stream = stream_(base);
+	const Log4gCallSite *site = log4g_logging_event_get_call_site(event);
+	if (site) {
+		guint count;
+		const Log4gArgument *args =
+			log4g_logging_event_get_arguments(event, &count);
+		if (args) {
+			call_(string, stream, event, site, args, count);
+			return;
+		}
+	}
+	/* define new strings before the event record */
+	guint logger = static_(string, stream,
+			log4g_logging_event_get_logger_name(event));
+	guint thread = static_(string, stream,
+			log4g_logging_event_get_thread_name(event));
+	guint file = static_(string, stream,
+			log4g_logging_event_get_file_name(event));
+	guint line = static_(string, stream,
+			log4g_logging_event_get_line_number(event));
+	guint function = static_(string, stream,
+			log4g_logging_event_get_function_name(event));
+	const Log4gMDCMap *mdc = log4g_logging_event_get_mdc_map(event);
+	guint size = log4g_mdc_map_get_size(mdc);
+	for (guint i = 0; i < size; ++i) {
+		transient_(string, stream, log4g_mdc_map_get_key(mdc, i));
+	}
+	/* fixed size fields */
+	gsize start = string->len;
+	g_string_set_size(string, start + RECORD_MAX);
+	guchar *p = (guchar *)string->str + start;
+	*p++ = LOG4G_BINARY_EVENT;
+	p = log4g_binary_put_varint(p, stream->number);
+	gint64 time = log4g_logging_event_get_time_stamp_ns(event);
+	p = log4g_binary_put_varint(p,
+			LOG4G_BINARY_ZIGZAG(time - stream->time));
+	stream->time = time;
+	Log4gLevel *level = log4g_logging_event_get_level(event);
+	p = log4g_binary_put_varint(p, LOG4G_BINARY_ZIGZAG(
+				(level ? log4g_level_to_int(level) : 0)));
+	p = log4g_binary_put_varint(p, logger);
+	p = log4g_binary_put_varint(p, thread);
+	p = log4g_binary_put_varint(p, file);
+	p = log4g_binary_put_varint(p, line);
+	p = log4g_binary_put_varint(p, function);
+	g_string_set_size(string, p - (guchar *)string->str);
+	/* variable size fields */
+	bytes_(string, log4g_logging_event_get_rendered_message(event));
+	bytes_(string, log4g_logging_event_get_ndc(event));
+	properties_(string, stream, mdc);
+}
+
+static gchar *
+format(Log4gLayout *base, Log4gLoggingEvent *event)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (priv->string->allocated_len > MAX_CAPACITY) {
+		g_string_free(priv->string, TRUE);
+		priv->string = g_string_sized_new(BUF_SIZE);
+	} else {
+		g_string_set_size(priv->string, 0);
+	}
+	format_to(base, event, priv->string);
+	return priv->string->str;
+}
+
+static const gchar *
+get_content_type(G_GNUC_UNUSED Log4gLayout *base)
+{
+	return "application/octet-stream";
+}
+
+static const gchar *
+get_header(Log4gLayout *base)
+{
+	/* a new file needs new dictionaries */
+	g_atomic_int_inc(&GET_PRIVATE(base)->epoch);
+	return LOG4G_BINARY_MAGIC;
+}
+
+static void
+log4g_binary_layout_class_init(Log4gBinaryLayoutClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = finalize;
+	Log4gLayoutClass *layout_class = LOG4G_LAYOUT_CLASS(klass);
+	layout_class->format = format;
+	layout_class->format_to = format_to;
+	layout_class->get_content_type = get_content_type;
+	layout_class->get_header = get_header;
+	g_type_class_add_private(klass, sizeof(struct Private));
+}
+
+static void
+log4g_binary_layout_class_finalize(G_GNUC_UNUSED Log4gBinaryLayoutClass *klass)
+{
+	/* do nothing */
+}
+
+void
+log4g_binary_layout_register(GTypeModule *module)
+{
+	log4g_binary_layout_register_type(module);
+}
@@ -0,0 +1,253 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: date-format
+ * @short_description: Date formatting with a per-second cache
+ * @see_also: strftime(3), #Log4gDateLayoutClass, #Log4gPatternLayoutClass
+ *
+ * A date format is a strftime(3) pattern with three extensions for
+ * sub-second fields:
+ * <itemizedlist>
+ * <listitem><para>\%3N outputs milliseconds (000-999)</para></listitem>
+ * <listitem><para>\%6N outputs microseconds (000000-999999)</para></listitem>
+ * <listitem><para>\%9N outputs nanoseconds
+ * (000000000-999999999)</para></listitem>
+ * </itemizedlist>
+ *
+ * The pattern is split around sub-second fields when the format is created.
+ * The strftime(3) parts are rendered once per second into a small per-thread
+ * cache, sub-second fields are appended with integer arithmetic. Most
+ * events therefore avoid localtime_r(3), which may lock the time zone
+ * state, and strftime(3) entirely.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "helpers/date-format.h"
+
+/** \brief The maximum number of fields in a date format */
+#define SEGMENT_MAX (16)
+
+/** \brief The number of date formats cached by each thread */
+#define CACHE_SIZE (4)
+
+struct Segment {
+	gchar *format; /* A strftime(3) pattern, NULL for sub-second fields */
+	gint digits; /* The number of sub-second digits (3, 6 or 9) */
+};
+
+struct Log4gDateFormat_ {
+	guint id; /* Identifies this format in per-thread caches */
+	guint size;
+	struct Segment segment[SEGMENT_MAX];
+};
+
+/* The strftime(3) parts of one date format rendered for one second */
+struct Entry {
+	guint id;
+	glong second;
+	gsize offset[SEGMENT_MAX + 1];
+	gchar buffer[LOG4G_DATE_FORMAT_SIZE];
+};
+
+/** \brief Nanoseconds per second */
+#define NSEC (1000000000L)
+
+/* Divisors that reduce nanoseconds to 'digits' sub-second digits */
+static const glong scale[] = {
+	[3] = 1000000L,
+	[6] = 1000L,
+	[9] = 1L
+};
+
+static GPrivate cache = G_PRIVATE_INIT(g_free);
+
+static gint next = 0;
+
+static void
+segment_(Log4gDateFormat *self, const gchar *format, gsize length,
+		gint digits)
+{
+	if (G_UNLIKELY(SEGMENT_MAX == self->size)) {
+		log4g_log_warn(Q_("too many fields in date format, "
+					"ignoring the remainder"));
+		return;
+	}
+	struct Segment *segment = &self->segment[self->size++];
+	segment->format = (format ? g_strndup(format, length) : NULL);
+	segment->digits = digits;
+}
+
+/**
+ * log4g_date_format_new:
+ * @format: A strftime(3) pattern, optionally with sub-second fields.
+ *
+ * Create a new date format.
+ *
+ * Returns: A new date format, free it with log4g_date_format_free().
+ * Since: 0.1
+ */
+Log4gDateFormat *
+log4g_date_format_new(const gchar *format)
+{
+	g_return_val_if_fail(format, NULL);
+	Log4gDateFormat *self = g_new0(Log4gDateFormat, 1);
+	self->id = (guint)g_atomic_int_add(&next, 1);
+	const gchar *start = format;
+	for (const gchar *p = format; *p; ++p) {
+		if ('%' != *p) {
+			continue;
+		}
+		if (('3' == p[1] || '6' == p[1] || '9' == p[1])
+				&& 'N' == p[2]) {
+			if (p > start) {
+				segment_(self, start, p - start, 0);
+			}
+			segment_(self, NULL, 0, p[1] - '0');
+			p += 2;
+			start = p + 1;
+		} else if (p[1]) {
+			++p; /* skip "%%" and other conversions */
+		}
+	}
+	if (*start) {
+		segment_(self, start, strlen(start), 0);
+	}
+	return self;
+}
+
+/**
+ * log4g_date_format_free:
+ * @self: A date format.
+ *
+ * Free a date format created by log4g_date_format_new().
+ *
+ * Since: 0.1
+ */
+void
+log4g_date_format_free(Log4gDateFormat *self)
+{
+	if (!self) {
+		return;
+	}
+	for (guint i = 0; i < self->size; ++i) {
+		g_free(self->segment[i].format);
+	}
+	g_free(self);
+}
+
+/* Render the strftime(3) parts of 'self' for 'second' */
+static gboolean
+update_(const Log4gDateFormat *self, struct Entry *entry, glong second)
+{
+	struct tm tm;
+	time_t time = second;
+	if (!localtime_r(&time, &tm)) {
+		log4g_log_error("localtime_r(): %s", g_strerror(errno));
+		return FALSE;
+	}
+	gsize offset = 0;
+	for (guint i = 0; i < self->size; ++i) {
+		entry->offset[i] = offset;
+		const gchar *format = self->segment[i].format;
+		if (!format) {
+			continue;
+		}
+		gsize n = strftime(entry->buffer + offset,
+				sizeof entry->buffer - offset, format, &tm);
+		if (!n && *format) {
+			log4g_log_error(Q_("strftime() returned zero (0)"));
+			entry->id = 0;
+			return FALSE;
+		}
+		offset += n;
+	}
+	entry->offset[self->size] = offset;
+	entry->id = self->id + 1;
+	entry->second = second;
+	return TRUE;
+}
+
+static gchar *
+digits_(gchar *p, glong value, gint digits)
+{
+	for (gint i = digits - 1; i >= 0; --i) {
+		p[i] = '0' + (value % 10);
+		value /= 10;
+	}
+	return p + digits;
+}
+
+/**
+ * log4g_date_format_render:
+ * @self: A date format.
+ * @time: The time to format in nanoseconds since the Unix epoch.
+ * @buffer: A buffer of at least #LOG4G_DATE_FORMAT_SIZE bytes.
+ *
+ * Format a time stamp. This function may be called from several threads
+ * at once.
+ *
+ * Returns: The length of the nul-terminated string written to @buffer, or
+ *          zero (0) if @time could not be formatted.
+ * Since: 0.1
+ */
+gsize
+log4g_date_format_render(const Log4gDateFormat *self, gint64 time,
+		gchar *buffer)
+{
+	glong second = time / NSEC;
+	glong nanosecond = time % NSEC;
+	if (G_UNLIKELY(nanosecond < 0)) {
+		nanosecond += NSEC;
+		--second;
+	}
+	struct Entry *entries = g_private_get(&cache);
+	if (G_UNLIKELY(!entries)) {
+		entries = g_new0(struct Entry, CACHE_SIZE);
+		g_private_set(&cache, entries);
+	}
+	/* entry ids are offset by one so a zeroed entry never matches */
+	struct Entry *entry = &entries[self->id % CACHE_SIZE];
+	if (entry->id != self->id + 1 || entry->second != second) {
+		if (!update_(self, entry, second)) {
+			return 0;
+		}
+	}
+	gchar *p = buffer;
+	gchar *end = buffer + LOG4G_DATE_FORMAT_SIZE - 1;
+	for (guint i = 0; i < self->size; ++i) {
+		if (self->segment[i].format) {
+			gsize n = entry->offset[i + 1] - entry->offset[i];
+			n = MIN(n, (gsize)(end - p));
+			memcpy(p, entry->buffer + entry->offset[i], n);
+			p += n;
+		} else {
+			gint digits = self->segment[i].digits;
+			if (p + digits > end) {
+				continue;
+			}
+			p = digits_(p, nanosecond / scale[digits], digits);
+		}
+	}
+	*p = '\0';
+	return p - buffer;
+}
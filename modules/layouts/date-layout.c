@@ -30,7 +30,9 @@
  * </orderedlist>
  *
  * The date-format property set the strftime(3) conversion pattern that will
- * be used to format the date.
+ * be used to format the date. The pattern may also contain \%3N for
+ * milliseconds, \%6N for microseconds and \%9N for nanoseconds. The
+ * formatted second is cached, see #Log4gDateFormat.
  *
  * The time-zone property can be used to explicitly set the timezone. The
  * default is %NULL.
@@ -40,6 +42,7 @@
 #include "config.h"
 #endif
 #include <errno.h>
+#include "helpers/date-format.h"
 #include "layout/date-layout.h"
 
 G_DEFINE_DYNAMIC_TYPE_EXTENDED(Log4gDateLayout, log4g_date_layout,
@@ -54,7 +57,7 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED(Log4gDateLayout, log4g_date_layout,
 
 struct Private {
 	Log4gDateLayoutType type;
-	gchar *format;
+	Log4gDateFormat *format;
 	gchar *tz;
 };
 
@@ -70,7 +73,7 @@ static void
 finalize(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
-	g_free(priv->format);
+	log4g_date_format_free(priv->format);
 	g_free(priv->tz);
 	G_OBJECT_CLASS(log4g_date_layout_parent_class)->finalize(base);
 }
@@ -88,10 +91,10 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	struct Private *priv = GET_PRIVATE(base);
 	switch (id) {
 	case PROP_DATE_FORMAT:
-		g_free(priv->format);
+		log4g_date_format_free(priv->format);
 		const gchar *format = g_value_get_string(value);
 		if (format) {
-			priv->format = g_strdup(format);
+			priv->format = log4g_date_format_new(format);
 		} else {
 			priv->type = RELATIVE_TIME_DATE_FORMAT;
 			priv->format = NULL;
@@ -164,31 +167,20 @@ log4g_date_layout_date_format(Log4gLayout *base, GString *string,
 		Log4gLoggingEvent *event)
 {
 	g_return_if_fail(LOG4G_IS_DATE_LAYOUT(base));
-	const GTimeVal *tv = log4g_logging_event_get_time_stamp(event);
-	if (!tv) {
-		return;
-	}
-	gchar buffer[128];
+	gint64 time = log4g_logging_event_get_time_stamp_ns(event);
+	gchar buffer[LOG4G_DATE_FORMAT_SIZE];
 	struct Private *priv = GET_PRIVATE(base);
 	if (priv->format) {
-		struct tm tm;
-		time_t time = tv->tv_sec;
-		if (!localtime_r(&time, &tm)) {
-			log4g_log_error("localtime_r(): %s", g_strerror(errno));
-			return;
-		}
-		if (!strftime(buffer, sizeof buffer, priv->format, &tm)) {
+		if (!log4g_date_format_render(priv->format, time, buffer)) {
 			return;
 		}
 	} else {
 		switch (priv->type) {
-		case RELATIVE_TIME_DATE_FORMAT: {
-			glong start = log4g_logging_event_get_start_time();
-			glong time = (tv->tv_sec * 1000)
-				+ (tv->tv_usec * 0.001);
-			g_snprintf(buffer, sizeof buffer, "%ld", time - start);
+		case RELATIVE_TIME_DATE_FORMAT:
+			time -= log4g_logging_event_get_start_time_ns();
+			g_snprintf(buffer, sizeof buffer, "%" G_GINT64_FORMAT,
+					time / G_GINT64_CONSTANT(1000000));
 			break;
-		}
 		default:
 			log4g_log_error(Q_("unrecognized date layout type: %d"),
 					priv->type);
@@ -0,0 +1,118 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG4G_BINARY_FORMAT_H
+#define LOG4G_BINARY_FORMAT_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * The binary log format written by #Log4gBinaryLayout.
+ *
+ * A file starts with LOG4G_BINARY_MAGIC (also written whenever an appender
+ * starts a new file) followed by records. Each record starts with a tag
+ * byte and a stream number. Every logging thread writes its own stream,
+ * so records within a stream are always in order.
+ *
+ * String record:
+ *   tag (LOG4G_BINARY_STRING), stream, id, length, bytes
+ *
+ * Event record:
+ *   tag (LOG4G_BINARY_EVENT), stream,
+ *   time (zig-zag, nanoseconds since the previous event in the stream),
+ *   level (zig-zag), logger id, thread id, file id, line id, function id,
+ *   message (length + 1, bytes), ndc (length + 1, bytes),
+ *   property count, { key id, value (length + 1, bytes) } ...
+ *
+ * Call site record:
+ *   tag (LOG4G_BINARY_CALL_SITE), stream, site id, level (zig-zag),
+ *   file id, line id, function id, format id
+ *
+ * Call record (an event logged from a call site):
+ *   tag (LOG4G_BINARY_CALL), stream, time (as above), site id, logger id,
+ *   thread id, argument count, { argument } ...,
+ *   ndc (length + 1, bytes), property count, { key id, value } ...
+ *
+ * Each argument is a Log4gArgumentType byte followed by the value: signed
+ * integers are zig-zag encoded, size_t & pointers are unsigned, doubles
+ * (and long doubles) are eight little endian IEEE 754 bytes and strings
+ * are length + 1, bytes. Site ids refer to a call site record earlier in
+ * the same stream.
+ *
+ * All integers are unsigned LEB128 variable length integers. String ids
+ * refer to a string record earlier in the same stream, zero (0) is NULL. A
+ * string record may redefine an id. Strings with a length field store the
+ * length plus one, zero (0) is NULL.
+ */
+
+/**
+ * LOG4G_BINARY_MAGIC:
+ *
+ * The header of a binary log file.
+ */
+#define LOG4G_BINARY_MAGIC "log4g-binary 1\n"
+
+#define LOG4G_BINARY_STRING (0x01)
+
+#define LOG4G_BINARY_EVENT (0x02)
+
+#define LOG4G_BINARY_CALL_SITE (0x03)
+
+#define LOG4G_BINARY_CALL (0x04)
+
+/* The maximum size of an encoded 64-bit integer */
+#define LOG4G_BINARY_VARINT_MAX (10)
+
+#define LOG4G_BINARY_ZIGZAG(value) \
+	(((guint64)(value) << 1) ^ (guint64)((gint64)(value) >> 63))
+
+#define LOG4G_BINARY_UNZIGZAG(value) \
+	((gint64)((value) >> 1) ^ -(gint64)((value) & 1))
+
+/* Encode 'value' at 'p', returns the end of the encoded integer */
+static inline guchar *
+log4g_binary_put_varint(guchar *p, guint64 value)
+{
+	while (value >= 0x80) {
+		*p++ = (guchar)(value | 0x80);
+		value >>= 7;
+	}
+	*p++ = (guchar)value;
+	return p;
+}
+
+/* Decode an integer at '*p', returns FALSE if the input is truncated */
+static inline gboolean
+log4g_binary_get_varint(const guchar **p, const guchar *end, guint64 *value)
+{
+	guint64 result = 0;
+	for (guint shift = 0; *p < end && shift < 64; shift += 7) {
+		guchar byte = *(*p)++;
+		result |= (guint64)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			*value = result;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+G_END_DECLS
+
+#endif /* LOG4G_BINARY_FORMAT_H */
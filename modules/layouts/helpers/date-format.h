@@ -0,0 +1,56 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG4G_DATE_FORMAT_H
+#define LOG4G_DATE_FORMAT_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Log4gDateFormat:
+ *
+ * A strftime(3) date format with a per-thread cache of the formatted
+ * second.
+ *
+ * The <structname>Log4gDateFormat</structname> structure does not have any
+ * public members.
+ */
+typedef struct Log4gDateFormat_ Log4gDateFormat;
+
+/**
+ * LOG4G_DATE_FORMAT_SIZE:
+ *
+ * The size of the largest date string a #Log4gDateFormat renders, including
+ * the terminating nul byte.
+ */
+#define LOG4G_DATE_FORMAT_SIZE (128)
+
+G_GNUC_INTERNAL Log4gDateFormat *
+log4g_date_format_new(const gchar *format);
+
+G_GNUC_INTERNAL void
+log4g_date_format_free(Log4gDateFormat *self);
+
+G_GNUC_INTERNAL gsize
+log4g_date_format_render(const Log4gDateFormat *self, gint64 time,
+		gchar *buffer);
+
+G_END_DECLS
+
+#endif /* LOG4G_DATE_FORMAT_H */
@@ -152,6 +152,8 @@ log4g_pattern_converter_space_pad(const Log4gPatternConverter *self,
  * @INVALID_CONVERTER: Sentinel value
  * @RELATIVE_TIME_CONVERTER: Time converter
  * @THREAD_CONVERTER: Thread converter
+ * @THREAD_ID_CONVERTER: Thread number converter
+ * @TID_CONVERTER: Operating system thread identifier converter
  * @LEVEL_CONVERTER: Log level converter
  * @NDC_CONVERTER: Nested data context converter
  * @MESSAGE_CONVERTER: Log message converter
@@ -165,6 +167,8 @@ typedef enum {
 	INVALID_CONVERTER = 0,
 	RELATIVE_TIME_CONVERTER,
 	THREAD_CONVERTER,
+	THREAD_ID_CONVERTER,
+	TID_CONVERTER,
 	LEVEL_CONVERTER,
 	NDC_CONVERTER,
 	MESSAGE_CONVERTER,
@@ -529,6 +533,26 @@ G_GNUC_INTERNAL Log4gPatternConverter *
 log4g_category_pattern_converter_new(struct Log4gFormattingInfo *formatting,
 		gint precision);
 
+/**
+ * Log4gPatternProgram:
+ *
+ * A conversion pattern compiled into a flat array of instructions.
+ *
+ * The <structname>Log4gPatternProgram</structname> structure does not have
+ * any public members.
+ */
+typedef struct Log4gPatternProgram_ Log4gPatternProgram;
+
+G_GNUC_INTERNAL Log4gPatternProgram *
+log4g_pattern_program_new(Log4gPatternConverter *head);
+
+G_GNUC_INTERNAL void
+log4g_pattern_program_free(Log4gPatternProgram *self);
+
+G_GNUC_INTERNAL void
+log4g_pattern_program_format(const Log4gPatternProgram *self,
+		GString *string, Log4gLoggingEvent *event);
+
 G_END_DECLS
 
 #endif /* LOG4G_PATTERN_CONVERTER_H */
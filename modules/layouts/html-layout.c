@@ -115,10 +115,9 @@ format(Log4gLayout *base, Log4gLoggingEvent *event)
 {
 	Log4gHTMLLayout *self = LOG4G_HTML_LAYOUT(base);
 	Log4gLevel *level = log4g_logging_event_get_level(event);
-	const GTimeVal *tv = log4g_logging_event_get_time_stamp(event);
 	gchar *escaped;
-	glong start = log4g_logging_event_get_start_time();
-	glong time = (tv->tv_sec * 1000) + (tv->tv_usec * 0.001);
+	gint64 time = log4g_logging_event_get_time_stamp_ns(event)
+		- log4g_logging_event_get_start_time_ns();
 	if (self->priv->string->len > MAX_CAPACITY) {
 		g_string_free(self->priv->string, TRUE);
 		self->priv->string = g_string_sized_new(BUF_SIZE);
@@ -133,7 +132,8 @@ format(Log4gLayout *base, Log4gLoggingEvent *event)
 	g_string_append(self->priv->string, LOG4G_LAYOUT_LINE_SEP);
 	/* time */
 	g_string_append(self->priv->string, "<td>");
-	g_string_append_printf(self->priv->string, "%ld", time - start);
+	g_string_append_printf(self->priv->string, "%" G_GINT64_FORMAT,
+			time / G_GINT64_CONSTANT(1000000));
 	g_string_append(self->priv->string, "</td>");
 	g_string_append(self->priv->string, LOG4G_LAYOUT_LINE_SEP);
 	/* thread */
@@ -22,11 +22,13 @@
  *
  * The output of this layout consists of a series of Log4g log event objects.
  *
- * Json layouts accept three properties:
+ * Json layouts accept five properties:
  * <orderedlist>
  * <listitem><para>properties</para></listitem>
  * <listitem><para>location-info</para></listitem>
  * <listitem><para>complete</para></listitem>
+ * <listitem><para>ndjson</para></listitem>
+ * <listitem><para>thread-id</para></listitem>
  * </orderedlist>
  *
  * Setting properties to %TRUE causes the JSON layout to output all MDC (mapped
@@ -62,13 +64,31 @@
  *
  * This approach enforces the independence of the JSON layout and the appender
  * where it is embedded.
+ *
+ * Setting the ndjson property to %TRUE selects newline delimited JSON: each
+ * event is written as a compact object on a single line, and the array
+ * header, footer and separators are omitted. This format is suited to log
+ * ingestion pipelines and does not depend on the order in which events are
+ * formatted, so it should be preferred when several threads log to the same
+ * appender. The default value is %FALSE.
+ *
+ * Setting the thread-id property to %TRUE adds the number of the thread
+ * (see log4g_thread_get_id()) as "threadId" and its operating system
+ * identifier (see log4g_thread_get_tid()) as "tid". The default value is
+ * %FALSE.
+ *
+ * Events are encoded directly into the output buffer. Member names are
+ * written from preformatted fragments and strings are escaped with a table
+ * lookup, scanning eight bytes at a time for characters that need escaping.
+ * Formatting an event does not allocate memory beyond growing the output
+ * buffer.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 #include "layout/json-layout.h"
-#include <errno.h>
+#include <string.h>
 
 G_DEFINE_DYNAMIC_TYPE(Log4gJsonLayout, log4g_json_layout, LOG4G_TYPE_LAYOUT)
 
@@ -78,6 +98,8 @@ struct Private {
 	gboolean properties;
 	gboolean info;
 	gboolean complete;
+	gboolean ndjson;
+	gboolean thread_id;
 };
 
 /* Default string buffer size */
@@ -86,6 +108,201 @@ struct Private {
 /* Maximum string buffer size */
 #define MAX_CAPACITY (2048)
 
+/* Preformatted member names & punctuation */
+enum Fragments {
+	SEPARATOR = 0,
+	BEGIN,
+	LOGGER,
+	TIMESTAMP,
+	LEVEL,
+	THREAD,
+	THREAD_ID,
+	TID,
+	MESSAGE,
+	NDC,
+	LOCATION,
+	MEMBER_SEPARATOR,
+	FILE_NAME,
+	LINE,
+	FUNCTION,
+	LOCATION_END,
+	PROPERTIES,
+	PROPERTY_SEPARATOR,
+	PROPERTY,
+	VALUE,
+	PROPERTY_END,
+	PROPERTIES_END,
+	END,
+	FRAGMENT_MAX
+};
+
+typedef struct Fragment_ {
+	const gchar *string;
+	gsize length;
+} Fragment;
+
+#define FRAGMENT(string) { string, sizeof(string) - 1 }
+
+/* Fragments for the indented array format */
+static const Fragment pretty[FRAGMENT_MAX] = {
+	[SEPARATOR] = FRAGMENT(",\n"),
+	[BEGIN] = FRAGMENT("  {\n"),
+	[LOGGER] = FRAGMENT("    \"logger\": \""),
+	[TIMESTAMP] = FRAGMENT(",\n    \"timestamp\": "),
+	[LEVEL] = FRAGMENT(",\n    \"level\": \""),
+	[THREAD] = FRAGMENT(",\n    \"thread\": \""),
+	[THREAD_ID] = FRAGMENT(",\n    \"threadId\": "),
+	[TID] = FRAGMENT(",\n    \"tid\": "),
+	[MESSAGE] = FRAGMENT(",\n    \"message\": \""),
+	[NDC] = FRAGMENT(",\n    \"ndc\": \""),
+	[LOCATION] = FRAGMENT(",\n    \"locationInfo\": {\n"),
+	[MEMBER_SEPARATOR] = FRAGMENT(",\n"),
+	[FILE_NAME] = FRAGMENT("      \"file\": \""),
+	[LINE] = FRAGMENT("      \"line\": "),
+	[FUNCTION] = FRAGMENT("      \"function\": \""),
+	[LOCATION_END] = FRAGMENT("\n    }"),
+	[PROPERTIES] = FRAGMENT(",\n    \"properties\": [\n"),
+	[PROPERTY_SEPARATOR] = FRAGMENT(",\n"),
+	[PROPERTY] = FRAGMENT("      {\n        \"name\": \""),
+	[VALUE] = FRAGMENT("\",\n        \"value\": \""),
+	[PROPERTY_END] = FRAGMENT("\"\n      }"),
+	[PROPERTIES_END] = FRAGMENT("\n    ]"),
+	[END] = FRAGMENT("\n  }")
+};
+
+/* Fragments for newline delimited JSON */
+static const Fragment compact[FRAGMENT_MAX] = {
+	[SEPARATOR] = FRAGMENT(""),
+	[BEGIN] = FRAGMENT("{"),
+	[LOGGER] = FRAGMENT("\"logger\":\""),
+	[TIMESTAMP] = FRAGMENT(",\"timestamp\":"),
+	[LEVEL] = FRAGMENT(",\"level\":\""),
+	[THREAD] = FRAGMENT(",\"thread\":\""),
+	[THREAD_ID] = FRAGMENT(",\"threadId\":"),
+	[TID] = FRAGMENT(",\"tid\":"),
+	[MESSAGE] = FRAGMENT(",\"message\":\""),
+	[NDC] = FRAGMENT(",\"ndc\":\""),
+	[LOCATION] = FRAGMENT(",\"locationInfo\":{"),
+	[MEMBER_SEPARATOR] = FRAGMENT(","),
+	[FILE_NAME] = FRAGMENT("\"file\":\""),
+	[LINE] = FRAGMENT("\"line\":"),
+	[FUNCTION] = FRAGMENT("\"function\":\""),
+	[LOCATION_END] = FRAGMENT("}"),
+	[PROPERTIES] = FRAGMENT(",\"properties\":["),
+	[PROPERTY_SEPARATOR] = FRAGMENT(","),
+	[PROPERTY] = FRAGMENT("{\"name\":\""),
+	[VALUE] = FRAGMENT("\",\"value\":\""),
+	[PROPERTY_END] = FRAGMENT("\"}"),
+	[PROPERTIES_END] = FRAGMENT("]"),
+	[END] = FRAGMENT("}\n")
+};
+
+#define U 'u'
+
+/* The escape character for each byte, zero if the byte is copied as is,
+ * 'u' if the byte is written as a \u00XX sequence */
+static const gchar escapes[256] = {
+	U, U, U, U, U, U, U, U, 'b', 't', 'n', U, 'f', 'r', U, U,
+	U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+	['"'] = '"',
+	['\\'] = '\\'
+};
+
+#undef U
+
+#define ONES (G_GUINT64_CONSTANT(0x0101010101010101))
+
+#define HIGHS (ONES * 0x80)
+
+/* Test if any byte in 'word' is a control character, '"' or '\' */
+static inline gboolean
+special_(guint64 word)
+{
+	guint64 quote = word ^ (ONES * '"');
+	guint64 backslash = word ^ (ONES * '\\');
+	return ((((word - (ONES * 0x20)) & ~word)
+			| ((quote - ONES) & ~quote)
+			| ((backslash - ONES) & ~backslash)) & HIGHS) != 0;
+}
+
+static inline void
+fragment_(GString *string, const Fragment *fragment)
+{
+	g_string_append_len(string, fragment->string, fragment->length);
+}
+
+/* Append 'source' to 'string' escaped as the contents of a JSON string */
+static void
+escape_(GString *string, const gchar *source)
+{
+	static const gchar hex[] = "0123456789abcdef";
+	const guchar *p = (const guchar *)source;
+	const guchar *end = p + strlen(source);
+	const guchar *run = p;
+	while (p < end) {
+		if (end - p >= 8) {
+			guint64 word;
+			memcpy(&word, p, sizeof word);
+			if (G_LIKELY(!special_(word))) {
+				p += 8;
+				continue;
+			}
+		}
+		for (const guchar *stop = MIN(p + 8, end); p < stop; ++p) {
+			gchar escape = escapes[*p];
+			if (G_LIKELY(!escape)) {
+				continue;
+			}
+			g_string_append_len(string, (const gchar *)run,
+					p - run);
+			gchar sequence[6] = { '\\', escape, '0', '0' };
+			if ('u' == escape) {
+				sequence[4] = hex[*p >> 4];
+				sequence[5] = hex[*p & 0xf];
+				g_string_append_len(string, sequence, 6);
+			} else {
+				g_string_append_len(string, sequence, 2);
+			}
+			run = p + 1;
+		}
+	}
+	g_string_append_len(string, (const gchar *)run, end - run);
+}
+
+/* Append a string member, 'fragment' contains the opening quote */
+static inline void
+string_(GString *string, const Fragment *fragment, const gchar *value)
+{
+	fragment_(string, fragment);
+	escape_(string, value);
+	g_string_append_c(string, '"');
+}
+
+static void
+integer_(GString *string, guint64 value)
+{
+	gchar buffer[20];
+	gchar *p = buffer + sizeof buffer;
+	do {
+		*--p = '0' + (value % 10);
+		value /= 10;
+	} while (value);
+	g_string_append_len(string, p, buffer + sizeof buffer - p);
+}
+
+/* Test if a line number may be copied as a JSON number */
+static gboolean
+is_number_(const gchar *line)
+{
+	if (!line || !g_ascii_isdigit(*line)) {
+		return FALSE;
+	}
+	while (g_ascii_isdigit(*line)) {
+		++line;
+	}
+	return !*line;
+}
+
 static void
 log4g_json_layout_init(Log4gJsonLayout *self)
 {
@@ -96,6 +313,8 @@ log4g_json_layout_init(Log4gJsonLayout *self)
 	self->priv->properties = TRUE;
 	self->priv->info = TRUE;
 	self->priv->complete = TRUE;
+	self->priv->ndjson = FALSE;
+	self->priv->thread_id = FALSE;
 }
 
 static void
@@ -113,6 +332,8 @@ enum Properties {
 	PROP_PROPERTIES,
 	PROP_LOCATION_INFO,
 	PROP_COMPLETE,
+	PROP_NDJSON,
+	PROP_THREAD_ID,
 	PROP_MAX
 };
 
@@ -130,169 +351,148 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	case PROP_COMPLETE:
 		self->priv->complete = g_value_get_boolean(value);
 		break;
+	case PROP_NDJSON:
+		self->priv->ndjson = g_value_get_boolean(value);
+		break;
+	case PROP_THREAD_ID:
+		self->priv->thread_id = g_value_get_boolean(value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(base, id, pspec);
 		break;
 	}
 }
 
-static gchar *
-strescape(const gchar *source, const gchar *exceptions)
+static void
+location_(GString *string, const Fragment *fragments,
+		Log4gLoggingEvent *event)
 {
-	if (G_UNLIKELY(!source)) {
-		return NULL;
+	gboolean delim = FALSE;
+	fragment_(string, &fragments[LOCATION]);
+	const gchar *file = log4g_logging_event_get_file_name(event);
+	if (file) {
+		string_(string, &fragments[FILE_NAME], file);
+		delim = TRUE;
 	}
-	return g_strescape(source, exceptions);
+	const gchar *line = log4g_logging_event_get_line_number(event);
+	if (is_number_(line)) {
+		if (delim) {
+			fragment_(string, &fragments[MEMBER_SEPARATOR]);
+		}
+		fragment_(string, &fragments[LINE]);
+		g_string_append(string, line);
+		delim = TRUE;
+	}
+	const gchar *function = log4g_logging_event_get_function_name(event);
+	if (function) {
+		if (delim) {
+			fragment_(string, &fragments[MEMBER_SEPARATOR]);
+		}
+		string_(string, &fragments[FUNCTION], function);
+	}
+	fragment_(string, &fragments[LOCATION_END]);
 }
 
-static gchar *
-format(Log4gLayout *base, Log4gLoggingEvent *event)
+static void
+properties_(GString *string, const Fragment *fragments,
+		Log4gLoggingEvent *event)
 {
-	Log4gJsonLayout *self = LOG4G_JSON_LAYOUT(base);
-	const GTimeVal *tv = log4g_logging_event_get_time_stamp(event);
-	Log4gLevel *level = log4g_logging_event_get_level(event);
-	gboolean first_layout_done;
-	gboolean delim = FALSE;
-	time_t t = tv->tv_sec;
-	const gchar *name;
-	gchar *escaped;
-
-	if (self->priv->string->len > MAX_CAPACITY) {
-		g_string_free(self->priv->string, TRUE);
-		self->priv->string = g_string_sized_new(BUF_SIZE);
-	} else {
-		g_string_set_size(self->priv->string, 0);
+	const Log4gMDCMap *mdc = log4g_logging_event_get_mdc_map(event);
+	guint size = log4g_mdc_map_get_size(mdc);
+	if (!size) {
+		return;
 	}
-
-	first_layout_done = g_atomic_int_get(&self->priv->first_layout_done);
-	if (first_layout_done) {
-		g_string_append(self->priv->string, ",\n");
-	} else {
-		g_string_append_c(self->priv->string, '\n');
-		g_atomic_int_set(&self->priv->first_layout_done, TRUE);
+	gboolean delim = FALSE;
+	fragment_(string, &fragments[PROPERTIES]);
+	for (guint i = 0; i < size; ++i) {
+		const gchar *key = log4g_mdc_map_get_key(mdc, i);
+		const gchar *value = log4g_mdc_map_get_value(mdc, i);
+		if (delim) {
+			fragment_(string, &fragments[PROPERTY_SEPARATOR]);
+		}
+		fragment_(string, &fragments[PROPERTY]);
+		escape_(string, key);
+		fragment_(string, &fragments[VALUE]);
+		escape_(string, value);
+		fragment_(string, &fragments[PROPERTY_END]);
+		delim = TRUE;
 	}
-	g_string_append(self->priv->string, "  {\n");
+	fragment_(string, &fragments[PROPERTIES_END]);
+}
 
-	name = log4g_logging_event_get_logger_name(event);
-	if (!name) {
-		name = "root";
+static void
+format_to(Log4gLayout *base, Log4gLoggingEvent *event, GString *string)
+{
+	Log4gJsonLayout *self = LOG4G_JSON_LAYOUT(base);
+	const Fragment *fragments = (self->priv->ndjson ? compact : pretty);
+	if (!self->priv->ndjson) {
+		if (g_atomic_int_compare_and_exchange(
+					&self->priv->first_layout_done,
+					FALSE, TRUE)) {
+			g_string_append_c(string, '\n');
+		} else {
+			fragment_(string, &fragments[SEPARATOR]);
+		}
 	}
-	escaped = strescape(name, NULL);
-	if (escaped) {
-		g_string_append_printf(self->priv->string,
-				"    \"logger\": \"%s\"",
-				escaped);
-		g_free(escaped);
-		delim = TRUE;
+	fragment_(string, &fragments[BEGIN]);
+	const gchar *name = log4g_logging_event_get_logger_name(event);
+	string_(string, &fragments[LOGGER], (name ? name : "root"));
+	fragment_(string, &fragments[TIMESTAMP]);
+	integer_(string, log4g_logging_event_get_time_stamp_ns(event)
+			/ G_GINT64_CONSTANT(1000000000));
+	Log4gLevel *level = log4g_logging_event_get_level(event);
+	const gchar *value = (level ? log4g_level_to_string(level) : NULL);
+	if (value) {
+		string_(string, &fragments[LEVEL], value);
 	}
-
-	g_string_append_printf(self->priv->string,
-			"%s    \"timestamp\": %lu",
-			delim ? ",\n" : "", (gulong)t);
-
-	escaped = strescape(log4g_level_to_string(level), NULL);
-	if (escaped) {
-		g_string_append_printf(self->priv->string,
-				",\n    \"level\": \"%s\"",
-				escaped);
-		g_free(escaped);
+	value = log4g_logging_event_get_thread_name(event);
+	if (value) {
+		string_(string, &fragments[THREAD], value);
 	}
-
-	escaped = strescape(log4g_logging_event_get_thread_name(event), NULL);
-	if (escaped) {
-		g_string_append_printf(self->priv->string,
-				",\n    \"thread\": \"%s\"",
-				escaped);
-		g_free(escaped);
+	if (self->priv->thread_id) {
+		fragment_(string, &fragments[THREAD_ID]);
+		integer_(string, log4g_logging_event_get_thread_id(event));
+		fragment_(string, &fragments[TID]);
+		integer_(string, (guint)log4g_logging_event_get_tid(event));
 	}
-
-	escaped = strescape(log4g_logging_event_get_rendered_message(event), NULL);
-	if (escaped) {
-		g_string_append_printf(self->priv->string,
-				",\n    \"message\": \"%s\"",
-				escaped);
-		g_free(escaped);
+	value = log4g_logging_event_get_rendered_message(event);
+	if (value) {
+		string_(string, &fragments[MESSAGE], value);
 	}
-
-	if (log4g_logging_event_get_ndc(event)) {
-		escaped = strescape(log4g_logging_event_get_ndc(event), NULL);
-		if (escaped) {
-			g_string_append_printf(self->priv->string,
-					",\n    \"ndc\": \"%s\"",
-					escaped);
-			g_free(escaped);
-		}
+	value = log4g_logging_event_get_ndc(event);
+	if (value) {
+		string_(string, &fragments[NDC], value);
 	}
-
 	if (self->priv->info) {
-		guint64 line_number;
-		g_string_append(self->priv->string, ",\n    \"locationInfo\": {\n");
-		escaped = strescape(log4g_logging_event_get_file_name(event), NULL);
-		if (escaped) {
-			g_string_append_printf(self->priv->string,
-					"      \"file\": \"%s\",\n",
-					escaped);
-			g_free(escaped);
-		}
-		errno = 0;
-		line_number = g_ascii_strtoull(log4g_logging_event_get_line_number(event),
-				NULL, 10);
-		if (!errno) {
-			g_string_append_printf(self->priv->string,
-					"      \"line\": %"G_GUINT64_FORMAT",\n",
-					line_number);
-		}
-		g_string_append_printf(self->priv->string,
-				"      \"function\": \"%s\"\n",
-				log4g_logging_event_get_function_name(event));
-		g_string_append(self->priv->string, "    }");
+		location_(string, fragments, event);
 	}
-
 	if (self->priv->properties) {
-		const GArray *keyset = log4g_logging_event_get_property_key_set(event);
-		if (keyset && keyset->len) {
-			const gchar *value;
-			gchar *key;
-			guint i;
-			g_string_append(self->priv->string,
-					",\n    \"properties\": [\n");
-			for (i = 0; i < keyset->len; ++i) {
-				key = g_array_index(keyset, gchar *, i);
-				value = log4g_logging_event_get_mdc(event, key);
-				if (!key || !escaped) {
-					continue;
-				}
-				key = strescape(key, NULL);
-				escaped = strescape(value, NULL);
-				if (!key || !escaped) {
-					g_free(key);
-					g_free(escaped);
-					continue;
-				}
-				g_string_append_printf(self->priv->string,
-						"      {\n"
-						"        \"name\": \"%s\",\n"
-						"        \"value\": \"%s\"\n"
-						"      }",
-						key, escaped);
-				g_free(key);
-				g_free(escaped);
-				if (i + 1 < keyset->len) {
-					g_string_append_c(self->priv->string, ',');
-				}
-				g_string_append_c(self->priv->string, '\n');
-			}
-			g_string_append(self->priv->string, "    ]");
-		}
+		properties_(string, fragments, event);
 	}
+	fragment_(string, &fragments[END]);
+}
 
-	g_string_append(self->priv->string, "\n  }");
+static gchar *
+format(Log4gLayout *base, Log4gLoggingEvent *event)
+{
+	Log4gJsonLayout *self = LOG4G_JSON_LAYOUT(base);
+	if (self->priv->string->allocated_len > MAX_CAPACITY) {
+		g_string_free(self->priv->string, TRUE);
+		self->priv->string = g_string_sized_new(BUF_SIZE);
+	} else {
+		g_string_set_size(self->priv->string, 0);
+	}
+	format_to(base, event, self->priv->string);
 	return self->priv->string->str;
 }
 
 static const gchar *
-get_content_type(G_GNUC_UNUSED Log4gLayout *base)
+get_content_type(Log4gLayout *base)
 {
+	Log4gJsonLayout *self = LOG4G_JSON_LAYOUT(base);
+	if (self->priv->ndjson) {
+		return "application/x-ndjson";
+	}
 	return "application/json";
 }
 
@@ -300,17 +500,17 @@ static const gchar *
 get_header(Log4gLayout *base)
 {
 	Log4gJsonLayout *self = LOG4G_JSON_LAYOUT(base);
-	if (!self->priv->complete) {
+	if (!self->priv->complete || self->priv->ndjson) {
 		return "";
 	}
 	return "[";
 }
 
 static const gchar *
-get_footer(G_GNUC_UNUSED Log4gLayout *base)
+get_footer(Log4gLayout *base)
 {
 	Log4gJsonLayout *self = LOG4G_JSON_LAYOUT(base);
-	if (!self->priv->complete) {
+	if (!self->priv->complete || self->priv->ndjson) {
 		return "";
 	}
 	return "\n]\n";
@@ -323,6 +523,7 @@ static void log4g_json_layout_class_init(Log4gJsonLayoutClass *klass)
 	object_class->set_property = set_property;
 	Log4gLayoutClass *layout_class = LOG4G_LAYOUT_CLASS(klass);
 	layout_class->format = format;
+	layout_class->format_to = format_to;
 	layout_class->get_content_type = get_content_type;
 	layout_class->get_header = get_header;
 	layout_class->get_footer = get_footer;
@@ -343,6 +544,16 @@ static void log4g_json_layout_class_init(Log4gJsonLayoutClass *klass)
 			Q_("Complete Document"),
 			Q_("Toggle writing a complete document"),
 			TRUE, G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_NDJSON,
+		g_param_spec_boolean("ndjson",
+			Q_("Newline Delimited JSON"),
+			Q_("Write one compact object per line"),
+			FALSE, G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_THREAD_ID,
+		g_param_spec_boolean("thread-id",
+			Q_("Thread Identifiers"),
+			Q_("Toggle thread identifiers"),
+			FALSE, G_PARAM_WRITABLE));
 }
 
 static void
@@ -20,6 +20,7 @@
 #endif
 #include "helpers/pattern-converter.h"
 #include "helpers/pattern-parser.h"
+#include "layout/binary-layout.h"
 #include "layout/date-layout.h"
 #include "layout/html-layout.h"
 #include "layout/json-layout.h"
@@ -33,6 +34,7 @@ void
 log4g_module_load(GTypeModule *module)
 {
 	g_type_module_set_name(module, "core-layouts");
+	log4g_binary_layout_register(module);
 	log4g_date_layout_register(module);
 	log4g_html_layout_register(module);
 	log4g_json_layout_register(module);
@@ -56,8 +56,9 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
-#include <errno.h>
+#include "helpers/date-format.h"
 #include "helpers/pattern-converter.h"
+#include "log4g/helpers/hazard.h"
 
 G_DEFINE_DYNAMIC_TYPE(Log4gPatternConverter, log4g_pattern_converter,
 		G_TYPE_OBJECT)
@@ -76,6 +77,24 @@ struct Private {
 	gboolean align;
 };
 
+#define SCRATCH_SIZE (128)
+
+static GPrivate scratch = G_PRIVATE_INIT(g_free);
+
+/* Converters may run concurrently for the same layout. Those that need to
+ * build a string convert into this per-thread buffer, its contents are
+ * consumed by format() before the next converter runs. */
+static gchar *
+scratch_(void)
+{
+	gchar *buffer = g_private_get(&scratch);
+	if (G_UNLIKELY(!buffer)) {
+		buffer = g_malloc(SCRATCH_SIZE);
+		g_private_set(&scratch, buffer);
+	}
+	return buffer;
+}
+
 static void
 log4g_pattern_converter_init(Log4gPatternConverter *self)
 {
@@ -261,7 +280,6 @@ G_DEFINE_DYNAMIC_TYPE(Log4gBasicPatternConverter,
 
 struct BasicPrivate {
 	Log4gPatternConverterType type;
-	gchar buffer[128];
 };
 
 static void
@@ -272,28 +290,32 @@ log4g_basic_pattern_converter_init(Log4gBasicPatternConverter *self)
 	priv->type = INVALID_CONVERTER;
 }
 
+/* Convert one of the basic fields, 'buffer' must hold SCRATCH_SIZE bytes */
 static const gchar *
-basic_pattern_converter_convert(Log4gPatternConverter *base,
-		Log4gLoggingEvent *event)
+basic_(Log4gPatternConverterType type, Log4gLoggingEvent *event,
+		gchar *buffer)
 {
-	Log4gBasicPatternConverter *self = LOG4G_BASIC_PATTERN_CONVERTER(base);
-	struct BasicPrivate *priv = GET_BASIC_PRIVATE(self);
-	switch (priv->type) {
+	switch (type) {
 	case RELATIVE_TIME_CONVERTER: {
-		glong start = log4g_logging_event_get_start_time();
-		const GTimeVal *tv = log4g_logging_event_get_time_stamp(event);
-		glong time = (tv->tv_sec * 1000) + (tv->tv_usec * 0.001);
-		g_snprintf(priv->buffer, sizeof priv->buffer, "%ld",
-				time - start);
-		return priv->buffer;
+		gint64 time = log4g_logging_event_get_time_stamp_ns(event)
+			- log4g_logging_event_get_start_time_ns();
+		g_snprintf(buffer, SCRATCH_SIZE, "%" G_GINT64_FORMAT,
+				time / G_GINT64_CONSTANT(1000000));
+		return buffer;
 	}
 	case THREAD_CONVERTER:
 	      return log4g_logging_event_get_thread_name(event);
-	case LEVEL_CONVERTER: {
+	case THREAD_ID_CONVERTER:
+		g_snprintf(buffer, SCRATCH_SIZE, "%u",
+				log4g_logging_event_get_thread_id(event));
+		return buffer;
+	case TID_CONVERTER:
+		g_snprintf(buffer, SCRATCH_SIZE, "%d",
+				log4g_logging_event_get_tid(event));
+		return buffer;
+	case LEVEL_CONVERTER:
 		return log4g_level_to_string(
 				log4g_logging_event_get_level(event));
-		return NULL;
-	}
 	case NDC_CONVERTER:
 		return log4g_logging_event_get_ndc(event);
 	case MESSAGE_CONVERTER:
@@ -303,6 +325,13 @@ basic_pattern_converter_convert(Log4gPatternConverter *base,
 	}
 }
 
+static const gchar *
+basic_pattern_converter_convert(Log4gPatternConverter *base,
+		Log4gLoggingEvent *event)
+{
+	return basic_(GET_BASIC_PRIVATE(base)->type, event, scratch_());
+}
+
 static void
 log4g_basic_pattern_converter_class_init(Log4gBasicPatternConverterClass *klass)
 {
@@ -455,7 +484,7 @@ G_DEFINE_DYNAMIC_TYPE(Log4gDatePatternConverter, log4g_date_pattern_converter,
 
 struct DatePrivate {
 	gchar *format;
-	gchar buffer[128];
+	Log4gDateFormat *date;
 };
 
 static void
@@ -464,6 +493,7 @@ log4g_date_pattern_converter_init(Log4gDatePatternConverter *self)
 	self->priv = ASSIGN_DATE_PRIVATE(self);
 	struct DatePrivate *priv = GET_DATE_PRIVATE(self);
 	priv->format = NULL;
+	priv->date = NULL;
 }
 
 static void
@@ -472,30 +502,32 @@ date_pattern_converter_finalize(GObject *base)
 	struct DatePrivate *priv = GET_DATE_PRIVATE(base);
 	g_free(priv->format);
 	priv->format = NULL;
+	log4g_date_format_free(priv->date);
+	priv->date = NULL;
 	G_OBJECT_CLASS(log4g_date_pattern_converter_parent_class)->
 		finalize(base);
 }
 
+/* Convert a time stamp, 'buffer' must hold SCRATCH_SIZE bytes */
 static const gchar *
-date_pattern_converter_convert(Log4gPatternConverter *base,
-		Log4gLoggingEvent *event)
+date_(const Log4gDateFormat *date, Log4gLoggingEvent *event, gchar *buffer)
 {
-	struct DatePrivate *priv = GET_DATE_PRIVATE(base);
-	const GTimeVal *tv = log4g_logging_event_get_time_stamp(event);
-	if (!tv) {
-		return NULL;
-	}
-	struct tm tm;
-	time_t time = tv->tv_sec;
-	if (!localtime_r(&time, &tm)) {
-		log4g_log_error("localtime_r(): %s", g_strerror(errno));
+	G_STATIC_ASSERT(SCRATCH_SIZE >= LOG4G_DATE_FORMAT_SIZE);
+	if (!date) {
 		return NULL;
 	}
-	if (!strftime(priv->buffer, sizeof priv->buffer, priv->format, &tm)) {
-		log4g_log_error(Q_("strftime() returned zero (0)"));
+	gint64 time = log4g_logging_event_get_time_stamp_ns(event);
+	if (!log4g_date_format_render(date, time, buffer)) {
 		return NULL;
 	}
-	return priv->buffer;
+	return buffer;
+}
+
+static const gchar *
+date_pattern_converter_convert(Log4gPatternConverter *base,
+		Log4gLoggingEvent *event)
+{
+	return date_(GET_DATE_PRIVATE(base)->date, event, scratch_());
 }
 
 static void
@@ -542,6 +574,7 @@ log4g_date_pattern_converter_new(struct Log4gFormattingInfo *formatting,
 	priv->max = formatting->max;
 	priv->align = formatting->align;
 	GET_DATE_PRIVATE(self)->format = format;
+	GET_DATE_PRIVATE(self)->date = log4g_date_format_new(format);
 	return LOG4G_PATTERN_CONVERTER(self);
 }
 
@@ -557,6 +590,7 @@ G_DEFINE_DYNAMIC_TYPE(Log4gMDCPatternConverter, log4g_mdc_pattern_converter,
 
 struct MDCPrivate {
 	gchar *key;
+	GQuark id; /* The registered identifier of 'key' */
 };
 
 static void
@@ -580,7 +614,8 @@ static const gchar *
 mdc_pattern_converter_convert(Log4gPatternConverter *base,
 		Log4gLoggingEvent *event)
 {
-	return log4g_logging_event_get_mdc(event, GET_MDC_PRIVATE(base)->key);
+	return log4g_logging_event_get_mdc_by_id(event,
+			GET_MDC_PRIVATE(base)->id);
 }
 
 static void
@@ -606,7 +641,9 @@ log4g_mdc_pattern_converter_class_finalize(
  * @formatting: Formatting parameters.
  * @key: The MDC key to look up.
  *
- * Create a new MDC (mapped data context) pattern converter object.
+ * Create a new MDC (mapped data context) pattern converter object. The
+ * key is registered with log4g_mdc_key_register() so events are not
+ * searched by name.
  *
  * @See: #Log4gMDCClass
  *
@@ -627,6 +664,7 @@ log4g_mdc_pattern_converter_new(struct Log4gFormattingInfo *formatting,
 	priv->max = formatting->max;
 	priv->align = formatting->align;
 	GET_MDC_PRIVATE(self)->key = key;
+	GET_MDC_PRIVATE(self)->id = log4g_mdc_key_register(key);
 	return LOG4G_PATTERN_CONVERTER(self);
 }
 
@@ -651,10 +689,9 @@ log4g_location_pattern_converter_init(Log4gLocationPatternConverter *self)
 }
 
 static const gchar *
-location_pattern_converter_convert(Log4gPatternConverter *base,
-		Log4gLoggingEvent *event)
+location_(Log4gPatternConverterType type, Log4gLoggingEvent *event)
 {
-	switch (GET_LOCATION_PRIVATE(base)->type) {
+	switch (type) {
 	case FULL_LOCATION_CONVERTER:
 		return log4g_logging_event_get_full_info(event);
 	case METHOD_LOCATION_CONVERTER:
@@ -668,6 +705,13 @@ location_pattern_converter_convert(Log4gPatternConverter *base,
 	}
 }
 
+static const gchar *
+location_pattern_converter_convert(Log4gPatternConverter *base,
+		Log4gLoggingEvent *event)
+{
+	return location_(GET_LOCATION_PRIVATE(base)->type, event);
+}
+
 static void
 log4g_location_pattern_converter_class_init(
 		Log4gLocationPatternConverterClass *klass)
@@ -724,6 +768,14 @@ G_DEFINE_DYNAMIC_TYPE(Log4gCategoryPatternConverter,
 
 struct CategoryPrivate {
 	gint precision;
+	gpointer cache; /* The last conversion (struct CategoryCache) */
+};
+
+/* A logger name paired with its conversion. Published through a single
+ * pointer so concurrent converters always see a matching pair. */
+struct CategoryCache {
+	const gchar *name; /* An interned logger name */
+	const gchar *category; /* The conversion of 'name' */
 };
 
 static void
@@ -732,6 +784,34 @@ log4g_category_pattern_converter_init(Log4gCategoryPatternConverter *self)
 	self->priv = ASSIGN_CATEGORY_PRIVATE(self);
 }
 
+static void
+category_pattern_converter_finalize(GObject *base)
+{
+	struct CategoryPrivate *priv = GET_CATEGORY_PRIVATE(base);
+	g_free(priv->cache);
+	priv->cache = NULL;
+	G_OBJECT_CLASS(log4g_category_pattern_converter_parent_class)->
+		finalize(base);
+}
+
+/* Retrieve the right most 'precision' components of a logger name */
+static const gchar *
+category_(const gchar *name, gint precision)
+{
+	gint end = strlen(name);
+	for (gint i = precision; i > 0; --i) {
+		while (--end > -1) {
+			if ('.' == name[end]) {
+				break;
+			}
+		}
+		if (-1 == end) {
+			break;
+		}
+	}
+	return &name[end + 1];
+}
+
 static const gchar *
 category_pattern_converter_convert(Log4gPatternConverter *base,
 		Log4gLoggingEvent *event)
@@ -744,26 +824,37 @@ category_pattern_converter_convert(Log4gPatternConverter *base,
 	if (1 > priv->precision) {
 		return name;
 	}
-	gint end = strlen(name);
-	for (gint i = priv->precision; i > 0; --i) {
-		while (--end > -1) {
-			if ('.' == name[end]) {
-				break;
-			}
-		}
-		if (-1 == end) {
-			break;
+	/* logger names are interned, compare by pointer */
+	struct CategoryCache *cache = log4g_hazard_acquire(&priv->cache);
+	if (cache && name == cache->name) {
+		const gchar *category = cache->category;
+		log4g_hazard_release();
+		return category;
+	}
+	log4g_hazard_release();
+	const gchar *category = category_(name, priv->precision);
+	struct CategoryCache *update = g_new(struct CategoryCache, 1);
+	update->name = name;
+	update->category = category;
+	if (g_atomic_pointer_compare_and_exchange(&priv->cache, cache,
+				update)) {
+		if (cache) {
+			log4g_hazard_retire(cache, g_free);
 		}
+	} else {
+		g_free(update);
 	}
-	return &name[end + 1];
+	return category;
 }
 
 static void
 log4g_category_pattern_converter_class_init(
 		Log4gCategoryPatternConverterClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 	Log4gPatternConverterClass *pc_class =
 		LOG4G_PATTERN_CONVERTER_CLASS(klass);
+	object_class->finalize = category_pattern_converter_finalize;
 	pc_class->convert = category_pattern_converter_convert;
 	g_type_class_add_private(klass, sizeof(struct CategoryPrivate));
 }
@@ -804,6 +895,238 @@ log4g_category_pattern_converter_new(struct Log4gFormattingInfo *formatting,
 	return LOG4G_PATTERN_CONVERTER(self);
 }
 
+/* A single step of a compiled conversion pattern */
+typedef enum {
+	OP_LITERAL = 0,
+	OP_BASIC,
+	OP_DATE,
+	OP_MDC,
+	OP_LOCATION,
+	OP_CATEGORY,
+	OP_CONVERTER /* A converter of unknown type, dispatched via its class */
+} Opcode;
+
+struct Instruction {
+	Opcode op;
+	Log4gPatternConverterType type; /* OP_BASIC & OP_LOCATION */
+	gboolean pad; /* FALSE if min/max can never change the field */
+	gint min;
+	gint max;
+	gboolean align;
+	gchar *string; /* The literal text */
+	Log4gDateFormat *date; /* OP_DATE */
+	gsize length; /* The length of a literal */
+	gint precision; /* OP_CATEGORY */
+	GQuark key; /* OP_MDC */
+	Log4gPatternConverter *converter; /* OP_CONVERTER */
+};
+
+struct Log4gPatternProgram_ {
+	guint size;
+	gsize hint; /* The expected length of a formatted event */
+	struct Instruction code[];
+};
+
+/**
+ * log4g_pattern_program_new:
+ * @head: The first pattern converter in a chain.
+ *
+ * Compile a chain of pattern converters into a flat program.
+ *
+ * Adjacent literals are merged and the formatting parameters of each
+ * converter are copied into the program, so formatting an event does not
+ * dispatch through the converter objects. Converters of types that are not
+ * known to this function are called through their class.
+ *
+ * Returns: A new compiled pattern, free it with log4g_pattern_program_free().
+ * Since: 0.1
+ */
+Log4gPatternProgram *
+log4g_pattern_program_new(Log4gPatternConverter *head)
+{
+	guint n = 0;
+	for (Log4gPatternConverter *c = head; c;
+			c = log4g_pattern_converter_get_next(c)) {
+		++n;
+	}
+	Log4gPatternProgram *self =
+		g_malloc0(sizeof *self + (n * sizeof(struct Instruction)));
+	struct Instruction *ins = NULL;
+	for (Log4gPatternConverter *c = head; c;
+			c = log4g_pattern_converter_get_next(c)) {
+		GType type = G_OBJECT_TYPE(c);
+		if (LOG4G_TYPE_LITERAL_PATTERN_CONVERTER == type) {
+			const gchar *literal = GET_LITERAL_PRIVATE(c)->literal;
+			if (!literal || !*literal) {
+				continue;
+			}
+			if (ins && OP_LITERAL == ins->op) {
+				gchar *merged = g_strconcat(ins->string, literal,
+						NULL);
+				g_free(ins->string);
+				ins->string = merged;
+			} else {
+				ins = &self->code[self->size++];
+				ins->op = OP_LITERAL;
+				ins->string = g_strdup(literal);
+			}
+			ins->length = strlen(ins->string);
+			self->hint += strlen(literal);
+			continue;
+		}
+		struct Private *priv = GET_PRIVATE(c);
+		ins = &self->code[self->size++];
+		ins->min = priv->min;
+		ins->max = priv->max;
+		ins->align = priv->align;
+		ins->pad = (0 < priv->min) || (0x7fffffff != priv->max);
+		self->hint += MAX(priv->min, 16);
+		if (LOG4G_TYPE_BASIC_PATTERN_CONVERTER == type) {
+			ins->op = OP_BASIC;
+			ins->type = GET_BASIC_PRIVATE(c)->type;
+		} else if (LOG4G_TYPE_DATE_PATTERN_CONVERTER == type) {
+			ins->op = OP_DATE;
+			ins->date = log4g_date_format_new(
+					GET_DATE_PRIVATE(c)->format);
+		} else if (LOG4G_TYPE_MDC_PATTERN_CONVERTER == type) {
+			ins->op = OP_MDC;
+			ins->key = GET_MDC_PRIVATE(c)->id;
+		} else if (LOG4G_TYPE_LOCATION_PATTERN_CONVERTER == type) {
+			ins->op = OP_LOCATION;
+			ins->type = GET_LOCATION_PRIVATE(c)->type;
+		} else if (LOG4G_TYPE_CATEGORY_PATTERN_CONVERTER == type) {
+			ins->op = OP_CATEGORY;
+			ins->precision = GET_CATEGORY_PRIVATE(c)->precision;
+		} else {
+			ins->op = OP_CONVERTER;
+			ins->converter = g_object_ref(c);
+		}
+	}
+	return self;
+}
+
+/**
+ * log4g_pattern_program_free:
+ * @self: A compiled pattern.
+ *
+ * Free a compiled pattern created by log4g_pattern_program_new().
+ *
+ * Since: 0.1
+ */
+void
+log4g_pattern_program_free(Log4gPatternProgram *self)
+{
+	if (!self) {
+		return;
+	}
+	for (guint i = 0; i < self->size; ++i) {
+		g_free(self->code[i].string);
+		log4g_date_format_free(self->code[i].date);
+		if (self->code[i].converter) {
+			g_object_unref(self->code[i].converter);
+		}
+	}
+	g_free(self);
+}
+
+static void
+spaces_(GString *string, gint length)
+{
+	static const gchar SPACES[] = "                                ";
+	while (0 < length) {
+		gint n = MIN(length, (gint)sizeof SPACES - 1);
+		g_string_append_len(string, SPACES, n);
+		length -= n;
+	}
+}
+
+/* Append a field honoring the minimum & maximum width */
+static void
+pad_(GString *string, const struct Instruction *ins, const gchar *value)
+{
+	if (!value) {
+		spaces_(string, ins->min);
+		return;
+	}
+	gint length = strlen(value);
+	if (length > ins->max) {
+		g_string_append_len(string, value + (length - ins->max),
+				ins->max);
+	} else if (length < ins->min) {
+		if (ins->align) {
+			g_string_append_len(string, value, length);
+			spaces_(string, ins->min - length);
+		} else {
+			spaces_(string, ins->min - length);
+			g_string_append_len(string, value, length);
+		}
+	} else {
+		g_string_append_len(string, value, length);
+	}
+}
+
+/**
+ * log4g_pattern_program_format:
+ * @self: A compiled pattern.
+ * @string: The formatted event is appended here.
+ * @event: The log event to format.
+ *
+ * Format a logging event according to a compiled pattern.
+ *
+ * This function does not modify @self and may be called from several
+ * threads at once.
+ *
+ * Since: 0.1
+ */
+void
+log4g_pattern_program_format(const Log4gPatternProgram *self,
+		GString *string, Log4gLoggingEvent *event)
+{
+	gchar buffer[SCRATCH_SIZE];
+	gsize len = string->len;
+	if (string->allocated_len <= len + self->hint) {
+		g_string_set_size(string, len + self->hint);
+		g_string_truncate(string, len);
+	}
+	for (guint i = 0; i < self->size; ++i) {
+		const struct Instruction *ins = &self->code[i];
+		const gchar *value = NULL;
+		switch (ins->op) {
+		case OP_LITERAL:
+			g_string_append_len(string, ins->string, ins->length);
+			continue;
+		case OP_BASIC:
+			value = basic_(ins->type, event, buffer);
+			break;
+		case OP_DATE:
+			value = date_(ins->date, event, buffer);
+			break;
+		case OP_MDC:
+			value = log4g_logging_event_get_mdc_by_id(event,
+					ins->key);
+			break;
+		case OP_LOCATION:
+			value = location_(ins->type, event);
+			break;
+		case OP_CATEGORY:
+			value = log4g_logging_event_get_logger_name(event);
+			if (value && 0 < ins->precision) {
+				value = category_(value, ins->precision);
+			}
+			break;
+		case OP_CONVERTER:
+			log4g_pattern_converter_format(ins->converter, string,
+					event);
+			continue;
+		}
+		if (G_UNLIKELY(ins->pad)) {
+			pad_(string, ins, value);
+		} else if (value) {
+			g_string_append(string, value);
+		}
+	}
+}
+
 void
 log4g_pattern_converter_register(GTypeModule *module)
 {
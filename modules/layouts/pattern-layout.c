@@ -22,11 +22,17 @@
  * This class formats a log event and returns the results as a string. The
  * result of the formatting depends on the value of a conversion pattern.
  *
- * Pattern layouts accept a single property:
+ * Pattern layouts accept the following properties:
  * <orderedlist>
  * <listitem><para>conversion-pattern</para></listitem>
+ * <listitem><para>compiled</para></listitem>
  * </orderedlist>
  *
+ * The conversion pattern is compiled into a flat array of instructions that
+ * is executed in a single loop. Setting compiled to %FALSE formats events by
+ * walking the chain of pattern converters instead. The default value is
+ * %TRUE.
+ *
  * The conversion pattern is similar in concept to the printf conversion
  * pattern. A conversion pattern is composed of literal text and format
  * control expressions called conversion specifiers.
@@ -108,7 +114,10 @@
  * </para>
  * <para>
  * The date format specifier accepts the same syntax as the strftime(3)
- * standard library function.
+ * standard library function. In addition \%3N outputs milliseconds, \%6N
+ * outputs microseconds and \%9N outputs nanoseconds, e.g.
+ * <emphasis>\%d{\%H:\%M:\%S.\%3N}</emphasis>. The resolution of the
+ * time stamp depends on the clock source, see log4g_clock_set_source().
  * </para>
  * <para>
  * @See: strftime(3)
@@ -124,6 +133,18 @@
  * </entry>
  * </row>
  * <row>
+ * <entry><emphasis>i</emphasis></entry>
+ * <entry align="left">
+ * <para>
+ * Output the number of the thread that generated the log event. Threads
+ * are numbered from one (1) in the order that they first log.
+ * </para>
+ * <para>
+ * @See: log4g_thread_get_id()
+ * </para>
+ * </entry>
+ * </row>
+ * <row>
  * <entry><emphasis>l</emphasis></entry>
  * <entry align="left">
  * <para>
@@ -196,6 +217,18 @@
  * </entry>
  * </row>
  * <row>
+ * <entry><emphasis>T</emphasis></entry>
+ * <entry align="left">
+ * <para>
+ * Output the operating system identifier of the thread that generated the
+ * log event, as returned by gettid() on Linux.
+ * </para>
+ * <para>
+ * @See: log4g_thread_get_tid()
+ * </para>
+ * </entry>
+ * </row>
+ * <row>
  * <entry><emphasis>x</emphasis></entry>
  * <entry align="left">
  * <para>
@@ -367,18 +400,23 @@ struct Private {
 	gchar *pattern;
 	GString *string;
 	Log4gPatternConverter *head;
+	gboolean compiled;
+	Log4gPatternProgram *program;
 };
 
 static void
 log4g_pattern_layout_init(Log4gPatternLayout *self)
 {
 	self->priv = ASSIGN_PRIVATE(self);
+	GET_PRIVATE(self)->compiled = TRUE;
 }
 
 static void
 dispose(GObject *base)
 {
 	struct Private *priv = GET_PRIVATE(base);
+	log4g_pattern_program_free(priv->program);
+	priv->program = NULL;
 	if (priv->head) {
 		g_object_unref(priv->head);
 		priv->head = NULL;
@@ -400,6 +438,7 @@ finalize(GObject *base)
 enum Properties {
 	PROP_O = 0,
 	PROP_CONVERSION_PATTERN,
+	PROP_COMPILED,
 	PROP_MAX
 };
 
@@ -409,7 +448,10 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	struct Private *priv = GET_PRIVATE(base);
 	switch (id) {
 	case PROP_CONVERSION_PATTERN:
+		log4g_layout_set_fingerprint(LOG4G_LAYOUT(base), NULL);
 		g_free(priv->pattern);
+		log4g_pattern_program_free(priv->program);
+		priv->program = NULL;
 		if (priv->head) {
 			g_object_unref(priv->head);
 			priv->head = NULL;
@@ -429,6 +471,18 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 		}
 		priv->head = log4g_pattern_parser_parse(parser);
 		g_object_unref(parser);
+		if (priv->head) {
+			priv->program = log4g_pattern_program_new(priv->head);
+			/* the output depends only on the type & pattern */
+			gchar *fingerprint = g_strconcat(G_OBJECT_TYPE_NAME(base),
+					":", priv->pattern, NULL);
+			log4g_layout_set_fingerprint(LOG4G_LAYOUT(base),
+					fingerprint);
+			g_free(fingerprint);
+		}
+		break;
+	case PROP_COMPILED:
+		priv->compiled = g_value_get_boolean(value);
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(base, id, pspec);
@@ -436,6 +490,20 @@ set_property(GObject *base, guint id, const GValue *value, GParamSpec *pspec)
 	}
 }
 
+static void
+format_to(Log4gLayout *base, Log4gLoggingEvent *event, GString *string)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	if (priv->compiled && priv->program) {
+		log4g_pattern_program_format(priv->program, string, event);
+		return;
+	}
+	for (Log4gPatternConverter *c = priv->head; c != NULL;
+			c = log4g_pattern_converter_get_next(c)) {
+		log4g_pattern_converter_format(c, string, event);
+	}
+}
+
 static gchar *
 format(Log4gLayout *base, Log4gLoggingEvent *event)
 {
@@ -454,10 +522,7 @@ format(Log4gLayout *base, Log4gLoggingEvent *event)
 	} else {
 		g_string_set_size(priv->string, 0);
 	}
-	for (Log4gPatternConverter *c = priv->head; c != NULL;
-			c = log4g_pattern_converter_get_next(c)) {
-		log4g_pattern_converter_format(c, priv->string, event);
-	}
+	format_to(base, event, priv->string);
 	return priv->string->str;
 }
 
@@ -476,6 +541,7 @@ log4g_pattern_layout_class_init(Log4gPatternLayoutClass *klass)
 	object_class->set_property = set_property;
 	Log4gLayoutClass *layout_class = LOG4G_LAYOUT_CLASS(klass);
 	layout_class->format = format;
+	layout_class->format_to = format_to;
 	klass->create_pattern_parser = create_pattern_parser;
 	g_type_class_add_private(klass, sizeof(struct Private));
 	/* install properties */
@@ -484,6 +550,10 @@ log4g_pattern_layout_class_init(Log4gPatternLayoutClass *klass)
 			Q_("Conversion Pattern"),
 			Q_("String that controls formatting"),
 			NULL, G_PARAM_WRITABLE));
+	g_object_class_install_property(object_class, PROP_COMPILED,
+		g_param_spec_boolean("compiled", Q_("Compiled"),
+			Q_("Format with a compiled conversion pattern"),
+			TRUE, G_PARAM_WRITABLE));
 }
 
 static void
@@ -407,6 +407,10 @@ log4g_pattern_parser_finalize_converter(Log4gPatternParser *self, gchar c)
 		pc = log4g_location_pattern_converter_new(&priv->formatting,
 				FILE_LOCATION_CONVERTER);
 		break;
+	case 'i':
+		pc = log4g_basic_pattern_converter_new(&priv->formatting,
+				THREAD_ID_CONVERTER);
+		break;
 	case 'l':
 		pc = log4g_location_pattern_converter_new(&priv->formatting,
 				FULL_LOCATION_CONVERTER);
@@ -435,6 +439,10 @@ log4g_pattern_parser_finalize_converter(Log4gPatternParser *self, gchar c)
 		pc = log4g_basic_pattern_converter_new(&priv->formatting,
 				THREAD_CONVERTER);
 		break;
+	case 'T':
+		pc = log4g_basic_pattern_converter_new(&priv->formatting,
+				TID_CONVERTER);
+		break;
 	case 'x':
 		pc = log4g_basic_pattern_converter_new(&priv->formatting,
 				NDC_CONVERTER);
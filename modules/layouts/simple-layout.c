@@ -65,19 +65,26 @@ finalize(GObject *base)
 	G_OBJECT_CLASS(log4g_simple_layout_parent_class)->finalize(base);
 }
 
-static gchar *
-format(Log4gLayout *base, Log4gLoggingEvent *event)
+static void
+format_to(G_GNUC_UNUSED Log4gLayout *base, Log4gLoggingEvent *event,
+		GString *string)
 {
-	struct Private *priv = GET_PRIVATE(base);
-	g_string_set_size(priv->string, 0);
 	Log4gLevel *level = log4g_logging_event_get_level(event);
 	if (level) {
-		g_string_append(priv->string, log4g_level_to_string(level));
+		g_string_append(string, log4g_level_to_string(level));
 	}
-	g_string_append(priv->string, " - ");
-	g_string_append(priv->string,
+	g_string_append(string, " - ");
+	g_string_append(string,
 			log4g_logging_event_get_rendered_message(event));
-	g_string_append(priv->string, LOG4G_LAYOUT_LINE_SEP);
+	g_string_append(string, LOG4G_LAYOUT_LINE_SEP);
+}
+
+static gchar *
+format(Log4gLayout *base, Log4gLoggingEvent *event)
+{
+	struct Private *priv = GET_PRIVATE(base);
+	g_string_set_size(priv->string, 0);
+	format_to(base, event, priv->string);
 	return priv->string->str;
 }
 
@@ -88,6 +95,7 @@ log4g_simple_layout_class_init(Log4gSimpleLayoutClass *klass)
 	object_class->finalize = finalize;
 	Log4gLayoutClass *layout_class = LOG4G_LAYOUT_CLASS(klass);
 	layout_class->format = format;
+	layout_class->format_to = format_to;
 	g_type_class_add_private(klass, sizeof(struct Private));
 }
 
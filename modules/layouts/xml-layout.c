@@ -208,27 +208,22 @@ format(Log4gLayout *base, Log4gLoggingEvent *event)
 		g_string_append(self->priv->string, "\" />\r\n");
 	}
 	if (self->priv->properties) {
-		const GArray *keyset =
-			log4g_logging_event_get_property_key_set(event);
-		if (keyset && keyset->len) {
+		const Log4gMDCMap *mdc = log4g_logging_event_get_mdc_map(event);
+		guint size = log4g_mdc_map_get_size(mdc);
+		if (size) {
 			gchar *key;
 			guint i;
 			g_string_append(self->priv->string, "<log4g:properties>\r\n");
-			for (i = 0; i < keyset->len; ++i) {
-				key = g_array_index(keyset, gchar *, i);
-				if (!key) {
-					continue;
-				}
+			for (i = 0; i < size; ++i) {
 				const gchar *value =
-					log4g_logging_event_get_mdc(event, key);
-				if (!value) {
-					continue;
-				}
+					log4g_mdc_map_get_value(mdc, i);
 				escaped = g_strescape(value, NULL);
 				if (escaped) {
 					g_string_append(self->priv->string,
 							"<log4g:data name=\"");
-					key = g_strescape(key, NULL);
+					key = g_strescape(
+						log4g_mdc_map_get_key(mdc, i),
+						NULL);
 					if (key) {
 						g_string_append(self->priv->string,
 								key);
@@ -22,9 +22,13 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include "log4g/helpers/clock.h"
 #include "log4g/interface/appender-attachable.h"
 #include "log4g/log4g.h"
 #include "log4g/module.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define CLASS "/log4g/appender/AsyncAppender"
 
@@ -84,6 +88,192 @@ test_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(appender);
 }
 
+/* Events & discarded events received by the counting appender */
+static gint appended = 0;
+static gint discarded = 0;
+
+/* The counting appender waits while the gate is closed */
+static GMutex gate_lock;
+static GCond gate_cond;
+static gboolean gate = TRUE;
+
+static void
+gate_set_(gboolean open)
+{
+	g_mutex_lock(&gate_lock);
+	gate = open;
+	g_cond_broadcast(&gate_cond);
+	g_mutex_unlock(&gate_lock);
+}
+
+static void
+count_(G_GNUC_UNUSED Log4gAppender *base, Log4gLoggingEvent *event)
+{
+	g_mutex_lock(&gate_lock);
+	while (!gate) {
+		g_cond_wait(&gate_cond, &gate_lock);
+	}
+	g_mutex_unlock(&gate_lock);
+	const gchar *message = log4g_logging_event_get_message(event);
+	gint count;
+	if (1 == sscanf(message, "Discarded %d messages", &count)) {
+		g_atomic_int_add(&discarded, count);
+	} else {
+		g_atomic_int_inc(&appended);
+	}
+}
+
+static void
+close_(G_GNUC_UNUSED Log4gAppender *base)
+{
+	/* do nothing */
+}
+
+static gboolean
+requires_layout_(G_GNUC_UNUSED Log4gAppender *base)
+{
+	return FALSE;
+}
+
+static void
+counting_class_init(gpointer klass, G_GNUC_UNUSED gpointer data)
+{
+	Log4gAppenderClass *appender_class = klass;
+	appender_class->append = count_;
+	appender_class->close = close_;
+	appender_class->requires_layout = requires_layout_;
+}
+
+/* Create an async appender that dispatches to a counting appender */
+static Log4gAppender *
+counting_appender_new(gint size, gboolean blocking)
+{
+	GType type = g_type_from_name("Log4gTestCountingAppender");
+	if (!type) {
+		GTypeQuery query;
+		g_type_query(LOG4G_TYPE_APPENDER, &query);
+		type = g_type_register_static_simple(LOG4G_TYPE_APPENDER,
+				"Log4gTestCountingAppender", query.class_size,
+				counting_class_init, query.instance_size,
+				NULL, 0);
+	}
+	g_assert(type);
+	Log4gAppender *counting = g_object_new(type, NULL);
+	g_assert(counting);
+	type = g_type_from_name("Log4gAsyncAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"buffer-size", size,
+			"blocking", blocking,
+			NULL);
+	g_assert(appender);
+	log4g_appender_attachable_add_appender(
+			LOG4G_APPENDER_ATTACHABLE(appender), counting);
+	g_object_unref(counting);
+	g_atomic_int_set(&appended, 0);
+	g_atomic_int_set(&discarded, 0);
+	return appender;
+}
+
+#define EVENTS (64)
+
+/* A tiny buffer makes blocking producers wait, every event arrives */
+void
+test_002(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender = counting_appender_new(2, TRUE);
+	for (gint i = 0; i < EVENTS; ++i) {
+		log4g_appender_do_append(appender, fixture->event);
+	}
+	/* closing drains the buffer */
+	g_object_unref(appender);
+	g_assert_cmpint(g_atomic_int_get(&appended), ==, EVENTS);
+	g_assert_cmpint(g_atomic_int_get(&discarded), ==, 0);
+}
+
+/* Non-blocking producers discard events while the buffer is full, and the
+ * discarded events are summarized */
+void
+test_003(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender = counting_appender_new(2, FALSE);
+	/* the consumer is held in the first append */
+	gate_set_(FALSE);
+	for (gint i = 0; i < EVENTS; ++i) {
+		log4g_appender_do_append(appender, fixture->event);
+	}
+	gate_set_(TRUE);
+	g_object_unref(appender);
+	gint n = g_atomic_int_get(&appended);
+	gint m = g_atomic_int_get(&discarded);
+	/* at most the batch held by the consumer & a full buffer */
+	g_assert_cmpint(n, <=, 4);
+	g_assert_cmpint(m, >=, EVENTS - 4);
+	g_assert_cmpint(n + m, ==, EVENTS);
+}
+
+#define PRODUCERS (32)
+
+#define PRODUCER_EVENTS (20000)
+
+static gpointer
+produce_(gpointer data)
+{
+	Log4gAppender *appender = data;
+	gint64 *latency = g_new(gint64, PRODUCER_EVENTS);
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			log4g_level_DEBUG(), __func__, __FILE__,
+			G_STRINGIFY(__LINE__), "test message", ap);
+	g_assert(event);
+	for (gint i = 0; i < PRODUCER_EVENTS; ++i) {
+		gint64 start = log4g_clock_get_time();
+		log4g_appender_do_append(appender, event);
+		latency[i] = log4g_clock_get_time() - start;
+	}
+	g_object_unref(event);
+	return latency;
+}
+
+static gint
+compare_(gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *)a;
+	gint64 y = *(const gint64 *)b;
+	return (x > y) - (x < y);
+}
+
+/* Append latency with many contending producers */
+void
+perf_001(G_GNUC_UNUSED Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender = counting_appender_new(8192, TRUE);
+	GThread *threads[PRODUCERS];
+	g_test_timer_start();
+	for (gint i = 0; i < PRODUCERS; ++i) {
+		threads[i] = g_thread_new(NULL, produce_, appender);
+	}
+	gint64 *latency = g_new(gint64, PRODUCERS * PRODUCER_EVENTS);
+	for (gint i = 0; i < PRODUCERS; ++i) {
+		gint64 *thread = g_thread_join(threads[i]);
+		memcpy(latency + i * PRODUCER_EVENTS, thread,
+				PRODUCER_EVENTS * sizeof(gint64));
+		g_free(thread);
+	}
+	gdouble e = g_test_timer_elapsed();
+	g_object_unref(appender);
+	g_assert_cmpint(g_atomic_int_get(&appended), ==,
+			PRODUCERS * PRODUCER_EVENTS);
+	gsize n = PRODUCERS * PRODUCER_EVENTS;
+	qsort(latency, n, sizeof(gint64), compare_);
+	g_test_minimized_result(latency[n * 99 / 100],
+			"%d producers, rate=%d/second, p50=%" G_GINT64_FORMAT
+			"ns, p99=%" G_GINT64_FORMAT "ns", PRODUCERS,
+			(gint)(n / e), latency[n / 2], latency[n * 99 / 100]);
+	g_free(latency);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -101,5 +291,11 @@ main(int argc, char *argv[])
 	g_assert(g_type_module_use(module));
 	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", Fixture, NULL, setup, test_001, teardown);
+	g_test_add(CLASS"/002", Fixture, NULL, setup, test_002, teardown);
+	g_test_add(CLASS"/003", Fixture, NULL, setup, test_003, teardown);
+	if (g_test_perf()) {
+		g_test_add(CLASS"/perf/001", Fixture, NULL, setup, perf_001,
+				teardown);
+	}
 	return g_test_run();
 }
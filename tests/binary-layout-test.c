@@ -0,0 +1,514 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tests for Log4gBinaryLayout
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "log4g/log4g.h"
+#include "log4g/module.h"
+#include "modules/layouts/helpers/binary-format.h"
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CLASS "/log4g/layout/BinaryLayout"
+
+typedef struct Fixture_ {
+	Log4gLoggingEvent *event;
+} Fixture;
+
+void
+setup(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	log4g_mdc_put("foo", "bar");
+	log4g_ndc_push("baz");
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	fixture->event = log4g_logging_event_new("org.gnome.test",
+			log4g_level_DEBUG(), __func__, __FILE__,
+			G_STRINGIFY(__LINE__), "test message", ap);
+	g_assert(fixture->event);
+}
+
+void
+teardown(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	log4g_mdc_remove("foo");
+	log4g_ndc_remove();
+	g_object_unref(fixture->event);
+}
+
+static Log4gLayout *
+layout_new(void)
+{
+	GType type = g_type_from_name("Log4gBinaryLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	return layout;
+}
+
+static guint64
+varint(const guchar **p, const guchar *end)
+{
+	guint64 value = 0;
+	g_assert(log4g_binary_get_varint(p, end, &value));
+	return value;
+}
+
+static gchar *
+bytes(const guchar **p, const guchar *end)
+{
+	guint64 length = varint(p, end);
+	if (!length) {
+		return NULL;
+	}
+	g_assert_cmpuint(end - *p, >=, length - 1);
+	gchar *value = g_strndup((const gchar *)*p, length - 1);
+	*p += length - 1;
+	return value;
+}
+
+/* Decode a buffer holding string records & exactly one event record */
+static void
+check_event(GString *string, GPtrArray *strings, Log4gLoggingEvent *event,
+		gint64 previous)
+{
+	const guchar *p = (const guchar *)string->str;
+	const guchar *end = p + string->len;
+	while (LOG4G_BINARY_STRING == *p) {
+		++p;
+		varint(&p, end);
+		guint64 id = varint(&p, end);
+		guint64 length = varint(&p, end);
+		if (id >= strings->len) {
+			g_ptr_array_set_size(strings, id + 1);
+		}
+		g_free(strings->pdata[id]);
+		strings->pdata[id] = g_strndup((const gchar *)p, length);
+		p += length;
+	}
+	g_assert_cmpint(*p++, ==, LOG4G_BINARY_EVENT);
+	varint(&p, end);
+	guint64 time = varint(&p, end);
+	g_assert_cmpint(previous + LOG4G_BINARY_UNZIGZAG(time), ==,
+			log4g_logging_event_get_time_stamp_ns(event));
+	guint64 level = varint(&p, end);
+	g_assert_cmpint(LOG4G_BINARY_UNZIGZAG(level), ==,
+			log4g_level_to_int(log4g_level_DEBUG()));
+	g_assert_cmpstr(strings->pdata[varint(&p, end)], ==, "org.gnome.test");
+	g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+			log4g_logging_event_get_thread_name(event));
+	g_assert_cmpstr(strings->pdata[varint(&p, end)], ==, __FILE__);
+	g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+			log4g_logging_event_get_line_number(event));
+	g_assert_cmpstr(strings->pdata[varint(&p, end)], ==, "setup");
+	gchar *value = bytes(&p, end);
+	g_assert_cmpstr(value, ==, "test message");
+	g_free(value);
+	value = bytes(&p, end);
+	g_assert_cmpstr(value, ==, "baz");
+	g_free(value);
+	g_assert_cmpuint(varint(&p, end), ==, 1);
+	g_assert_cmpstr(strings->pdata[varint(&p, end)], ==, "foo");
+	value = bytes(&p, end);
+	g_assert_cmpstr(value, ==, "bar");
+	g_free(value);
+	g_assert(p == end);
+}
+
+void
+test_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLayout *layout = layout_new();
+	g_assert_cmpstr(log4g_layout_get_header(layout), ==,
+			LOG4G_BINARY_MAGIC);
+	GPtrArray *strings = g_ptr_array_new_with_free_func(g_free);
+	GString *first = g_string_new(NULL);
+	log4g_layout_format_to(layout, fixture->event, first);
+	check_event(first, strings, fixture->event, 0);
+	/* strings are defined once, the time stamp is a delta */
+	GString *second = g_string_new(NULL);
+	log4g_layout_format_to(layout, fixture->event, second);
+	g_assert_cmpint(second->str[0], ==, LOG4G_BINARY_EVENT);
+	g_assert_cmpuint(second->len, <, first->len);
+	check_event(second, strings, fixture->event,
+			log4g_logging_event_get_time_stamp_ns(fixture->event));
+	/* a new file starts a new dictionary */
+	log4g_layout_get_header(layout);
+	g_string_set_size(second, 0);
+	log4g_layout_format_to(layout, fixture->event, second);
+	g_assert_cmpint(second->str[0], ==, LOG4G_BINARY_STRING);
+	g_string_free(first, TRUE);
+	g_string_free(second, TRUE);
+	g_ptr_array_free(strings, TRUE);
+	g_object_unref(layout);
+}
+
+static Log4gLoggingEvent *
+site_event_new(Log4gCallSite *site, ...)
+{
+	va_list ap;
+	va_start(ap, site);
+	Log4gLoggingEvent *event = log4g_logging_event_new_call_site(
+			g_intern_static_string("org.gnome.test"),
+			log4g_level_INFO(), site, ap);
+	va_end(ap);
+	return event;
+}
+
+/* Decode the string & call site records at the start of a buffer */
+static const guchar *
+definitions(const guchar *p, const guchar *end, GPtrArray *strings,
+		guint64 *site)
+{
+	while (p < end) {
+		if (LOG4G_BINARY_STRING == *p) {
+			++p;
+			varint(&p, end);
+			guint64 id = varint(&p, end);
+			guint64 length = varint(&p, end);
+			if (id >= strings->len) {
+				g_ptr_array_set_size(strings, id + 1);
+			}
+			g_free(strings->pdata[id]);
+			strings->pdata[id] =
+				g_strndup((const gchar *)p, length);
+			p += length;
+		} else if (LOG4G_BINARY_CALL_SITE == *p) {
+			++p;
+			varint(&p, end);
+			*site = varint(&p, end);
+			g_assert_cmpint(LOG4G_BINARY_UNZIGZAG(varint(&p, end)),
+					==, LOG4G_LEVEL_INFO_INT);
+			g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+					__FILE__);
+			g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+					"42");
+			g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+					"test_002");
+			g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+					"%s=%d %.1f");
+		} else {
+			break;
+		}
+	}
+	return p;
+}
+
+/* Events logged from a call site are written without their message */
+void
+test_002(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	static Log4gCallSite site = {
+		0, LOG4G_LEVEL_INFO_INT, "test_002", __FILE__, "42",
+		"%s=%d %.1f", 0, NULL
+	};
+	Log4gLayout *layout = layout_new();
+	log4g_layout_get_header(layout);
+	GPtrArray *strings = g_ptr_array_new_with_free_func(g_free);
+	Log4gLoggingEvent *event = site_event_new(&site, "answer", -42, 0.5);
+	g_assert(event);
+	GString *string = g_string_new(NULL);
+	for (gint i = 0; i < 2; ++i) {
+		g_string_set_size(string, 0);
+		log4g_layout_format_to(layout, event, string);
+		const guchar *p = (const guchar *)string->str;
+		const guchar *end = p + string->len;
+		guint64 id = 0;
+		p = definitions(p, end, strings, &id);
+		if (!i) {
+			g_assert_cmpuint(id, ==, (guint)site.id);
+		} else {
+			/* the call site is only defined once */
+			g_assert_cmpuint(id, ==, 0);
+			g_assert(p == (const guchar *)string->str);
+		}
+		g_assert_cmpint(*p++, ==, LOG4G_BINARY_CALL);
+		varint(&p, end);
+		varint(&p, end);
+		g_assert_cmpuint(varint(&p, end), ==, (guint)site.id);
+		g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+				"org.gnome.test");
+		g_assert_cmpstr(strings->pdata[varint(&p, end)], ==,
+				log4g_logging_event_get_thread_name(event));
+		g_assert_cmpuint(varint(&p, end), ==, 3);
+		g_assert_cmpint(*p++, ==, LOG4G_ARGUMENT_STRING);
+		gchar *value = bytes(&p, end);
+		g_assert_cmpstr(value, ==, "answer");
+		g_free(value);
+		g_assert_cmpint(*p++, ==, LOG4G_ARGUMENT_INT);
+		g_assert_cmpint(LOG4G_BINARY_UNZIGZAG(varint(&p, end)), ==, -42);
+		g_assert_cmpint(*p++, ==, LOG4G_ARGUMENT_DOUBLE);
+		guint64 bits;
+		gdouble d;
+		memcpy(&bits, p, sizeof(bits));
+		bits = GUINT64_FROM_LE(bits);
+		memcpy(&d, &bits, sizeof(d));
+		g_assert_cmpfloat(d, ==, 0.5);
+		p += sizeof(bits);
+		value = bytes(&p, end);
+		g_assert_cmpstr(value, ==, "baz");
+		g_free(value);
+		g_assert_cmpuint(varint(&p, end), ==, 1);
+		g_assert_cmpstr(strings->pdata[varint(&p, end)], ==, "foo");
+		value = bytes(&p, end);
+		g_assert_cmpstr(value, ==, "bar");
+		g_free(value);
+		g_assert(p == end);
+	}
+	/* the message is still available to other layouts */
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			"answer=-42 0.5");
+	g_string_free(string, TRUE);
+	g_ptr_array_free(strings, TRUE);
+	g_object_unref(event);
+	g_object_unref(layout);
+}
+
+#define DECODE_PATTERN "%d{%Y-%m-%d %H:%M:%S.%9N} %-5p %c %X{key0} %m%n"
+
+/* More events than there are strings in a dictionary */
+#define DECODE_EVENTS (5000)
+
+/* Files decode to the same output as the pattern layout, including time
+ * stamps written after the dictionary is cleared */
+void
+test_003(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLayout *layout = layout_new();
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *pattern = g_object_new(type,
+			"conversion-pattern", DECODE_PATTERN, NULL);
+	g_assert(pattern);
+	log4g_layout_activate_options(pattern);
+	GString *binary = g_string_new(log4g_layout_get_header(layout));
+	GString *expected = g_string_new(NULL);
+	gint64 time = log4g_logging_event_get_time_stamp_ns(fixture->event);
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	for (gint i = 0; i < DECODE_EVENTS; ++i) {
+		/* each MDC key is a new dictionary entry */
+		gchar *key = g_strdup_printf("key%d", i);
+		log4g_mdc_put(key, "%d", i);
+		Log4gLoggingEvent *event = log4g_logging_event_new(
+				"org.gnome.test", log4g_level_DEBUG(),
+				__func__, __FILE__, G_STRINGIFY(__LINE__),
+				"test message", ap);
+		g_assert(event);
+		log4g_mdc_remove(key);
+		g_free(key);
+		log4g_logging_event_set_time_stamp_ns(event,
+				time + (i * G_GINT64_CONSTANT(1000001)));
+		log4g_layout_format_to(layout, event, binary);
+		log4g_layout_format_to(pattern, event, expected);
+		g_object_unref(event);
+	}
+	GError *error = NULL;
+	gchar *name = NULL;
+	gint fd = g_file_open_tmp("log4g-XXXXXX.log4g", &name, &error);
+	g_assert_no_error(error);
+	close(fd);
+	g_assert(g_file_set_contents(name, binary->str, binary->len,
+				&error));
+	g_assert_no_error(error);
+	gchar *argv[] = {
+		"tools/log4g-decode", "--pattern", DECODE_PATTERN, name, NULL
+	};
+	gchar *output = NULL;
+	gint status;
+	g_assert(g_spawn_sync(NULL, argv, NULL, 0, NULL, NULL, &output,
+				NULL, &status, &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(status, ==, 0);
+	g_assert_cmpstr(output, ==, expected->str);
+	g_unlink(name);
+	g_free(output);
+	g_free(name);
+	g_string_free(expected, TRUE);
+	g_string_free(binary, TRUE);
+	g_object_unref(pattern);
+	g_object_unref(layout);
+}
+
+/* Layouts used alternately by one thread keep their streams */
+void
+test_004(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	/* the first & last layout have identifiers four apart */
+	Log4gLayout *layouts[5];
+	for (guint i = 0; i < G_N_ELEMENTS(layouts); ++i) {
+		layouts[i] = layout_new();
+		log4g_layout_get_header(layouts[i]);
+	}
+	GString *string = g_string_new(NULL);
+	guint64 numbers[2];
+	for (gint i = 0; i < 6; ++i) {
+		Log4gLayout *layout = layouts[(i % 2) * 4];
+		g_string_set_size(string, 0);
+		log4g_layout_format_to(layout, fixture->event, string);
+		const guchar *p = (const guchar *)string->str + 1;
+		guint64 number = varint(&p, p + string->len - 1);
+		if (i < 2) {
+			g_assert_cmpint(string->str[0], ==,
+					LOG4G_BINARY_STRING);
+			numbers[i] = number;
+		} else {
+			/* no new stream & no new definitions */
+			g_assert_cmpint(string->str[0], ==,
+					LOG4G_BINARY_EVENT);
+			g_assert_cmpuint(number, ==, numbers[i % 2]);
+		}
+	}
+	g_string_free(string, TRUE);
+	for (guint i = 0; i < G_N_ELEMENTS(layouts); ++i) {
+		g_object_unref(layouts[i]);
+	}
+}
+
+#define PERF_EVENTS (1000000)
+
+static gdouble
+perf_format(Log4gLayout *layout, Log4gLoggingEvent *event, gsize *size)
+{
+	GString *string = g_string_sized_new(256);
+	*size = 0;
+	g_test_timer_start();
+	for (gint i = 0; i < PERF_EVENTS; ++i) {
+		g_string_set_size(string, 0);
+		log4g_layout_format_to(layout, event, string);
+		*size += string->len;
+	}
+	gdouble e = g_test_timer_elapsed();
+	g_string_free(string, TRUE);
+	return e;
+}
+
+/* Compare the binary layout with a typical pattern layout */
+
+/* Append a record of variable length integers */
+static void
+record_(GString *string, guchar tag, const guint64 *values, gsize n)
+{
+	guchar buffer[LOG4G_BINARY_VARINT_MAX];
+	g_string_append_c(string, tag);
+	for (gsize i = 0; i < n; ++i) {
+		guchar *p = log4g_binary_put_varint(buffer, values[i]);
+		g_string_append_len(string, (const gchar *)buffer,
+				p - buffer);
+	}
+}
+
+/* Run the decoder on 'binary', returns its exit status */
+static gint
+decode_(const GString *binary)
+{
+	GError *error = NULL;
+	gchar *name = NULL;
+	gint fd = g_file_open_tmp("log4g-XXXXXX.log4g", &name, &error);
+	g_assert_no_error(error);
+	close(fd);
+	g_assert(g_file_set_contents(name, binary->str, binary->len,
+				&error));
+	g_assert_no_error(error);
+	gchar *argv[] = { "tools/log4g-decode", name, NULL };
+	gint status;
+	g_assert(g_spawn_sync(NULL, argv, NULL, G_SPAWN_STDOUT_TO_DEV_NULL
+				| G_SPAWN_STDERR_TO_DEV_NULL, NULL, NULL,
+				NULL, NULL, &status, &error));
+	g_assert_no_error(error);
+	g_unlink(name);
+	g_free(name);
+	return status;
+}
+
+/* Corrupt dictionary ids are rejected instead of sizing tables by them */
+void
+test_005(G_GNUC_UNUSED Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	/* stream, id, length & the bytes of a string record */
+	const guint64 first[] = { 0, 1, 1, 'a' };
+	const guint64 skipped[] = { 0, 3, 1, 'b' };
+	const guint64 huge[] = { 0, G_MAXUINT, 1, 'c' };
+	/* stream, id, level, file, line, function & format of a site */
+	const guint64 site[] = { 0, G_MAXUINT, 0, 1, 1, 1, 1 };
+	GString *binary = g_string_new(LOG4G_BINARY_MAGIC);
+	record_(binary, LOG4G_BINARY_STRING, first, G_N_ELEMENTS(first));
+	/* site ids are not dense, a large id is valid */
+	record_(binary, LOG4G_BINARY_CALL_SITE, site, G_N_ELEMENTS(site));
+	g_assert_cmpint(decode_(binary), ==, 0);
+	gsize length = binary->len;
+	record_(binary, LOG4G_BINARY_STRING, skipped, G_N_ELEMENTS(skipped));
+	g_assert_cmpint(decode_(binary), !=, 0);
+	g_string_truncate(binary, length);
+	record_(binary, LOG4G_BINARY_STRING, huge, G_N_ELEMENTS(huge));
+	g_assert_cmpint(decode_(binary), !=, 0);
+	g_string_free(binary, TRUE);
+}
+
+void
+perf_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	gsize size;
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, "conversion-pattern",
+			"%d{%Y-%m-%d %H:%M:%S.%6N} %-5p [%t] %c %l %x %X{foo} "
+			"- %m%n", NULL);
+	g_assert(layout);
+	gdouble e = perf_format(layout, fixture->event, &size);
+	g_test_minimized_result(e, "pattern layout, cost=%.2fns/event, "
+			"size=%.1fB/event", (e / PERF_EVENTS) * 1e9,
+			(gdouble)size / PERF_EVENTS);
+	g_object_unref(layout);
+	layout = layout_new();
+	e = perf_format(layout, fixture->event, &size);
+	g_test_minimized_result(e, "binary layout, cost=%.2fns/event, "
+			"size=%.1fB/event", (e / PERF_EVENTS) * 1e9,
+			(gdouble)size / PERF_EVENTS);
+	g_object_unref(layout);
+}
+
+int
+main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+	GTypeModule *module =
+		log4g_module_new("modules/layouts/liblog4g-layouts.la");
+	g_assert(module);
+	g_assert(g_type_module_use(module));
+	g_type_module_unuse(module);
+	g_test_add(CLASS"/001", Fixture, NULL, setup, test_001, teardown);
+	g_test_add(CLASS"/002", Fixture, NULL, setup, test_002, teardown);
+	g_test_add(CLASS"/003", Fixture, NULL, setup, test_003, teardown);
+	g_test_add(CLASS"/004", Fixture, NULL, setup, test_004, teardown);
+	g_test_add(CLASS"/005", Fixture, NULL, setup, test_005, teardown);
+	if (g_test_perf()) {
+		g_test_add(CLASS"/perf/001", Fixture, NULL, setup, perf_001,
+				teardown);
+	}
+	return g_test_run();
+}
@@ -23,6 +23,7 @@
 #include "config.h"
 #endif
 #include "log4g/dom-configurator.h"
+#include "log4g/helpers/clock.h"
 #include "log4g/log4g.h"
 #include <stdlib.h>
 
@@ -63,6 +64,7 @@ test_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
 		g_error_free(error);
 		g_assert(ok);
 	}
+	g_assert_cmpint(log4g_clock_get_source(), ==, LOG4G_CLOCK_MONOTONIC);
 	log4g_debug("debug message (match this string)");
 	Log4gLogger *logger = log4g_get_logger("org.gnome.test");
 	g_assert(logger);
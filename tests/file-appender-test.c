@@ -66,6 +66,48 @@ test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(appender);
 }
 
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GType type = g_type_from_name("Log4gSimpleLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", "tests/file-appender-test.txt",
+			"append", FALSE,
+			"io-uring", TRUE,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	GString *expected = g_string_new(NULL);
+	for (gint i = 0; i < 1000; ++i) {
+		Log4gLoggingEvent *event = log4g_logging_event_new(
+				"org.gnome.test", log4g_level_DEBUG(),
+				__func__, __FILE__, G_STRINGIFY(__LINE__),
+				"test message", ap);
+		g_assert(event);
+		log4g_appender_do_append(appender, event);
+		g_object_unref(event);
+		g_string_append(expected, "DEBUG - test message\n");
+	}
+	/* closing waits for the completion thread */
+	g_object_unref(appender);
+	gchar *contents = NULL;
+	g_assert(g_file_get_contents("tests/file-appender-test.txt",
+				&contents, NULL, NULL));
+	g_assert_cmpstr(contents, ==, expected->str);
+	g_string_free(expected, TRUE);
+	g_free(contents);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -83,5 +125,6 @@ main(int argc, char *argv[])
 	g_assert(g_type_module_use(module));
 	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
 	return g_test_run();
 }
@@ -22,8 +22,10 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include "log4g/helpers/thread.h"
 #include "log4g/log4g.h"
 #include "log4g/module.h"
+#include <string.h>
 
 #define CLASS "/log4g/layout/JsonLayout"
 
@@ -89,6 +91,106 @@ test_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(layout);
 }
 
+static Log4gLoggingEvent *
+event_new(const gchar *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			log4g_level_INFO(), "function", "file.c", "42",
+			format, ap);
+	va_end(ap);
+	return event;
+}
+
+static Log4gLayout *
+layout_new(gboolean ndjson)
+{
+	GType type = g_type_from_name("Log4gJsonLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type,
+			"properties", FALSE,
+			"location-info", TRUE,
+			"ndjson", ndjson,
+			NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	return layout;
+}
+
+/* NDJSON output & string escaping */
+void
+test_002(G_GNUC_UNUSED Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLoggingEvent *event =
+		event_new("%s", "q \" b \\ t \t n \n a \a \xc3\xa9");
+	g_assert(event);
+	Log4gLayout *layout = layout_new(TRUE);
+	g_assert_cmpstr(log4g_layout_get_header(layout), ==, "");
+	g_assert_cmpstr(log4g_layout_get_footer(layout), ==, "");
+	gchar *expected = g_strdup_printf("{\"logger\":\"org.gnome.test\","
+			"\"timestamp\":%" G_GINT64_FORMAT ","
+			"\"level\":\"INFO\",\"thread\":\"%s\","
+			"\"message\":\"q \\\" b \\\\ t \\t n \\n a "
+			"\\u0007 \xc3\xa9\",\"ndc\":\"%s\","
+			"\"locationInfo\":{\"file\":\"file.c\",\"line\":42,"
+			"\"function\":\"function\"}}\n",
+			log4g_logging_event_get_time_stamp_ns(event)
+				/ 1000000000,
+			log4g_logging_event_get_thread_name(event),
+			log4g_logging_event_get_ndc(event));
+	g_assert_cmpstr(log4g_layout_format(layout, event), ==, expected);
+	/* every event is framed identically */
+	g_assert_cmpstr(log4g_layout_format(layout, event), ==, expected);
+	g_free(expected);
+	g_object_unref(layout);
+	g_object_unref(event);
+}
+
+/* Array framing */
+void
+test_003(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLayout *layout = layout_new(FALSE);
+	g_assert_cmpstr(log4g_layout_get_header(layout), ==, "[");
+	g_assert_cmpstr(log4g_layout_get_footer(layout), ==, "\n]\n");
+	const gchar *string = log4g_layout_format(layout, fixture->event0);
+	g_assert(g_str_has_prefix(string,
+				"\n  {\n    \"logger\": \"org.gnome.test\",\n"));
+	g_assert(g_str_has_suffix(string, "\n  }"));
+	string = log4g_layout_format(layout, fixture->event1);
+	g_assert(g_str_has_prefix(string, ",\n  {\n"));
+	g_assert(strstr(string, "\n    \"level\": \"WARN\",\n"));
+	g_assert(strstr(string, "\"locationInfo\": {\n"));
+	g_object_unref(layout);
+}
+
+/* Thread identifiers */
+void
+test_004(G_GNUC_UNUSED Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLoggingEvent *event = event_new("%s", "message");
+	g_assert(event);
+	GType type = g_type_from_name("Log4gJsonLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type,
+			"properties", FALSE,
+			"location-info", FALSE,
+			"ndjson", TRUE,
+			"thread-id", TRUE,
+			NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	gchar *expected = g_strdup_printf("\"thread\":\"%s\","
+			"\"threadId\":%u,\"tid\":%d,\"message\":",
+			log4g_thread_get_name(), log4g_thread_get_id(),
+			log4g_thread_get_tid());
+	g_assert(strstr(log4g_layout_format(layout, event), expected));
+	g_free(expected);
+	g_object_unref(layout);
+	g_object_unref(event);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -102,5 +204,8 @@ main(int argc, char *argv[])
 	g_assert(g_type_module_use(module));
 	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", Fixture, NULL, setup, test_001, teardown);
+	g_test_add(CLASS"/002", Fixture, NULL, setup, test_002, teardown);
+	g_test_add(CLASS"/003", Fixture, NULL, setup, test_003, teardown);
+	g_test_add(CLASS"/004", Fixture, NULL, setup, test_004, teardown);
 	return g_test_run();
 }
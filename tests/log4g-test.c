@@ -22,18 +22,232 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include "log4g/interface/appender-attachable.h"
 #include "log4g/log4g.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #define CLASS "/log4g"
 
+#ifdef __GLIBC__
+/* Count heap allocations made while 'counting' is set */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+static gint allocations = 0;
+static gint counting = FALSE;
+
+void *
+malloc(size_t size)
+{
+	if (g_atomic_int_get(&counting)) {
+		g_atomic_int_inc(&allocations);
+	}
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	if (g_atomic_int_get(&counting)) {
+		g_atomic_int_inc(&allocations);
+	}
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *pointer, size_t size)
+{
+	if (g_atomic_int_get(&counting)) {
+		g_atomic_int_inc(&allocations);
+	}
+	return __libc_realloc(pointer, size);
+}
+
+void *
+memalign(size_t alignment, size_t size)
+{
+	if (g_atomic_int_get(&counting)) {
+		g_atomic_int_inc(&allocations);
+	}
+	return __libc_memalign(alignment, size);
+}
+
+void *
+aligned_alloc(size_t alignment, size_t size)
+{
+	return memalign(alignment, size);
+}
+
+int
+posix_memalign(void **pointer, size_t alignment, size_t size)
+{
+	if (!alignment || alignment % sizeof(void *)
+			|| alignment & (alignment - 1)) {
+		return EINVAL;
+	}
+	void *memory = memalign(alignment, size);
+	if (!memory) {
+		return ENOMEM;
+	}
+	*pointer = memory;
+	return 0;
+}
+#endif /* __GLIBC__ */
+
 void
 test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 {
 	log4g_error("log4g-test: logging message (match this string)");
 }
 
+static gint evaluated = 0;
+
+static gint
+evaluate(void)
+{
+	return ++evaluated;
+}
+
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLogger *root = log4g_get_root_logger();
+	Log4gLevel *level = log4g_logger_get_level(root);
+	if (level) {
+		g_object_ref(level);
+	}
+	log4g_logger_set_level(root, log4g_level_INFO());
+	evaluated = 0;
+	for (gint i = 0; i < 2; ++i) {
+		log4g_trace("%d not evaluated", evaluate());
+		log4g_debug("%d not evaluated", evaluate());
+		log4g_logger_debug(root, "%d not evaluated", evaluate());
+	}
+	g_assert_cmpint(evaluated, ==, 0);
+	g_assert(!log4g_is_debug_enabled());
+	log4g_logger_set_level(root, log4g_level_ALL());
+	g_assert(log4g_is_debug_enabled());
+	log4g_logger_set_level(root, level);
+	if (level) {
+		g_object_unref(level);
+	}
+}
+
+#ifdef __GLIBC__
+static Log4gAppender *
+file_appender_new(const gchar *file, const gchar *pattern)
+{
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type,
+			"conversion-pattern", pattern,
+			NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", file,
+			"append", FALSE,
+			"buffered-io", TRUE,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	return appender;
+}
+
+static Log4gLogger *
+pattern_logger_new(const gchar *name, const gchar *file, const gchar *pattern)
+{
+	Log4gAppender *appender = file_appender_new(file, pattern);
+	Log4gLogger *logger = log4g_get_logger(name);
+	log4g_logger_set_additivity(logger, FALSE);
+	log4g_logger_set_level(logger, log4g_level_DEBUG());
+	log4g_logger_add_appender(logger, appender);
+	g_object_unref(appender);
+	return logger;
+}
+
+/* Count the heap allocations made while logging 'log' messages through
+ * 'appender' */
+static gint
+count_allocations_(Log4gAppender *appender, gint log)
+{
+	Log4gLogger *logger = log4g_get_logger("org.gnome.test.allocations");
+	log4g_logger_set_additivity(logger, FALSE);
+	log4g_logger_set_level(logger, log4g_level_DEBUG());
+	log4g_logger_add_appender(logger, appender);
+	/* warm up the event pool & appender buffers */
+	for (gint i = 0; i < 1000; ++i) {
+		log4g_logger_debug(logger, "%d log this message", i);
+	}
+	g_atomic_int_set(&allocations, 0);
+	g_atomic_int_set(&counting, TRUE);
+	for (gint i = 0; i < log; ++i) {
+		log4g_logger_debug(logger, "%d log this message", i);
+	}
+	g_atomic_int_set(&counting, FALSE);
+	log4g_logger_remove_all_appenders(logger);
+	return g_atomic_int_get(&allocations);
+}
+
+/* Count the heap allocations made while logging to 'first' & 'second' */
+static gint
+pattern_allocations_(Log4gLogger *first, Log4gLogger *second)
+{
+	/* warm up the event pool & appender buffers */
+	for (gint i = 0; i < 1000; ++i) {
+		log4g_logger_debug(first, "%d log this message", i);
+		log4g_logger_debug(second, "%d log this message", i);
+	}
+	g_atomic_int_set(&allocations, 0);
+	g_atomic_int_set(&counting, TRUE);
+	for (gint i = 0; i < 1000; ++i) {
+		log4g_logger_debug(first, "%d log this message", i);
+		log4g_logger_debug(second, "%d log this message", i);
+	}
+	g_atomic_int_set(&counting, FALSE);
+	return g_atomic_int_get(&allocations);
+}
+
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	/* two layouts with the same fingerprint on disjoint loggers, every
+	 * event is formatted by one of them & caches its output */
+	Log4gLogger *first = pattern_logger_new("org.gnome.test.first",
+			"tests/first-test.txt", "%c - %m%n");
+	Log4gLogger *second = pattern_logger_new("org.gnome.test.second",
+			"tests/second-test.txt", "%c - %m%n");
+	gint shared = pattern_allocations_(first, second);
+	log4g_logger_remove_all_appenders(second);
+	/* the same loggers with distinct fingerprints, nothing is cached */
+	second = pattern_logger_new("org.gnome.test.second",
+			"tests/second-test.txt", "%c: %m%n");
+	gint distinct = pattern_allocations_(first, second);
+	log4g_logger_remove_all_appenders(first);
+	log4g_logger_remove_all_appenders(second);
+	g_assert_cmpint(shared, ==, distinct);
+}
+
+/* Once the event pool is warm, logging to a file appender does not
+ * allocate */
+void
+test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender = file_appender_new("tests/file.txt",
+			"%d %-5p [%t] %c - %m%n");
+	g_assert_cmpint(count_allocations_(appender, 10000), ==, 0);
+	g_object_unref(appender);
+}
+#endif /* __GLIBC__ */
+
 void
 perf_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 {
@@ -74,6 +288,60 @@ perf_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 			(gint)(log / e));
 }
 
+/* The upper bound of the cost of a disabled statement, in nanoseconds */
+#define DISABLED_COST (10.0)
+
+void
+perf_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	gint log = 100000000;
+	g_test_timer_start();
+	for (gint i = 0; i < log; ++i) {
+		log4g_trace("%d skip this message", i);
+	}
+	gdouble e = g_test_timer_elapsed();
+	gdouble cost = (e * 1e9) / log;
+	g_test_minimized_result(e, "skipped messages, cost=%.2fns/message",
+			cost);
+	/* the target is ~2ns, the bound is loose enough for slow machines
+	 * but still catches a return to the GObject level comparison */
+	g_assert_cmpfloat(cost, <, DISABLED_COST);
+}
+
+#ifdef __GLIBC__
+static void
+allocations_(Log4gAppender *appender, const gchar *name)
+{
+	gint log = 100000;
+	gdouble count = (gdouble)count_allocations_(appender, log) / log;
+	g_test_minimized_result(count, "%s, allocations=%.3f/message",
+			name, count);
+}
+
+void
+perf_005(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender = file_appender_new("tests/file.txt",
+			"%d %-5p [%t] %c - %m%n");
+	allocations_(appender, "file appender");
+	g_object_unref(appender);
+	/* events are released by the async appender thread and returned to
+	 * the pool of the logging thread */
+	GType type = g_type_from_name("Log4gAsyncAppender");
+	g_assert(type);
+	appender = g_object_new(type, NULL);
+	g_assert(appender);
+	Log4gAppender *file = file_appender_new("tests/file.txt",
+			"%d %-5p [%t] %c - %m%n");
+	log4g_appender_attachable_add_appender(
+			LOG4G_APPENDER_ATTACHABLE(appender), file);
+	g_object_unref(file);
+	log4g_appender_activate_options(appender);
+	allocations_(appender, "async appender");
+	g_object_unref(appender);
+}
+#endif /* __GLIBC__ */
+
 int
 main(int argc, char *argv[])
 {
@@ -99,6 +367,11 @@ main(int argc, char *argv[])
 	}
 	g_option_context_free(context);
 	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+#ifdef __GLIBC__
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
+	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, NULL);
+#endif /* __GLIBC__ */
 	if (g_test_perf()) {
 		g_test_add(CLASS"/perf/001", gpointer, NULL, NULL,
 				perf_001, NULL);
@@ -106,6 +379,12 @@ main(int argc, char *argv[])
 				perf_002, NULL);
 		g_test_add(CLASS"/perf/003", gpointer, NULL, NULL,
 				perf_003, NULL);
+		g_test_add(CLASS"/perf/004", gpointer, NULL, NULL,
+				perf_004, NULL);
+#ifdef __GLIBC__
+		g_test_add(CLASS"/perf/005", gpointer, NULL, NULL,
+				perf_005, NULL);
+#endif /* __GLIBC__ */
 	}
 	int status = g_test_run();
 	log4g_finalize();
@@ -23,6 +23,8 @@
 #include "config.h"
 #endif
 #include "log4g/log4g.h"
+#include "log4g/module.h"
+#include <string.h>
 
 #define CLASS "/log4g/Logger"
 
@@ -34,6 +36,139 @@ test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(logger);
 }
 
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLogger *parent = log4g_logger_new("org.gnome");
+	g_assert(parent);
+	Log4gLogger *child = log4g_logger_new("org.gnome.test");
+	g_assert(child);
+	log4g_logger_set_parent(child, parent);
+	log4g_logger_set_level(parent, log4g_level_DEBUG());
+	g_assert_cmpint(log4g_logger_get_effective_level_int(child), ==,
+			LOG4G_LEVEL_DEBUG_INT);
+	/* the cached value must follow changes to an ancestor */
+	log4g_logger_set_level(parent, log4g_level_WARN());
+	g_assert_cmpint(log4g_logger_get_effective_level_int(child), ==,
+			LOG4G_LEVEL_WARN_INT);
+	log4g_logger_set_level(child, log4g_level_INFO());
+	g_assert_cmpint(log4g_logger_get_effective_level_int(child), ==,
+			LOG4G_LEVEL_INFO_INT);
+	log4g_logger_set_level(child, NULL);
+	g_assert_cmpint(log4g_logger_get_effective_level_int(child), ==,
+			LOG4G_LEVEL_WARN_INT);
+	g_object_unref(child);
+	g_object_unref(parent);
+}
+
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	gchar *name = g_strdup("org.gnome.test");
+	Log4gLogger *logger = log4g_logger_new(name);
+	g_assert(logger);
+	/* logger names are interned */
+	g_assert(log4g_logger_get_name(logger) != name);
+	g_assert(log4g_logger_get_name(logger)
+			== g_intern_string("org.gnome.test"));
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	Log4gLoggingEvent *event = log4g_logging_event_new(name,
+			log4g_level_DEBUG(), __func__, __FILE__,
+			G_STRINGIFY(__LINE__), "test message", ap);
+	g_assert(event);
+	g_assert(log4g_logging_event_get_logger_name(event)
+			== log4g_logger_get_name(logger));
+	g_object_unref(event);
+	g_object_unref(logger);
+	g_free(name);
+}
+
+static gpointer
+log_(gpointer data)
+{
+	Log4gLogger *logger = data;
+	for (gint i = 0; i < 10000; ++i) {
+		log4g_logger_info(logger, "%d test message", i);
+	}
+	return NULL;
+}
+
+void
+test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GType type = g_type_from_name("Log4gNullAppender");
+	g_assert(type);
+	Log4gLogger *logger = log4g_logger_new("org.gnome.test");
+	g_assert(logger);
+	log4g_logger_set_level(logger, log4g_level_INFO());
+	Log4gAppender *appender = g_object_new(type, NULL);
+	g_assert(appender);
+	log4g_logger_add_appender(logger, appender);
+	g_object_unref(appender);
+	/* appenders may be added & removed while other threads log */
+	GThread *threads[4];
+	for (guint i = 0; i < G_N_ELEMENTS(threads); ++i) {
+		threads[i] = g_thread_new("logger-test", log_, logger);
+		g_assert(threads[i]);
+	}
+	for (gint i = 0; i < 1000; ++i) {
+		appender = g_object_new(type, NULL);
+		log4g_logger_add_appender(logger, appender);
+		g_object_unref(appender);
+		log4g_logger_remove_appender(logger, appender);
+	}
+	for (guint i = 0; i < G_N_ELEMENTS(threads); ++i) {
+		g_thread_join(threads[i]);
+	}
+	g_object_unref(logger);
+}
+
+void
+test_005(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GType type = g_type_from_name("Log4gSimpleLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", "tests/logger-test.txt",
+			"append", FALSE,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	Log4gLogger *parent = log4g_logger_new("org.gnome");
+	g_assert(parent);
+	Log4gLogger *child = log4g_logger_new("org.gnome.test");
+	g_assert(child);
+	log4g_logger_set_parent(child, parent);
+	log4g_logger_set_level(parent, log4g_level_INFO());
+	log4g_logger_set_additivity(parent, FALSE);
+	log4g_logger_set_additivity(child, TRUE);
+	/* an appender reachable twice only receives each event once */
+	log4g_logger_add_appender(parent, appender);
+	log4g_logger_add_appender(child, appender);
+	log4g_logger_info(child, "message 1");
+	log4g_logger_remove_appender(child, appender);
+	log4g_logger_set_additivity(child, FALSE);
+	log4g_logger_add_appender(child, appender);
+	log4g_logger_info(child, "message 2");
+	log4g_appender_close(appender);
+	g_object_unref(appender);
+	g_object_unref(child);
+	g_object_unref(parent);
+	gchar *contents = NULL;
+	g_assert(g_file_get_contents("tests/logger-test.txt", &contents,
+				NULL, NULL));
+	g_assert_cmpstr(contents, ==, "INFO - message 1\nINFO - message 2\n");
+	g_free(contents);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -41,6 +176,19 @@ main(int argc, char *argv[])
 #if !GLIB_CHECK_VERSION(2, 36, 0)
 	g_type_init();
 #endif
+	GTypeModule *module =
+		log4g_module_new("modules/appenders/liblog4g-appenders.la");
+	g_assert(module);
+	g_assert(g_type_module_use(module));
+	g_type_module_unuse(module);
+	module = log4g_module_new("modules/layouts/liblog4g-layouts.la");
+	g_assert(module);
+	g_assert(g_type_module_use(module));
+	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
+	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, NULL);
+	g_test_add(CLASS"/005", gpointer, NULL, NULL, test_005, NULL);
 	return g_test_run();
 }
@@ -0,0 +1,376 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tests for Log4gLoggingEvent
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "log4g/helpers/clock.h"
+#include "log4g/helpers/thread.h"
+#include "log4g/log4g.h"
+#include <string.h>
+
+#define CLASS "/log4g/LoggingEvent"
+
+static Log4gLoggingEvent *
+event_new(const gchar *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			log4g_level_DEBUG(), __func__, __FILE__,
+			G_STRINGIFY(__LINE__), format, ap);
+	va_end(ap);
+	return event;
+}
+
+void
+test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	log4g_logging_event_set_deferred_formatting(FALSE);
+	Log4gLoggingEvent *event = event_new("%s %d", "test", 1);
+	g_assert(event);
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			"test 1");
+	g_object_unref(event);
+}
+
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	log4g_logging_event_set_deferred_formatting(TRUE);
+	gchar buffer[] = "copied";
+	gpointer pointer = &buffer;
+	Log4gLoggingEvent *event = event_new(
+			"%s|%5d|%-*.*s|%c|%lu|%lld|%zu|%%|%.2f|%p|%hd|%#x",
+			buffer, 42, 8, 3, "abcdef", 'z', 7UL, -9LL,
+			(gsize)11, 3.14159, pointer, (short)-3, 255);
+	g_assert(event);
+	/* string parameters are copied when the event is created */
+	gchar *expected = g_strdup_printf(
+			"%s|%5d|%-*.*s|%c|%lu|%lld|%zu|%%|%.2f|%p|%hd|%#x",
+			buffer, 42, 8, 3, "abcdef", 'z', 7UL, -9LL,
+			(gsize)11, 3.14159, pointer, (short)-3, 255);
+	memset(buffer, 'x', sizeof(buffer) - 1);
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			expected);
+	/* the message is rendered once */
+	g_assert(log4g_logging_event_get_rendered_message(event)
+			== log4g_logging_event_get_message(event));
+	g_free(expected);
+	g_object_unref(event);
+	log4g_logging_event_set_deferred_formatting(FALSE);
+}
+
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	log4g_logging_event_set_deferred_formatting(TRUE);
+	/* formats that cannot be deferred are formatted immediately */
+	Log4gLoggingEvent *event = event_new("%2$s %1$s", "world", "hello");
+	g_assert(event);
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			"hello world");
+	g_object_unref(event);
+	/* a negative precision is ignored */
+	event = event_new("[%.*s]", -1, "abc");
+	g_assert(event);
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			"[abc]");
+	g_object_unref(event);
+	log4g_logging_event_set_deferred_formatting(FALSE);
+}
+
+void
+test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLoggingEvent *event = event_new("%s", "first");
+	g_assert(event);
+	log4g_ndc_push("ndc");
+	log4g_logging_event_get_ndc_copy(event);
+	log4g_ndc_pop();
+	g_assert_cmpstr(log4g_logging_event_get_ndc(event), ==, "ndc");
+	g_object_unref(event);
+	/* recycled events must not carry state from a previous event */
+	gchar *message = g_strnfill(1000, 'm');
+	event = event_new("%s", message);
+	g_assert(event);
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			message);
+	g_assert(!log4g_logging_event_get_ndc(event));
+	g_free(message);
+	g_object_unref(event);
+}
+
+void
+test_005(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	static const Log4gClockSource sources[] = {
+		LOG4G_CLOCK_REALTIME,
+		LOG4G_CLOCK_REALTIME_COARSE,
+		LOG4G_CLOCK_MONOTONIC,
+		LOG4G_CLOCK_CYCLES
+	};
+	for (guint i = 0; i < G_N_ELEMENTS(sources); ++i) {
+		log4g_clock_set_source(sources[i]);
+		gint64 previous = 0;
+		for (gint j = 0; j < 1000; ++j) {
+			Log4gLoggingEvent *event = event_new("%d", j);
+			g_assert(event);
+			gint64 time =
+				log4g_logging_event_get_time_stamp_ns(event);
+			const GTimeVal *tv =
+				log4g_logging_event_get_time_stamp(event);
+			g_assert_cmpint(tv->tv_sec, ==, time / 1000000000);
+			g_assert_cmpint(tv->tv_usec, ==,
+					(time % 1000000000) / 1000);
+			/* all clocks are close to the wall clock */
+			gint64 now = g_get_real_time() * 1000;
+			g_assert_cmpint(ABS(now - time), <, 1000000000);
+			if (LOG4G_CLOCK_MONOTONIC
+					== log4g_clock_get_source()
+					|| LOG4G_CLOCK_CYCLES
+					== log4g_clock_get_source()) {
+				g_assert_cmpint(time, >=, previous);
+			}
+			previous = time;
+			g_object_unref(event);
+		}
+	}
+	g_assert(log4g_clock_set_source_name("realtime"));
+	g_assert_cmpint(log4g_clock_get_source(), ==, LOG4G_CLOCK_REALTIME);
+	g_assert(!log4g_clock_set_source_name("sundial"));
+}
+
+static Log4gLoggingEvent *
+site_event_new(Log4gCallSite *site, ...)
+{
+	va_list ap;
+	va_start(ap, site);
+	Log4gLoggingEvent *event = log4g_logging_event_new_call_site(
+			g_intern_static_string("org.gnome.test"),
+			log4g_level_INFO(), site, ap);
+	va_end(ap);
+	return event;
+}
+
+void
+test_006(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	static Log4gCallSite site = {
+		0, LOG4G_LEVEL_INFO_INT, "test_006", __FILE__, "42",
+		"%s %*d %lu %%", 0, NULL
+	};
+	static Log4gCallSite positional = {
+		0, LOG4G_LEVEL_INFO_INT, "test_006", __FILE__, "43",
+		"%2$s %1$s", 0, NULL
+	};
+	log4g_logging_event_set_deferred_formatting(FALSE);
+	gchar buffer[] = "copied";
+	Log4gLoggingEvent *event = site_event_new(&site, buffer, 3, 7, 8UL);
+	g_assert(event);
+	/* the call site is registered on first use */
+	g_assert_cmpint(site.id, >, 0);
+	g_assert(log4g_call_site_lookup(site.id) == &site);
+	g_assert_cmpuint(log4g_call_site_get_count(), >=, (guint)site.id);
+	g_assert_cmpuint(log4g_call_site_register(&site), ==, (guint)site.id);
+	g_assert(log4g_logging_event_get_call_site(event) == &site);
+	g_assert_cmpstr(log4g_logging_event_get_line_number(event), ==, "42");
+	/* parameters are captured even without deferred formatting */
+	guint size = 0;
+	const Log4gArgument *args =
+		log4g_logging_event_get_arguments(event, &size);
+	g_assert(args);
+	g_assert_cmpuint(size, ==, 4);
+	g_assert_cmpint(args[0].type, ==, LOG4G_ARGUMENT_STRING);
+	g_assert_cmpint(args[1].type, ==, LOG4G_ARGUMENT_INT);
+	g_assert_cmpint(args[2].type, ==, LOG4G_ARGUMENT_INT);
+	g_assert_cmpint(args[3].type, ==, LOG4G_ARGUMENT_LONG);
+	buffer[0] = 'X';
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			"copied   7 8 %");
+	/* replay the captured parameters */
+	Log4gLoggingEvent *copy = log4g_logging_event_new_arguments(
+			"org.gnome.test", log4g_level_INFO(), "test_006",
+			__FILE__, "42", site.format, args, size);
+	g_assert(copy);
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(copy), ==,
+			"copied   7 8 %");
+	g_object_unref(copy);
+	g_assert(!log4g_logging_event_new_arguments("org.gnome.test",
+			log4g_level_INFO(), "test_006", __FILE__, "42",
+			"%d", args, size));
+	g_object_unref(event);
+	/* formats that cannot be captured are formatted immediately */
+	event = site_event_new(&positional, "first", "second");
+	g_assert(event);
+	g_assert(!log4g_logging_event_get_arguments(event, NULL));
+	g_assert_cmpstr(log4g_logging_event_get_rendered_message(event), ==,
+			"second first");
+	g_assert_cmpint(positional.id, >, 0);
+	g_assert_cmpint(positional.id, !=, site.id);
+	g_object_unref(event);
+}
+
+static gpointer
+thread_(gpointer data)
+{
+	Log4gLoggingEvent *event = data;
+	log4g_thread_set_name("worker");
+	log4g_logging_event_get_thread_copy(event);
+	return GUINT_TO_POINTER(log4g_thread_get_id());
+}
+
+void
+test_007(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLoggingEvent *event = event_new("%s", "thread");
+	g_assert(event);
+	/* events that were not copied report the current thread */
+	g_assert_cmpuint(log4g_logging_event_get_thread_id(event), ==,
+			log4g_thread_get_id());
+	g_assert_cmpint(log4g_logging_event_get_tid(event), ==,
+			log4g_thread_get_tid());
+	g_assert(log4g_logging_event_get_thread_name(event)
+			== log4g_thread_get_name());
+	GThread *thread = g_thread_new("worker", thread_, event);
+	guint id = GPOINTER_TO_UINT(g_thread_join(thread));
+	g_assert_cmpuint(id, >, 0);
+	g_assert_cmpuint(id, !=, log4g_thread_get_id());
+	g_assert_cmpuint(log4g_logging_event_get_thread_id(event), ==, id);
+	g_assert_cmpint(log4g_logging_event_get_tid(event), !=,
+			log4g_thread_get_tid());
+	/* names are interned */
+	g_assert(log4g_logging_event_get_thread_name(event)
+			== g_intern_string("worker"));
+	g_object_unref(event);
+}
+
+static gpointer
+release_(gpointer event)
+{
+	g_object_unref(event);
+	return NULL;
+}
+
+static void
+finalized_(gpointer data, G_GNUC_UNUSED GObject *event)
+{
+	*(gboolean *)data = TRUE;
+}
+
+/* More events than a pool keeps idle */
+#define EVENTS (128)
+
+/* Events released by another thread return to the pool of the thread that
+ * created them */
+void
+test_008(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	gboolean finalized = FALSE;
+	Log4gLoggingEvent *event = event_new("%s", "released");
+	g_assert(event);
+	g_object_weak_ref(G_OBJECT(event), finalized_, &finalized);
+	/* the pool of the releasing thread is destroyed when it exits */
+	GThread *thread = g_thread_new("release", release_, event);
+	g_thread_join(thread);
+	g_assert(!finalized);
+	Log4gLoggingEvent *events[EVENTS];
+	gboolean found = FALSE;
+	for (gint i = 0; i < EVENTS; ++i) {
+		events[i] = event_new("%d", i);
+		g_assert(events[i]);
+		if (events[i] == event) {
+			found = TRUE;
+			g_object_weak_unref(G_OBJECT(event), finalized_,
+					&finalized);
+			/* the recycled event holds the new message */
+			gchar *message = g_strdup_printf("%d", i);
+			g_assert_cmpstr(log4g_logging_event_get_message(
+						event), ==, message);
+			g_free(message);
+		}
+	}
+	g_assert(found);
+	for (gint i = 0; i < EVENTS; ++i) {
+		g_object_unref(events[i]);
+	}
+}
+
+/* Cached outputs are kept inline, a large output is allocated */
+void
+test_009(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLoggingEvent *event = event_new("%s", "cached");
+	g_assert(event);
+	const gchar *small = g_intern_static_string("test:small");
+	const gchar *large = g_intern_static_string("test:large");
+	const gchar *empty = g_intern_static_string("test:empty");
+	gchar buffer[1024];
+	memset(buffer, 'x', sizeof(buffer));
+	buffer[7] = '\0';
+	log4g_logging_event_set_cached_output(event, small, "small\n", 6);
+	log4g_logging_event_set_cached_output(event, large, buffer,
+			sizeof(buffer));
+	log4g_logging_event_set_cached_output(event, empty, "", 0);
+	/* only the first output for a fingerprint is kept */
+	log4g_logging_event_set_cached_output(event, small, "other\n", 6);
+	gsize length = 0;
+	const gchar *output =
+		log4g_logging_event_get_cached_output(event, small, &length);
+	g_assert(output);
+	g_assert_cmpuint(length, ==, 6);
+	g_assert(!memcmp(output, "small\n", 6));
+	output = log4g_logging_event_get_cached_output(event, large, &length);
+	g_assert(output);
+	g_assert_cmpuint(length, ==, sizeof(buffer));
+	g_assert(!memcmp(output, buffer, sizeof(buffer)));
+	output = log4g_logging_event_get_cached_output(event, empty, &length);
+	g_assert(output);
+	g_assert_cmpuint(length, ==, 0);
+	g_object_unref(event);
+	/* a recycled event starts with an empty cache */
+	event = event_new("%s", "cached");
+	g_assert(event);
+	g_assert(!log4g_logging_event_get_cached_output(event, small,
+				&length));
+	g_assert(!log4g_logging_event_get_cached_output(event, large,
+				&length));
+	g_object_unref(event);
+}
+
+int
+main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
+	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, NULL);
+	g_test_add(CLASS"/005", gpointer, NULL, NULL, test_005, NULL);
+	g_test_add(CLASS"/006", gpointer, NULL, NULL, test_006, NULL);
+	g_test_add(CLASS"/007", gpointer, NULL, NULL, test_007, NULL);
+	g_test_add(CLASS"/008", gpointer, NULL, NULL, test_008, NULL);
+	g_test_add(CLASS"/009", gpointer, NULL, NULL, test_009, NULL);
+	return g_test_run();
+}
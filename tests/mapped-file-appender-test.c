@@ -0,0 +1,260 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tests for Log4gMappedFileAppender
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "log4g/log4g.h"
+#include "log4g/module.h"
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define CLASS "/log4g/appender/MappedFileAppender"
+
+#define THREADS (4)
+
+#define EVENTS (2000)
+
+static void
+append_(Log4gAppender *appender, const gchar *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			log4g_level_INFO(), "function", "file.c", "42",
+			format, ap);
+	va_end(ap);
+	g_assert(event);
+	log4g_appender_do_append(appender, event);
+	g_object_unref(event);
+}
+
+static Log4gAppender *
+appender_new_with_layout(const gchar *file, gboolean append,
+		const gchar *name)
+{
+	GType type = g_type_from_name(name);
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gMappedFileAppender");
+	g_assert(type);
+	/* small segments so that events span several of them */
+	Log4gAppender *appender = g_object_new(type,
+			"file", file,
+			"append", append,
+			"segment-size", 4096,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	return appender;
+}
+
+static Log4gAppender *
+appender_new(const gchar *file, gboolean append)
+{
+	return appender_new_with_layout(file, append, "Log4gSimpleLayout");
+}
+
+static gpointer
+log_(gpointer data)
+{
+	static gint next = 0;
+	gint thread = g_atomic_int_add(&next, 1);
+	for (gint i = 0; i < EVENTS; ++i) {
+		append_(data, "thread %d event %d", thread, i);
+	}
+	return NULL;
+}
+
+void
+test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender =
+		appender_new("tests/mapped-file-appender-test.txt", FALSE);
+	GThread *threads[THREADS];
+	for (guint i = 0; i < G_N_ELEMENTS(threads); ++i) {
+		threads[i] = g_thread_new("mapped-file-appender-test", log_,
+				appender);
+		g_assert(threads[i]);
+	}
+	for (guint i = 0; i < G_N_ELEMENTS(threads); ++i) {
+		g_thread_join(threads[i]);
+	}
+	g_object_unref(appender);
+	gchar *contents = NULL;
+	gsize length = 0;
+	g_assert(g_file_get_contents("tests/mapped-file-appender-test.txt",
+				&contents, &length, NULL));
+	/* the file is truncated to the data written */
+	g_assert_cmpuint(strlen(contents), ==, length);
+	gchar **lines = g_strsplit(contents, "\n", -1);
+	g_assert_cmpuint(g_strv_length(lines), ==, THREADS * EVENTS + 1);
+	g_assert_cmpstr(lines[THREADS * EVENTS], ==, "");
+	/* events are not interleaved & each thread's events are in order */
+	gint expected[THREADS] = { 0 };
+	for (guint i = 0; i < THREADS * EVENTS; ++i) {
+		gint thread, event;
+		g_assert_cmpint(sscanf(lines[i], "INFO - thread %d event %d",
+					&thread, &event), ==, 2);
+		g_assert_cmpint(thread, >=, 0);
+		g_assert_cmpint(thread, <, THREADS);
+		g_assert_cmpint(event, ==, expected[thread]++);
+	}
+	g_strfreev(lines);
+	g_free(contents);
+}
+
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/mapped-file-appender-test-002.txt";
+	Log4gAppender *appender = appender_new(file, FALSE);
+	append_(appender, "message 1");
+	g_object_unref(appender);
+	appender = appender_new(file, TRUE);
+	append_(appender, "message 2");
+	/* an event larger than a segment */
+	gchar *large = g_strnfill(10000, 'x');
+	append_(appender, "%s", large);
+	g_object_unref(appender);
+	gchar *contents = NULL;
+	g_assert(g_file_get_contents(file, &contents, NULL, NULL));
+	gchar *expected = g_strdup_printf(
+			"INFO - message 1\nINFO - message 2\nINFO - %s\n",
+			large);
+	g_assert_cmpstr(contents, ==, expected);
+	g_free(expected);
+	g_free(contents);
+	g_free(large);
+}
+
+/* The file is trimmed after a crash */
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/mapped-file-appender-test-003.txt";
+	const gchar *marker = "tests/mapped-file-appender-test-003.txt.open";
+	pid_t pid = fork();
+	g_assert_cmpint(pid, >=, 0);
+	if (!pid) {
+		/* exit without closing the appender */
+		Log4gAppender *appender = appender_new(file, FALSE);
+		append_(appender, "message 1");
+		_exit(EXIT_SUCCESS);
+	}
+	gint status;
+	g_assert_cmpint(waitpid(pid, &status, 0), ==, pid);
+	g_assert(WIFEXITED(status));
+	g_assert(g_file_test(marker, G_FILE_TEST_EXISTS));
+	/* the rest of the segment was left in the file */
+	gchar *contents = NULL;
+	gsize length = 0;
+	g_assert(g_file_get_contents(file, &contents, &length, NULL));
+	g_assert_cmpuint(length, >, strlen("INFO - message 1\n"));
+	g_assert_cmpstr(contents, ==, "INFO - message 1\n");
+	g_free(contents);
+	Log4gAppender *appender = appender_new(file, TRUE);
+	append_(appender, "message 2");
+	g_object_unref(appender);
+	g_assert(!g_file_test(marker, G_FILE_TEST_EXISTS));
+	g_assert(g_file_get_contents(file, &contents, &length, NULL));
+	g_assert_cmpuint(length, ==, strlen(contents));
+	g_assert_cmpstr(contents, ==,
+			"INFO - message 1\nINFO - message 2\n");
+	g_free(contents);
+}
+
+/* A layout whose output ends with a zero byte */
+static void
+format_to(G_GNUC_UNUSED Log4gLayout *base, Log4gLoggingEvent *event,
+		GString *string)
+{
+	g_string_append(string,
+			log4g_logging_event_get_rendered_message(event));
+	g_string_append_c(string, '\0');
+}
+
+static void
+class_init(gpointer klass, G_GNUC_UNUSED gpointer data)
+{
+	LOG4G_LAYOUT_CLASS(klass)->format_to = format_to;
+}
+
+/* Output that ends with a zero byte is not trimmed after a clean close */
+void
+test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/mapped-file-appender-test-004.txt";
+	GType parent = g_type_from_name("Log4gSimpleLayout");
+	g_assert(parent);
+	GTypeQuery query;
+	g_type_query(parent, &query);
+	GType type = g_type_register_static_simple(parent,
+			"Log4gTestZeroLayout", query.class_size, class_init,
+			query.instance_size, NULL, 0);
+	g_assert(type);
+	Log4gAppender *appender =
+		appender_new_with_layout(file, FALSE, "Log4gTestZeroLayout");
+	append_(appender, "message 1");
+	g_object_unref(appender);
+	appender = appender_new_with_layout(file, TRUE, "Log4gTestZeroLayout");
+	append_(appender, "message 2");
+	g_object_unref(appender);
+	/* reopen without writing */
+	appender = appender_new_with_layout(file, TRUE, "Log4gTestZeroLayout");
+	g_object_unref(appender);
+	gchar *contents = NULL;
+	gsize length = 0;
+	g_assert(g_file_get_contents(file, &contents, &length, NULL));
+	g_assert_cmpuint(length, ==, sizeof("message 1") * 2);
+	g_assert(!memcmp(contents, "message 1\0message 2\0", length));
+	g_free(contents);
+}
+
+int
+main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+	g_type_init();
+#endif
+	GTypeModule *module =
+		log4g_module_new("modules/layouts/liblog4g-layouts.la");
+	g_assert(module);
+	g_assert(g_type_module_use(module));
+	g_type_module_unuse(module);
+	module = log4g_module_new("modules/appenders/liblog4g-appenders.la");
+	g_assert(module);
+	g_assert(g_type_module_use(module));
+	g_type_module_unuse(module);
+	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
+	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, NULL);
+	return g_test_run();
+}
@@ -38,6 +38,65 @@ test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_assert(!string);
 }
 
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GQuark foo = log4g_mdc_key_register("foo");
+	GQuark qux = log4g_mdc_key_register("qux");
+	g_assert(!log4g_mdc_get_snapshot());
+	log4g_mdc_put("foo", "bar");
+	Log4gMDCMap *s1 = log4g_mdc_get_snapshot();
+	g_assert(s1);
+	/* snapshots of an unchanged MDC are shared */
+	Log4gMDCMap *s2 = log4g_mdc_get_snapshot();
+	g_assert(s1 == s2);
+	log4g_mdc_map_unref(s2);
+	log4g_mdc_put("foo", "baz");
+	log4g_mdc_put("qux", "quux");
+	g_assert_cmpstr(log4g_mdc_map_lookup(s1, foo), ==, "bar");
+	g_assert(!log4g_mdc_map_lookup(s1, qux));
+	g_assert_cmpstr(log4g_mdc_get("foo"), ==, "baz");
+	s2 = log4g_mdc_get_snapshot();
+	g_assert(s1 != s2);
+	log4g_mdc_remove("foo");
+	g_assert_cmpstr(log4g_mdc_map_lookup(s2, foo), ==, "baz");
+	g_assert_cmpstr(log4g_mdc_map_lookup(s2, qux), ==, "quux");
+	g_assert(!log4g_mdc_get("foo"));
+	log4g_mdc_map_unref(s1);
+	log4g_mdc_map_unref(s2);
+	log4g_mdc_remove("qux");
+	g_assert(!log4g_mdc_get_snapshot());
+}
+
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GQuark foo = log4g_mdc_key_register("foo");
+	g_assert(foo);
+	g_assert(foo == log4g_mdc_key_register("foo"));
+	GQuark bar = log4g_mdc_key_register("bar");
+	g_assert(bar && bar != foo);
+	log4g_mdc_put_by_id(foo, "%d", 42);
+	const gchar *value = "a value that is too long to be stored inline";
+	log4g_mdc_put("bar", "%s", value);
+	g_assert_cmpstr(log4g_mdc_get("foo"), ==, "42");
+	g_assert_cmpstr(log4g_mdc_get_by_id(bar), ==, value);
+	const Log4gMDCMap *map = log4g_mdc_get_map();
+	g_assert_cmpuint(log4g_mdc_map_get_size(map), ==, 2);
+	/* entries are sorted by key identifier */
+	guint first = (foo < bar ? 0 : 1);
+	g_assert_cmpstr(log4g_mdc_map_get_key(map, first), ==, "foo");
+	g_assert_cmpstr(log4g_mdc_map_get_value(map, first), ==, "42");
+	g_assert_cmpstr(log4g_mdc_map_get_key(map, 1 - first), ==, "bar");
+	const GHashTable *context = log4g_mdc_get_context();
+	g_assert_cmpstr(g_hash_table_lookup((GHashTable *)context, "foo"), ==,
+			"42");
+	log4g_mdc_remove("foo");
+	g_assert(!log4g_mdc_get_by_id(foo));
+	log4g_mdc_remove("bar");
+	g_assert(!log4g_mdc_map_get_size(log4g_mdc_get_map()));
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -46,5 +105,7 @@ main(int argc, char *argv[])
 	g_type_init();
 #endif
 	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
 	return g_test_run();
 }
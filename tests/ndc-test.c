@@ -100,6 +100,38 @@ test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_assert_cmpstr(log4g_ndc_get(), ==, "foo bar baz");
 }
 
+void
+test_005(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	g_assert(!log4g_ndc_get_snapshot());
+	log4g_ndc_push("foo");
+	log4g_ndc_push("bar");
+	Log4gNDCFrame *s1 = log4g_ndc_get_snapshot();
+	g_assert(s1);
+	log4g_ndc_push("baz");
+	Log4gNDCFrame *s2 = log4g_ndc_get_snapshot();
+	g_assert_cmpstr(log4g_ndc_get(), ==, "foo bar baz");
+	/* frames are not changed by popping the context */
+	log4g_ndc_clear();
+	g_assert(!log4g_ndc_get());
+	g_assert_cmpstr(log4g_ndc_frame_get_message(s1), ==, "bar");
+	g_assert_cmpstr(log4g_ndc_frame_get_string(s1), ==, "foo bar");
+	g_assert_cmpstr(log4g_ndc_frame_get_string(s2), ==, "foo bar baz");
+	log4g_ndc_frame_unref(s1);
+	log4g_ndc_frame_unref(s2);
+	for (guint i = 0; i < 1000; ++i) {
+		log4g_ndc_push("%u", i);
+	}
+	g_assert_cmpuint(log4g_ndc_size(), ==, 1000);
+	s1 = log4g_ndc_get_snapshot();
+	log4g_ndc_set_max_depth(0);
+	g_assert_cmpuint(log4g_ndc_size(), ==, 0);
+	const gchar *string = log4g_ndc_frame_get_string(s1);
+	g_assert(g_str_has_prefix(string, "0 1 2 "));
+	g_assert(g_str_has_suffix(string, " 998 999"));
+	log4g_ndc_frame_unref(s1);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -111,5 +143,6 @@ main(int argc, char *argv[])
 	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, teardown);
 	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, teardown);
 	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, teardown);
+	g_test_add(CLASS"/005", gpointer, NULL, NULL, test_005, teardown);
 	return g_test_run();
 }
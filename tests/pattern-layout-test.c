@@ -22,8 +22,11 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include "log4g/helpers/thread.h"
 #include "log4g/log4g.h"
 #include "log4g/module.h"
+#include <string.h>
+#include <time.h>
 
 #define CLASS "/log4g/layout/PatternLayout"
 
@@ -66,6 +69,177 @@ test_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(layout);
 }
 
+static Log4gLayout *
+layout_new(const gchar *pattern, gboolean compiled)
+{
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type,
+			"conversion-pattern", pattern,
+			"compiled", compiled,
+			NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	return layout;
+}
+
+/* The compiled pattern formats exactly like the converter chain */
+void
+test_002(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	static const gchar *patterns[] = {
+		"%d %-5p [%t] %c{2} - %m%n",
+		"[%d{%H:%M:%S}] [%.7c{2}] %M(%F:%L) [%.5m] [%20p] [%-20p] "
+			"[%r] [%X{foo}] [%X{none}] [%8X{none}] [%x] %m%n",
+		"100%% literal %%%% text%n",
+		"%c %c{1} %c{9} %l%n",
+		"[%t] [%i] [%-8T] [%3i]%n",
+	};
+	for (guint i = 0; i < G_N_ELEMENTS(patterns); ++i) {
+		Log4gLayout *chain = layout_new(patterns[i], FALSE);
+		Log4gLayout *compiled = layout_new(patterns[i], TRUE);
+		/* don't let the compiled layout reuse the chain's output */
+		log4g_layout_set_fingerprint(chain, NULL);
+		GString *expected = g_string_new("prefix ");
+		GString *actual = g_string_new("prefix ");
+		log4g_layout_format_to(chain, fixture->event, expected);
+		log4g_layout_format_to(compiled, fixture->event, actual);
+		g_assert_cmpstr(actual->str, ==, expected->str);
+		g_assert_cmpstr(log4g_layout_format(compiled, fixture->event),
+				==, expected->str + strlen("prefix "));
+		g_string_free(expected, TRUE);
+		g_string_free(actual, TRUE);
+		g_object_unref(chain);
+		g_object_unref(compiled);
+	}
+}
+
+/* Sub-second date fields and the per-second cache */
+void
+test_003(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const GTimeVal *tv =
+		log4g_logging_event_get_time_stamp(fixture->event);
+	g_assert(tv);
+	struct tm tm;
+	time_t time = tv->tv_sec;
+	g_assert(localtime_r(&time, &tm));
+	gchar prefix[64];
+	g_assert(strftime(prefix, sizeof prefix, "%Y-%m-%d %H:%M:%S", &tm));
+	gint64 ns = log4g_logging_event_get_time_stamp_ns(fixture->event);
+	gchar *expected = g_strdup_printf("[%s.%03ld|%06ld|%09ld%%]\n",
+			prefix, tv->tv_usec / 1000, tv->tv_usec,
+			(glong)(ns % 1000000000));
+	for (gint compiled = 0; compiled < 2; ++compiled) {
+		Log4gLayout *layout = layout_new(
+				"[%d{%Y-%m-%d %H:%M:%S.%3N|%6N|%9N%%}]%n",
+				compiled);
+		/* the second call is served from the cache */
+		for (gint i = 0; i < 2; ++i) {
+			g_assert_cmpstr(log4g_layout_format(layout,
+						fixture->event), ==, expected);
+		}
+		g_object_unref(layout);
+	}
+	g_free(expected);
+}
+
+/* Thread numbers & operating system thread identifiers */
+void
+test_004(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	gchar *expected = g_strdup_printf("%s %u %d\n",
+			log4g_thread_get_name(), log4g_thread_get_id(),
+			log4g_thread_get_tid());
+	for (gint compiled = 0; compiled < 2; ++compiled) {
+		Log4gLayout *layout = layout_new("%t %i %T%n", compiled);
+		g_assert_cmpstr(log4g_layout_format(layout, fixture->event),
+				==, expected);
+		g_object_unref(layout);
+	}
+	g_free(expected);
+}
+
+/* Layouts with the same pattern share their output */
+void
+test_005(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *fingerprint =
+		g_intern_string("Log4gPatternLayout:[%c] %m%n");
+	gsize length;
+	Log4gLayout *first = layout_new("[%c] %m%n", TRUE);
+	GString *string = g_string_new(NULL);
+	log4g_layout_format_to(first, fixture->event, string);
+	g_assert_cmpstr(string->str, ==, "[org.gnome.test] test message\n");
+	/* a single layout does not cache its output */
+	g_assert(!log4g_logging_event_get_cached_output(fixture->event,
+				fingerprint, &length));
+	Log4gLayout *second = layout_new("[%c] %m%n", FALSE);
+	Log4gLayout *other = layout_new("%m%n", TRUE);
+	g_string_set_size(string, 0);
+	log4g_layout_format_to(first, fixture->event, string);
+	const gchar *output = log4g_logging_event_get_cached_output(
+			fixture->event, fingerprint, &length);
+	g_assert(output);
+	g_assert_cmpuint(length, ==, string->len);
+	g_assert(!memcmp(output, string->str, length));
+	g_string_set_size(string, 0);
+	log4g_layout_format_to(second, fixture->event, string);
+	g_assert_cmpstr(string->str, ==, "[org.gnome.test] test message\n");
+	g_string_set_size(string, 0);
+	log4g_layout_format_to(other, fixture->event, string);
+	g_assert_cmpstr(string->str, ==, "test message\n");
+	g_assert(!log4g_logging_event_get_cached_output(fixture->event,
+				g_intern_string("Log4gPatternLayout:%m%n"),
+				&length));
+	/* changing the pattern changes the fingerprint */
+	g_object_set(second, "conversion-pattern", "%m%n", NULL);
+	g_string_set_size(string, 0);
+	log4g_layout_format_to(second, fixture->event, string);
+	g_assert_cmpstr(string->str, ==, "test message\n");
+	g_assert(log4g_logging_event_get_cached_output(fixture->event,
+				g_intern_string("Log4gPatternLayout:%m%n"),
+				&length));
+	g_string_free(string, TRUE);
+	g_object_unref(first);
+	g_object_unref(second);
+	g_object_unref(other);
+}
+
+#define PERF_PATTERN "%d %-5p [%t] %c{2} - %m%n"
+
+#define PERF_EVENTS (1000000)
+
+static gdouble
+perf_format(Log4gLayout *layout, Log4gLoggingEvent *event)
+{
+	GString *string = g_string_sized_new(256);
+	g_test_timer_start();
+	for (gint i = 0; i < PERF_EVENTS; ++i) {
+		g_string_set_size(string, 0);
+		log4g_layout_format_to(layout, event, string);
+	}
+	gdouble e = g_test_timer_elapsed();
+	g_string_free(string, TRUE);
+	return e;
+}
+
+/* Compare the converter chain with the compiled pattern */
+void
+perf_001(Fixture *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gLayout *layout = layout_new(PERF_PATTERN, FALSE);
+	gdouble e = perf_format(layout, fixture->event);
+	g_test_minimized_result(e, "converter chain, cost=%.2fns/event",
+			(e / PERF_EVENTS) * 1e9);
+	g_object_unref(layout);
+	layout = layout_new(PERF_PATTERN, TRUE);
+	e = perf_format(layout, fixture->event);
+	g_test_minimized_result(e, "compiled pattern, cost=%.2fns/event",
+			(e / PERF_EVENTS) * 1e9);
+	g_object_unref(layout);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -79,5 +253,13 @@ main(int argc, char *argv[])
 	g_assert(g_type_module_use(module));
 	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", Fixture, NULL, setup, test_001, teardown);
+	g_test_add(CLASS"/002", Fixture, NULL, setup, test_002, teardown);
+	g_test_add(CLASS"/003", Fixture, NULL, setup, test_003, teardown);
+	g_test_add(CLASS"/004", Fixture, NULL, setup, test_004, teardown);
+	g_test_add(CLASS"/005", Fixture, NULL, setup, test_005, teardown);
+	if (g_test_perf()) {
+		g_test_add(CLASS"/perf/001", Fixture, NULL, setup, perf_001,
+				teardown);
+	}
 	return g_test_run();
 }
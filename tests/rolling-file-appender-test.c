@@ -24,6 +24,8 @@
 #endif
 #include "log4g/log4g.h"
 #include "log4g/module.h"
+#include <glib/gstdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #define CLASS "/log4g/appender/RollingFileAppender"
@@ -62,6 +64,365 @@ test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(appender);
 }
 
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GType type = g_type_from_name("Log4gSimpleLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gRollingFileAppender");
+	g_assert(type);
+	g_unlink("tests/rolling-file-appender-test-002.txt.1");
+	Log4gAppender *appender = g_object_new(type,
+			"file", "tests/rolling-file-appender-test-002.txt",
+			"append", FALSE,
+			"max-backup-index", 1,
+			"maximum-file-size", 100,
+			"io-uring", TRUE,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	for (gint i = 0; i < 10; ++i) {
+		Log4gLoggingEvent *event = log4g_logging_event_new(
+				"org.gnome.test", log4g_level_DEBUG(),
+				__func__, __FILE__, G_STRINGIFY(__LINE__),
+				"test message", ap);
+		g_assert(event);
+		log4g_appender_do_append(appender, event);
+		g_object_unref(event);
+	}
+	g_object_unref(appender);
+	/* bytes queued for the completion thread count towards the size */
+	g_assert(g_file_test("tests/rolling-file-appender-test-002.txt.1",
+				G_FILE_TEST_EXISTS));
+}
+
+static void
+append_(Log4gAppender *appender, const gchar *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			log4g_level_DEBUG(), __func__, __FILE__,
+			G_STRINGIFY(__LINE__), format, ap);
+	va_end(ap);
+	g_assert(event);
+	log4g_appender_do_append(appender, event);
+	g_object_unref(event);
+}
+
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/rolling-file-appender-test-003.txt";
+	GType type = g_type_from_name("Log4gSimpleLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gRollingFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", file,
+			"append", FALSE,
+			"max-backup-index", 3,
+			"maximum-file-size", 30,
+			"async-roll-over", TRUE,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	for (gint i = 0; i < 21; ++i) {
+		append_(appender, "message %d", i);
+	}
+	/* closing waits for queued roll-overs */
+	g_object_unref(appender);
+	/* backups are in order, the newest events are in the log file */
+	GString *all = g_string_new(NULL);
+	for (gint i = 3; i >= 0; --i) {
+		gchar *name = (i ? g_strdup_printf("%s.%d", file, i)
+				: g_strdup(file));
+		gchar *contents = NULL;
+		g_assert(g_file_get_contents(name, &contents, NULL, NULL));
+		g_assert(*contents);
+		g_string_append(all, contents);
+		g_free(contents);
+		g_free(name);
+	}
+	gchar **lines = g_strsplit(all->str, "\n", -1);
+	guint n = g_strv_length(lines) - 1;
+	g_assert_cmpuint(n, >, 4);
+	for (guint i = 0; i < n; ++i) {
+		gchar *expected = g_strdup_printf("DEBUG - message %u",
+				21 - n + i);
+		g_assert_cmpstr(lines[i], ==, expected);
+		g_free(expected);
+	}
+	g_strfreev(lines);
+	g_string_free(all, TRUE);
+	/* no temporary files are left behind */
+	GDir *dir = g_dir_open("tests", 0, NULL);
+	g_assert(dir);
+	const gchar *name;
+	while ((name = g_dir_read_name(dir))) {
+		g_assert(!g_str_has_suffix(name, ".rolling"));
+	}
+	g_dir_close(dir);
+}
+
+static Log4gLoggingEvent *
+event_new_(Log4gLevel *level, const gchar *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			level, __func__, __FILE__, G_STRINGIFY(__LINE__),
+			format, ap);
+	va_end(ap);
+	g_assert(event);
+	return event;
+}
+
+#define BATCH_EVENTS (8)
+
+/* A batch is written exactly like the same events appended one at a time,
+ * and is checked against the threshold per event */
+void
+test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *names[] = {
+		"tests/rolling-file-appender-test-single.txt",
+		"tests/rolling-file-appender-test-batch.txt"
+	};
+	Log4gLoggingEvent *events[BATCH_EVENTS];
+	for (gint i = 0; i < BATCH_EVENTS; ++i) {
+		events[i] = event_new_((i % 2 ? log4g_level_INFO()
+					: log4g_level_DEBUG()), "message %d", i);
+	}
+	for (gint i = 0; i < 2; ++i) {
+		GType type = g_type_from_name("Log4gSimpleLayout");
+		g_assert(type);
+		Log4gLayout *layout = g_object_new(type, NULL);
+		g_assert(layout);
+		log4g_layout_activate_options(layout);
+		type = g_type_from_name("Log4gRollingFileAppender");
+		g_assert(type);
+		Log4gAppender *appender = g_object_new(type,
+				"file", names[i],
+				"append", FALSE,
+				"max-backup-index", 1,
+				"maximum-file-size", 4096,
+				"threshold", "INFO",
+				NULL);
+		g_assert(appender);
+		log4g_appender_set_layout(appender, layout);
+		log4g_appender_activate_options(appender);
+		g_object_unref(layout);
+		if (!i) {
+			for (gint j = 0; j < BATCH_EVENTS; ++j) {
+				log4g_appender_do_append(appender, events[j]);
+			}
+		} else {
+			log4g_appender_do_append_batch(appender, events, 0);
+			log4g_appender_do_append_batch(appender, events,
+					BATCH_EVENTS);
+		}
+		g_object_unref(appender);
+	}
+	for (gint i = 0; i < BATCH_EVENTS; ++i) {
+		g_object_unref(events[i]);
+	}
+	gchar *single = NULL;
+	gchar *batch = NULL;
+	g_assert(g_file_get_contents(names[0], &single, NULL, NULL));
+	g_assert(g_file_get_contents(names[1], &batch, NULL, NULL));
+	g_assert_cmpstr(single, ==,
+			"INFO - message 1\nINFO - message 3\n"
+			"INFO - message 5\nINFO - message 7\n");
+	g_assert_cmpstr(batch, ==, single);
+	g_free(single);
+	g_free(batch);
+}
+
+/* Binary output is counted by length, not up to the first nul byte */
+void
+test_005(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/rolling-file-appender-test-005.txt";
+	gchar *backup = g_strdup_printf("%s.1", file);
+	g_unlink(backup);
+	GType type = g_type_from_name("Log4gBinaryLayout");
+	g_assert(type);
+	Log4gLoggingEvent *event = event_new_(log4g_level_INFO(),
+			"binary message");
+	/* an identical layout formats the expected record */
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	GString *expected = g_string_new(log4g_layout_get_header(layout));
+	log4g_layout_format_to(layout, event, expected);
+	g_object_unref(layout);
+	g_assert_cmpuint(strlen(expected->str), <, expected->len);
+	layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gRollingFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", file,
+			"append", FALSE,
+			"max-backup-index", 1,
+			"maximum-file-size", (gulong)expected->len,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	log4g_appender_do_append(appender, event);
+	g_object_unref(appender);
+	g_object_unref(event);
+	/* the whole record was written & counted, so the file rolled over */
+	gchar *contents = NULL;
+	gsize length = 0;
+	g_assert(g_file_get_contents(backup, &contents, &length, NULL));
+	g_assert_cmpuint(length, ==, expected->len);
+	g_assert(!memcmp(contents, expected->str, length));
+	g_free(contents);
+	g_string_free(expected, TRUE);
+	g_free(backup);
+}
+
+/* Empty output is not written and does not count towards the size */
+void
+test_006(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/rolling-file-appender-test-006.txt";
+	gchar *backup = g_strdup_printf("%s.1", file);
+	g_unlink(backup);
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, "conversion-pattern", "%m",
+			NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gRollingFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", file,
+			"append", FALSE,
+			"max-backup-index", 1,
+			"maximum-file-size", (gulong)1,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	Log4gLoggingEvent *event = event_new_(log4g_level_INFO(), "");
+	for (gint i = 0; i < 3; ++i) {
+		log4g_appender_do_append(appender, event);
+	}
+	g_object_unref(event);
+	g_object_unref(appender);
+	gchar *contents = NULL;
+	g_assert(g_file_get_contents(file, &contents, NULL, NULL));
+	g_assert_cmpstr(contents, ==, "");
+	g_free(contents);
+	g_assert(!g_file_test(backup, G_FILE_TEST_EXISTS));
+	g_free(backup);
+}
+
+
+/* Check if a thread named 'name' is running, or if it cannot be known */
+static gboolean
+thread_running_(const gchar *name)
+{
+	GDir *dir = g_dir_open("/proc/self/task", 0, NULL);
+	if (!dir) {
+		return TRUE;
+	}
+	gboolean running = FALSE;
+	const gchar *task;
+	while (!running && (task = g_dir_read_name(dir))) {
+		gchar *file = g_strdup_printf("/proc/self/task/%s/comm",
+				task);
+		gchar *comm = NULL;
+		if (g_file_get_contents(file, &comm, NULL, NULL)) {
+			running = !strcmp(g_strchomp(comm), name);
+			g_free(comm);
+		}
+		g_free(file);
+	}
+	g_dir_close(dir);
+	return running;
+}
+
+/* Roll-overs remain asynchronous after the appender is closed & reopened */
+void
+test_007(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *file = "tests/rolling-file-appender-test-007.txt";
+	GType type = g_type_from_name("Log4gSimpleLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type, NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gRollingFileAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type,
+			"file", file,
+			"append", FALSE,
+			"max-backup-index", 3,
+			"maximum-file-size", 30,
+			"async-roll-over", TRUE,
+			NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	for (gint i = 0; i < 4; ++i) {
+		append_(appender, "message %d", i);
+	}
+	log4g_appender_close(appender);
+	g_assert(!thread_running_("log4g-roll-over"));
+	log4g_appender_set_closed(appender, FALSE);
+	log4g_appender_activate_options(appender);
+	for (gint i = 4; i < 8; ++i) {
+		append_(appender, "message %d", i);
+	}
+	/* the worker was started again */
+	g_assert(thread_running_("log4g-roll-over"));
+	g_object_unref(appender);
+	/* the reopened log file was appended to & rolled over in order */
+	GString *all = g_string_new(NULL);
+	for (gint i = 3; i >= 0; --i) {
+		gchar *name = (i ? g_strdup_printf("%s.%d", file, i)
+				: g_strdup(file));
+		gchar *contents = NULL;
+		if (g_file_get_contents(name, &contents, NULL, NULL)) {
+			g_string_append(all, contents);
+			g_free(contents);
+		}
+		g_free(name);
+	}
+	gchar **lines = g_strsplit(all->str, "\n", -1);
+	guint n = g_strv_length(lines) - 1;
+	g_assert_cmpuint(n, >, 4);
+	for (guint i = 0; i < n; ++i) {
+		gchar *expected = g_strdup_printf("DEBUG - message %u",
+				8 - n + i);
+		g_assert_cmpstr(lines[i], ==, expected);
+		g_free(expected);
+	}
+	g_strfreev(lines);
+	g_string_free(all, TRUE);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -79,5 +440,11 @@ main(int argc, char *argv[])
 	g_assert(g_type_module_use(module));
 	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
+	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, NULL);
+	g_test_add(CLASS"/005", gpointer, NULL, NULL, test_005, NULL);
+	g_test_add(CLASS"/006", gpointer, NULL, NULL, test_006, NULL);
+	g_test_add(CLASS"/007", gpointer, NULL, NULL, test_007, NULL);
 	return g_test_run();
 }
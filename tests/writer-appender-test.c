@@ -22,6 +22,8 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include "log4g/helpers/appender-attachable-impl.h"
+#include "log4g/interface/appender-attachable.h"
 #include "log4g/log4g.h"
 #include "log4g/module.h"
 #include <stdio.h>
@@ -57,6 +59,297 @@ test_001(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
 	g_object_unref(appender);
 }
 
+#define THREADS (4)
+
+#define EVENTS (1000)
+
+static gpointer
+append_(gpointer appender)
+{
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	for (gint i = 0; i < EVENTS; ++i) {
+		Log4gLoggingEvent *event = log4g_logging_event_new(
+				"org.gnome.test", log4g_level_INFO(),
+				__func__, __FILE__, G_STRINGIFY(__LINE__),
+				"concurrent message", ap);
+		g_assert(event);
+		log4g_appender_do_append(appender, event);
+		g_object_unref(event);
+	}
+	return NULL;
+}
+
+/* Events appended from several threads are formatted concurrently but
+ * written whole */
+void
+test_002(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	FILE *file = fopen("tests/writer-appender-test.txt", "w");
+	g_assert(file);
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type,
+			"conversion-pattern", "%-5p %c{2} - %m%n", NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gWriterAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type, "writer", file, NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	GThread *threads[THREADS];
+	for (gint i = 0; i < THREADS; ++i) {
+		threads[i] = g_thread_new(NULL, append_, appender);
+	}
+	for (gint i = 0; i < THREADS; ++i) {
+		g_thread_join(threads[i]);
+	}
+	g_object_unref(appender);
+	gchar *contents;
+	g_assert(g_file_get_contents("tests/writer-appender-test.txt",
+				&contents, NULL, NULL));
+	gchar **lines = g_strsplit(contents, "\n", -1);
+	guint n = g_strv_length(lines);
+	g_assert_cmpuint(n, ==, THREADS * EVENTS + 1);
+	for (guint i = 0; i < n - 1; ++i) {
+		g_assert_cmpstr(lines[i], ==,
+				"INFO  gnome.test - concurrent message");
+	}
+	g_assert_cmpstr(lines[n - 1], ==, "");
+	g_strfreev(lines);
+	g_free(contents);
+}
+
+static Log4gAppender *
+batch_appender_new(const gchar *name)
+{
+	FILE *file = fopen(name, "w");
+	g_assert(file);
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	Log4gLayout *layout = g_object_new(type,
+			"conversion-pattern", "%-5p %c{2} - %m%n", NULL);
+	g_assert(layout);
+	log4g_layout_activate_options(layout);
+	type = g_type_from_name("Log4gWriterAppender");
+	g_assert(type);
+	Log4gAppender *appender = g_object_new(type, "writer", file, NULL);
+	g_assert(appender);
+	log4g_appender_set_layout(appender, layout);
+	log4g_appender_activate_options(appender);
+	g_object_unref(layout);
+	return appender;
+}
+
+static Log4gLoggingEvent *
+batch_event_new(Log4gLevel *level, const gchar *message)
+{
+	va_list ap;
+	memset(&ap, 0, sizeof ap);
+	Log4gLoggingEvent *event = log4g_logging_event_new("org.gnome.test",
+			level, __func__, __FILE__, G_STRINGIFY(__LINE__),
+			message, ap);
+	g_assert(event);
+	return event;
+}
+
+#define BATCH_EVENTS (5)
+
+static void
+batch_events_new(Log4gLoggingEvent **events)
+{
+	events[0] = batch_event_new(log4g_level_DEBUG(), "below threshold");
+	events[1] = batch_event_new(log4g_level_INFO(), "first message");
+	events[2] = batch_event_new(log4g_level_WARN(), "secret message");
+	events[3] = batch_event_new(log4g_level_ERROR(), "second message");
+	events[4] = batch_event_new(log4g_level_INFO(), "third message");
+}
+
+static void
+batch_events_free(Log4gLoggingEvent **events)
+{
+	for (gint i = 0; i < BATCH_EVENTS; ++i) {
+		g_object_unref(events[i]);
+	}
+}
+
+static gchar *
+contents_(const gchar *name)
+{
+	gchar *contents;
+	g_assert(g_file_get_contents(name, &contents, NULL, NULL));
+	return contents;
+}
+
+/* The threshold & filters are applied to each event of a batch, and a
+ * batch is written exactly like the same events appended one at a time */
+void
+test_003(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *names[] = {
+		"tests/writer-appender-test-single.txt",
+		"tests/writer-appender-test-batch.txt"
+	};
+	Log4gLoggingEvent *events[BATCH_EVENTS];
+	batch_events_new(events);
+	GType type = g_type_from_name("Log4gStringMatchFilter");
+	g_assert(type);
+	for (gint i = 0; i < 2; ++i) {
+		Log4gFilter *filter = g_object_new(type,
+				"string-to-match", "secret",
+				"accept-on-match", FALSE,
+				NULL);
+		g_assert(filter);
+		log4g_filter_activate_options(filter);
+		Log4gAppender *appender = batch_appender_new(names[i]);
+		log4g_appender_set_threshold(appender, "INFO");
+		log4g_appender_add_filter(appender, filter);
+		g_object_unref(filter);
+		if (!i) {
+			for (gint j = 0; j < BATCH_EVENTS; ++j) {
+				log4g_appender_do_append(appender, events[j]);
+			}
+		} else {
+			log4g_appender_do_append_batch(appender, events,
+					BATCH_EVENTS);
+		}
+		g_object_unref(appender);
+	}
+	batch_events_free(events);
+	gchar *single = contents_(names[0]);
+	gchar *batch = contents_(names[1]);
+	g_assert_cmpstr(single, ==,
+			"INFO  gnome.test - first message\n"
+			"ERROR gnome.test - second message\n"
+			"INFO  gnome.test - third message\n");
+	g_assert_cmpstr(batch, ==, single);
+	g_free(single);
+	g_free(batch);
+}
+
+/* Empty batches and batches the filters reject entirely write nothing */
+void
+test_004(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *name = "tests/writer-appender-test-empty.txt";
+	Log4gLoggingEvent *events[BATCH_EVENTS];
+	batch_events_new(events);
+	Log4gAppender *appender = batch_appender_new(name);
+	log4g_appender_do_append_batch(appender, NULL, 0);
+	log4g_appender_do_append_batch(appender, events, 0);
+	log4g_appender_set_threshold(appender, "FATAL");
+	log4g_appender_do_append_batch(appender, events, BATCH_EVENTS);
+	log4g_appender_set_threshold(appender, "ALL");
+	log4g_appender_do_append_batch(appender, events + 3, 1);
+	g_object_unref(appender);
+	batch_events_free(events);
+	gchar *contents = contents_(name);
+	g_assert_cmpstr(contents, ==, "ERROR gnome.test - second message\n");
+	g_free(contents);
+}
+
+/* A batch reaches every attached appender */
+void
+test_005(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	const gchar *names[] = {
+		"tests/writer-appender-test-attached-1.txt",
+		"tests/writer-appender-test-attached-2.txt"
+	};
+	Log4gLoggingEvent *events[BATCH_EVENTS];
+	batch_events_new(events);
+	Log4gAppenderAttachable *aai = log4g_appender_attachable_impl_new();
+	g_assert(aai);
+	g_assert_cmpuint(
+		log4g_appender_attachable_impl_append_batch_loop_on_appenders(
+			aai, events, BATCH_EVENTS), ==, 0);
+	for (guint i = 0; i < G_N_ELEMENTS(names); ++i) {
+		Log4gAppender *appender = batch_appender_new(names[i]);
+		log4g_appender_attachable_add_appender(aai, appender);
+		g_object_unref(appender);
+	}
+	g_assert_cmpuint(
+		log4g_appender_attachable_impl_append_batch_loop_on_appenders(
+			aai, events, BATCH_EVENTS), ==, G_N_ELEMENTS(names));
+	g_assert_cmpuint(
+		log4g_appender_attachable_impl_append_batch_loop_on_appenders(
+			aai, events, 0), ==, G_N_ELEMENTS(names));
+	g_object_unref(aai);
+	batch_events_free(events);
+	for (guint i = 0; i < G_N_ELEMENTS(names); ++i) {
+		gchar *contents = contents_(names[i]);
+		g_assert_cmpstr(contents, ==,
+				"DEBUG gnome.test - below threshold\n"
+				"INFO  gnome.test - first message\n"
+				"WARN  gnome.test - secret message\n"
+				"ERROR gnome.test - second message\n"
+				"INFO  gnome.test - third message\n");
+		g_free(contents);
+	}
+}
+
+/* Sub-classes are serialized unless they opt in to concurrent append */
+void
+test_006(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	GType parent = g_type_from_name("Log4gWriterAppender");
+	g_assert(parent);
+	GTypeQuery query;
+	g_type_query(parent, &query);
+	GType type = g_type_register_static_simple(parent,
+			"Log4gTestWriterAppender", query.class_size, NULL,
+			query.instance_size, NULL, 0);
+	g_assert(type);
+	Log4gAppenderClass *klass = g_type_class_ref(parent);
+	g_assert(klass->concurrent_append);
+	g_type_class_unref(klass);
+	klass = g_type_class_ref(type);
+	g_assert(!klass->concurrent_append);
+	g_type_class_unref(klass);
+}
+
+/* Layouts replaced while events are appended concurrently are not
+ * destroyed while they are in use */
+void
+test_007(G_GNUC_UNUSED gpointer *fixture, G_GNUC_UNUSED gconstpointer data)
+{
+	Log4gAppender *appender =
+		batch_appender_new("tests/writer-appender-test.txt");
+	GType type = g_type_from_name("Log4gPatternLayout");
+	g_assert(type);
+	GThread *threads[THREADS];
+	for (gint i = 0; i < THREADS; ++i) {
+		threads[i] = g_thread_new(NULL, append_, appender);
+	}
+	for (gint i = 0; i < 100; ++i) {
+		Log4gLayout *layout = g_object_new(type,
+				"conversion-pattern", "%-5p %c{2} - %m%n",
+				NULL);
+		g_assert(layout);
+		log4g_layout_activate_options(layout);
+		log4g_appender_set_layout(appender, layout);
+		g_object_unref(layout);
+		g_thread_yield();
+	}
+	for (gint i = 0; i < THREADS; ++i) {
+		g_thread_join(threads[i]);
+	}
+	g_object_unref(appender);
+	gchar *contents = contents_("tests/writer-appender-test.txt");
+	gchar **lines = g_strsplit(contents, "\n", -1);
+	guint n = g_strv_length(lines);
+	g_assert_cmpuint(n, ==, THREADS * EVENTS + 1);
+	for (guint i = 0; i < n - 1; ++i) {
+		g_assert_cmpstr(lines[i], ==,
+				"INFO  gnome.test - concurrent message");
+	}
+	g_strfreev(lines);
+	g_free(contents);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -73,6 +366,16 @@ main(int argc, char *argv[])
 	g_assert(module);
 	g_assert(g_type_module_use(module));
 	g_type_module_unuse(module);
+	module = log4g_module_new("modules/filters/liblog4g-filters.la");
+	g_assert(module);
+	g_assert(g_type_module_use(module));
+	g_type_module_unuse(module);
 	g_test_add(CLASS"/001", gpointer, NULL, NULL, test_001, NULL);
+	g_test_add(CLASS"/002", gpointer, NULL, NULL, test_002, NULL);
+	g_test_add(CLASS"/003", gpointer, NULL, NULL, test_003, NULL);
+	g_test_add(CLASS"/004", gpointer, NULL, NULL, test_004, NULL);
+	g_test_add(CLASS"/005", gpointer, NULL, NULL, test_005, NULL);
+	g_test_add(CLASS"/006", gpointer, NULL, NULL, test_006, NULL);
+	g_test_add(CLASS"/007", gpointer, NULL, NULL, test_007, NULL);
 	return g_test_run();
 }
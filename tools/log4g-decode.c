@@ -0,0 +1,607 @@
+/* Copyright 2010, 2011 Michael Steinert
+ * This file is part of Log4g.
+ *
+ * Log4g is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * Log4g is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Log4g. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * log4g-decode: render files written by Log4gBinaryLayout
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include "helpers/binary-format.h"
+#include "log4g/log4g.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The default conversion pattern */
+#define PATTERN "%d{%Y-%m-%d %H:%M:%S.%6N} %-5p [%t] %c - %m%n"
+
+/* The size of each read from the input */
+#define READ_SIZE (65536)
+
+/* A call site, strings are ids in the stream that defined it */
+typedef struct Site_ {
+	gint level;
+	guint64 file;
+	guint64 line;
+	guint64 function;
+	guint64 format;
+} Site;
+
+/* The strings, call sites & time stamp of one stream */
+typedef struct Stream_ {
+	GPtrArray *strings; /* Indexed by string id */
+	GHashTable *sites; /* Keyed by call site id, ids are not dense */
+	gint64 time;
+} Stream;
+
+typedef struct Decoder_ {
+	GHashTable *streams;
+	Log4gLayout *layout;
+	GString *output;
+	GPtrArray *keys; /* MDC keys set for the previous event */
+} Decoder;
+
+/* The result of decoding one record */
+enum Result {
+	RECORD_ERROR = -1,
+	RECORD_TRUNCATED = 0
+};
+
+static gchar *pattern = NULL;
+
+static const GOptionEntry entries[] = {
+	{ "pattern", 'p', 0, G_OPTION_ARG_STRING, &pattern,
+		"Conversion pattern used to render events", "PATTERN" },
+	{ NULL, '\0', 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+};
+
+static void
+stream_free(gpointer data)
+{
+	Stream *self = data;
+	g_ptr_array_free(self->strings, TRUE);
+	g_hash_table_destroy(self->sites);
+	g_slice_free(Stream, self);
+}
+
+static Stream *
+stream_get(Decoder *self, guint64 number)
+{
+	Stream *stream = g_hash_table_lookup(self->streams, &number);
+	if (!stream) {
+		stream = g_slice_new0(Stream);
+		stream->strings = g_ptr_array_new_with_free_func(g_free);
+		stream->sites = g_hash_table_new_full(NULL, NULL, NULL,
+				g_free);
+		gint64 *key = g_new(gint64, 1);
+		*key = (gint64)number;
+		g_hash_table_insert(self->streams, key, stream);
+	}
+	return stream;
+}
+
+static const gchar *
+stream_lookup(Stream *self, guint64 id)
+{
+	if (!id) {
+		return NULL;
+	}
+	if (id >= self->strings->len || !self->strings->pdata[id]) {
+		return "?";
+	}
+	return self->strings->pdata[id];
+}
+
+/* Read a length prefixed string, '*value' is NULL for a NULL string */
+static gboolean
+get_bytes(const guchar **p, const guchar *end, gchar **value)
+{
+	guint64 length;
+	if (!log4g_binary_get_varint(p, end, &length)) {
+		return FALSE;
+	}
+	if (!length) {
+		*value = NULL;
+		return TRUE;
+	}
+	if ((guint64)(end - *p) < length - 1) {
+		return FALSE;
+	}
+	*value = g_strndup((const gchar *)*p, length - 1);
+	*p += length - 1;
+	return TRUE;
+}
+
+static Log4gLoggingEvent *
+event_new(const gchar *logger, Log4gLevel *level, const gchar *function,
+		const gchar *file, const gchar *line, const gchar *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	Log4gLoggingEvent *event = log4g_logging_event_new(logger, level,
+			function, file, line, format, ap);
+	va_end(ap);
+	return event;
+}
+
+/* Replace the MDC of the calling thread */
+static void
+mdc_set(Decoder *self, GPtrArray *properties)
+{
+	for (guint i = 0; i < self->keys->len; ++i) {
+		log4g_mdc_remove(self->keys->pdata[i]);
+	}
+	g_ptr_array_set_size(self->keys, 0);
+	for (guint i = 0; i + 1 < properties->len; i += 2) {
+		const gchar *key = properties->pdata[i];
+		const gchar *value = properties->pdata[i + 1];
+		if (key && value) {
+			log4g_mdc_put(key, "%s", value);
+			g_ptr_array_add(self->keys, g_strdup(key));
+		}
+	}
+}
+
+static gssize
+decode_string(Decoder *self, const guchar *p, const guchar *end)
+{
+	const guchar *start = p;
+	guint64 number, id;
+	gchar *value;
+	if (!log4g_binary_get_varint(&p, end, &number)
+			|| !log4g_binary_get_varint(&p, end, &id)) {
+		return RECORD_TRUNCATED;
+	}
+	guint64 length;
+	if (!log4g_binary_get_varint(&p, end, &length)) {
+		return RECORD_TRUNCATED;
+	}
+	if ((guint64)(end - p) < length) {
+		return RECORD_TRUNCATED;
+	}
+	Stream *stream = stream_get(self, number);
+	/* ids are assigned in sequence from 1, a larger id is corrupt */
+	if (!id || id > MAX(stream->strings->len, 1)) {
+		return RECORD_ERROR;
+	}
+	value = g_strndup((const gchar *)p, length);
+	p += length;
+	if (id >= stream->strings->len) {
+		g_ptr_array_set_size(stream->strings, id + 1);
+	}
+	g_free(stream->strings->pdata[id]);
+	stream->strings->pdata[id] = value;
+	return p - start;
+}
+
+/* Read the MDC of an event */
+static gboolean
+get_properties(Stream *stream, const guchar **p, const guchar *end,
+		GPtrArray *properties)
+{
+	guint64 count;
+	if (!log4g_binary_get_varint(p, end, &count)) {
+		return FALSE;
+	}
+	for (guint64 i = 0; i < count; ++i) {
+		guint64 key;
+		gchar *value;
+		if (!log4g_binary_get_varint(p, end, &key)
+				|| !get_bytes(p, end, &value)) {
+			return FALSE;
+		}
+		g_ptr_array_add(properties,
+				g_strdup(stream_lookup(stream, key)));
+		g_ptr_array_add(properties, value);
+	}
+	return TRUE;
+}
+
+/* Restore the thread name, NDC & MDC of an event on the calling thread */
+static void
+context_set(Decoder *self, Stream *stream, guint64 thread, const gchar *ndc,
+		GPtrArray *properties)
+{
+	const gchar *name = stream_lookup(stream, thread);
+	log4g_thread_set_name(name ? name : "?");
+	log4g_ndc_clear();
+	if (ndc) {
+		log4g_ndc_push("%s", ndc);
+	}
+	mdc_set(self, properties);
+}
+
+/* Render an event to the standard output */
+static void
+render(Decoder *self, Log4gLoggingEvent *event, gint64 time)
+{
+	log4g_logging_event_set_time_stamp_ns(event, time);
+	g_string_set_size(self->output, 0);
+	log4g_layout_format_to(self->layout, event, self->output);
+	fwrite(self->output->str, 1, self->output->len, stdout);
+	g_object_unref(event);
+}
+
+static gssize
+decode_event(Decoder *self, const guchar *p, const guchar *end)
+{
+	const guchar *start = p;
+	guint64 number, time, level, logger, thread, file, line, function;
+	gchar *message = NULL;
+	gchar *ndc = NULL;
+	gssize result = RECORD_TRUNCATED;
+	GPtrArray *properties = g_ptr_array_new_with_free_func(g_free);
+	if (!log4g_binary_get_varint(&p, end, &number)
+			|| !log4g_binary_get_varint(&p, end, &time)
+			|| !log4g_binary_get_varint(&p, end, &level)
+			|| !log4g_binary_get_varint(&p, end, &logger)
+			|| !log4g_binary_get_varint(&p, end, &thread)
+			|| !log4g_binary_get_varint(&p, end, &file)
+			|| !log4g_binary_get_varint(&p, end, &line)
+			|| !log4g_binary_get_varint(&p, end, &function)
+			|| !get_bytes(&p, end, &message)
+			|| !get_bytes(&p, end, &ndc)) {
+		goto exit;
+	}
+	Stream *stream = stream_get(self, number);
+	if (!get_properties(stream, &p, end, properties)) {
+		goto exit;
+	}
+	/* the record is complete */
+	result = p - start;
+	stream->time += LOG4G_BINARY_UNZIGZAG(time);
+	context_set(self, stream, thread, ndc, properties);
+	Log4gLevel *l = log4g_level_int_to_level_default(
+			(gint)LOG4G_BINARY_UNZIGZAG(level), log4g_level_DEBUG());
+	Log4gLoggingEvent *event = event_new(stream_lookup(stream, logger),
+			l, stream_lookup(stream, function),
+			stream_lookup(stream, file), stream_lookup(stream, line),
+			(message ? "%s" : NULL), message);
+	if (event) {
+		render(self, event, stream->time);
+	}
+exit:
+	g_free(message);
+	g_free(ndc);
+	g_ptr_array_free(properties, TRUE);
+	return result;
+}
+
+static gssize
+decode_call_site(Decoder *self, const guchar *p, const guchar *end)
+{
+	const guchar *start = p;
+	guint64 number, id, level;
+	Site site;
+	if (!log4g_binary_get_varint(&p, end, &number)
+			|| !log4g_binary_get_varint(&p, end, &id)
+			|| !log4g_binary_get_varint(&p, end, &level)
+			|| !log4g_binary_get_varint(&p, end, &site.file)
+			|| !log4g_binary_get_varint(&p, end, &site.line)
+			|| !log4g_binary_get_varint(&p, end, &site.function)
+			|| !log4g_binary_get_varint(&p, end, &site.format)) {
+		return RECORD_TRUNCATED;
+	}
+	if (!id || id > G_MAXUINT) {
+		return RECORD_ERROR;
+	}
+	site.level = (gint)LOG4G_BINARY_UNZIGZAG(level);
+	Stream *stream = stream_get(self, number);
+	Site *copy = g_new(Site, 1);
+	*copy = site;
+	g_hash_table_insert(stream->sites, GUINT_TO_POINTER((guint)id), copy);
+	return p - start;
+}
+
+/* Read one captured format parameter */
+static gssize
+get_argument(const guchar **p, const guchar *end, Log4gArgument *arg)
+{
+	guint64 value;
+	gdouble d;
+	if (*p >= end) {
+		return RECORD_TRUNCATED;
+	}
+	arg->type = *(*p)++;
+	switch (arg->type) {
+	case LOG4G_ARGUMENT_INT:
+	case LOG4G_ARGUMENT_LONG:
+	case LOG4G_ARGUMENT_LLONG:
+	case LOG4G_ARGUMENT_INTMAX:
+	case LOG4G_ARGUMENT_PTRDIFF:
+	case LOG4G_ARGUMENT_SIZE:
+	case LOG4G_ARGUMENT_POINTER:
+		if (!log4g_binary_get_varint(p, end, &value)) {
+			return RECORD_TRUNCATED;
+		}
+		break;
+	case LOG4G_ARGUMENT_DOUBLE:
+	case LOG4G_ARGUMENT_LDOUBLE:
+		if (end - *p < (gssize)sizeof(value)) {
+			return RECORD_TRUNCATED;
+		}
+		memcpy(&value, *p, sizeof(value));
+		*p += sizeof(value);
+		value = GUINT64_FROM_LE(value);
+		memcpy(&d, &value, sizeof(d));
+		break;
+	case LOG4G_ARGUMENT_STRING:
+		if (!get_bytes(p, end, &arg->value.s)) {
+			arg->type = LOG4G_ARGUMENT_NONE;
+			return RECORD_TRUNCATED;
+		}
+		return 1;
+	default:
+		return RECORD_ERROR;
+	}
+	switch (arg->type) {
+	case LOG4G_ARGUMENT_INT:
+		arg->value.i = (gint)LOG4G_BINARY_UNZIGZAG(value);
+		break;
+	case LOG4G_ARGUMENT_LONG:
+		arg->value.l = (glong)LOG4G_BINARY_UNZIGZAG(value);
+		break;
+	case LOG4G_ARGUMENT_LLONG:
+		arg->value.ll = (long long)LOG4G_BINARY_UNZIGZAG(value);
+		break;
+	case LOG4G_ARGUMENT_INTMAX:
+		arg->value.j = (intmax_t)LOG4G_BINARY_UNZIGZAG(value);
+		break;
+	case LOG4G_ARGUMENT_PTRDIFF:
+		arg->value.t = (ptrdiff_t)LOG4G_BINARY_UNZIGZAG(value);
+		break;
+	case LOG4G_ARGUMENT_SIZE:
+		arg->value.z = (gsize)value;
+		break;
+	case LOG4G_ARGUMENT_POINTER:
+		arg->value.p = (gpointer)(guintptr)value;
+		break;
+	case LOG4G_ARGUMENT_DOUBLE:
+		arg->value.d = d;
+		break;
+	case LOG4G_ARGUMENT_LDOUBLE:
+		arg->value.ld = d;
+		break;
+	default:
+		break;
+	}
+	return 1;
+}
+
+static gssize
+decode_call(Decoder *self, const guchar *p, const guchar *end)
+{
+	const guchar *start = p;
+	guint64 number, time, id, logger, thread, count;
+	gchar *ndc = NULL;
+	gssize result = RECORD_TRUNCATED;
+	GArray *args = g_array_new(FALSE, TRUE, sizeof(Log4gArgument));
+	GPtrArray *properties = g_ptr_array_new_with_free_func(g_free);
+	if (!log4g_binary_get_varint(&p, end, &number)
+			|| !log4g_binary_get_varint(&p, end, &time)
+			|| !log4g_binary_get_varint(&p, end, &id)
+			|| !log4g_binary_get_varint(&p, end, &logger)
+			|| !log4g_binary_get_varint(&p, end, &thread)
+			|| !log4g_binary_get_varint(&p, end, &count)) {
+		goto exit;
+	}
+	if (count > (guint64)(end - p)) {
+		/* every argument needs at least one byte */
+		goto exit;
+	}
+	for (guint64 i = 0; i < count; ++i) {
+		Log4gArgument arg;
+		gssize n = get_argument(&p, end, &arg);
+		if (n <= 0) {
+			result = n;
+			goto exit;
+		}
+		g_array_append_val(args, arg);
+	}
+	if (!get_bytes(&p, end, &ndc)) {
+		goto exit;
+	}
+	Stream *stream = stream_get(self, number);
+	if (!get_properties(stream, &p, end, properties)) {
+		goto exit;
+	}
+	/* the record is complete */
+	result = p - start;
+	stream->time += LOG4G_BINARY_UNZIGZAG(time);
+	context_set(self, stream, thread, ndc, properties);
+	const Site *site = (id <= G_MAXUINT)
+		? g_hash_table_lookup(stream->sites,
+				GUINT_TO_POINTER((guint)id))
+		: NULL;
+	Log4gLevel *level = log4g_level_int_to_level_default(
+			(site ? site->level : 0), log4g_level_DEBUG());
+	const gchar *format = (site ? stream_lookup(stream, site->format)
+			: NULL);
+	Log4gLoggingEvent *event = NULL;
+	if (format) {
+		event = log4g_logging_event_new_arguments(
+				stream_lookup(stream, logger), level,
+				stream_lookup(stream, site->function),
+				stream_lookup(stream, site->file),
+				stream_lookup(stream, site->line), format,
+				(const Log4gArgument *)args->data, args->len);
+	}
+	if (!event) {
+		/* unknown call site or mismatched arguments */
+		event = event_new(stream_lookup(stream, logger), level,
+				(site ? stream_lookup(stream, site->function)
+				 : "?"),
+				(site ? stream_lookup(stream, site->file)
+				 : "?"),
+				(site ? stream_lookup(stream, site->line)
+				 : "?"), "%s", "?");
+	}
+	if (event) {
+		render(self, event, stream->time);
+	}
+exit:
+	for (guint i = 0; i < args->len; ++i) {
+		Log4gArgument *arg = &g_array_index(args, Log4gArgument, i);
+		if (arg->type == LOG4G_ARGUMENT_STRING) {
+			g_free(arg->value.s);
+		}
+	}
+	g_array_free(args, TRUE);
+	g_free(ndc);
+	g_ptr_array_free(properties, TRUE);
+	return result;
+}
+
+/* Decode the records in 'buffer', returns the number of bytes consumed or
+ * -1 if the input is not a binary log */
+static gssize
+decode(Decoder *self, const guchar *buffer, gsize size, gboolean eof)
+{
+	const gsize magic = sizeof(LOG4G_BINARY_MAGIC) - 1;
+	const guchar *p = buffer;
+	const guchar *end = buffer + size;
+	while (p < end) {
+		gssize n;
+		switch (*p) {
+		case LOG4G_BINARY_STRING:
+			n = decode_string(self, p + 1, end);
+			break;
+		case LOG4G_BINARY_EVENT:
+			n = decode_event(self, p + 1, end);
+			break;
+		case LOG4G_BINARY_CALL_SITE:
+			n = decode_call_site(self, p + 1, end);
+			break;
+		case LOG4G_BINARY_CALL:
+			n = decode_call(self, p + 1, end);
+			break;
+		default:
+			if ((gsize)(end - p) < magic && !eof) {
+				return p - buffer;
+			}
+			if ((gsize)(end - p) < magic
+					|| memcmp(p, LOG4G_BINARY_MAGIC, magic)) {
+				return RECORD_ERROR;
+			}
+			/* each header starts a new file */
+			g_hash_table_remove_all(self->streams);
+			n = magic - 1;
+			break;
+		}
+		if (RECORD_ERROR == n) {
+			return RECORD_ERROR;
+		}
+		if (RECORD_TRUNCATED == n) {
+			return eof ? RECORD_ERROR : p - buffer;
+		}
+		p += n + 1;
+	}
+	return p - buffer;
+}
+
+static gboolean
+decode_file(Decoder *self, const gchar *name)
+{
+	FILE *file = stdin;
+	if (strcmp(name, "-")) {
+		file = fopen(name, "rb");
+		if (!file) {
+			g_printerr("%s: %s\n", name, g_strerror(errno));
+			return FALSE;
+		}
+	}
+	gboolean status = TRUE;
+	GByteArray *buffer = g_byte_array_new();
+	gboolean eof = FALSE;
+	while (!eof) {
+		guint length = buffer->len;
+		g_byte_array_set_size(buffer, length + READ_SIZE);
+		gsize n = fread(buffer->data + length, 1, READ_SIZE, file);
+		g_byte_array_set_size(buffer, length + n);
+		if (n < READ_SIZE) {
+			if (ferror(file)) {
+				g_printerr("%s: %s\n", name, g_strerror(errno));
+				status = FALSE;
+				break;
+			}
+			eof = TRUE;
+		}
+		gssize consumed = decode(self, buffer->data, buffer->len, eof);
+		if (consumed < 0) {
+			g_printerr("%s: not a valid binary log\n", name);
+			status = FALSE;
+			break;
+		}
+		g_byte_array_remove_range(buffer, 0, consumed);
+	}
+	g_byte_array_free(buffer, TRUE);
+	if (file != stdin) {
+		fclose(file);
+	}
+	return status;
+}
+
+int
+main(int argc, char *argv[])
+{
+	GError *error = NULL;
+	GOptionContext *context = g_option_context_new("FILE...");
+	g_option_context_set_summary(context,
+			"Render files written by the Log4g binary layout.");
+	g_option_context_add_main_entries(context, entries, NULL);
+	g_option_context_add_group(context, log4g_get_option_group());
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(context);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+	GType type = g_type_from_name("Log4gPatternLayout");
+	if (!type) {
+		g_printerr("the Log4g layouts module is not installed\n");
+		return EXIT_FAILURE;
+	}
+	Decoder decoder;
+	decoder.layout = g_object_new(type, "conversion-pattern",
+			(pattern ? pattern : PATTERN), NULL);
+	log4g_layout_activate_options(decoder.layout);
+	decoder.streams = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+			g_free, stream_free);
+	decoder.output = g_string_sized_new(256);
+	decoder.keys = g_ptr_array_new_with_free_func(g_free);
+	int status = EXIT_SUCCESS;
+	if (argc < 2) {
+		if (!decode_file(&decoder, "-")) {
+			status = EXIT_FAILURE;
+		}
+	}
+	for (int i = 1; i < argc; ++i) {
+		if (!decode_file(&decoder, argv[i])) {
+			status = EXIT_FAILURE;
+		}
+	}
+	g_ptr_array_free(decoder.keys, TRUE);
+	g_string_free(decoder.output, TRUE);
+	g_hash_table_destroy(decoder.streams);
+	g_object_unref(decoder.layout);
+	g_free(pattern);
+	return status;
+}